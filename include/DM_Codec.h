@@ -0,0 +1,70 @@
+/** +----------------------------------------------+
+ *  |      DM_Codec - Time series compression      |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef DM_Codec_h
+#define DM_Codec_h
+
+// IMPORT THE NECESSARY LIBRARIES (only standard headers, so this library also builds on a computer to decode what the station sends)
+#include <stddef.h>    // Used to be able to use the "size_t" type
+#include <stdint.h>    // Used to be able to use the fixed width integer types
+#include <DM_Sample.h> // Used to be able to use "DM_PackedSample" as a type for an argument
+
+/**
+ * The format of a stream (every number is a varint: 7 bits per byte, the highest bit means "another byte follows"):
+ *  - The first sample: the timestamp, the Unix time, the temperature (zig-zag), the air pressure and the light intensity as they are.
+ *  - Every next sample: the change of the change of the timestamp and of the Unix time (0 when the samples are taken at a fixed rate),
+ *    followed by the change of the temperature, the air pressure and the light intensity (zig-zag, so small changes in both directions take one byte).
+ * All differences are calculated modulo 2^32, so a timestamp that wraps around (or a failed reading) never breaks the stream.
+ */
+
+// DECLARE THE CLASS "DM_Encoder"
+class DM_Encoder
+{
+public: // The public functions and constants
+    static const size_t maxEncodedSampleSize = 25; // The most bytes one sample can take (5 numbers of at most 5 bytes)
+
+    static size_t writeVarint(uint8_t *buffer, uint32_t value);
+    DM_Encoder();
+    void begin(uint8_t *buffer, size_t capacity);
+    bool add(const DM_PackedSample &sample, uint32_t epochSeconds);
+    size_t getLength() const;
+    uint32_t getAmount() const;
+
+private: // The private members
+    uint8_t *_buffer;                 // The buffer the stream is written to
+    size_t _capacity;                 // The size of the buffer
+    size_t _length;                   // The amount of bytes written
+    uint32_t _amount;                 // The amount of samples written
+    DM_PackedSample _previous;        // The previous sample
+    uint32_t _previousEpochSeconds;   // The Unix time of the previous sample
+    uint32_t _previousTimestampDelta; // The change of the timestamp between the two previous samples
+    uint32_t _previousEpochDelta;     // The change of the Unix time between the two previous samples
+};
+
+// DECLARE THE CLASS "DM_Decoder"
+class DM_Decoder
+{
+public: // The public functions
+    static bool readVarint(const uint8_t *buffer, size_t length, size_t &position, uint32_t &value);
+    DM_Decoder();
+    void begin(const uint8_t *buffer, size_t length, uint32_t amount);
+    bool next(DM_PackedSample &sample, uint32_t &epochSeconds);
+
+private: // The private members
+    const uint8_t *_buffer;           // The stream
+    size_t _length;                   // The length of the stream
+    size_t _position;                 // The position of the next byte to read
+    uint32_t _amount;                 // The amount of samples in the stream
+    uint32_t _decoded;                // The amount of samples decoded so far
+    DM_PackedSample _previous;        // The previous sample
+    uint32_t _previousEpochSeconds;   // The Unix time of the previous sample
+    uint32_t _previousTimestampDelta; // The change of the timestamp between the two previous samples
+    uint32_t _previousEpochDelta;     // The change of the Unix time between the two previous samples
+};
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,55 @@
+/** +----------------------------------------------+
+ *  |   DM_Connection - Connection state machine   |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef DM_Connection_h
+#define DM_Connection_h
+
+// IMPORT THE NECESSARY LIBRARY
+#include <stdint.h> // Used to be able to use the fixed width integer types
+
+// DECLARE THE STATES OF A CONNECTION
+enum DM_ConnectionState
+{
+    DM_STATE_IDLE,       // Not connected and no attempt is running (the next tick() starts one)
+    DM_STATE_CONNECTING, // A connection attempt is running
+    DM_STATE_CONNECTED,  // The connection is up
+    DM_STATE_BACKOFF,    // The last attempt failed, we wait before trying again
+    DM_AMOUNT_OF_STATES  // The amount of states (keep this one last)
+};
+
+// DECLARE THE CLASS "DM_ConnectionStateMachine"
+class DM_ConnectionStateMachine
+{
+public: // The public functions
+    DM_ConnectionStateMachine(const char *name, uint32_t connectTimeoutMs, uint32_t initialBackoffMs, uint32_t maxBackoffMs);
+    DM_ConnectionState getState();
+    void changeState(DM_ConnectionState newState);
+    bool hasConnectTimedOut();
+    bool isBackoffOver();
+    uint32_t getTimeInStateMs(DM_ConnectionState state);
+    uint32_t getAmountOfConnects();
+    uint32_t getLastOutageMs();
+    void printStatistics();
+    static const char *getStateName(DM_ConnectionState state);
+
+private: // The private members
+    const char *_name;                            // The name that is used as prefix when printing (e.g. "DM_WiFi")
+    DM_ConnectionState _state;                    // The current state
+    uint32_t _stateEnteredMs;                     // The moment the current state was entered
+    uint32_t _timeInStateMs[DM_AMOUNT_OF_STATES]; // The total time spent in every state (without the time in the current state)
+    uint32_t _connectTimeoutMs;                   // The time a connection attempt may take before it is seen as failed
+    uint32_t _initialBackoffMs;                   // The backoff after the first failed attempt
+    uint32_t _maxBackoffMs;                       // The highest backoff we will ever wait
+    uint32_t _nextBackoffMs;                      // The backoff that will be used after the next failed attempt (doubles every failure)
+    uint32_t _currentBackoffMs;                   // The backoff (including jitter) we are waiting in the current BACKOFF state
+    uint32_t _amountOfConnects;                   // The amount of times the connection has been established
+    uint32_t _disconnectedSinceMs;                // The moment the connection was lost (or the state machine was created)
+    uint32_t _lastOutageMs;                       // The time it took to get connected the last time
+};
+
+#endif // End the header guard
\ No newline at end of file
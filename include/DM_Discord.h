@@ -9,15 +9,45 @@
 #ifndef DM_Discord_h
 #define DM_Discord_h
 
-// IMPORT THE NECESSARY LIBRARY
-using namespace std; // Used to be able to use the string type without needing to say "std::string" every time
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h>    // Used to be able to use the "size_t" type
+#include <stdint.h>    // Used to be able to use the fixed width integer types
+#include <string>      // Used to be able to use the string type
+#include <DM_Sample.h> // Used to be able to use "DM_Sample" and "DM_Field" as types for an argument
+using namespace std;   // Used to be able to use the string type without needing to say "std::string" every time
+
+// DECLARE THE ENUM "DM_DiscordResult" (what happened to the measurements of "sendSamples()")
+enum DM_DiscordResult
+{
+    DM_DISCORD_SENT,      // Discord accepted the message
+    DM_DISCORD_FAILED,    // The message was not accepted (sending it again later can work)
+    DM_DISCORD_TOO_LARGE, // The measurements don't fit in one message, so they can never be sent
+};
 
 // DECLARE THE CLASS "DM_WebhookConnector"
 class DM_WebhookConnector
 {
-public: // The public functions
-    static void sendMessage(string webhookURL, string message);
-    static string embedBuilder(float temperatureC, float lightIntensityLux, float airPressureBar);
+public: // The public functions and constants
+    static constexpr size_t maxSamplesPerMessage = 8; // The most measurements that are shown in one message
+
+    static void setWebhookURL(string webhookURL);
+    static void setFields(const DM_Field *fields, size_t amountOfFields);
+    static DM_DiscordResult sendSamples(const DM_Sample *samples, size_t amount);
+    static bool isRateLimitOver();
+    static bool sendMessage(const char *message, size_t messageLength);
+    static size_t embedBuilder(char *buffer, size_t bufferSize, const DM_Sample *samples, size_t amount, const DM_Field *fields, size_t amountOfFields);
+    static void printStatistics();
+
+private: // The private members
+    static string _webhookURL;
+    static const DM_Field *_fields;
+    static size_t _amountOfFields;
+    static uint32_t _nextSendMs;
+    static char _message[];
+    static uint32_t _newConnectionLatencyMs;
+    static uint32_t _amountOfNewConnections;
+    static uint32_t _reusedConnectionLatencyMs;
+    static uint32_t _amountOfReusedConnections;
 };
 
 #endif // End the header guard
\ No newline at end of file
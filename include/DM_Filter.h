@@ -0,0 +1,80 @@
+/** +----------------------------------------------+
+ *  |        DM_Filter - Outlier rejection         |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef DM_Filter_h
+#define DM_Filter_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h> // Used to be able to use the "size_t" type
+#include <stdint.h> // Used to be able to use the fixed width integer types
+
+// DECLARE THE STRUCT "DM_FilterState" (declared below the class, because it needs the size of the window)
+struct DM_FilterState;
+
+/**
+ * Turns a burst of fast readings of one value into one reading that a single glitch can't move:
+ *  1. The median of the burst (a sorting network, so the same comparisons are done no matter the readings).
+ *  2. A spike check against the readings before it: a median that is further from the rolling median than "spikeThreshold" times the rolling MAD (median absolute deviation, scaled to a standard deviation) is flagged and replaced by the rolling median.
+ *     The MAD has a floor, in the unit of the value and as a part of the rolling median (a value like the light intensity changes by a few percent within seconds, whether it is 10 or 30000 lux).
+ *     Every median is still added to the window, so a real step (e.g. a light that is turned on) is accepted once it fills half of the window.
+ *  3. An optional exponential moving average in fixed point (the weight of a new reading is 1 / 2^emaShift, 0 turns it off).
+ *
+ * Every step works on a fixed amount of readings (at most "maxBurstSize" and "windowSize"), so one burst always takes about the same few microseconds (see the "filter" stage of "DM_Profiler").
+ * Besides the profiler, only standard headers are used, so the filter also runs on a computer against recorded or synthetic readings.
+ */
+class DM_Filter
+{
+public: // The public functions and constants
+    static constexpr uint8_t maxBurstSize = 7;      // The most readings in one burst (the largest sorting network)
+    static constexpr uint8_t windowSize = 15;       // The amount of medians the rolling median and MAD are taken over
+    static constexpr uint8_t minimumWindowSize = 5; // The amount of medians that are needed before spikes are flagged
+    static constexpr uint8_t EMAFractionBits = 8;   // The bits below the resolution the moving average keeps (so a small weight still moves it)
+
+    DM_Filter(float resolution, uint8_t EMAShift, float spikeThreshold, float minimumDeviation, float minimumRelativeDeviation);
+    void addReading(float reading);
+    float filterBurst();
+    void clear();
+    void saveState(DM_FilterState &state) const;
+    bool restoreState(const DM_FilterState &state);
+    bool wasSpike() const;
+    float getLastMedian() const;
+    uint32_t getAmountOfSpikes() const;
+    static float median(float *values, uint8_t amount);
+
+private: // The private functions and members
+    float _resolution;               // The value of one step of the moving average (e.g. 0.01 °C)
+    uint8_t _EMAShift;               // The weight of a new reading in the moving average as a power of two (0: no moving average)
+    float _spikeThreshold;           // The distance from the rolling median (in scaled MADs) above which a median is a spike
+    float _minimumDeviation;         // The lowest scaled MAD that is used (the readings of a steady value are often all the same)
+    float _minimumRelativeDeviation; // The lowest scaled MAD that is used as a part of the rolling median (e.g. 0.05 for 5 %)
+    float _burst[maxBurstSize];      // The readings of the running burst
+    uint8_t _burstLength;            // The amount of readings in the running burst
+    float _window[windowSize];       // The last medians (a ring)
+    uint8_t _windowLength;           // The amount of medians in the window
+    uint8_t _windowIndex;            // The place of the next median in the window
+    int32_t _EMA;                    // The moving average in steps of the resolution, with "EMAFractionBits" more bits
+    bool _EMAStarted;                // If the moving average holds a value
+    bool _lastWasSpike;              // If the last burst was flagged as a spike
+    float _lastMedian;               // The median of the last burst (before the spike check and the moving average)
+    uint32_t _amountOfSpikes;        // The amount of bursts that were flagged as a spike
+    int32_t _toFixedPoint(float value) const;
+};
+
+// DECLARE THE STRUCT "DM_FilterState" (what a filter remembers from the bursts before, so it can be kept in RTC memory during a deep sleep)
+struct DM_FilterState
+{
+    uint32_t magic;                      // Tells a saved state apart from an empty one
+    float window[DM_Filter::windowSize]; // The last medians (a ring)
+    uint8_t windowLength;                // The amount of medians in the window
+    uint8_t windowIndex;                 // The place of the next median in the window
+    bool EMAStarted;                     // If the moving average holds a value
+    int32_t EMA;                         // The moving average in steps of the resolution, with "EMAFractionBits" more bits
+    uint32_t amountOfSpikes;             // The amount of bursts that were flagged as a spike
+};
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,51 @@
+/** +----------------------------------------------+
+ *  |    DM_Format - Allocation-free formatting    |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef DM_Format_h
+#define DM_Format_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h> // Used to be able to use the "size_t" type
+#include <stdint.h> // Used to be able to use the fixed width integer types
+
+// DECLARE THE CLASS "DM_Formatter"
+class DM_Formatter
+{
+public: // The public functions
+    DM_Formatter(char *buffer, size_t capacity);
+    void clear();
+    DM_Formatter &append(const char *text);
+    DM_Formatter &append(const char *text, size_t length);
+    DM_Formatter &appendUnsigned(uint32_t number);
+    DM_Formatter &appendInteger(int32_t number);
+    DM_Formatter &appendFixed(float number, uint8_t decimals);
+    const char *c_str() const;
+    size_t length() const;
+    bool hasOverflowed() const;
+
+    /**
+     * Append a string literal (its length is known at compile time, so nothing is counted at run time). Used for the parts of a payload that never change.
+     *
+     * @param text The string literal to append.
+     *
+     * @return The formatter itself, so calls can be chained.
+     */
+    template <size_t Size>
+    DM_Formatter &appendLiteral(const char (&text)[Size])
+    {
+        return append(text, Size - 1);
+    }
+
+private: // The private members
+    char *_buffer;    // The buffer the text is written into (provided by the caller)
+    size_t _capacity; // The size of the buffer (including the closing zero)
+    size_t _length;   // The length of the text in the buffer
+    bool _overflowed; // If something did not fit in the buffer (the text is cut off)
+};
+
+#endif // End the header guard
\ No newline at end of file
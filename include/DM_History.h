@@ -0,0 +1,41 @@
+/** +----------------------------------------------+
+ *  |     DM_History - Compact sample history      |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef DM_History_h
+#define DM_History_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h>            // Used to be able to use the "size_t" type
+#include <stdint.h>            // Used to be able to use the fixed width integer types
+#include <freertos/FreeRTOS.h> // Used to protect the history while it is read by another task
+#include <DM_Sample.h>         // Used to be able to use "DM_Sample" as a type for an argument
+
+// DECLARE THE CLASS "DM_History"
+class DM_History
+{
+public: // The public functions
+    DM_History();
+    size_t begin(size_t externalCapacity, size_t internalCapacity);
+    void push(const DM_Sample &sample);
+    bool get(size_t index, DM_Sample &sample);
+    bool findFirst(uint32_t timestampMs, DM_Sample &sample);
+    size_t getAmount();
+    size_t getCapacity();
+
+private: // The private members
+    uint32_t *_timestampsMs;                           // The timestamps of all samples (every value has its own array: "struct of arrays")
+    uint32_t *_airPressures;                           // The packed air pressures of all samples
+    int16_t *_temperatures;                            // The packed temperatures of all samples
+    uint16_t *_lightIntensities;                       // The packed light intensities of all samples
+    size_t _capacity;                                  // The amount of samples the history can hold (decided at runtime, by the kind of memory the board has)
+    size_t _next;                                      // The slot the next sample is written to
+    size_t _amount;                                    // The amount of samples in the history
+    portMUX_TYPE _lock = portMUX_INITIALIZER_UNLOCKED; // Keeps a reader from seeing a sample that is half overwritten
+};
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,100 @@
+/** +----------------------------------------------+
+ *  |        DM_Log - Asynchronous logging         |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef DM_Log_h
+#define DM_Log_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h>            // Used to be able to use the "size_t" type
+#include <stdint.h>            // Used to be able to use the fixed width integer types
+#include <freertos/FreeRTOS.h> // Used to be able to use the FreeRTOS types
+#include <freertos/task.h>     // Used to print the messages from a task of their own
+#include <DM_RingBuffer.h>     // Used as the lock-free queue between the tasks that log and the task that prints
+
+// DECLARE THE LOG LEVELS (macros instead of an enum, so they can be compared by the preprocessor)
+#define DM_LOG_LEVEL_NONE 0    // Nothing is logged
+#define DM_LOG_LEVEL_ERROR 1   // Something failed and could not be recovered
+#define DM_LOG_LEVEL_WARNING 2 // Something failed, but is retried or worked around
+#define DM_LOG_LEVEL_INFO 3    // What the station is doing (connections, measurements, statistics)
+#define DM_LOG_LEVEL_DEBUG 4   // Details that are only needed while looking for a problem
+
+// Log everything up to "info" unless the build says otherwise (e.g. "-D DM_LOG_LEVEL=DM_LOG_LEVEL_WARNING" in "platformio.ini")
+#ifndef DM_LOG_LEVEL
+#define DM_LOG_LEVEL DM_LOG_LEVEL_INFO
+#endif
+
+// DECLARE THE STRUCT "DM_LogEntry" (one message that is waiting to be printed)
+struct DM_LogEntry
+{
+    const char *tag; // The module that logged the message (e.g. "DM_WiFi", a string literal), or nullptr for a message without prefix
+    uint8_t level;   // The log level of the message
+    char text[128];  // The formatted message (longer messages are cut off)
+};
+
+/**
+ * Logs the messages of every module without waiting for the serial port: a message is formatted straight into a slot of a lock-free queue, and a task with a low priority prints the queue.
+ * At 9600 baud every character costs about a millisecond, so printing from the sampling or uplink task used to hold them up for hundreds of milliseconds per measurement.
+ *
+ * Use the macros (DM_LOG_ERROR(), DM_LOG_WARNING(), DM_LOG_INFO() and DM_LOG_DEBUG()) instead of calling write() yourself: the ones above "DM_LOG_LEVEL" are empty, so their format strings are not even stored in flash.
+ * When the queue is full, the message is dropped and counted (the task that logs never waits), the printing task shows how many messages were lost.
+ * Messages that are logged before begin() wait in the queue until the task is started (or until flush() is called).
+ */
+class DM_Log
+{
+public: // The public functions and constants
+    static constexpr size_t queueCapacity = 64;   // The amount of messages that can wait to be printed (a power of two, see "DM_MPSCRingBuffer")
+    static constexpr uint32_t drainPeriodMs = 20; // The time the printing task sleeps when the queue is empty
+
+    static bool begin(BaseType_t core, UBaseType_t priority);
+    static void write(uint8_t level, const char *tag, const char *format, ...) __attribute__((format(printf, 3, 4)));
+    static void flush();
+    static uint32_t getAmountOfDroppedMessages();
+
+private: // The private functions and members
+    static DM_MPSCRingBuffer<DM_LogEntry, queueCapacity> _queue;
+    static TaskHandle_t _taskHandle;
+    static uint32_t _reportedDrops;
+    static void _task(void *parameters);
+    static bool _printNext();
+};
+
+// DECLARE THE MACROS (a message above the log level of the build is an empty statement, its arguments are never evaluated)
+#if DM_LOG_LEVEL >= DM_LOG_LEVEL_ERROR
+#define DM_LOG_ERROR(tag, ...) DM_Log::write(DM_LOG_LEVEL_ERROR, tag, __VA_ARGS__)
+#else
+#define DM_LOG_ERROR(tag, ...) \
+    do                         \
+    {                          \
+    } while (0)
+#endif
+#if DM_LOG_LEVEL >= DM_LOG_LEVEL_WARNING
+#define DM_LOG_WARNING(tag, ...) DM_Log::write(DM_LOG_LEVEL_WARNING, tag, __VA_ARGS__)
+#else
+#define DM_LOG_WARNING(tag, ...) \
+    do                           \
+    {                            \
+    } while (0)
+#endif
+#if DM_LOG_LEVEL >= DM_LOG_LEVEL_INFO
+#define DM_LOG_INFO(tag, ...) DM_Log::write(DM_LOG_LEVEL_INFO, tag, __VA_ARGS__)
+#else
+#define DM_LOG_INFO(tag, ...) \
+    do                        \
+    {                         \
+    } while (0)
+#endif
+#if DM_LOG_LEVEL >= DM_LOG_LEVEL_DEBUG
+#define DM_LOG_DEBUG(tag, ...) DM_Log::write(DM_LOG_LEVEL_DEBUG, tag, __VA_ARGS__)
+#else
+#define DM_LOG_DEBUG(tag, ...) \
+    do                         \
+    {                          \
+    } while (0)
+#endif
+
+#endif // End the header guard
\ No newline at end of file
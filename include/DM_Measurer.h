@@ -10,23 +10,66 @@
 #define DM_Measurer_h
 
 // IMPORT THE NECESSARY LIBRARIES
-#include <Adafruit_BMP280.h> // Used to be able to use "Adafruit_BMP280" as a type for an argument and as a type for a member of the class
+#include <Adafruit_BMP280.h> // Used to be able to use "Adafruit_BMP280" as a type for an argument
 #include <BH1750.h>          // Used to be able to use "BH1750" as a type for an argument
 
+// DECLARE THE STRUCT "DM_BMP280Snapshot" (everything the BMP280 measures, calculated from one burst read)
+struct DM_BMP280Snapshot
+{
+    bool valid;              // If the measurement succeeded
+    float temperatureC;      // The temperature in degrees Celsius
+    float pressurePa;        // The air pressure in Pascal
+    float pressureBar;       // The air pressure in bar
+    uint8_t i2cTransactions; // The amount of I2C transactions the measurement took
+    uint32_t i2cBusTimeUs;   // The time spent on the I2C bus (without the time waiting for the conversion)
+};
+
+// DECLARE THE STRUCT "DM_BMP280Calibration" (the factory calibration of the chip, read once when the chip is initialized; the names follow "dig_T1" to "dig_P9" in the datasheet)
+struct DM_BMP280Calibration
+{
+    uint16_t T1;
+    int16_t T2;
+    int16_t T3;
+    uint16_t P1;
+    int16_t P2;
+    int16_t P3;
+    int16_t P4;
+    int16_t P5;
+    int16_t P6;
+    int16_t P7;
+    int16_t P8;
+    int16_t P9;
+};
+
 // DECLARE THE CLASS "DM_Measurer"
 class DM_Measurer
 {
 public: // The public functions
     static bool initializeBMP280(Adafruit_BMP280 &measurementChip);
     static bool initializeBH1750(BH1750 &measurementChip);
-    static float BMP280readTemperatureC();
-    static float BMP280readPressurePa();
-    static float BMP280readPressureBar();
-    static float BH1750readLightLevelLux(BH1750 measurementChip);
+    static bool resumeBMP280(Adafruit_BMP280 &measurementChip);
+    static bool resumeBH1750();
+    static bool BMP280startConversion();
+    static bool BMP280isConversionReady();
+    static DM_BMP280Snapshot BMP280collectSnapshot();
+    static bool BH1750startConversion();
+    static bool BH1750isConversionReady();
+    static float BH1750collectLightLevelLux();
+    static uint8_t BH1750getMTreg();
 
-private: // The private function and member
-    static Adafruit_BMP280 _BMP280Chip;
+private: // The private functions and members
+    static DM_BMP280Calibration _BMP280Calibration;
+    static bool _BMP280calibrationRead;
+    static uint8_t _i2cTransactions;
+    static uint32_t _i2cBusTimeUs;
+    static uint32_t _BMP280conversionStartMs;
+    static uint8_t _BH1750MTreg;
+    static uint8_t _BH1750appliedMTreg;
+    static uint32_t _BH1750conversionStartMs;
     static float _convertPaToBar(float numberPa);
+    static bool _BMP280writeRegister(uint8_t reg, uint8_t value);
+    static bool _BMP280readRegisters(uint8_t reg, uint8_t *buffer, uint8_t length);
+    static bool _BH1750writeOpcode(uint8_t opcode);
 };
 
 #endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,69 @@
+/** +----------------------------------------------+
+ *  |      DM_Payload - Binary uplink payload      |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef DM_Payload_h
+#define DM_Payload_h
+
+// IMPORT THE NECESSARY LIBRARIES (only standard headers, so this library also builds on a computer to decode what the station sends)
+#include <stddef.h>    // Used to be able to use the "size_t" type
+#include <stdint.h>    // Used to be able to use the fixed width integer types
+#include <DM_Sample.h> // Used to be able to use "DM_PackedSample" as a type for an argument
+#include <DM_Codec.h>  // Used to compress the samples of a payload
+
+/**
+ * The binary payload the station can publish to a broker of our own, instead of text (see "DM_MQTTSink::setPayloadFormat()" and "tools/ingest"):
+ *  - The version of the format (1 byte, "version"), the schema of the samples (1 byte, "schemaPackedSample") and the amount of samples (1 byte, 1 to 255).
+ *  - The station ID, the boot ID and the sequence number of the first sample (varints), the next samples have the next sequence numbers.
+ *    The station picks a new boot ID at random every time it boots and counts its samples from 0 again, so the server skips a sample it already has by its boot ID and sequence number.
+ *  - The samples as a stream of "DM_Codec.h": the timestamp, the Unix time and the fixed-point values of "DM_PackedSample" (1/100 °C, 1/100 Pa, scaled lux).
+ * A decoder refuses a version or schema it doesn't know, so the format can change without a station and a server misreading each other.
+ * In a batch of 32 samples a sample takes about 7 bytes, a sixth of "field1=..&field2=..&field3=.." (see "ingest --payloads" in "tools/ingest").
+ */
+
+// DECLARE THE CLASS "DM_PayloadEncoder"
+class DM_PayloadEncoder
+{
+public: // The public functions and constants
+    static const uint8_t version = 2;               // The version of the format this encoder writes (2 added the boot ID)
+    static const uint8_t schemaPackedSample = 1;    // The schema of the samples: "DM_PackedSample" (temperature, air pressure, light intensity)
+    static const size_t maxHeaderSize = 18;         // The most bytes the header can take (3 bytes and 3 varints of at most 5 bytes)
+    static const size_t maxSamplesPerPayload = 255; // The most samples one payload can carry (the amount is one byte)
+
+    DM_PayloadEncoder();
+    bool begin(uint8_t *buffer, size_t capacity, uint32_t stationID, uint32_t bootID, uint32_t sequence);
+    bool add(const DM_PackedSample &sample, uint32_t epochSeconds);
+    size_t getLength() const;
+    uint32_t getAmount() const;
+
+private: // The private members
+    uint8_t *_buffer;     // The buffer the payload is written to
+    size_t _headerLength; // The length of the header
+    DM_Encoder _encoder;  // Writes the samples behind the header
+};
+
+// DECLARE THE CLASS "DM_PayloadDecoder"
+class DM_PayloadDecoder
+{
+public: // The public functions
+    DM_PayloadDecoder();
+    bool begin(const uint8_t *buffer, size_t length);
+    uint32_t getStationID() const;
+    uint32_t getBootID() const;
+    uint32_t getSequence() const;
+    uint32_t getAmount() const;
+    bool next(DM_PackedSample &sample, uint32_t &epochSeconds);
+
+private: // The private members
+    uint32_t _stationID; // The station ID in the header
+    uint32_t _bootID;    // The boot ID in the header
+    uint32_t _sequence;  // The sequence number of the first sample
+    uint32_t _amount;    // The amount of samples
+    DM_Decoder _decoder; // Reads the samples behind the header
+};
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,69 @@
+/** +----------------------------------------------+
+ *  |      DM_Power - Deep-sleep duty cycling      |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef DM_Power_h
+#define DM_Power_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h>    // Used to be able to use the "size_t" type
+#include <stdint.h>    // Used to be able to use the fixed width integer types
+#include <DM_Sample.h> // Used to be able to use "DM_Sample" and "DM_PackedSample" as types
+
+// DECLARE THE STRUCT "DM_PowerState" (everything that has to survive a deep sleep, it is kept in RTC slow memory)
+struct DM_PowerState
+{
+    static constexpr size_t maxAmountOfSamples = 100; // The amount of samples kept in RTC memory (16 bytes each, the RTC slow memory holds 8 KB; one ThingSpeak bulk update takes at most 100)
+
+    uint32_t magic;                              // Tells a valid state apart from the content after a power-on (or the state of another firmware)
+    uint32_t amountOfWakes;                      // The amount of wakes since the first boot
+    uint32_t stationMsAtSleep;                   // The station clock when the last deep sleep started
+    int64_t sleepStartUs;                        // The system clock (kept by the RTC during deep sleep) when the last deep sleep started
+    uint32_t plannedSleepMs;                     // The length of the last deep sleep
+    uint32_t nextSampleMs;                       // The moment (on the station clock) the next sample is due
+    uint32_t hourStartMs;                        // The moment (on the station clock) the current hour started
+    uint32_t awakeMsThisHour;                    // The time spent awake in the current hour (light sleep not included)
+    uint32_t awakeMsLastHour;                    // The time spent awake in the last complete hour
+    uint32_t awakeMsCompleteHours;               // The time spent awake in all complete hours (for the average)
+    uint32_t amountOfHours;                      // The amount of complete hours
+    uint32_t lastWakeToSampleMs;                 // The time from the last wake (the moment the RTC timer fired) until its sample was taken
+    uint32_t totalWakeToSampleMs;                // The sum of all wake-to-sample times (for the average)
+    uint32_t amountOfSamples;                    // The amount of samples in "samples"
+    DM_PackedSample samples[maxAmountOfSamples]; // The samples that are waiting for the radio
+    uint32_t epochSeconds[maxAmountOfSamples];   // The Unix time of every sample (0 if the clock was not synchronized yet)
+};
+
+/**
+ * Duty cycling for the low-power mode (build with "DM_LOW_POWER", see "platformio.ini"): the station wakes from deep sleep for every sample, keeps the samples in RTC memory
+ * and only turns on the radio when a batch is full or the oldest sample waited too long. The station clock ("getStationMs()") keeps counting during deep sleep, "millis()" starts over on every wake.
+ */
+class DM_Power
+{
+public: // The public functions
+    static bool begin();
+    static bool isResumed();
+    static uint32_t getStationMs();
+    static void sampleTaken();
+    static bool bufferSample(const DM_Sample &sample);
+    static size_t getAmountOfBufferedSamples();
+    static size_t readBufferedSamples(DM_Sample *samples, size_t maxAmount);
+    static void clearBufferedSamples();
+    static bool isUplinkDue(size_t batchSize, uint32_t maxLatencyMs);
+    static void lightSleep(uint32_t durationMs);
+    static void deepSleepUntilNextSample(uint32_t samplePeriodMs);
+    static void printStatistics();
+
+private: // The private members
+    static DM_PowerState _state;
+    static bool _resumed;
+    static uint32_t _stationOffsetMs;
+    static uint32_t _wakeStationMs;
+    static uint32_t _lightSleptMs;
+    static int64_t _systemClockUs();
+};
+
+#endif // End the header guard
\ No newline at end of file
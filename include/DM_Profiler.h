@@ -0,0 +1,125 @@
+/** +----------------------------------------------+
+ *  |    DM_Profiler - Latency of the hot paths    |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef DM_Profiler_h
+#define DM_Profiler_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h> // Used to be able to use the "size_t" type
+#include <stdint.h> // Used to be able to use the fixed width integer types
+#include <atomic>   // Used to count the latencies from several tasks (and both cores) without a lock
+#ifdef ARDUINO
+#include <Arduino.h> // Used to read the cycle counter of the core ("ESP.getCycleCount()")
+#else
+#include <chrono> // Used as the clock of a native build (there is no cycle counter to read)
+#endif
+
+// DECLARE THE ENUM "DM_Stage" (the hot paths that are measured)
+enum DM_Stage : uint8_t
+{
+    DM_STAGE_I2C_BMP280,     // One transaction with the BMP280 on the I2C bus
+    DM_STAGE_I2C_BH1750,     // Starting or collecting one conversion of the BH1750
+    DM_STAGE_MQTT_PUBLISH,   // Publishing one message to ThingSpeak over MQTT
+    DM_STAGE_BULK_UPDATE,    // Sending one bulk update to ThingSpeak over HTTP
+    DM_STAGE_DISCORD_POST,   // Posting one message to the Discord webhook
+    DM_STAGE_WIFI_CONNECT,   // One connection to Wi-Fi, from the start of the attempt to the IP address
+    DM_STAGE_MQTT_CONNECT,   // One connection attempt to the MQTT broker of ThingSpeak
+    DM_STAGE_SERIAL_PRINT,   // Printing one log message on the serial monitor (by the log task)
+    DM_STAGE_ENCODE_PAYLOAD, // Writing the payload of one message to the MQTT broker of our own (JSON or binary, see "DM_MQTTSink")
+    DM_STAGE_FILTER,         // Filtering one burst of readings of one value (median, spike check and moving average, see "DM_Filter")
+    DM_AMOUNT_OF_STAGES      // The amount of stages (not a stage)
+};
+
+/**
+ * Keeps a log-linear latency histogram per stage: every power of two is split in "subBuckets" equal parts, so every latency from 1 µs to 71 minutes is kept with an error of at most 25 %, in 124 counters.
+ *
+ * A probe reads the cycle counter of the core when the scope starts and when it ends (a few instructions), record() turns the difference into a bucket and counts it with two atomic increments (well below a microsecond at 240 MHz).
+ * The cycle counter wraps after about 17 seconds at 240 MHz, so longer stages (like connecting to Wi-Fi) are measured with "micros()" and handed to recordMicroseconds().
+ * Every core has its own cycle counter: a probe is only correct in a task that is pinned to one core (every task of the station is).
+ *
+ * The probes only exist when the station is built with "-D DM_PROFILING" (see "platformio.ini"), otherwise the macros are empty and nothing is kept.
+ * In a native build (without "ARDUINO") the same probes use the steady clock of the computer, so they also work against the mocked drivers.
+ */
+class DM_Profiler
+{
+public: // The public functions and constants
+    static constexpr uint8_t subBucketBits = 2;                                                 // The amount of bits below the highest one that choose the bucket within a power of two
+    static constexpr size_t subBuckets = 1 << subBucketBits;                                    // The amount of buckets per power of two
+    static constexpr size_t amountOfBuckets = (32 - subBucketBits + 1) * subBuckets;            // The amount of buckets to hold every 32-bit latency in microseconds
+    static constexpr uint32_t defaultTicksPerMicrosecond = 240;                                 // The cycles per microsecond until begin() read the clock of the CPU
+    static constexpr uint16_t percentiles[] = {500, 900, 990};                                  // The percentiles (in per mille) that are shown in the report and on "/metrics"
+    static constexpr size_t amountOfPercentiles = sizeof(percentiles) / sizeof(percentiles[0]); // The amount of percentiles
+
+    /**
+     * Read the clock the probes use (only the difference between two readings on the same core has a meaning).
+     *
+     * @return The cycle counter of the core (or the microseconds of the steady clock in a native build).
+     */
+    static inline uint32_t now()
+    {
+#ifdef ARDUINO
+        return ESP.getCycleCount();
+#else
+        return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    static void begin();
+    static void record(DM_Stage stage, uint32_t ticks);
+    static void recordMicroseconds(DM_Stage stage, uint32_t latencyUs);
+    static const char *getStageName(DM_Stage stage);
+    static uint32_t getAmountOfSamples(DM_Stage stage);
+    static uint32_t getPercentileMicroseconds(DM_Stage stage, uint16_t perMille);
+    static uint32_t getMaximumMicroseconds(DM_Stage stage);
+    static void printReport();
+
+private: // The private functions and members
+    struct _Histogram
+    {
+        std::atomic<uint32_t> buckets[amountOfBuckets]; // The amount of latencies per bucket
+        std::atomic<uint32_t> amount;                   // The amount of latencies
+        std::atomic<uint32_t> maximumUs;                // The highest latency
+    };
+    static _Histogram _histograms[DM_AMOUNT_OF_STAGES];
+    static uint32_t _ticksPerMicrosecond;
+    static size_t _getBucket(uint32_t latencyUs);
+    static uint64_t _getBucketLowerBound(size_t bucket);
+};
+
+/**
+ * Measures the time until the end of the scope it is created in and records it for its stage (use "DM_PROFILE_SCOPE()" instead of creating one yourself, so it disappears when profiling is off).
+ */
+class DM_ProfileScope
+{
+public: // The public functions
+    explicit DM_ProfileScope(DM_Stage stage) : _stage(stage), _startTicks(DM_Profiler::now()) {}
+    ~DM_ProfileScope() { DM_Profiler::record(_stage, DM_Profiler::now() - _startTicks); }
+
+private: // The private members
+    DM_Stage _stage;      // The stage the time is recorded for
+    uint32_t _startTicks; // The clock when the scope started
+};
+
+// DECLARE THE PROBES (they are empty statements when the station is built without "-D DM_PROFILING")
+#ifdef DM_PROFILING
+#define DM_PROFILE_NAME_(line) _profileScope##line
+#define DM_PROFILE_NAME(line) DM_PROFILE_NAME_(line)
+#define DM_PROFILE_SCOPE(stage) DM_ProfileScope DM_PROFILE_NAME(__LINE__)(stage)
+#define DM_PROFILE_MICROSECONDS(stage, latencyUs) DM_Profiler::recordMicroseconds(stage, latencyUs)
+#else
+#define DM_PROFILE_SCOPE(stage) \
+    do                          \
+    {                           \
+    } while (0)
+#define DM_PROFILE_MICROSECONDS(stage, latencyUs) \
+    do                                            \
+    {                                             \
+    } while (0)
+#endif
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,61 @@
+/** +----------------------------------------------+
+ *  |   DM_Reporting - Deadband reporting policy   |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef DM_Reporting_h
+#define DM_Reporting_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h>        // Used to be able to use the "size_t" type
+#include <stdint.h>        // Used to be able to use the fixed width integer types
+#include <DM_Sample.h>     // Used to be able to use "DM_Field" as a type for an argument
+#include <DM_Statistics.h> // Used to be able to use "DM_WindowSummary" as a type for an argument
+
+// DECLARE THE ENUM "DM_ReportingDecision" (what to do with a window summary)
+enum DM_ReportingDecision
+{
+    DM_REPORT_SUPPRESS,  // Every value stayed within its deadband, nothing is sent
+    DM_REPORT_CHANGED,   // At least one value left its deadband
+    DM_REPORT_HEARTBEAT, // Nothing changed, but the last publish is too long ago
+};
+
+/**
+ * Decides which window summaries are worth sending. A summary is only sent when one of its values moved more than its deadband (see "DM_Field") away from the last value that was sent,
+ * or when nothing has been sent for the length of a heartbeat. When a value changes faster than its "fastChangePerMinute", the policy asks for fast reporting (shorter windows) until every value is calm again.
+ */
+class DM_ReportingPolicy
+{
+public: // The public functions
+    DM_ReportingPolicy(const DM_Field *fields, size_t amountOfFields);
+    void configure(uint32_t heartbeatMs, uint32_t fastReportingHoldMs);
+    DM_ReportingDecision evaluate(const DM_WindowSummary &summary);
+    bool isFastReporting() const;
+    uint32_t getAmountOfPublishes() const;
+    uint32_t getAmountOfHeartbeats() const;
+    uint32_t getAmountOfSuppressed() const;
+    void printStatistics() const;
+
+private: // The private functions and members
+    const DM_Field *_fields;                                   // The values of a summary that are checked
+    size_t _amountOfFields;                                    // The amount of values that are checked
+    uint32_t _heartbeatMs;                                     // The longest time without a publish
+    uint32_t _fastReportingHoldMs;                             // The time every value has to stay calm before fast reporting stops
+    bool _published;                                           // If a summary has been published since boot
+    uint32_t _lastPublishMs;                                   // The end of the last summary that was published
+    float _lastPublished[DM_WindowSummary::maxAmountOfFields]; // The means of the last summary that was published
+    bool _hasPrevious;                                         // If a summary has been evaluated before
+    uint32_t _previousEndMs;                                   // The end of the previous summary
+    float _previous[DM_WindowSummary::maxAmountOfFields];      // The means of the previous summary
+    bool _fastReporting;                                       // If the values are changing fast
+    uint32_t _lastFastChangeMs;                                // The end of the last summary with a fast change
+    uint32_t _amountOfPublishes;                               // The amount of summaries that were worth sending (including the heartbeats)
+    uint32_t _amountOfHeartbeats;                              // The amount of summaries that were only sent as a heartbeat
+    uint32_t _amountOfSuppressed;                              // The amount of summaries that were not sent
+    static bool _hasChanged(float value, float reference, float deadband);
+};
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,236 @@
+/** +----------------------------------------------+
+ *  |       DM_RingBuffer - Lock-free queues       |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef DM_RingBuffer_h
+#define DM_RingBuffer_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h> // Used to be able to use the "size_t" type
+#include <stdint.h> // Used to be able to use the fixed width integer types
+#include <atomic>   // Used to share the read and write positions between tasks without a lock
+
+/**
+ * A single-producer/single-consumer ring buffer that never blocks and never takes a lock.
+ *
+ * Exactly one task may call push() and exactly one (other) task may call pop(). The positions are free running counters, so the capacity has to be a power of two.
+ * When the buffer is full, the newest item is dropped and counted as an overrun (the producer is never allowed to touch the read position).
+ */
+template <typename T, size_t Capacity>
+class DM_RingBuffer
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "The capacity of a DM_RingBuffer must be a power of two");
+
+public: // The public functions
+    DM_RingBuffer() : _head(0), _tail(0), _overruns(0), _highWaterMark(0) {}
+
+    /**
+     * Add an item to the buffer (only call this from the producer task).
+     *
+     * @param item The item to add.
+     *
+     * @return False if the buffer was full and the item has been dropped.
+     */
+    bool push(const T &item)
+    {
+        // Only the producer writes the head, so a relaxed load is enough; the tail needs "acquire" to see the slots the consumer released
+        size_t head = _head.load(std::memory_order_relaxed);
+        size_t depth = head - _tail.load(std::memory_order_acquire);
+
+        // Drop the item and count the overrun if the buffer is full
+        if (depth >= Capacity)
+        {
+            _overruns.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        // Store the item and publish it to the consumer ("release" makes the item visible before the new head)
+        _items[head & (Capacity - 1)] = item;
+        _head.store(head + 1, std::memory_order_release);
+
+        // Keep track of the deepest the buffer has ever been
+        if (depth + 1 > _highWaterMark.load(std::memory_order_relaxed))
+            _highWaterMark.store(depth + 1, std::memory_order_relaxed);
+
+        // Return the success rate
+        return true;
+    }
+
+    /**
+     * Take the oldest item out of the buffer (only call this from the consumer task).
+     *
+     * @param item The variable the item will be copied into.
+     *
+     * @return False if the buffer was empty.
+     */
+    bool pop(T &item)
+    {
+        // Only the consumer writes the tail, so a relaxed load is enough; the head needs "acquire" to see the item the producer stored
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire))
+            return false;
+
+        // Copy the item and hand the slot back to the producer
+        item = _items[tail & (Capacity - 1)];
+        _tail.store(tail + 1, std::memory_order_release);
+
+        // Return the success rate
+        return true;
+    }
+
+    /**
+     * Get the amount of items that are waiting in the buffer.
+     *
+     * @return The current depth of the buffer.
+     */
+    size_t getDepth() const
+    {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Get the maximum amount of items the buffer can hold.
+     *
+     * @return The capacity of the buffer.
+     */
+    size_t getCapacity() const
+    {
+        return Capacity;
+    }
+
+    /**
+     * Get the amount of items that have been dropped because the buffer was full.
+     *
+     * @return The amount of overruns.
+     */
+    uint32_t getOverruns() const
+    {
+        return _overruns.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Get the highest depth the buffer has reached since boot.
+     *
+     * @return The high-water mark of the buffer.
+     */
+    size_t getHighWaterMark() const
+    {
+        return _highWaterMark.load(std::memory_order_relaxed);
+    }
+
+private: // The private members
+    T _items[Capacity];                 // The slots of the buffer
+    std::atomic<size_t> _head;          // The amount of items ever pushed (only written by the producer)
+    std::atomic<size_t> _tail;          // The amount of items ever popped (only written by the consumer)
+    std::atomic<uint32_t> _overruns;    // The amount of items dropped because the buffer was full
+    std::atomic<size_t> _highWaterMark; // The highest depth the buffer has reached
+};
+
+/**
+ * A multi-producer/single-consumer ring buffer that never blocks and never takes a lock (a bounded queue with a sequence number per slot).
+ *
+ * Any task may call push() at the same time, but only one task may call pop(). A producer claims a slot by moving the head forward with a compare-and-swap, fills it in place and then publishes it through the sequence number of the slot.
+ * When the buffer is full, the newest item is dropped and counted as an overrun. A slot that is claimed but not filled yet holds up the consumer until its producer is done (pop() returns false in the meantime).
+ */
+template <typename T, size_t Capacity>
+class DM_MPSCRingBuffer
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "The capacity of a DM_MPSCRingBuffer must be a power of two");
+
+public: // The public functions
+    DM_MPSCRingBuffer() : _head(0), _tail(0), _overruns(0)
+    {
+        for (size_t i = 0; i < Capacity; i++)
+            _sequences[i].store(i, std::memory_order_relaxed);
+    }
+
+    /**
+     * Claim a slot and let the caller fill it in place (may be called from any task, but not from an interrupt).
+     *
+     * @param write A function that fills the slot it gets (e.g. a lambda that formats a message into it).
+     *
+     * @return False if the buffer was full and nothing has been written.
+     */
+    template <typename Writer>
+    bool push(Writer write)
+    {
+        // Claim the slot at the head: it is free when its sequence number equals the head, and still unread by the consumer when it is lower
+        size_t head = _head.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            intptr_t difference = (intptr_t)_sequences[head & (Capacity - 1)].load(std::memory_order_acquire) - (intptr_t)head;
+            if (difference == 0)
+            {
+                if (_head.compare_exchange_weak(head, head + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (difference < 0)
+            {
+                _overruns.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            else
+                head = _head.load(std::memory_order_relaxed);
+        }
+
+        // Fill the slot and publish it to the consumer ("release" makes the item visible before the sequence number)
+        write(_items[head & (Capacity - 1)]);
+        _sequences[head & (Capacity - 1)].store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Let the caller read the oldest item in place and hand its slot back to the producers (only call this from the consumer task).
+     *
+     * @param read A function that reads the slot it gets.
+     *
+     * @return False if the buffer was empty (or the oldest slot is still being filled).
+     */
+    template <typename Reader>
+    bool pop(Reader read)
+    {
+        // The oldest slot is ready when its producer published it
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        if (_sequences[tail & (Capacity - 1)].load(std::memory_order_acquire) != tail + 1)
+            return false;
+
+        // Read the item and free the slot for the producer that comes around the buffer next time
+        read(_items[tail & (Capacity - 1)]);
+        _sequences[tail & (Capacity - 1)].store(tail + Capacity, std::memory_order_release);
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Get the amount of items that are waiting in the buffer (including the ones that are still being filled).
+     *
+     * @return The current depth of the buffer.
+     */
+    size_t getDepth() const
+    {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Get the amount of items that have been dropped because the buffer was full.
+     *
+     * @return The amount of overruns.
+     */
+    uint32_t getOverruns() const
+    {
+        return _overruns.load(std::memory_order_relaxed);
+    }
+
+private: // The private members
+    T _items[Capacity];                       // The slots of the buffer
+    std::atomic<size_t> _sequences[Capacity]; // The sequence number of every slot (its position when it is free, its position + 1 when it holds an item)
+    std::atomic<size_t> _head;                // The amount of slots ever claimed by the producers
+    std::atomic<size_t> _tail;                // The amount of items ever popped (only written by the consumer)
+    std::atomic<uint32_t> _overruns;          // The amount of items dropped because the buffer was full
+};
+
+#endif // End the header guard
\ No newline at end of file
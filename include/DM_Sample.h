@@ -0,0 +1,55 @@
+/** +----------------------------------------------+
+ *  |     DM_Sample - Timestamped measurement      |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef DM_Sample_h
+#define DM_Sample_h
+
+// IMPORT THE NECESSARY LIBRARY
+#include <stdint.h> // Used to be able to use the fixed width integer types
+
+// DECLARE THE STRUCT "DM_Sample"
+struct DM_Sample
+{
+    uint32_t timestampMs;    // The moment (in milliseconds since boot) the sample was taken
+    uint32_t epochSeconds;   // The moment (in Unix time) the sample was taken, 0 if the clock was not synchronized yet
+    float temperatureC;      // The temperature in degrees Celsius
+    float lightIntensityLux; // The light intensity in lux
+    float airPressurePa;     // The air pressure in Pascal
+    float airPressureBar;    // The air pressure in bar
+};
+
+// DECLARE THE STRUCT "DM_PackedSample" (a sample in fixed-point, 12 bytes instead of the 24 bytes of "DM_Sample", converted in "DM_Sample.cpp" without any Arduino or FreeRTOS library, so the ingest server uses the same code)
+struct DM_PackedSample
+{
+    static const uint32_t airPressureBasePa = 30000;          // The lowest air pressure the BMP280 can measure (300 hPa), the packed pressure is stored above it
+    static const int16_t invalidTemperature = INT16_MIN;      // The packed temperature of a failed reading
+    static const uint32_t invalidAirPressure = UINT32_MAX;    // The packed air pressure of a failed reading
+    static const uint16_t invalidLightIntensity = UINT16_MAX; // The packed light intensity of a failed reading
+
+    uint32_t timestampMs;    // The moment (in milliseconds since boot) the sample was taken
+    uint32_t airPressure;    // The air pressure in 1/100 Pa above 300 hPa (the lowest air pressure the BMP280 can measure)
+    int16_t temperature;     // The temperature in 1/100 °C
+    uint16_t lightIntensity; // The light intensity, scaled (see "pack()")
+
+    static DM_PackedSample pack(const DM_Sample &sample);
+    static DM_Sample unpack(const DM_PackedSample &packed);
+};
+static_assert(sizeof(DM_PackedSample) <= 12, "A packed sample has to fit in 12 bytes");
+
+// DECLARE THE STRUCT "DM_Field" (describes one value of a sample, the payload builders loop over these instead of naming every value themselves)
+struct DM_Field
+{
+    const char *name;          // The readable name of the value (e.g. "Temperature")
+    const char *unit;          // The unit of the value (e.g. "°C")
+    float DM_Sample::*member;  // The member of "DM_Sample" that holds the value
+    uint8_t thingSpeakField;   // The number of the ThingSpeak field the value is sent to (1 to 8, 0 if it is not sent)
+    float deadband;            // The smallest change of the value that is worth a publish (see "DM_ReportingPolicy")
+    float fastChangePerMinute; // The change per minute above which the value is reported faster (e.g. a passing front or clouds)
+};
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,187 @@
+/** +----------------------------------------------+
+ *  | DM_SensorSet - Compile-time sensor registry  |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef DM_SensorSet_h
+#define DM_SensorSet_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <Arduino.h>   // Used to read the time since boot ("millis()")
+#include <stddef.h>    // Used to be able to use the "size_t" type
+#include <stdint.h>    // Used to be able to use the fixed width integer types
+#include <tuple>       // Used to store the sensors next to each other (each with its own type)
+#include <type_traits> // Used to get the type of a sensor inside a loop over the sensors
+#include <utility>     // Used to loop over the sensors at compile time ("std::index_sequence")
+#include <DM_Filter.h> // Used to check the burst size of every sensor against the largest burst a filter takes
+#include <DM_Sample.h> // Used to be able to use "DM_Sample" and "DM_Field" as types
+
+/**
+ * A fixed set of sensors, each measured at its own rate. The set is resolved at compile time: every call to a sensor is a direct call to its class (no virtual functions).
+ * Adding a sensor means writing its class (see "DM_Sensors.h") and adding it to the list of template parameters, the payloads follow from its "fields".
+ */
+template <typename... Sensors>
+class DM_SensorSet
+{
+public: // The public functions and constants
+    static constexpr size_t amountOfSensors = sizeof...(Sensors);                                                // The amount of sensors in the set
+    static constexpr size_t amountOfFields = (0 + ... + (sizeof(Sensors::fields) / sizeof(Sensors::fields[0]))); // The amount of values all sensors together fill in
+
+    DM_SensorSet(Sensors &...sensors) : _sensors(sensors...), _amountOfFields(0)
+    {
+        // Gather the fields of every sensor in one table (this is what the payload builders loop over)
+        _forEachSensor([this](auto &sensor, size_t index)
+                       {
+                           for (const DM_Field &field : sensor.fields)
+                               _fields[_amountOfFields++] = field;
+                           _nextMeasurementMs[index] = 0;
+                           _converting[index] = false;
+                           _burstReadings[index] = 0;
+                       });
+    }
+
+    /**
+     * Initialize every sensor (all of them are initialized, even when one fails).
+     *
+     * @return True if every sensor was initialized successfully.
+     */
+    bool begin()
+    {
+        bool success = true;
+        _forEachSensor([&success](auto &sensor, size_t)
+                       { success = sensor.begin() && success; });
+        return success;
+    }
+
+    /**
+     * Get every sensor ready again after a deep sleep, instead of initializing them completely (see "DM_Power.h"). Every sensor is due right away, because "millis()" starts over on every wake.
+     *
+     * @return True if every sensor was resumed successfully.
+     */
+    bool resume()
+    {
+        bool success = true;
+        _forEachSensor([this, &success](auto &sensor, size_t index)
+                       {
+                           success = sensor.resume() && success;
+                           _nextMeasurementMs[index] = 0;
+                           _converting[index] = false;
+                           _burstReadings[index] = 0;
+                       });
+        return success;
+    }
+
+    /**
+     * Move the measurements forward: start the conversions of the sensors that are due, and collect the ones that are finished (this never waits).
+     * A measurement is a burst of "burstSize" conversions back to back: every finished conversion is read and the next one started, the sensor fills in its values once the burst is complete.
+     *
+     * @param sample The sample the collected values are written into (values of sensors that are not due keep their last value).
+     *
+     * @return The time (in milliseconds) until something needs to be done again.
+     */
+    uint32_t service(DM_Sample &sample)
+    {
+        // Start all due conversions first, so they run next to each other
+        uint32_t now = millis();
+        _forEachSensor([this, now](auto &sensor, size_t index)
+                       {
+                           if (!_converting[index] && (int32_t)(now - _nextMeasurementMs[index]) >= 0)
+                           {
+                               sensor.startConversion();
+                               _converting[index] = true;
+                           }
+                       });
+
+        // Read the finished conversions, start the next conversion of a burst, and collect the complete bursts and plan the next measurement of those sensors (at a fixed rate, a late measurement doesn't shift the ones after it)
+        uint32_t waitMs = UINT32_MAX;
+        _forEachSensor([this, &sample, &waitMs, now](auto &sensor, size_t index)
+                       {
+                           using Sensor = typename std::remove_reference<decltype(sensor)>::type;
+                           static_assert(Sensor::burstSize >= 1 && Sensor::burstSize <= DM_Filter::maxBurstSize, "The burst of a sensor must hold 1 to DM_Filter::maxBurstSize conversions");
+                           if (_converting[index] && sensor.isConversionReady())
+                           {
+                               sensor.readConversion();
+                               if (++_burstReadings[index] < Sensor::burstSize)
+                                   sensor.startConversion();
+                               else
+                               {
+                                   sensor.collect(sample);
+                                   _burstReadings[index] = 0;
+                                   _converting[index] = false;
+                                   _nextMeasurementMs[index] = (int32_t)(now - _nextMeasurementMs[index]) >= (int32_t)Sensor::samplePeriodMs ? now + Sensor::samplePeriodMs : _nextMeasurementMs[index] + Sensor::samplePeriodMs;
+                               }
+                           }
+                           uint32_t sensorWaitMs = _converting[index] ? conversionPollPeriodMs : (int32_t)(_nextMeasurementMs[index] - now) > 0 ? _nextMeasurementMs[index] - now : 0;
+                           waitMs = sensorWaitMs < waitMs ? sensorWaitMs : waitMs;
+                       });
+
+        // Return how long the caller may sleep
+        return waitMs;
+    }
+
+    /**
+     * Check if a conversion is still running (a sample should not be taken in the middle of one, or in the middle of a burst).
+     *
+     * @return True if at least one sensor is converting.
+     */
+    bool isConverting() const
+    {
+        for (size_t i = 0; i < amountOfSensors; i++)
+            if (_converting[i])
+                return true;
+        return false;
+    }
+
+    /**
+     * Get one of the sensors (resolved at compile time).
+     *
+     * @return A reference to the sensor.
+     */
+    template <size_t Index>
+    auto &get()
+    {
+        return std::get<Index>(_sensors);
+    }
+
+    /**
+     * Get the fields of all sensors together (in the order of the sensors).
+     *
+     * @return The table of fields ("amountOfFields" long).
+     */
+    const DM_Field *getFields() const
+    {
+        return _fields;
+    }
+
+private: // The private functions and members
+    static constexpr uint32_t conversionPollPeriodMs = 10; // The time between two checks if a conversion is finished
+
+    std::tuple<Sensors &...> _sensors;            // The sensors
+    DM_Field _fields[amountOfFields];             // The fields of all sensors together
+    size_t _amountOfFields;                       // The amount of fields that have been gathered (only used while building the table)
+    uint32_t _nextMeasurementMs[amountOfSensors]; // The moment the next measurement of every sensor is due
+    bool _converting[amountOfSensors];            // If a conversion of every sensor is running
+    uint8_t _burstReadings[amountOfSensors];      // The amount of conversions of the running burst of every sensor that have been read
+
+    /**
+     * Call a function for every sensor (unrolled at compile time).
+     *
+     * @param function The function to call with the sensor and its index.
+     */
+    template <typename Function>
+    void _forEachSensor(Function function)
+    {
+        _forEachSensor(function, std::index_sequence_for<Sensors...>{});
+    }
+
+    template <typename Function, size_t... Indexes>
+    void _forEachSensor(Function &function, std::index_sequence<Indexes...>)
+    {
+        (function(std::get<Indexes>(_sensors), Indexes), ...);
+    }
+};
+
+#endif // End the header guard
\ No newline at end of file
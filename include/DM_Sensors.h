@@ -0,0 +1,88 @@
+/** +----------------------------------------------+
+ *  |     DM_Sensors - Sensors of the station      |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef DM_Sensors_h
+#define DM_Sensors_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h>          // Used to be able to use the "size_t" type
+#include <stdint.h>          // Used to be able to use the fixed width integer types
+#include <Adafruit_BMP280.h> // Used to be able to use "Adafruit_BMP280" as a type for an argument
+#include <BH1750.h>          // Used to be able to use "BH1750" as a type for an argument
+#include <DM_Filter.h>       // Used to filter the bursts of readings of every value
+#include <DM_Measurer.h>     // Used to be able to use "DM_BMP280Snapshot" as a type
+#include <DM_Sample.h>       // Used to be able to use "DM_Sample" and "DM_Field" as types
+
+/**
+ * Every sensor that is added to a "DM_SensorSet" looks like the ones below:
+ *  - "samplePeriodMs": the time between two measurements of this sensor.
+ *  - "burstSize": the amount of conversions one measurement takes back to back (1 to "DM_Filter::maxBurstSize"), so a single glitched reading never reaches the sinks.
+ *  - "fields": the values of "DM_Sample" this sensor fills in (the ThingSpeak field they are sent to, and when they are worth reporting).
+ *  - begin(), startConversion(), isConversionReady() and readConversion(): one conversion is split in two, so the conversions of different sensors overlap.
+ *  - collect(sample): filter the readings of the burst (see "DM_Filter.h") and fill in the values of this sensor in the sample.
+ *  - resume(): get the sensor ready again after a deep sleep, with as little work as possible (the chips stay powered, see "DM_Power.h").
+ *    The state of the filters is kept in RTC memory (saved by every collect()), so the spike check still knows the readings of the wakes before.
+ */
+
+// DECLARE THE CLASS "DM_BMP280Sensor"
+class DM_BMP280Sensor
+{
+public: // The public functions and constants
+    static constexpr uint32_t samplePeriodMs = 1000; // Measured every second (a forced conversion takes 44 ms), the statistics summarize the readings per window
+    static constexpr uint8_t burstSize = 5;          // Five forced conversions per measurement (220 ms), the median removes a glitch of the chip or the bus
+    static constexpr DM_Field fields[] = {
+        {"Temperature", "°C", &DM_Sample::temperatureC, 1, 0.1, 0.3}, // The temperature is sent to field 1 (reported on a change of 0.1 °C, faster above 0.3 °C per minute)
+        {"Air pressure", "Pa", &DM_Sample::airPressurePa, 3, 10, 10}, // The air pressure is sent to field 3 (reported on a change of 0.1 hPa, faster above 0.1 hPa per minute)
+    };
+
+    DM_BMP280Sensor(Adafruit_BMP280 &measurementChip);
+    bool begin();
+    bool resume();
+    bool startConversion();
+    bool isConversionReady();
+    void readConversion();
+    void collect(DM_Sample &sample);
+    const DM_BMP280Snapshot &getLastSnapshot() const;
+    uint32_t getAmountOfSpikes() const;
+
+private: // The private members
+    Adafruit_BMP280 &_measurementChip;             // The chip object (only used to initialize the chip, the measurements are read directly)
+    DM_BMP280Snapshot _lastSnapshot;               // The last measurement (including what it cost on the I2C bus)
+    DM_Filter _temperatureFilter;                  // Filters the temperatures of a burst (a moving average of 1/4 in steps of 0.01 °C, a spike lies 5 MADs and at least 0.5 °C away)
+    DM_Filter _pressureFilter;                     // Filters the air pressures of a burst (a moving average of 1/4 in steps of 1 Pa, a spike lies 5 MADs and at least 50 Pa away)
+    static DM_FilterState _savedTemperatureFilter; // The state of the temperature filter, kept in RTC memory during a deep sleep (there is one BMP280 on the bus)
+    static DM_FilterState _savedPressureFilter;    // The state of the air pressure filter, kept in RTC memory during a deep sleep
+};
+
+// DECLARE THE CLASS "DM_BH1750Sensor"
+class DM_BH1750Sensor
+{
+public: // The public functions and constants
+    static constexpr uint32_t samplePeriodMs = 1000; // Measured every second (a conversion takes up to 663 ms at the longest measurement time), the statistics summarize the readings per window
+    static constexpr uint8_t burstSize = 3;          // Three conversions per measurement (360 ms in daylight, in the dark the long measurement time stretches the burst beyond the sample period)
+    static constexpr DM_Field fields[] = {
+        {"Light intensity", "lux", &DM_Sample::lightIntensityLux, 2, 20, 2000}, // The light intensity is sent to field 2 (reported on a change of 20 lux, faster above 2000 lux per minute)
+    };
+
+    DM_BH1750Sensor(BH1750 &measurementChip);
+    bool begin();
+    bool resume();
+    bool startConversion();
+    bool isConversionReady();
+    void readConversion();
+    void collect(DM_Sample &sample);
+    uint32_t getAmountOfSpikes() const;
+
+private: // The private members
+    BH1750 &_measurementChip;                // The chip object
+    bool _conversionStarted;                 // If a conversion has been started successfully (otherwise there is nothing to wait for)
+    DM_Filter _lightFilter;                  // Filters the light intensities of a burst (no moving average, clouds change the light within seconds; a spike lies 5 MADs and at least 5 % of the rolling median or 2 lux away)
+    static DM_FilterState _savedLightFilter; // The state of the light intensity filter, kept in RTC memory during a deep sleep (there is one BH1750 on the bus)
+};
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,86 @@
+/** +----------------------------------------------+
+ *  |    DM_Sink - Fan-out of the measurements     |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef DM_Sink_h
+#define DM_Sink_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h>            // Used to be able to use the "size_t" type
+#include <stdint.h>            // Used to be able to use the fixed width integer types
+#include <freertos/FreeRTOS.h> // Used to be able to use the FreeRTOS types
+#include <freertos/task.h>     // Used to give every sink its own task
+#include <DM_RingBuffer.h>     // Used as the lock-free queue between the uplink task and the task of the sink
+#include <DM_Sample.h>         // Used to be able to use "DM_Sample" as a type for an argument
+
+/**
+ * A destination of the measurements (ThingSpeak, Discord, InfluxDB, an MQTT broker, ...), see "DM_Sinks.h".
+ *
+ * Every sink runs in its own task, with its own queue and its own batch policy: offer() only copies the measurement into the queue of the sink, so a slow or dead sink never holds up the sampling or the other sinks.
+ * When the queue of a sink is full (backpressure), the newest measurement is dropped and counted for that sink only.
+ * A sink only has to implement how a batch is delivered, and optionally:
+ *  - service(): called on every wakeup of the task (keep a connection alive, replay stored measurements, ...).
+ *  - isReady(): if a batch may be delivered now (by default when the network is available).
+ *  - spill(batch): what to do with a batch that can't be delivered now or whose delivery failed (by default it is kept and retried).
+ * A batch that can never be delivered (e.g. it is too large for the destination) is counted with dropSamples() in deliver(), which then returns true so it isn't retried.
+ */
+class DM_Sink
+{
+public: // The public functions and constants
+    static constexpr size_t queueCapacity = 32;           // The amount of measurements that can wait for a sink (a power of two, see "DM_RingBuffer")
+    static constexpr size_t maxBatchSize = 32;            // The highest amount of measurements that are delivered together
+    static constexpr uint32_t pollPeriodMs = 250;         // The longest time the task of a sink sleeps when no measurement is offered
+    static constexpr uint32_t initialRetryDelayMs = 1000; // The time to wait after the first failed delivery (this doubles after every next failure)
+    static constexpr uint32_t maxRetryDelayMs = 60000;    // The longest time to wait between two deliveries
+
+    DM_Sink(const char *name, size_t maxSamplesPerBatch);
+    virtual ~DM_Sink() {}
+    void setBatchPolicy(size_t samplesPerBatch, uint32_t maxDelayMs);
+    bool start(BaseType_t core, UBaseType_t priority, uint32_t stackSize);
+    bool isStarted() const;
+    bool offer(const DM_Sample &sample);
+    const char *getName() const;
+    uint32_t getAmountOfDeliveredSamples() const;
+    uint32_t getAmountOfDroppedSamples() const;
+    void printStatistics() const;
+    static void setNetworkAvailable(bool networkAvailable);
+
+protected: // The functions a sink implements
+    virtual void service();
+    virtual bool isReady();
+    virtual bool deliver(const DM_Sample *samples, size_t amount) = 0;
+    virtual bool spill(const DM_Sample *samples, size_t amount);
+    size_t getSamplesPerBatch() const;
+    void dropSamples(size_t amount);
+    static bool isNetworkAvailable();
+
+private: // The private functions and members
+    const char *_name;                              // The name that is used as prefix when printing status messages
+    size_t _maxSamplesPerBatch;                     // The most measurements the sink can deliver together
+    size_t _samplesPerBatch;                        // The amount of measurements that fill a batch
+    uint32_t _maxDelayMs;                           // The longest time a measurement may wait for the others of its batch
+    DM_RingBuffer<DM_Sample, queueCapacity> _queue; // The measurements that are waiting for the task of the sink
+    DM_Sample _batch[maxBatchSize];                 // The batch that is being delivered (only used by the task of the sink)
+    size_t _batchAmount;                            // The amount of measurements in the batch
+    uint32_t _oldestBatchedMs;                      // The moment the oldest measurement was added to the batch
+    uint32_t _retryDelayMs;                         // The time to wait after the next failed delivery
+    uint32_t _nextAttemptMs;                        // The moment the next delivery may be tried
+    TaskHandle_t _taskHandle;                       // The handle of the task of the sink (NULL as long as it isn't started)
+    uint32_t _startMs;                              // The moment the task was started (used to calculate the throughput)
+    uint32_t _deliveredSamples;                     // The amount of measurements delivered since the start
+    uint32_t _amountOfDeliveries;                   // The amount of successful deliveries
+    uint32_t _failedDeliveries;                     // The amount of failed deliveries
+    uint32_t _spilledSamples;                       // The amount of measurements handed to spill() (e.g. stored in the flash log)
+    uint32_t _droppedSamples;                       // The amount of measurements deliver() dropped because they can never be delivered
+    uint32_t _deliveryTimeMs;                       // The total time of the successful deliveries
+    static volatile bool _networkAvailable;         // If we are connected to the Wi-Fi network (written by the uplink task, read by the tasks of the sinks)
+    static void _task(void *parameters);
+    void _run();
+    void _deliverBatch();
+};
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,128 @@
+/** +----------------------------------------------+
+ *  | DM_Sinks - Destinations of the measurements  |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef DM_Sinks_h
+#define DM_Sinks_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h>        // Used to be able to use the "size_t" type
+#include <stdint.h>        // Used to be able to use the fixed width integer types
+#include <string>          // Used to be able to use the string type
+#include <WiFi.h>          // Used to be able to use "WiFiClient" as a type
+#include <WiFiUdp.h>       // Used to send the InfluxDB line protocol over UDP
+#include <PubSubClient.h>  // Used to be able to use "PubSubClient" as a type
+#include <DM_Sink.h>       // Used as the base class of every sink
+#include <DM_Connection.h> // Used to keep track of the state of the MQTT connection without blocking
+#include <DM_Sample.h>     // Used to be able to use "DM_Sample" and "DM_Field" as types
+#include <DM_Payload.h>    // Used to size the buffer of a binary payload
+using namespace std;       // Used to be able to use the string type without needing to say "std::string" every time
+
+// DECLARE THE CLASS "DM_ThingSpeakSink" (sends the measurements with "DM_ThingSpeak", and keeps them in the flash log while that is not possible)
+class DM_ThingSpeakSink : public DM_Sink
+{
+public: // The public functions
+    DM_ThingSpeakSink(DM_Sample *replayBatch, size_t replayBatchSize);
+
+protected: // The functions of the sink
+    void service() override;
+    bool isReady() override;
+    bool deliver(const DM_Sample *samples, size_t amount) override;
+    bool spill(const DM_Sample *samples, size_t amount) override;
+
+private: // The private members
+    DM_Sample *_replayBatch; // The buffer the stored measurements are read into before they are replayed
+    size_t _replayBatchSize; // The size of that buffer
+    bool _unreachable;       // If the last bulk update failed (the batches are stored in the flash log then, until a replay succeeds)
+};
+
+// DECLARE THE CLASS "DM_DiscordSink" (shows the measurements with "DM_WebhookConnector", within the rate limit of Discord)
+class DM_DiscordSink : public DM_Sink
+{
+public: // The public functions
+    DM_DiscordSink();
+
+protected: // The functions of the sink
+    bool isReady() override;
+    bool deliver(const DM_Sample *samples, size_t amount) override;
+};
+
+// DECLARE THE CLASS "DM_InfluxSink" (writes the measurements to InfluxDB in its line protocol, over UDP or HTTP)
+class DM_InfluxSink : public DM_Sink
+{
+public: // The public functions and constants
+    static constexpr size_t maxDatagramSize = 1024; // The largest UDP datagram that is sent (several lines go in one datagram, but it has to stay below the MTU)
+
+    DM_InfluxSink();
+    void setUDPServer(string host, uint16_t port);
+    void setHTTPServer(string writeURL, string token);
+    void setMeasurement(string measurement, string station);
+    void setFields(const DM_Field *fields, size_t amountOfFields);
+
+protected: // The functions of the sink
+    bool deliver(const DM_Sample *samples, size_t amount) override;
+
+private: // The private functions and members
+    string _host;                            // The host of the UDP listener
+    uint16_t _port;                          // The port of the UDP listener (0 when HTTP is used)
+    string _writeURL;                        // The URL of the write API (e.g. "http://influx.local:8086/api/v2/write?org=home&bucket=weather&precision=s")
+    string _token;                           // The API token that is allowed to write to the bucket
+    string _measurement;                     // The name of the measurement every line is written to
+    string _station;                         // The value of the "station" tag of every line
+    const DM_Field *_fields;                 // The values of a measurement that are written (one field per value)
+    size_t _amountOfFields;                  // The amount of fields
+    WiFiUDP _UDP;                            // The UDP socket
+    char _body[DM_Sink::maxBatchSize * 128]; // The lines of one batch (one line with three values takes at most 128 bytes)
+    size_t _writeLine(char *buffer, size_t bufferSize, const DM_Sample &sample);
+    bool _sendUDP(const DM_Sample *samples, size_t amount);
+    bool _sendHTTP(const DM_Sample *samples, size_t amount);
+};
+
+// DECLARE THE ENUM "DM_PayloadFormat" (how "DM_MQTTSink" writes the measurements)
+enum DM_PayloadFormat : uint8_t
+{
+    DM_PAYLOAD_JSON,  // One JSON message per measurement (any subscriber can read it)
+    DM_PAYLOAD_BINARY // One binary message per batch (see "DM_Payload.h", read by "tools/ingest")
+};
+
+// DECLARE THE CLASS "DM_MQTTSink" (publishes the measurements as JSON or as binary payloads to an MQTT broker of your own)
+class DM_MQTTSink : public DM_Sink
+{
+public: // The public functions
+    DM_MQTTSink();
+    void setBroker(string host, uint16_t port, string clientID, string username, string password);
+    void setTopic(string topic);
+    void setFields(const DM_Field *fields, size_t amountOfFields);
+    void setPayloadFormat(DM_PayloadFormat format, uint32_t stationID);
+
+protected: // The functions of the sink
+    void service() override;
+    bool isReady() override;
+    bool deliver(const DM_Sample *samples, size_t amount) override;
+
+private: // The private functions and members
+    string _host;                            // The host of the broker
+    uint16_t _port;                          // The port of the broker
+    string _clientID;                        // The client ID for the MQTT connection
+    string _username;                        // The username for the MQTT connection
+    string _password;                        // The password for the MQTT connection
+    string _topic;                           // The topic the measurements are published to
+    const DM_Field *_fields;                 // The values of a measurement that are published
+    size_t _amountOfFields;                  // The amount of fields
+    DM_PayloadFormat _format;                // The format of the payloads
+    uint32_t _stationID;                     // The station ID in a binary payload
+    uint32_t _bootID;                        // The boot ID in a binary payload (picked at random by "setPayloadFormat()")
+    uint32_t _sequence;                      // The sequence number of the next measurement in a binary payload (counted since the boot ID was picked)
+    WiFiClient _WiFiClient;                  // The TCP connection to the broker
+    PubSubClient _MQTTClient;                // The MQTT client
+    DM_ConnectionStateMachine _stateMachine; // The state of the MQTT connection
+    uint8_t _payload[DM_PayloadEncoder::maxHeaderSize + DM_Sink::maxBatchSize * DM_Encoder::maxEncodedSampleSize]; // The binary payload of one batch
+    bool _deliverJSON(const DM_Sample *samples, size_t amount);
+    bool _deliverBinary(const DM_Sample *samples, size_t amount);
+};
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,95 @@
+/** +----------------------------------------------+
+ *  |     DM_Statistics - Windowed statistics      |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef DM_Statistics_h
+#define DM_Statistics_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h>    // Used to be able to use the "size_t" type
+#include <stdint.h>    // Used to be able to use the fixed width integer types
+#include <atomic>      // Used to hand a new window configuration from one task to another without a lock
+#include <DM_Sample.h> // Used to be able to use "DM_Sample" and "DM_Field" as types for an argument
+
+// DECLARE THE STRUCT "DM_FieldStatistics" (the statistics of one value over one window)
+struct DM_FieldStatistics
+{
+    uint32_t amount; // The amount of readings in the window
+    float minimum;   // The lowest reading
+    float maximum;   // The highest reading
+    float mean;      // The average of the readings
+    float variance;  // The (population) variance of the readings
+    float last;      // The newest reading
+};
+
+// DECLARE THE CLASS "DM_RunningStatistics" (Welford's algorithm: the mean and variance are updated with every reading, nothing is stored)
+class DM_RunningStatistics
+{
+public: // The public functions
+    DM_RunningStatistics();
+    void clear();
+    void add(float value);
+    void merge(const DM_RunningStatistics &other);
+    uint32_t getAmount() const;
+    DM_FieldStatistics getStatistics() const;
+
+private: // The private members
+    uint32_t _amount;    // The amount of readings
+    float _mean;         // The running mean
+    float _sumOfSquares; // The sum of the squared differences from the mean ("M2" in Welford's algorithm)
+    float _minimum;      // The lowest reading
+    float _maximum;      // The highest reading
+    float _last;         // The newest reading
+};
+
+// DECLARE THE STRUCT "DM_WindowSummary" (the statistics of every value over one window, this is what is sent instead of single readings)
+struct DM_WindowSummary
+{
+    static constexpr size_t maxAmountOfFields = 8; // A ThingSpeak channel has 8 fields, so a sample never holds more values
+
+    uint32_t startMs;                             // The moment (in milliseconds since boot) the window started
+    uint32_t endMs;                               // The moment (in milliseconds since boot) the window ended
+    uint32_t epochSeconds;                        // The moment (in Unix time) the window ended, 0 if the clock was not synchronized yet
+    uint8_t amountOfFields;                       // The amount of values in "fields"
+    DM_FieldStatistics fields[maxAmountOfFields]; // The statistics of every value (in the order of the field table)
+};
+
+// DECLARE THE CLASS "DM_WindowedStatistics"
+class DM_WindowedStatistics
+{
+public: // The public functions and constants
+    static constexpr size_t maxAmountOfPanes = 16; // The highest amount of slides in one window (the window length divided by the slide)
+
+    DM_WindowedStatistics(const DM_Field *fields, size_t amountOfFields);
+    static bool isValidConfiguration(uint32_t windowMs, uint32_t slideMs);
+    bool configure(uint32_t windowMs, uint32_t slideMs);
+    void requestConfiguration(uint32_t windowMs, uint32_t slideMs);
+    bool add(const DM_Sample &sample, DM_WindowSummary &summary);
+    uint32_t getWindowMs() const;
+    uint32_t getSlideMs() const;
+
+private: // The private functions and members
+    const DM_Field *_fields;                                                            // The values of a sample that are tracked
+    size_t _amountOfFields;                                                             // The amount of values that are tracked
+    uint32_t _windowMs;                                                                 // The length of a window
+    uint32_t _slideMs;                                                                  // The time between the start of two windows (equal to the window length for tumbling windows)
+    size_t _panesPerWindow;                                                             // The amount of slides in one window
+    DM_RunningStatistics _panes[maxAmountOfPanes][DM_WindowSummary::maxAmountOfFields]; // The statistics of the last slides (a ring, one row per slide)
+    size_t _currentPane;                                                                // The row of the slide that is being filled
+    size_t _amountOfClosedPanes;                                                        // The amount of slides that have been closed since the last configuration
+    uint32_t _paneStartMs;                                                              // The moment the current slide started
+    bool _started;                                                                      // If the first reading has been added
+    uint32_t _lastEpochSeconds;                                                         // The Unix time of the newest sample (0 if unknown)
+    uint32_t _lastTimestampMs;                                                          // The moment of the newest sample
+    std::atomic<bool> _configurationRequested;                                          // If another task asked for a new configuration
+    uint32_t _requestedWindowMs;                                                        // The window length that was asked for
+    uint32_t _requestedSlideMs;                                                         // The slide that was asked for
+    void _reset();
+    void _closePane(DM_WindowSummary &summary, bool &windowReady);
+};
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,67 @@
+/** +----------------------------------------------+
+ *  |      DM_Storage - Store-and-forward log      |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef DM_Storage_h
+#define DM_Storage_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h>    // Used to be able to use the "size_t" type
+#include <stdint.h>    // Used to be able to use the fixed width integer types
+#include <DM_Sample.h> // Used to be able to use "DM_Sample" as a type for an argument
+#include <DM_Codec.h>  // Used to compress the samples before they are written to flash
+
+// DECLARE THE STRUCT "DM_StorageReplayPosition" (how far the replay got, kept in RTC memory so a deep sleep doesn't start the replay of the oldest segment over)
+struct DM_StorageReplayPosition
+{
+    uint32_t magic;   // Tells a valid position apart from an empty one
+    uint32_t segment; // The oldest segment at the last change of the position
+    uint32_t sample;  // The index of the next sample to replay, counted from the start of that segment
+};
+
+// DECLARE THE CLASS "DM_StorageLog"
+class DM_StorageLog
+{
+public: // The public functions and constants
+    static const size_t pageSize = 256;                           // The size of one flash page (samples are only written to flash in whole pages, the rest of a page stays unused)
+    static const size_t pageHeaderSize = 2;                       // The first byte of a page holds the amount of samples in it, the second one the format of the page
+    static const uint8_t pageFormat = 0xC1;                       // The format of a page (compressed with "DM_Encoder", version 1)
+    static const size_t segmentSize = 4096;                       // The size of one flash sector (every segment file holds exactly one sector)
+    static const size_t pagesPerSegment = segmentSize / pageSize; // The amount of pages in one segment
+    static const uint32_t maxAmountOfSegments = 64;               // The amount of segments the log may use (the oldest one is dropped when this is reached)
+
+    static bool begin();
+    static bool append(const DM_Sample &sample);
+    static size_t readBatch(DM_Sample *samples, size_t maxAmount);
+    static void commitBatch(size_t amount);
+    static bool flush();
+    static bool isEmpty();
+    static uint32_t getAmountOfStoredSamples();
+    static uint32_t getAmountOfDroppedSamples();
+
+private: // The private functions and members
+    static bool _ready;
+    static uint32_t _oldestSegment;
+    static uint32_t _newestSegment;
+    static uint32_t _newestSegmentPages;
+    static uint32_t _readSample;
+    static DM_StorageReplayPosition _replayPosition;
+    static uint8_t _page[pageSize];
+    static DM_Encoder _pageEncoder;
+    static uint32_t _segmentSamples[];
+    static uint32_t _droppedSamples;
+    static bool _flushPage();
+    static void _saveReplayPosition();
+    static void _dropOldestSegment();
+    static void _dropConsumedSegments();
+    static uint32_t _samplesInSegment(uint32_t segment);
+    static uint32_t _countSamplesInFile(const char *path, uint32_t &pages);
+    static size_t _decodePage(const uint8_t *stream, size_t length, uint32_t pageSamples, uint32_t skip, DM_Sample *samples, size_t maxAmount);
+    static void _segmentPath(uint32_t segment, char *path, size_t pathSize);
+};
+
+#endif // End the header guard
\ No newline at end of file
@@ -9,8 +9,23 @@
 #ifndef DM_ThingSpeak_h
 #define DM_ThingSpeak_h
 
-// IMPORT THE NECESSARY LIBRARY
-using namespace std; // Used to be able to use the string type without needing to say "std::string" every time
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h>            // Used to be able to use the "size_t" type
+#include <stdint.h>            // Used to be able to use the fixed width integer types
+#include <atomic>              // Used to count the uplink calls and the statistics of the MQTT service task and the sink task without a lock
+#include <freertos/FreeRTOS.h> // Used to be able to use the FreeRTOS types
+#include <freertos/queue.h>    // Used to hand the publishes over to the MQTT service task
+#include <DM_Connection.h>     // Used to keep track of the state of the MQTT connection without blocking
+#include <DM_Sample.h>         // Used to be able to use "DM_Sample" and "DM_Field" as types for an argument
+using namespace std;           // Used to be able to use the string type without needing to say "std::string" every time
+
+// DECLARE THE STRUCT "DM_MQTTMessage" (one publish waiting in the outbound queue)
+struct DM_MQTTMessage
+{
+    char payload[160]; // The payload, formatted when the message is queued
+    uint32_t queuedMs; // The moment the message was queued (used to measure the publish latency)
+    uint8_t attempts;  // The amount of publishes of this message that failed
+};
 
 // DECLARE THE CLASS "DM_ThingSpeak"
 class DM_ThingSpeak
@@ -20,12 +35,48 @@ private: // The public functions
     static string _MQTTClientID;
     static string _MQTTUsername;
     static string _MQTTPassword;
+    static string _writeAPIKey;
+    static DM_ConnectionStateMachine _stateMachine;
+    static uint32_t _nextBulkUpdateMs;
+    static std::atomic<uint32_t> _amountOfUplinkCalls;
+    static char _publishTopic[];
+    static char _bulkUpdateLink[];
+    static char _bulkUpdateBody[];
+    static const DM_Field *_fields;
+    static size_t _amountOfFields;
+    static QueueHandle_t _outboundQueue;
+    static DM_MQTTMessage _inFlight;
+    static bool _hasInFlight;
+    static volatile bool _networkAvailable;
+    static volatile bool _connected;
+    static std::atomic<uint32_t> _amountOfPublishes;
+    static std::atomic<uint32_t> _amountOfRetries;
+    static std::atomic<uint32_t> _droppedMessages;
+    static std::atomic<uint32_t> _publishLatencyMs;
+    static std::atomic<uint32_t> _maxPublishLatencyMs;
+    static void _serviceTask(void *parameters);
+    static void _publishQueuedMessages();
 
 public: // The private functions
+    static const size_t maxBatchSize = 100;        // The highest amount of samples that can be sent in one bulk update
+    static const size_t outboundQueueSize = 16;    // The highest amount of publishes that can wait for the MQTT service task (the oldest one is dropped when it is full)
+    static const size_t maxPublishesPerWakeup = 4; // The highest amount of publishes sent one after the other before the client is serviced again
+    static const uint8_t maxPublishAttempts = 3;   // The amount of failed publishes after which a message is dropped
+    static const uint32_t servicePeriodMs = 100;   // The longest time the MQTT service task waits before it services the client again
+
     static void setConnectionParameters(unsigned long channelNumber, string MQTTClientID, string MQTTUsername, string MQTTPassword);
-    static void publishInformation(float temperatureC, float lightIntensityLux, float airPressureBar);
-    static bool connectToMQTT();
-    static bool checkAndReconnectToMQTT();
+    static void setWriteAPIKey(string writeAPIKey);
+    static void setFields(const DM_Field *fields, size_t amountOfFields);
+    static bool startService(BaseType_t core, UBaseType_t priority);
+    static void setNetworkAvailable(bool networkAvailable);
+    static bool isConnected();
+    static bool publishInformation(const DM_Sample &sample);
+    static bool publishBatch(const DM_Sample *samples, size_t amount);
+    static bool isBulkUpdateAllowed();
+    static uint32_t getAmountOfUplinkCalls();
+    static bool tick(bool networkAvailable);
+    static DM_ConnectionStateMachine &getStateMachine();
+    static void printStatistics();
 };
 
 #endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,32 @@
+/** +----------------------------------------------+
+ *  |     DM_Time - SNTP time synchronisation      |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef DM_Time_h
+#define DM_Time_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h>    // Used to be able to use the "size_t" type
+#include <stdint.h>    // Used to be able to use the fixed width integer types
+#include <DM_Sample.h> // Used to be able to use "DM_Sample" as a type for an argument
+
+// DECLARE THE CLASS "DM_Time"
+class DM_Time
+{
+public: // The public functions
+    static void begin();
+    static bool isSynchronized();
+    static uint32_t getEpochSeconds();
+    static void completeTimestamp(DM_Sample &sample);
+    static void completeTimestamp(DM_Sample &sample, uint32_t nowMs);
+    static size_t formatISO8601(uint32_t epochSeconds, char *buffer, size_t bufferSize);
+
+private: // The private member
+    static bool _started;
+};
+
+#endif // End the header guard
\ No newline at end of file
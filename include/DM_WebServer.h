@@ -0,0 +1,61 @@
+/** +----------------------------------------------+
+ *  |      DM_WebServer - Metrics and history      |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef DM_WebServer_h
+#define DM_WebServer_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h>     // Used to be able to use the "size_t" type
+#include <stdint.h>     // Used to be able to use the fixed width integer types
+#include <DM_Sample.h>  // Used to be able to use "DM_Field" as a type for an argument
+#include <DM_History.h> // Used to read the samples that are streamed by "/history"
+#include <DM_Sink.h>    // Used to read the counters of the sinks
+#include <DM_Format.h>  // Used to write the responses without allocating memory
+
+// DECLARE THE STRUCT "DM_Metric" (an internal counter or gauge that is shown on "/metrics")
+struct DM_Metric
+{
+    const char *name;   // The name of the metric (e.g. "dm_summary_buffer_overruns_total")
+    const char *type;   // The Prometheus type of the metric ("counter" or "gauge")
+    const char *help;   // The description of the metric
+    uint32_t (*read)(); // The function that reads the current value (called from the task of the web server, so it may not wait)
+};
+
+/**
+ * A small HTTP server that runs next to the station (on the task of the asynchronous TCP stack, so it never holds up the sampling or the uplink):
+ *  - "/metrics": the newest reading of every value, the counters of every sink, the latency of the hot paths (see "DM_Profiler.h") and the metrics of "setMetrics()", in the Prometheus text format.
+ *  - "/history?from=<Unix time>&to=<Unix time>": the samples in the history as CSV (both parameters are optional).
+ * Both responses are sent with chunked transfer encoding and written straight into the send buffer, line by line, so no response is ever built in memory.
+ */
+class DM_WebServer
+{
+public: // The public functions and constants
+    static const uint16_t port = 80; // The port the server listens on
+
+    static void setHistory(DM_History *history, const DM_Field *fields, size_t amountOfFields);
+    static void setSinks(DM_Sink *const *sinks, size_t amountOfSinks);
+    static void setMetrics(const DM_Metric *metrics, size_t amountOfMetrics);
+    static void begin();
+    static uint32_t getAmountOfRequests();
+
+private: // The private functions and members
+    static bool _started;
+    static DM_History *_history;
+    static const DM_Field *_fields;
+    static size_t _amountOfFields;
+    static DM_Sink *const *_sinks;
+    static size_t _amountOfSinks;
+    static const DM_Metric *_metrics;
+    static size_t _amountOfMetrics;
+    static volatile uint32_t _amountOfRequests;
+    static size_t _fillMetrics(uint8_t *buffer, size_t maxLength, size_t &family, size_t &line);
+    static bool _writeMetricsLine(DM_Formatter &output, size_t family, size_t line);
+    static size_t _fillHistory(uint8_t *buffer, size_t maxLength, size_t index, uint32_t &nextMs, uint32_t toMs);
+};
+
+#endif // End the header guard
\ No newline at end of file
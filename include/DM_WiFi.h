@@ -10,20 +10,66 @@
 #define DM_WiFi_h
 
 // IMPORT THE NECESSARY LIBRARIES
-#include <WiFi.h>    // Used to be able to use "wl_status_t" as a return type of a function
-using namespace std; // Used to be able to use the string type without needing to say "std::string" every time
+#include <WiFi.h>          // Used to be able to use "wl_status_t" as a return type of a function
+#include <DM_Connection.h> // Used to keep track of the state of the Wi-Fi connection without blocking
+using namespace std;       // Used to be able to use the string type without needing to say "std::string" every time
+
+// DECLARE THE STRUCT "DM_WiFiCache" (what is needed to connect again without scanning or asking for an IP address, kept in RTC memory and in NVS)
+struct DM_WiFiCache
+{
+    uint32_t magic;                   // Tells a valid cache apart from an empty one
+    uint8_t BSSID[6];                 // The MAC address of the access point of the last good connection
+    int32_t channel;                  // The channel of the access point
+    uint32_t localIP;                 // The IP address of the last DHCP lease
+    uint32_t gatewayIP;               // The gateway of the last DHCP lease
+    uint32_t subnetMask;              // The subnet mask of the last DHCP lease
+    uint32_t DNSIP;                   // The DNS server of the last DHCP lease
+    uint32_t leaseExpiryEpochSeconds; // The Unix time the last DHCP lease runs out (0 if unknown, the cached IP address is only reused before it)
+};
+
+// DECLARE THE ENUM "DM_WiFiAttempt" (how the current connection attempt was started)
+enum DM_WiFiAttempt
+{
+    DM_WIFI_ATTEMPT_FAST,     // Straight to the cached access point, with the cached IP address (no scan, no DHCP)
+    DM_WIFI_ATTEMPT_CACHED,   // Straight to the cached access point, with DHCP (the cached lease ran out)
+    DM_WIFI_ATTEMPT_SCANNING, // Waiting for the scan that looks for the best access point
+    DM_WIFI_ATTEMPT_SCANNED,  // To the access point the scan found, with DHCP
+    DM_WIFI_ATTEMPT_PLAIN,    // To any access point with the SSID (the scan failed), with DHCP
+};
 
 // DECLARE THE CLASS "DM_WiFi"
 class DM_WiFi
 {
 public: // The public functions
-    static bool connectToWiFi(string SSID, string password);
-    static bool checkAndReconnect(string SSID, string password);
+    static void setCredentials(string SSID, string password);
+    static bool tick();
+    static DM_ConnectionStateMachine &getStateMachine();
 
-private: // The private functions
+private: // The private functions and members
+    static string _SSID;
+    static string _password;
+    static DM_ConnectionStateMachine _stateMachine;
+    static DM_WiFiCache _cache;
+    static bool _cacheLoaded;
+    static DM_WiFiAttempt _attempt;
+    static uint32_t _attemptStartMs;
+    static bool _scanValid;
+    static uint32_t _scanMs;
+    static uint8_t _scannedBSSID[6];
+    static int32_t _scannedChannel;
+    static uint32_t _leaseSeconds;
+    static uint32_t _leaseStartMs;
     static wl_status_t _isConnected();
-    static int _getAmountOfAvailableWiFiNetworks();
-    static void _printAvailableWiFiNetworks();
+    static void _printConnectionFailure(wl_status_t status);
+    static void _startAttempt();
+    static void _startScan();
+    static bool _collectScan();
+    static void _loadCache();
+    static void _storeCache();
+    static void _clearCache();
+    static void _writeCache();
+    static bool _isLeaseValid();
+    static void _completeLeaseExpiry();
 };
 
 #endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,101 @@
+/** +----------------------------------------------+
+ *  |     Adafruit_BMP280 - Simulated library      |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "Adafruit_BMP280.h" // Include the header file where the declarations for this library are stored
+
+/**
+ * Create the sensor.
+ *
+ * @param wire The I2C bus of the chip.
+ */
+Adafruit_BMP280::Adafruit_BMP280(TwoWire *wire) : _wire(wire), _address(BMP280_ADDRESS), _sensorID(0)
+{
+}
+
+/**
+ * Check the chip ID, read the calibration and start measuring in normal mode (the defaults of "setSampling()").
+ *
+ * @param address The I2C address of the chip.
+ * @param chipID The chip ID that is expected.
+ *
+ * @return True if a chip with the expected ID answered.
+ */
+bool Adafruit_BMP280::begin(uint8_t address, uint8_t chipID)
+{
+    // Check that the chip answers with the right ID
+    this->_address = address;
+    this->_wire->begin();
+    if (!this->_readRegisters(0xD0, &this->_sensorID, 1) || this->_sensorID != chipID)
+        return false;
+
+    // Read the calibration (the library keeps it for its own conversions, the station reads it again itself)
+    uint8_t calibration[24];
+    this->_readRegisters(0x88, calibration, sizeof(calibration));
+    this->setSampling();
+    delay(100);
+    return true;
+}
+
+/**
+ * Set the oversampling, the mode, the IIR filter and the standby time.
+ *
+ * @param mode The operation mode.
+ * @param temperatureSampling The oversampling of the temperature.
+ * @param pressureSampling The oversampling of the pressure.
+ * @param filter The IIR filter.
+ * @param duration The standby time in normal mode.
+ */
+void Adafruit_BMP280::setSampling(sensor_mode mode, sensor_sampling temperatureSampling, sensor_sampling pressureSampling, sensor_filter filter, standby_duration duration)
+{
+    this->_writeRegister(0xF5, (duration << 5) | (filter << 2));
+    this->_writeRegister(0xF4, (temperatureSampling << 5) | (pressureSampling << 2) | mode);
+}
+
+/**
+ * Get the chip ID that was read by "begin()".
+ *
+ * @return The chip ID.
+ */
+uint8_t Adafruit_BMP280::sensorID()
+{
+    return this->_sensorID;
+}
+
+/**
+ * Read registers of the chip (the address goes up after every byte).
+ *
+ * @param reg The first register.
+ * @param buffer The buffer for the values.
+ * @param length The amount of registers.
+ *
+ * @return The success rate.
+ */
+bool Adafruit_BMP280::_readRegisters(uint8_t reg, uint8_t *buffer, uint8_t length)
+{
+    this->_wire->beginTransmission(this->_address);
+    this->_wire->write(reg);
+    if (this->_wire->endTransmission() != 0 || this->_wire->requestFrom(this->_address, length) != length)
+        return false;
+    for (uint8_t i = 0; i < length; i++)
+        buffer[i] = this->_wire->read();
+    return true;
+}
+
+/**
+ * Write a register of the chip.
+ *
+ * @param reg The register.
+ * @param value The value.
+ */
+void Adafruit_BMP280::_writeRegister(uint8_t reg, uint8_t value)
+{
+    this->_wire->beginTransmission(this->_address);
+    this->_wire->write(reg);
+    this->_wire->write(value);
+    this->_wire->endTransmission();
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+/** +----------------------------------------------+
+ *  |     Adafruit_BMP280 - Simulated library      |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef Adafruit_BMP280_h
+#define Adafruit_BMP280_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "Arduino.h" // Used to wait after the initialization
+#include "Wire.h"    // Used to talk to the chip over the I2C bus
+
+// DECLARE THE CONSTANTS OF THE LIBRARY
+#define BMP280_ADDRESS 0x77 // The default I2C address of the chip
+#define BMP280_CHIPID 0x58  // The value of the chip ID register
+
+/**
+ * The "Adafruit BMP280" library with the part of the interface the station uses: the same I2C transactions and delays as the real library, on the simulated I2C bus.
+ */
+class Adafruit_BMP280
+{
+public: // The public functions and constants
+    enum sensor_sampling
+    {
+        SAMPLING_NONE = 0x00,
+        SAMPLING_X1 = 0x01,
+        SAMPLING_X2 = 0x02,
+        SAMPLING_X4 = 0x03,
+        SAMPLING_X8 = 0x04,
+        SAMPLING_X16 = 0x05
+    };
+    enum sensor_mode
+    {
+        MODE_SLEEP = 0x00,
+        MODE_FORCED = 0x01,
+        MODE_NORMAL = 0x03,
+        MODE_SOFT_RESET_CODE = 0xB6
+    };
+    enum sensor_filter
+    {
+        FILTER_OFF = 0x00,
+        FILTER_X2 = 0x01,
+        FILTER_X4 = 0x02,
+        FILTER_X8 = 0x03,
+        FILTER_X16 = 0x04
+    };
+    enum standby_duration
+    {
+        STANDBY_MS_1 = 0x00,
+        STANDBY_MS_63 = 0x01,
+        STANDBY_MS_125 = 0x02,
+        STANDBY_MS_250 = 0x03,
+        STANDBY_MS_500 = 0x04,
+        STANDBY_MS_1000 = 0x05,
+        STANDBY_MS_2000 = 0x06,
+        STANDBY_MS_4000 = 0x07
+    };
+
+    Adafruit_BMP280(TwoWire *wire = &Wire);
+    bool begin(uint8_t address = BMP280_ADDRESS, uint8_t chipID = BMP280_CHIPID);
+    void setSampling(sensor_mode mode = MODE_NORMAL, sensor_sampling temperatureSampling = SAMPLING_X16, sensor_sampling pressureSampling = SAMPLING_X16, sensor_filter filter = FILTER_OFF, standby_duration duration = STANDBY_MS_1);
+    uint8_t sensorID();
+
+private: // The private functions and members
+    TwoWire *_wire;    // The I2C bus of the chip
+    uint8_t _address;  // The I2C address of the chip
+    uint8_t _sensorID; // The chip ID that was read
+    bool _readRegisters(uint8_t reg, uint8_t *buffer, uint8_t length);
+    void _writeRegister(uint8_t reg, uint8_t value);
+};
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,515 @@
+/** +----------------------------------------------+
+ *  |      Arduino - Simulated Arduino core        |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "Arduino.h"             // Include the header file where the declarations for this library are stored
+#include "DM_Simulator.h"        // Used to read and advance the virtual clock
+#include "DM_SimulatedWorld.h"   // Used to read the typed commands, and to draw the random numbers of the station
+#include "DM_SimulatedNetwork.h" // Used to check if the NTP servers can be reached
+#include "esp_heap_caps.h"       // Used to read the free memory
+#include <sys/time.h>            // Used to replace the system clock of Linux with the one of the station ("gettimeofday()")
+#include <time.h>                // Used to replace the system clock of Linux with the one of the station ("time()")
+
+// INITIALIZE THE OBJECTS (the ones the Arduino core creates for every sketch)
+HardwareSerial Serial;
+EspClass ESP;
+
+// OTHER VARIABLES
+bool SNTPStarted = false;         // If "configTime()" has been called
+uint64_t SNTPStartMs = 0;         // The moment the SNTP client was started
+bool clockSynchronized = false;   // If the system clock holds the real time
+const uint32_t SNTPDelayMs = 700; // The time the SNTP client needs to get the time from a server (DNS lookup and one exchange)
+
+/**
+ * Create a text.
+ *
+ * @param text The characters.
+ */
+String::String(const char *text) : _text(text != nullptr ? text : "") {}
+
+/**
+ * Create a text.
+ *
+ * @param text The characters.
+ */
+String::String(const std::string &text) : _text(text) {}
+
+/**
+ * Create the text of a number.
+ *
+ * @param number The number.
+ */
+String::String(int number) : _text(std::to_string(number)) {}
+
+/**
+ * Get the characters.
+ *
+ * @return The characters, ending in a null character.
+ */
+const char *String::c_str() const
+{
+    return _text.c_str();
+}
+
+/**
+ * Get the length of the text.
+ *
+ * @return The amount of characters.
+ */
+unsigned int String::length() const
+{
+    return _text.length();
+}
+
+/**
+ * Read the number at the start of the text.
+ *
+ * @return The number (0 if the text doesn't start with one).
+ */
+long String::toInt() const
+{
+    return atol(_text.c_str());
+}
+
+/**
+ * Read the decimal number at the start of the text.
+ *
+ * @return The number (0 if the text doesn't start with one).
+ */
+float String::toFloat() const
+{
+    return atof(_text.c_str());
+}
+
+/**
+ * Compare the text with other characters.
+ *
+ * @param text The other characters.
+ *
+ * @return True if they are the same.
+ */
+bool String::equals(const char *text) const
+{
+    return _text == (text != nullptr ? text : "");
+}
+
+bool String::operator==(const char *text) const
+{
+    return equals(text);
+}
+
+bool String::operator!=(const char *text) const
+{
+    return !equals(text);
+}
+
+bool String::operator==(const String &text) const
+{
+    return _text == text._text;
+}
+
+bool String::operator!=(const String &text) const
+{
+    return _text != text._text;
+}
+
+String &String::operator+=(const char *text)
+{
+    _text += text;
+    return *this;
+}
+
+/**
+ * Create the address 0.0.0.0 (no address).
+ */
+IPAddress::IPAddress() : _address(0) {}
+
+/**
+ * Create an address from its four bytes.
+ */
+IPAddress::IPAddress(uint8_t first, uint8_t second, uint8_t third, uint8_t fourth) : _address((uint32_t)first | (uint32_t)second << 8 | (uint32_t)third << 16 | (uint32_t)fourth << 24) {}
+
+/**
+ * Create an address from its 32-bit value (as stored by the ESP32).
+ */
+IPAddress::IPAddress(uint32_t address) : _address(address) {}
+
+IPAddress::operator uint32_t() const
+{
+    return _address;
+}
+
+uint8_t IPAddress::operator[](int index) const
+{
+    return _address >> (8 * index);
+}
+
+bool IPAddress::operator==(const IPAddress &address) const
+{
+    return _address == address._address;
+}
+
+bool IPAddress::operator!=(const IPAddress &address) const
+{
+    return _address != address._address;
+}
+
+/**
+ * Write the address in the dotted notation (e.g. "192.168.1.42").
+ *
+ * @return The address as text.
+ */
+String IPAddress::toString() const
+{
+    char text[16];
+    snprintf(text, sizeof(text), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+    return String(text);
+}
+
+/**
+ * Write one character.
+ *
+ * @param character The character.
+ *
+ * @return The amount of characters written.
+ */
+size_t Print::write(uint8_t character)
+{
+    return write(&character, 1);
+}
+
+size_t Print::print(const char *text)
+{
+    return write((const uint8_t *)text, strlen(text));
+}
+
+size_t Print::print(const String &text)
+{
+    return write((const uint8_t *)text.c_str(), text.length());
+}
+
+size_t Print::print(char character)
+{
+    return write((uint8_t)character);
+}
+
+size_t Print::print(int number)
+{
+    return print((long)number);
+}
+
+size_t Print::print(unsigned int number)
+{
+    return print((unsigned long)number);
+}
+
+size_t Print::print(long number)
+{
+    char text[24];
+    return write((const uint8_t *)text, snprintf(text, sizeof(text), "%ld", number));
+}
+
+size_t Print::print(unsigned long number)
+{
+    char text[24];
+    return write((const uint8_t *)text, snprintf(text, sizeof(text), "%lu", number));
+}
+
+size_t Print::print(double number, int digits)
+{
+    char text[48];
+    return write((const uint8_t *)text, snprintf(text, sizeof(text), "%.*f", digits, number));
+}
+
+size_t Print::println()
+{
+    return write((const uint8_t *)"\r\n", 2);
+}
+
+size_t Print::println(const char *text)
+{
+    return print(text) + println();
+}
+
+size_t Print::println(const String &text)
+{
+    return print(text) + println();
+}
+
+size_t Print::println(char character)
+{
+    return print(character) + println();
+}
+
+size_t Print::println(int number)
+{
+    return print(number) + println();
+}
+
+size_t Print::println(unsigned int number)
+{
+    return print(number) + println();
+}
+
+size_t Print::println(long number)
+{
+    return print(number) + println();
+}
+
+size_t Print::println(unsigned long number)
+{
+    return print(number) + println();
+}
+
+size_t Print::println(double number, int digits)
+{
+    return print(number, digits) + println();
+}
+
+/**
+ * Start the serial port.
+ *
+ * @param baudRate The speed in bits per second.
+ */
+void HardwareSerial::begin(unsigned long baudRate)
+{
+    _baudRate = baudRate;
+    _transmitDoneUs = DM_Simulator::getMicroseconds();
+}
+
+/**
+ * Stop the serial port.
+ */
+void HardwareSerial::end()
+{
+    flush();
+    _baudRate = 0;
+}
+
+/**
+ * Count the characters that have been received.
+ *
+ * @return The amount of characters that can be read.
+ */
+int HardwareSerial::available()
+{
+    return _baudRate > 0 ? DM_SimulatedWorld::getAvailableSerialInput(DM_Simulator::getMicroseconds() / 1000) : 0;
+}
+
+/**
+ * Read one received character.
+ *
+ * @return The character, or -1 if nothing has been received.
+ */
+int HardwareSerial::read()
+{
+    return _baudRate > 0 ? DM_SimulatedWorld::readSerialInput(DM_Simulator::getMicroseconds() / 1000) : -1;
+}
+
+/**
+ * Wait until every character in the buffer has been sent.
+ */
+void HardwareSerial::flush()
+{
+    uint64_t nowUs = DM_Simulator::getMicroseconds();
+    if (_transmitDoneUs > nowUs)
+        DM_Simulator::sleep(_transmitDoneUs - nowUs);
+}
+
+/**
+ * Send characters: they are added to the buffer, and the task waits while the buffer is full (10 bits per character: a start bit, 8 data bits and a stop bit).
+ *
+ * @param buffer The characters.
+ * @param size The amount of characters.
+ *
+ * @return The amount of characters sent.
+ */
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+    if (_baudRate == 0)
+        return 0;
+    uint64_t characterUs = 10000000ULL / _baudRate;
+    for (size_t i = 0; i < size; i++)
+    {
+        // Wait until there is room in the buffer
+        uint64_t nowUs = DM_Simulator::getMicroseconds();
+        if (_transmitDoneUs > nowUs + HardwareSerial::transmitBufferSize * characterUs)
+            DM_Simulator::sleep(_transmitDoneUs - nowUs - HardwareSerial::transmitBufferSize * characterUs);
+
+        // Add the character behind the ones that are waiting
+        _transmitDoneUs = std::max(_transmitDoneUs, DM_Simulator::getMicroseconds()) + characterUs;
+    }
+    DM_Simulator::showSerialOutput(buffer, size);
+    return size;
+}
+
+/**
+ * Check if the serial port is ready.
+ *
+ * @return True if the port has been started.
+ */
+HardwareSerial::operator bool() const
+{
+    return _baudRate > 0;
+}
+
+/**
+ * Read the cycle counter of the core (the virtual clock at the simulated CPU frequency).
+ *
+ * @return The amount of cycles since the boot (it wraps around every 18 seconds).
+ */
+uint32_t EspClass::getCycleCount()
+{
+    return (uint32_t)(DM_Simulator::getMicrosecondsSinceBoot() * EspClass::CPUFrequencyMHz);
+}
+
+/**
+ * Get the frequency of the cores.
+ *
+ * @return The frequency in MHz.
+ */
+uint32_t EspClass::getCpuFreqMHz()
+{
+    return EspClass::CPUFrequencyMHz;
+}
+
+/**
+ * Get the amount of free memory.
+ *
+ * @return The amount of free bytes.
+ */
+uint32_t EspClass::getFreeHeap()
+{
+    return heap_caps_get_free_size(MALLOC_CAP_8BIT);
+}
+
+/**
+ * Read the clock in milliseconds.
+ *
+ * @return The amount of milliseconds since the boot.
+ */
+uint32_t millis()
+{
+    return (uint32_t)(DM_Simulator::getMicrosecondsSinceBoot() / 1000);
+}
+
+/**
+ * Read the clock in microseconds.
+ *
+ * @return The amount of microseconds since the boot.
+ */
+uint32_t micros()
+{
+    return (uint32_t)DM_Simulator::getMicrosecondsSinceBoot();
+}
+
+/**
+ * Wait (the other tasks run in the meantime, like "delay()" on the ESP32, which calls "vTaskDelay()").
+ *
+ * @param durationMs The time to wait in ms.
+ */
+void delay(uint32_t durationMs)
+{
+    DM_Simulator::sleep((uint64_t)durationMs * 1000);
+}
+
+/**
+ * Wait without letting another task run (a busy wait, like on the ESP32).
+ *
+ * @param durationUs The time to wait in µs.
+ */
+void delayMicroseconds(uint32_t durationUs)
+{
+    DM_Simulator::busyWait(durationUs);
+}
+
+/**
+ * Draw a random number (from the seed of the simulation, so it is the same in every run with the same seed).
+ *
+ * @param howBig The upper bound (not included).
+ *
+ * @return A number from 0 to "howBig - 1".
+ */
+long random(long howBig)
+{
+    return howBig > 0 ? (long)(DM_SimulatedWorld::drawUniform(DM_RANDOM_STATION) * howBig) : 0;
+}
+
+/**
+ * Draw a random number between two bounds.
+ *
+ * @param howSmall The lower bound (included).
+ * @param howBig The upper bound (not included).
+ *
+ * @return A number from "howSmall" to "howBig - 1".
+ */
+long random(long howSmall, long howBig)
+{
+    return howSmall >= howBig ? howSmall : howSmall + random(howBig - howSmall);
+}
+
+/**
+ * Does nothing: the random numbers come from the seed of the simulation ("--seed").
+ *
+ * @param seed Unused.
+ */
+void randomSeed(unsigned long seed)
+{
+}
+
+/**
+ * Start the SNTP client: the clock holds the real time once an NTP server could be reached for "SNTPDelayMs" (the time zone is ignored, the station only uses UTC).
+ *
+ * @param gmtOffsetSeconds Unused.
+ * @param daylightOffsetSeconds Unused.
+ * @param server1 Unused (every server gives the time of the simulated world).
+ * @param server2 Unused.
+ * @param server3 Unused.
+ */
+void configTime(long gmtOffsetSeconds, int daylightOffsetSeconds, const char *server1, const char *server2, const char *server3)
+{
+    SNTPStarted = true;
+    SNTPStartMs = DM_Simulator::getMicroseconds() / 1000;
+}
+
+/**
+ * Read the system clock of the station: the seconds since the boot until the SNTP client got the time, the real time of the simulated world after that.
+ * This replaces the "time()" of the C library for the whole program, so the station reads the simulated time without knowing it.
+ *
+ * @param result Where the time is also written to (if it isn't NULL).
+ *
+ * @return The Unix time (or the seconds since the boot).
+ */
+time_t time(time_t *result) noexcept
+{
+    struct timeval now;
+    gettimeofday(&now, nullptr);
+    if (result != nullptr)
+        *result = now.tv_sec;
+    return now.tv_sec;
+}
+
+/**
+ * Read the system clock of the station with microseconds (see "time()").
+ *
+ * @param now Where the time is written to.
+ * @param timeZone Unused.
+ *
+ * @return 0.
+ */
+int gettimeofday(struct timeval *now, void *timeZone) noexcept
+{
+    // The clock gets synchronized the first time it is read after the SNTP client reached a server
+    uint64_t nowUs = DM_Simulator::getMicroseconds();
+    if (SNTPStarted && !clockSynchronized && nowUs / 1000 >= SNTPStartMs + SNTPDelayMs && DM_SimulatedNetwork::isInternetReachable())
+        clockSynchronized = true;
+
+    // Count from the real time at the boot once it is known
+    now->tv_sec = (clockSynchronized ? DM_SimulatedWorld::getStartEpochSeconds() : 0) + nowUs / 1000000;
+    now->tv_usec = nowUs % 1000000;
+    return 0;
+}
\ No newline at end of file
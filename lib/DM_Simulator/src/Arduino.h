@@ -0,0 +1,161 @@
+/** +----------------------------------------------+
+ *  |      Arduino - Simulated Arduino core        |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef Arduino_h
+#define Arduino_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h>            // Used to be able to use the "size_t" type
+#include <stdint.h>            // Used to be able to use the fixed width integer types
+#include <stdio.h>             // The Arduino core makes the C library available to every file that includes it
+#include <stdlib.h>            // The Arduino core makes the C library available to every file that includes it
+#include <string.h>            // The Arduino core makes the C library available to every file that includes it
+#include <math.h>              // The Arduino core makes the C library available to every file that includes it
+#include <algorithm>           // Used to be able to use "min()" and "max()" like the ESP32 core does
+#include <string>              // Used to hold the characters of a "String"
+#include <freertos/FreeRTOS.h> // The ESP32 core includes FreeRTOS in every file that includes it
+#include <freertos/task.h>     // The ESP32 core includes FreeRTOS in every file that includes it
+
+// The ESP32 core uses the functions of the standard library for these
+using std::max;
+using std::min;
+
+// DECLARE THE MACROS AND TYPES OF THE ARDUINO CORE
+#define RTC_DATA_ATTR // There is no deep sleep that clears the RAM in the simulator, so RTC memory is normal memory
+#define constrain(amount, low, high) ((amount) < (low) ? (low) : ((amount) > (high) ? (high) : (amount)))
+typedef uint8_t byte;
+typedef bool boolean;
+
+/**
+ * A text, with the part of the interface of the Arduino "String" the station uses.
+ */
+class String
+{
+public: // The public functions
+    String(const char *text = "");
+    String(const std::string &text);
+    explicit String(int number);
+    const char *c_str() const;
+    unsigned int length() const;
+    long toInt() const;
+    float toFloat() const;
+    bool equals(const char *text) const;
+    bool operator==(const char *text) const;
+    bool operator!=(const char *text) const;
+    bool operator==(const String &text) const;
+    bool operator!=(const String &text) const;
+    String &operator+=(const char *text);
+
+private: // The private members
+    std::string _text; // The characters
+};
+
+/**
+ * An IPv4 address, stored like the ESP32 stores it (the first byte of the address in the lowest byte).
+ */
+class IPAddress
+{
+public: // The public functions
+    IPAddress();
+    IPAddress(uint8_t first, uint8_t second, uint8_t third, uint8_t fourth);
+    IPAddress(uint32_t address);
+    operator uint32_t() const;
+    uint8_t operator[](int index) const;
+    bool operator==(const IPAddress &address) const;
+    bool operator!=(const IPAddress &address) const;
+    String toString() const;
+
+private: // The private members
+    uint32_t _address; // The address
+};
+
+// The address that means "no address" (e.g. to go back to DHCP)
+const IPAddress INADDR_NONE(0, 0, 0, 0);
+
+/**
+ * Writes text and numbers to a stream of bytes, like the Arduino "Print" class.
+ */
+class Print
+{
+public: // The public functions
+    virtual ~Print() {}
+    virtual size_t write(uint8_t character);
+    virtual size_t write(const uint8_t *buffer, size_t size) = 0;
+    size_t print(const char *text);
+    size_t print(const String &text);
+    size_t print(char character);
+    size_t print(int number);
+    size_t print(unsigned int number);
+    size_t print(long number);
+    size_t print(unsigned long number);
+    size_t print(double number, int digits = 2);
+    size_t println();
+    size_t println(const char *text);
+    size_t println(const String &text);
+    size_t println(char character);
+    size_t println(int number);
+    size_t println(unsigned int number);
+    size_t println(long number);
+    size_t println(unsigned long number);
+    size_t println(double number, int digits = 2);
+};
+
+/**
+ * The serial port to the computer: what is written is shown by the simulator (see "DM_Simulator::showSerialOutput()"), what is read comes from the "--type" option.
+ *
+ * The port sends at the chosen baud rate through a 128-byte buffer, like the UART of the ESP32: a task that writes more than fits waits until there is room, so printing costs the same time as on the station.
+ */
+class HardwareSerial : public Print
+{
+public: // The public functions and constants
+    static constexpr size_t transmitBufferSize = 128; // The amount of bytes that can wait to be sent (the hardware buffer of the UART)
+
+    void begin(unsigned long baudRate);
+    void end();
+    int available();
+    int read();
+    void flush();
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+    operator bool() const;
+
+private: // The private members
+    unsigned long _baudRate = 0;    // The speed of the port (0 as long as it isn't started)
+    uint64_t _transmitDoneUs = 0;   // The moment the last byte in the buffer has been sent
+};
+extern HardwareSerial Serial;
+
+/**
+ * The functions of the ESP32 chip, with the part of the interface of "EspClass" the station uses.
+ */
+class EspClass
+{
+public: // The public functions and constants
+    static constexpr uint32_t CPUFrequencyMHz = 240; // The clock of the simulated cores
+
+    uint32_t getCycleCount();
+    uint32_t getCpuFreqMHz();
+    uint32_t getFreeHeap();
+};
+extern EspClass ESP;
+
+// DECLARE THE FUNCTIONS OF THE ARDUINO CORE (the clocks return "uint32_t" because "unsigned long" is 32 bits wide on the ESP32, so they wrap around exactly like they do on the station)
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t durationMs);
+void delayMicroseconds(uint32_t durationUs);
+long random(long howBig);
+long random(long howSmall, long howBig);
+void randomSeed(unsigned long seed);
+void configTime(long gmtOffsetSeconds, int daylightOffsetSeconds, const char *server1, const char *server2 = nullptr, const char *server3 = nullptr);
+
+// DECLARE THE FUNCTIONS OF THE STATION (see "main.cpp")
+void setup();
+void loop();
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,144 @@
+/** +----------------------------------------------+
+ *  |   BH1750 - Simulated light sensor library    |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "BH1750.h" // Include the header file where the declarations for this library are stored
+
+/**
+ * Create the sensor.
+ *
+ * @param address The I2C address of the chip.
+ */
+BH1750::BH1750(byte address) : _address(address), _wire(&Wire), _mode(UNCONFIGURED), _MTreg(defaultMTreg), _lastReadTimestamp(0)
+{
+}
+
+/**
+ * Set the mode of the chip and the default measurement time.
+ *
+ * @param mode The measurement mode.
+ * @param address The I2C address of the chip (0 keeps the address of the constructor).
+ * @param wire The I2C bus (NULL for "Wire").
+ *
+ * @return The success rate.
+ */
+bool BH1750::begin(Mode mode, byte address, TwoWire *wire)
+{
+    if (address != 0)
+        this->_address = address;
+    this->_wire = wire != nullptr ? wire : &Wire;
+    return this->configure(mode) && this->setMTreg(defaultMTreg);
+}
+
+/**
+ * Send a measurement mode to the chip (a one-time mode starts a conversion).
+ *
+ * @param mode The measurement mode.
+ *
+ * @return The success rate.
+ */
+bool BH1750::configure(Mode mode)
+{
+    if (mode != CONTINUOUS_HIGH_RES_MODE && mode != CONTINUOUS_HIGH_RES_MODE_2 && mode != CONTINUOUS_LOW_RES_MODE && mode != ONE_TIME_HIGH_RES_MODE && mode != ONE_TIME_HIGH_RES_MODE_2 && mode != ONE_TIME_LOW_RES_MODE)
+    {
+        Serial.println("[BH1750] ERROR: Invalid mode");
+        return false;
+    }
+    this->_wire->beginTransmission(this->_address);
+    this->_wire->write((uint8_t)mode);
+    byte ack = this->_wire->endTransmission();
+    delay(10);
+    this->_lastReadTimestamp = millis();
+    if (ack != 0)
+    {
+        Serial.println("[BH1750] ERROR: received NACK on transmit of address");
+        return false;
+    }
+    this->_mode = mode;
+    return true;
+}
+
+/**
+ * Set the measurement time register of the chip (and send the mode again, which starts a conversion in a one-time mode).
+ *
+ * @param MTreg The measurement time register (31 to 254).
+ *
+ * @return The success rate.
+ */
+bool BH1750::setMTreg(byte MTreg)
+{
+    if (MTreg < 31 || MTreg > 254)
+    {
+        Serial.println("[BH1750] ERROR: MTreg out of range");
+        return false;
+    }
+    this->_wire->beginTransmission(this->_address);
+    this->_wire->write((uint8_t)((0b01000 << 3) | (MTreg >> 5)));
+    byte ack = this->_wire->endTransmission();
+    this->_wire->beginTransmission(this->_address);
+    this->_wire->write((uint8_t)((0b011 << 5) | (MTreg & 0b11111)));
+    ack = ack | this->_wire->endTransmission();
+    this->_wire->beginTransmission(this->_address);
+    this->_wire->write((uint8_t)this->_mode);
+    ack = ack | this->_wire->endTransmission();
+    delay(10);
+    if (ack != 0)
+    {
+        Serial.println("[BH1750] ERROR: received NACK on transmit of address");
+        return false;
+    }
+    this->_MTreg = MTreg;
+    return true;
+}
+
+/**
+ * Check if the conversion that was started last is done (only from the time that passed, the chip isn't asked).
+ *
+ * @param maxWait True to use the longest conversion time of the datasheet instead of the typical one.
+ *
+ * @return True if the result can be read.
+ */
+bool BH1750::measurementReady(bool maxWait)
+{
+    unsigned long delayTimeMs = 0;
+    if (this->_mode == CONTINUOUS_LOW_RES_MODE || this->_mode == ONE_TIME_LOW_RES_MODE)
+        delayTimeMs = maxWait ? (24 * this->_MTreg / defaultMTreg) : (16 * this->_MTreg / defaultMTreg);
+    else
+        delayTimeMs = maxWait ? (180 * this->_MTreg / defaultMTreg) : (120 * this->_MTreg / defaultMTreg);
+    return millis() - this->_lastReadTimestamp >= delayTimeMs;
+}
+
+/**
+ * Read the result of the last conversion.
+ *
+ * @return The light level in lux, -1 if the chip didn't answer, or -2 if no mode was configured.
+ */
+float BH1750::readLightLevel()
+{
+    if (this->_mode == UNCONFIGURED)
+    {
+        Serial.println("[BH1750] Device is not configured!");
+        return -2.0;
+    }
+    float level = -1.0;
+    if (this->_wire->requestFrom(this->_address, (uint8_t)2) == 2)
+    {
+        unsigned int counts = this->_wire->read() << 8;
+        counts |= this->_wire->read();
+        level = counts;
+    }
+    this->_lastReadTimestamp = millis();
+    if (level != -1.0)
+    {
+        if (this->_MTreg != defaultMTreg)
+            level *= (float)defaultMTreg / this->_MTreg;
+        if (this->_mode == ONE_TIME_HIGH_RES_MODE_2 || this->_mode == CONTINUOUS_HIGH_RES_MODE_2)
+            level /= 2;
+        level /= conversionFactor;
+    }
+    return level;
+}
\ No newline at end of file
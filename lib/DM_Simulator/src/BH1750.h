@@ -0,0 +1,50 @@
+/** +----------------------------------------------+
+ *  |   BH1750 - Simulated light sensor library    |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef BH1750_h
+#define BH1750_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "Arduino.h" // Used to be able to use the "byte" type and the clock
+#include "Wire.h"    // Used to talk to the chip over the I2C bus
+
+/**
+ * The "BH1750" library (claws/BH1750 1.3) with the part of the interface the station uses: the same I2C transactions, delays and conversions as the real library, on the simulated I2C bus.
+ */
+class BH1750
+{
+public: // The public functions and constants
+    enum Mode
+    {
+        UNCONFIGURED = 0,
+        CONTINUOUS_HIGH_RES_MODE = 0x10,
+        CONTINUOUS_HIGH_RES_MODE_2 = 0x11,
+        CONTINUOUS_LOW_RES_MODE = 0x13,
+        ONE_TIME_HIGH_RES_MODE = 0x20,
+        ONE_TIME_HIGH_RES_MODE_2 = 0x21,
+        ONE_TIME_LOW_RES_MODE = 0x23
+    };
+    static constexpr byte defaultMTreg = 69;       // The measurement time register after "begin()"
+    static constexpr float conversionFactor = 1.2; // The counts per lux with the default measurement time
+
+    BH1750(byte address = 0x23);
+    bool begin(Mode mode = CONTINUOUS_HIGH_RES_MODE, byte address = 0x23, TwoWire *wire = nullptr);
+    bool configure(Mode mode);
+    bool setMTreg(byte MTreg);
+    bool measurementReady(bool maxWait = false);
+    float readLightLevel();
+
+private: // The private members
+    byte _address;                    // The I2C address of the chip
+    TwoWire *_wire;                   // The I2C bus of the chip
+    Mode _mode;                       // The configured measurement mode
+    byte _MTreg;                      // The measurement time register
+    unsigned long _lastReadTimestamp; // The moment the last conversion was started or read
+};
+
+#endif // End the header guard
\ No newline at end of file
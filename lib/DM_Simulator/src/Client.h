@@ -0,0 +1,27 @@
+/** +----------------------------------------------+
+ *  |      Client - Simulated network client       |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef Client_h
+#define Client_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stdint.h> // Used to be able to use the fixed width integer types
+
+/**
+ * A connection to a server, with the part of the interface of the Arduino "Client" class the network libraries use.
+ */
+class Client
+{
+public: // The public functions
+    virtual ~Client() {}
+    virtual int connect(const char *host, uint16_t port) = 0;
+    virtual uint8_t connected() = 0;
+    virtual void stop() = 0;
+};
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,205 @@
+/** +----------------------------------------------+
+ *  |  DM_SimulatedCodec - Compression benchmark   |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "DM_SimulatedCodec.h" // Include the header file where the declarations for this library are stored
+#include "DM_SimulatedWorld.h" // Used to give the samples the Unix time of the simulated clock
+#include <DM_Sample.h>         // Used to convert the readings to fixed-point like the station does ("DM_PackedSample::pack()")
+#include <math.h>              // Used to mark a reading that was not taken yet ("NAN")
+#include <string.h>            // Used to move the samples of the open page to the front of the block
+#include <algorithm>           // Used to find the moment the next sample is due ("std::max()")
+#include <chrono>              // Used to measure how long the compression takes
+
+// INITIALIZE THE CLASS MEMBERS (the "static" members of the class)
+DM_PackedSample DM_SimulatedCodec::_samples[DM_SimulatedCodec::blockSize];                       // The samples that have not been compressed into a closed page yet
+uint32_t DM_SimulatedCodec::_epochs[DM_SimulatedCodec::blockSize];                               // The Unix time of those samples
+size_t DM_SimulatedCodec::_amount = 0;                                                           // The amount of samples in the block
+uint8_t DM_SimulatedCodec::_pages[DM_SimulatedCodec::maxPagesPerBlock][DM_StorageLog::pageSize]; // The pages the block is compressed into
+uint32_t DM_SimulatedCodec::_pageAmounts[DM_SimulatedCodec::maxPagesPerBlock];                   // The amount of samples in every page
+size_t DM_SimulatedCodec::_pageLengths[DM_SimulatedCodec::maxPagesPerBlock];                     // The amount of bytes used in every page (behind the page header)
+size_t DM_SimulatedCodec::_pageStarts[DM_SimulatedCodec::maxPagesPerBlock];                      // The position of the first sample of every page in the block
+double DM_SimulatedCodec::_lux = NAN;                                                            // The last light level the BH1750 measured
+uint64_t DM_SimulatedCodec::_nextSampleMs = 0;                                                   // The moment the next sample is due
+bool DM_SimulatedCodec::_finished = false;                                                       // True once the last page has been closed
+uint32_t DM_SimulatedCodec::_totalSamples = 0;                                                   // The amount of samples taken since the start
+uint32_t DM_SimulatedCodec::_fullPages = 0;                                                      // The amount of pages that were closed because they were full
+uint64_t DM_SimulatedCodec::_flashBytes = 0;                                                     // The amount of flash the closed pages take
+uint32_t DM_SimulatedCodec::_mismatches = 0;                                                     // The amount of samples that did not decode to what went in
+uint64_t DM_SimulatedCodec::_encodedSamples = 0;                                                 // The amount of samples compressed (the samples of an open page are compressed again with the next block)
+uint64_t DM_SimulatedCodec::_encodeNs = 0;                                                       // The time the compression took
+uint64_t DM_SimulatedCodec::_decodedSamples = 0;                                                 // The amount of samples decompressed
+uint64_t DM_SimulatedCodec::_decodeNs = 0;                                                       // The time the decompression took
+
+/**
+ * Take in a conversion of the BMP280, and take a sample with it and the last light level once the next sample is due.
+ *
+ * @param timeMs The moment of the conversion (in milliseconds since the start).
+ * @param temperatureC The temperature the chip measured (NAN if it was not measured).
+ * @param pressurePa The air pressure the chip measured (NAN if it was not measured).
+ */
+void DM_SimulatedCodec::setBMP280Reading(uint64_t timeMs, double temperatureC, double pressurePa)
+{
+    // Only sample at the rate of the station
+    if (timeMs < DM_SimulatedCodec::_nextSampleMs || DM_SimulatedCodec::_finished)
+        return;
+    DM_SimulatedCodec::_nextSampleMs = std::max(DM_SimulatedCodec::_nextSampleMs + samplePeriodMs, timeMs);
+
+    // Convert the readings to fixed-point like the station does before it compresses them
+    DM_Sample sample = {};
+    sample.timestampMs = (uint32_t)timeMs;
+    sample.epochSeconds = DM_SimulatedWorld::getStartEpochSeconds() + (uint32_t)(timeMs / 1000);
+    sample.temperatureC = (float)temperatureC;
+    sample.airPressurePa = (float)pressurePa;
+    sample.airPressureBar = (float)(pressurePa / 100000);
+    sample.lightIntensityLux = (float)DM_SimulatedCodec::_lux;
+    DM_SimulatedCodec::_samples[DM_SimulatedCodec::_amount] = DM_PackedSample::pack(sample);
+    DM_SimulatedCodec::_epochs[DM_SimulatedCodec::_amount] = sample.epochSeconds;
+    DM_SimulatedCodec::_amount += 1;
+    DM_SimulatedCodec::_totalSamples += 1;
+
+    // Compress the block once it is full
+    if (DM_SimulatedCodec::_amount == blockSize)
+        DM_SimulatedCodec::_compressBlock(false);
+}
+
+/**
+ * Take in a conversion of the BH1750 (it is used by the next sample).
+ *
+ * @param lux The light level the chip measured.
+ */
+void DM_SimulatedCodec::setBH1750Reading(double lux)
+{
+    DM_SimulatedCodec::_lux = lux;
+}
+
+/**
+ * Get how long the compression of one sample took on this computer.
+ *
+ * @return The mean time in nanoseconds (0 if nothing was compressed).
+ */
+double DM_SimulatedCodec::getEncodeNanosecondsPerSample()
+{
+    DM_SimulatedCodec::_finish();
+    return DM_SimulatedCodec::_encodedSamples > 0 ? (double)DM_SimulatedCodec::_encodeNs / DM_SimulatedCodec::_encodedSamples : 0.0;
+}
+
+/**
+ * Get how long the decompression of one sample took on this computer.
+ *
+ * @return The mean time in nanoseconds (0 if nothing was decompressed).
+ */
+double DM_SimulatedCodec::getDecodeNanosecondsPerSample()
+{
+    DM_SimulatedCodec::_finish();
+    return DM_SimulatedCodec::_decodedSamples > 0 ? (double)DM_SimulatedCodec::_decodeNs / DM_SimulatedCodec::_decodedSamples : 0.0;
+}
+
+/**
+ * Show how well the samples were compressed.
+ */
+void DM_SimulatedCodec::printSummary()
+{
+    DM_SimulatedCodec::_finish();
+    double bytesPerSample = DM_SimulatedCodec::_totalSamples > 0 ? (double)DM_SimulatedCodec::_flashBytes / DM_SimulatedCodec::_totalSamples : 0.0;
+    printf("Codec: %lu samples in %.2f bytes of flash each (%.1fx smaller than packed), %lu mismatches, %.0f ns to compress and %.0f ns to decompress a sample\n",
+           (unsigned long)DM_SimulatedCodec::_totalSamples, bytesPerSample, bytesPerSample > 0 ? sizeof(DM_PackedSample) / bytesPerSample : 0.0, (unsigned long)DM_SimulatedCodec::_mismatches,
+           DM_SimulatedCodec::getEncodeNanosecondsPerSample(), DM_SimulatedCodec::getDecodeNanosecondsPerSample());
+}
+
+/**
+ * Write how well the samples were compressed as the "codec" member of the benchmark results (JSON).
+ * The times go in the "host" member, as they depend on the computer.
+ *
+ * @param file The file of the benchmark results.
+ */
+void DM_SimulatedCodec::printBenchmark(FILE *file)
+{
+    DM_SimulatedCodec::_finish();
+    double bytesPerSample = DM_SimulatedCodec::_totalSamples > 0 ? (double)DM_SimulatedCodec::_flashBytes / DM_SimulatedCodec::_totalSamples : 0.0;
+    fprintf(file, "  \"codec\": {\"samples\": %lu, \"full_pages\": %lu, \"flash_bytes_per_sample\": %.3f, \"ratio_to_packed\": %.2f, \"mismatches\": %lu}",
+            (unsigned long)DM_SimulatedCodec::_totalSamples, (unsigned long)DM_SimulatedCodec::_fullPages, bytesPerSample, bytesPerSample > 0 ? sizeof(DM_PackedSample) / bytesPerSample : 0.0, (unsigned long)DM_SimulatedCodec::_mismatches);
+}
+
+/**
+ * Compress the block into pages, decompress the pages that are closed and compare them with the samples that went in.
+ * A page is only closed once it is full (or at the end), so the samples of the open page are kept for the next block.
+ *
+ * @param last True to close the open page as well (at the end of the simulation).
+ */
+void DM_SimulatedCodec::_compressBlock(bool last)
+{
+    // Compress the samples like "DM_StorageLog::append()" does: a sample that does not fit anymore starts the next page
+    size_t pages = 0;
+    DM_Encoder encoder;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    encoder.begin(DM_SimulatedCodec::_pages[0] + DM_StorageLog::pageHeaderSize, DM_StorageLog::pageSize - DM_StorageLog::pageHeaderSize);
+    DM_SimulatedCodec::_pageStarts[0] = 0;
+    for (size_t i = 0; i < DM_SimulatedCodec::_amount; i++)
+    {
+        if (encoder.add(DM_SimulatedCodec::_samples[i], DM_SimulatedCodec::_epochs[i]))
+            continue;
+        DM_SimulatedCodec::_pageAmounts[pages] = encoder.getAmount();
+        DM_SimulatedCodec::_pageLengths[pages] = encoder.getLength();
+        pages += 1;
+        DM_SimulatedCodec::_pageStarts[pages] = i;
+        encoder.begin(DM_SimulatedCodec::_pages[pages] + DM_StorageLog::pageHeaderSize, DM_StorageLog::pageSize - DM_StorageLog::pageHeaderSize);
+        encoder.add(DM_SimulatedCodec::_samples[i], DM_SimulatedCodec::_epochs[i]);
+    }
+    DM_SimulatedCodec::_encodeNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    DM_SimulatedCodec::_encodedSamples += DM_SimulatedCodec::_amount;
+    DM_SimulatedCodec::_fullPages += pages;
+    DM_SimulatedCodec::_flashBytes += pages * DM_StorageLog::pageSize;
+
+    // Close the open page at the end (only the part of it that is used counts, the station fills the rest later)
+    if (last && encoder.getAmount() > 0)
+    {
+        DM_SimulatedCodec::_pageAmounts[pages] = encoder.getAmount();
+        DM_SimulatedCodec::_pageLengths[pages] = encoder.getLength();
+        DM_SimulatedCodec::_flashBytes += DM_StorageLog::pageHeaderSize + encoder.getLength();
+        pages += 1;
+    }
+
+    // Decompress the closed pages, and compare every sample with the one that went in
+    static DM_PackedSample decoded[blockSize];
+    static uint32_t decodedEpochs[blockSize];
+    size_t amount = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t page = 0; page < pages; page++)
+    {
+        DM_Decoder decoder;
+        decoder.begin(DM_SimulatedCodec::_pages[page] + DM_StorageLog::pageHeaderSize, DM_SimulatedCodec::_pageLengths[page], DM_SimulatedCodec::_pageAmounts[page]);
+        while (amount < blockSize && decoder.next(decoded[amount], decodedEpochs[amount]))
+            amount += 1;
+    }
+    DM_SimulatedCodec::_decodeNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    DM_SimulatedCodec::_decodedSamples += amount;
+    size_t closed = pages == 0 ? 0 : DM_SimulatedCodec::_pageStarts[pages - 1] + DM_SimulatedCodec::_pageAmounts[pages - 1];
+    for (size_t i = 0; i < closed; i++)
+    {
+        const DM_PackedSample &in = DM_SimulatedCodec::_samples[i];
+        const DM_PackedSample &out = decoded[i];
+        bool equal = i < amount && in.timestampMs == out.timestampMs && in.airPressure == out.airPressure && in.temperature == out.temperature && in.lightIntensity == out.lightIntensity &&
+                     DM_SimulatedCodec::_epochs[i] == decodedEpochs[i];
+        DM_SimulatedCodec::_mismatches += equal ? 0 : 1;
+    }
+
+    // Keep the samples of the open page for the next block
+    DM_SimulatedCodec::_amount -= closed;
+    memmove(DM_SimulatedCodec::_samples, DM_SimulatedCodec::_samples + closed, DM_SimulatedCodec::_amount * sizeof(DM_PackedSample));
+    memmove(DM_SimulatedCodec::_epochs, DM_SimulatedCodec::_epochs + closed, DM_SimulatedCodec::_amount * sizeof(uint32_t));
+}
+
+/**
+ * Compress the samples that are left and close the open page (only once, the summary and the benchmark results both need it).
+ */
+void DM_SimulatedCodec::_finish()
+{
+    if (DM_SimulatedCodec::_finished)
+        return;
+    DM_SimulatedCodec::_compressBlock(true);
+    DM_SimulatedCodec::_finished = true;
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+/** +----------------------------------------------+
+ *  |  DM_SimulatedCodec - Compression benchmark   |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef DM_SimulatedCodec_h
+#define DM_SimulatedCodec_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h>     // Used to be able to use the "size_t" type
+#include <stdint.h>     // Used to be able to use the fixed width integer types
+#include <stdio.h>      // Used to write the benchmark results
+#include <DM_Codec.h>   // Used to compress and decompress the samples like the flash log does
+#include <DM_Storage.h> // Used to fill pages of the size of the flash log
+
+/**
+ * Measures how well "DM_Encoder" compresses the weather the simulated sensors read (the model, or a replayed trace of a real station), and how long it takes on this computer.
+ *
+ * The readings are taken once a second, like the station samples, and compressed in blocks into pages of the flash log: a page is only closed once it is full, like on the station.
+ * Every closed page is decoded again and compared with what went in, so a change to the codec that loses a sample shows up as a mismatch.
+ */
+class DM_SimulatedCodec
+{
+public: // The public functions and constants
+    static const uint32_t samplePeriodMs = 1000;                                                                                                         // The time between two samples (the sampling cycle of the station)
+    static const size_t blockSize = 4096;                                                                                                                // The amount of samples that are compressed at once (so the timing is not just the clock)
+    static const size_t maxPagesPerBlock = blockSize * DM_Encoder::maxEncodedSampleSize / (DM_StorageLog::pageSize - DM_StorageLog::pageHeaderSize) + 2; // The most pages one block can fill
+
+    static void setBMP280Reading(uint64_t timeMs, double temperatureC, double pressurePa);
+    static void setBH1750Reading(double lux);
+    static double getEncodeNanosecondsPerSample();
+    static double getDecodeNanosecondsPerSample();
+    static void printSummary();
+    static void printBenchmark(FILE *file);
+
+private: // The private functions and members
+    static DM_PackedSample _samples[blockSize];
+    static uint32_t _epochs[blockSize];
+    static size_t _amount;
+    static uint8_t _pages[maxPagesPerBlock][DM_StorageLog::pageSize];
+    static uint32_t _pageAmounts[maxPagesPerBlock];
+    static size_t _pageLengths[maxPagesPerBlock];
+    static size_t _pageStarts[maxPagesPerBlock];
+    static double _lux;
+    static uint64_t _nextSampleMs;
+    static bool _finished;
+    static uint32_t _totalSamples;
+    static uint32_t _fullPages;
+    static uint64_t _flashBytes;
+    static uint32_t _mismatches;
+    static uint64_t _encodedSamples;
+    static uint64_t _encodeNs;
+    static uint64_t _decodedSamples;
+    static uint64_t _decodeNs;
+    static void _compressBlock(bool last);
+    static void _finish();
+};
+
+#endif // End the header guard
\ No newline at end of file
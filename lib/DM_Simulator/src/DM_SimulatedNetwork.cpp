@@ -0,0 +1,698 @@
+/** +----------------------------------------------+
+ *  |   DM_SimulatedNetwork - Wi-Fi and servers    |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "DM_SimulatedNetwork.h" // Include the header file where the declarations for this library are stored
+#include "DM_Simulator.h"        // Used to read the virtual clock and to let the network time pass
+#include "DM_SimulatedWorld.h"   // Used to read the outages and to draw the latencies
+#include "ESPAsyncWebServer.h"   // Used to request the pages of the web server of the station
+#include "esp_heap_caps.h"       // Used to keep the times of the measurements ThingSpeak received out of the heap of the station
+#include <stdio.h>               // Used to show the summary and the pages
+#include <string.h>              // Used to compare the BSSIDs and to find the routes of the URLs
+#include <math.h>                // Used to spread the latencies exponentially
+#include <algorithm>             // Used to limit the waits to the timeouts ("std::min()")
+#include <time.h>                // Used to read the real time of the measurements in a bulk update ("timegm()")
+
+// INITIALIZE THE CLASS MEMBERS (the "static" members of the class)
+DM_SimulatedNetwork::_WiFiStates DM_SimulatedNetwork::_state = DM_SimulatedNetwork::_WIFI_OFF;
+uint32_t DM_SimulatedNetwork::_WiFiSession = 0;
+uint32_t DM_SimulatedNetwork::_amountOfWiFiConnects = 0;
+uint64_t DM_SimulatedNetwork::_WiFiStartMs = 0;
+uint64_t DM_SimulatedNetwork::_WiFiFoundMs = 0;
+uint64_t DM_SimulatedNetwork::_WiFiConnectedMs = 0;
+DM_SimulatedAccessPoint *DM_SimulatedNetwork::_accessPoint = nullptr;
+IPAddress DM_SimulatedNetwork::_staticIP[4]; // The addresses set with "config()" (local IP, gateway, subnet mask, DNS server), all 0 to use DHCP
+IPAddress DM_SimulatedNetwork::_IP[4];       // The addresses of the current connection (in the same order)
+std::vector<DM_SimulatedAccessPoint> DM_SimulatedNetwork::_accessPoints;
+std::vector<DM_SimulatedAccessPoint> DM_SimulatedNetwork::_scanResults;
+bool DM_SimulatedNetwork::_scanStarted = false;
+uint64_t DM_SimulatedNetwork::_scanEndMs = 0;
+uint32_t DM_SimulatedNetwork::_amountOfScans = 0;
+DM_SimulatedNetwork::_Endpoint DM_SimulatedNetwork::_ThingSpeak;
+DM_SimulatedNetwork::_Endpoint DM_SimulatedNetwork::_Discord;
+DM_SimulatedNetwork::_Endpoint DM_SimulatedNetwork::_Influx;
+DM_SimulatedNetwork::_Endpoint DM_SimulatedNetwork::_InfluxUDP;
+uint64_t DM_SimulatedNetwork::_lastBulkUpdateMs = 0;
+uint64_t DM_SimulatedNetwork::_DiscordWindowStartMs = 0;
+uint32_t DM_SimulatedNetwork::_DiscordRemaining = DM_SimulatedNetwork::DiscordRateLimit;
+uint32_t DM_SimulatedNetwork::_amountOfMQTTConnects = 0;
+DM_SimulatedNetwork::_Endpoint DM_SimulatedNetwork::_MQTT;
+std::map<std::string, uint32_t> DM_SimulatedNetwork::_MQTTMessages;
+uint64_t DM_SimulatedNetwork::_ThingSpeakAgeSumSeconds = 0; // The sum of the ages of the measurements ThingSpeak accepted (the time between the measurement and its delivery)
+uint32_t DM_SimulatedNetwork::_ThingSpeakMaxAgeSeconds = 0; // The age of the oldest measurement ThingSpeak accepted
+uint32_t DM_SimulatedNetwork::_ThingSpeakAgedItems = 0;     // The amount of accepted measurements with a real time (only those have an age)
+std::set<uint64_t> DM_SimulatedNetwork::_ThingSpeakTimes;   // The real time of every measurement ThingSpeak accepted
+uint32_t DM_SimulatedNetwork::_ThingSpeakDuplicates = 0;    // The amount of accepted measurements with the time of one that was accepted before (sent twice)
+uint32_t DM_SimulatedNetwork::_replayedItems = 0;           // The amount of replayed measurements ThingSpeak accepted (older than "replayAgeSeconds")
+uint64_t DM_SimulatedNetwork::_replayMs = 0;                // The time the replays took (from the first to the last bulk update of every replay)
+uint64_t DM_SimulatedNetwork::_lastReplayMs = 0;            // The moment of the last bulk update with replayed measurements (0 before the first one)
+
+// OTHER VARIABLES
+const IPAddress DHCPAddresses[4] = {IPAddress(192, 168, 1, 42), IPAddress(192, 168, 1, 1), IPAddress(255, 255, 255, 0), IPAddress(192, 168, 1, 1)}; // The addresses the router hands out
+const int HTTPReadTimeout = -11;                                                                                                                    // The error code of "HTTPClient" when the server doesn't answer in time
+
+/**
+ * Turn the Wi-Fi chip on or off (turning it off breaks the connection).
+ *
+ * @param on True to turn the chip on.
+ */
+void DM_SimulatedNetwork::setWiFiMode(bool on)
+{
+    if (!on)
+        DM_SimulatedNetwork::_state = _WIFI_OFF;
+    else if (DM_SimulatedNetwork::_state == _WIFI_OFF)
+        DM_SimulatedNetwork::_state = _WIFI_IDLE;
+}
+
+/**
+ * Start connecting to an access point (this returns right away, "getWiFiStatus()" follows the attempt).
+ *
+ * @param SSID The name of the network.
+ * @param channel The channel of the access point (0 if unknown).
+ * @param BSSID The MAC address of the access point (NULL if unknown).
+ */
+void DM_SimulatedNetwork::beginWiFi(const char *SSID, int32_t channel, const uint8_t *BSSID)
+{
+    // Choose the strongest access point that matches (the chip has to scan all channels to find it, unless the channel and the BSSID are given)
+    uint64_t nowMs = DM_SimulatedNetwork::_getNowMs();
+    DM_SimulatedNetwork::_createAccessPoints();
+    DM_SimulatedNetwork::_accessPoint = nullptr;
+    for (DM_SimulatedAccessPoint &accessPoint : DM_SimulatedNetwork::_accessPoints)
+    {
+        bool matches = accessPoint.SSID == SSID && (BSSID == nullptr || memcmp(accessPoint.BSSID, BSSID, sizeof(accessPoint.BSSID)) == 0) && (channel == 0 || accessPoint.channel == channel);
+        if (matches && (DM_SimulatedNetwork::_accessPoint == nullptr || accessPoint.RSSI > DM_SimulatedNetwork::_accessPoint->RSSI))
+            DM_SimulatedNetwork::_accessPoint = &accessPoint;
+    }
+
+    // Plan the attempt: finding the access point, the association, and DHCP (skipped with a static IP address)
+    bool staticIP = (uint32_t)DM_SimulatedNetwork::_staticIP[0] != 0;
+    DM_SimulatedNetwork::_state = _WIFI_CONNECTING;
+    DM_SimulatedNetwork::_WiFiStartMs = nowMs;
+    DM_SimulatedNetwork::_WiFiFoundMs = nowMs + (BSSID != nullptr && channel != 0 ? findFastMs : findScanMs);
+    DM_SimulatedNetwork::_WiFiConnectedMs = DM_SimulatedNetwork::_WiFiFoundMs + associationMs;
+    if (!staticIP)
+        DM_SimulatedNetwork::_WiFiConnectedMs += DHCPMs - DHCPJitterMs + (uint64_t)(2 * DHCPJitterMs * DM_SimulatedWorld::drawUniform(DM_RANDOM_NETWORK));
+}
+
+/**
+ * Set static addresses for the next connection (all "INADDR_NONE" to go back to DHCP).
+ *
+ * @param localIP The IP address of the station.
+ * @param gateway The IP address of the router.
+ * @param subnet The subnet mask.
+ * @param DNS The IP address of the DNS server.
+ */
+void DM_SimulatedNetwork::configWiFi(IPAddress localIP, IPAddress gateway, IPAddress subnet, IPAddress DNS)
+{
+    DM_SimulatedNetwork::_staticIP[0] = localIP;
+    DM_SimulatedNetwork::_staticIP[1] = gateway;
+    DM_SimulatedNetwork::_staticIP[2] = subnet;
+    DM_SimulatedNetwork::_staticIP[3] = DNS;
+}
+
+/**
+ * Disconnect from the access point (or stop the attempt).
+ */
+void DM_SimulatedNetwork::disconnectWiFi()
+{
+    if (DM_SimulatedNetwork::_state != _WIFI_OFF)
+        DM_SimulatedNetwork::_state = _WIFI_IDLE;
+}
+
+/**
+ * Get the status of the Wi-Fi connection (an attempt or a connection is checked against the outages up to now).
+ *
+ * @return The status, with the values of the ESP32 core.
+ */
+wl_status_t DM_SimulatedNetwork::getWiFiStatus()
+{
+    // Follow the attempt: it fails when the access point isn't there when it is searched or disappears before the IP address is received
+    uint64_t nowMs = DM_SimulatedNetwork::_getNowMs();
+    if (DM_SimulatedNetwork::_state == _WIFI_CONNECTING && nowMs >= DM_SimulatedNetwork::_WiFiFoundMs)
+    {
+        if (DM_SimulatedNetwork::_accessPoint == nullptr || DM_SimulatedWorld::wasDown(DM_LINK_WIFI, DM_SimulatedNetwork::_WiFiStartMs, std::min(nowMs, DM_SimulatedNetwork::_WiFiConnectedMs)))
+            DM_SimulatedNetwork::_state = _WIFI_NO_SSID;
+        else if (nowMs >= DM_SimulatedNetwork::_WiFiConnectedMs)
+        {
+            // Connected: a new session, so the TCP connections of the previous one are broken
+            bool staticIP = (uint32_t)DM_SimulatedNetwork::_staticIP[0] != 0;
+            for (int i = 0; i < 4; i++)
+                DM_SimulatedNetwork::_IP[i] = staticIP ? DM_SimulatedNetwork::_staticIP[i] : DHCPAddresses[i];
+            DM_SimulatedNetwork::_state = _WIFI_CONNECTED;
+            DM_SimulatedNetwork::_WiFiSession += 1;
+            DM_SimulatedNetwork::_amountOfWiFiConnects += 1;
+        }
+    }
+
+    // A connection is lost as soon as the access points go down (and stays lost until the next attempt)
+    if (DM_SimulatedNetwork::_state == _WIFI_CONNECTED && DM_SimulatedWorld::wasDown(DM_LINK_WIFI, DM_SimulatedNetwork::_WiFiConnectedMs, nowMs))
+        DM_SimulatedNetwork::_state = _WIFI_LOST;
+
+    // Translate the state to the status of the ESP32 core
+    switch (DM_SimulatedNetwork::_state)
+    {
+    case _WIFI_OFF:
+        return WL_NO_SHIELD;
+    case _WIFI_CONNECTED:
+        return WL_CONNECTED;
+    case _WIFI_NO_SSID:
+        return WL_NO_SSID_AVAIL;
+    case _WIFI_LOST:
+        return WL_CONNECTION_LOST;
+    default:
+        return WL_DISCONNECTED;
+    }
+}
+
+/**
+ * Get the number of the current Wi-Fi connection (it goes up with every connection, so a TCP connection can tell if the Wi-Fi it was made over is still there).
+ *
+ * @return The number of the connection.
+ */
+uint32_t DM_SimulatedNetwork::getWiFiSession()
+{
+    return DM_SimulatedNetwork::_WiFiSession;
+}
+
+/**
+ * Get the IP address of the station.
+ *
+ * @return The address (0.0.0.0 without a connection).
+ */
+IPAddress DM_SimulatedNetwork::getLocalIP()
+{
+    return DM_SimulatedNetwork::getWiFiStatus() == WL_CONNECTED ? DM_SimulatedNetwork::_IP[0] : IPAddress();
+}
+
+/**
+ * Get the IP address of the router.
+ *
+ * @return The address (0.0.0.0 without a connection).
+ */
+IPAddress DM_SimulatedNetwork::getGatewayIP()
+{
+    return DM_SimulatedNetwork::getWiFiStatus() == WL_CONNECTED ? DM_SimulatedNetwork::_IP[1] : IPAddress();
+}
+
+/**
+ * Get the subnet mask.
+ *
+ * @return The mask (0.0.0.0 without a connection).
+ */
+IPAddress DM_SimulatedNetwork::getSubnetMask()
+{
+    return DM_SimulatedNetwork::getWiFiStatus() == WL_CONNECTED ? DM_SimulatedNetwork::_IP[2] : IPAddress();
+}
+
+/**
+ * Get the IP address of the DNS server.
+ *
+ * @return The address (0.0.0.0 without a connection).
+ */
+IPAddress DM_SimulatedNetwork::getDNSIP()
+{
+    return DM_SimulatedNetwork::getWiFiStatus() == WL_CONNECTED ? DM_SimulatedNetwork::_IP[3] : IPAddress();
+}
+
+/**
+ * Get the access point the station is connected to.
+ *
+ * @return The access point (NULL without a connection).
+ */
+DM_SimulatedAccessPoint *DM_SimulatedNetwork::getAccessPoint()
+{
+    return DM_SimulatedNetwork::getWiFiStatus() == WL_CONNECTED ? DM_SimulatedNetwork::_accessPoint : nullptr;
+}
+
+/**
+ * Read the signal strength of the connection (every reading adds a little noise).
+ *
+ * @return The signal strength in dBm (0 without a connection).
+ */
+int8_t DM_SimulatedNetwork::getRSSI()
+{
+    DM_SimulatedAccessPoint *accessPoint = DM_SimulatedNetwork::getAccessPoint();
+    return accessPoint != nullptr ? accessPoint->RSSI + (int8_t)lround(2 * DM_SimulatedWorld::drawNormal(DM_RANDOM_NETWORK)) : 0;
+}
+
+/**
+ * Start a scan of all channels (the results are there after "scanMs").
+ *
+ * @return True if the scan was started (the chip has to be on).
+ */
+bool DM_SimulatedNetwork::startScan()
+{
+    // A scan needs the chip
+    if (DM_SimulatedNetwork::_state == _WIFI_OFF)
+        return false;
+
+    // Find every access point that is up now, with the signal strength of this moment
+    uint64_t nowMs = DM_SimulatedNetwork::_getNowMs();
+    DM_SimulatedNetwork::_createAccessPoints();
+    DM_SimulatedNetwork::_scanResults.clear();
+    for (const DM_SimulatedAccessPoint &accessPoint : DM_SimulatedNetwork::_accessPoints)
+    {
+        if (accessPoint.SSID == DM_SimulatedWorld::getSSID() && DM_SimulatedWorld::isDown(DM_LINK_WIFI, nowMs))
+            continue;
+        DM_SimulatedNetwork::_scanResults.push_back(accessPoint);
+        DM_SimulatedNetwork::_scanResults.back().RSSI += (int8_t)lround(3 * DM_SimulatedWorld::drawNormal(DM_RANDOM_NETWORK));
+    }
+    DM_SimulatedNetwork::_scanStarted = true;
+    DM_SimulatedNetwork::_scanEndMs = nowMs + scanMs;
+    DM_SimulatedNetwork::_amountOfScans += 1;
+    return true;
+}
+
+/**
+ * Get the result of the scan.
+ *
+ * @return The amount of access points found, "WIFI_SCAN_RUNNING" while the scan runs, or "WIFI_SCAN_FAILED" if no scan was started.
+ */
+int16_t DM_SimulatedNetwork::getScanResult()
+{
+    if (!DM_SimulatedNetwork::_scanStarted)
+        return WIFI_SCAN_FAILED;
+    if (DM_SimulatedNetwork::_getNowMs() < DM_SimulatedNetwork::_scanEndMs)
+        return WIFI_SCAN_RUNNING;
+    return DM_SimulatedNetwork::_scanResults.size();
+}
+
+/**
+ * Forget the result of the scan.
+ */
+void DM_SimulatedNetwork::deleteScan()
+{
+    DM_SimulatedNetwork::_scanStarted = false;
+    DM_SimulatedNetwork::_scanResults.clear();
+}
+
+/**
+ * Get an access point the scan found.
+ *
+ * @param index The number of the access point.
+ *
+ * @return The access point (NULL if there is none with that number, or the scan isn't done).
+ */
+DM_SimulatedAccessPoint *DM_SimulatedNetwork::getScannedAccessPoint(uint8_t index)
+{
+    if (DM_SimulatedNetwork::getScanResult() <= index)
+        return nullptr;
+    return &DM_SimulatedNetwork::_scanResults[index];
+}
+
+/**
+ * Check if the servers on the internet can be reached now.
+ *
+ * @return True if the station is connected to Wi-Fi and the internet is up.
+ */
+bool DM_SimulatedNetwork::isInternetReachable()
+{
+    return DM_SimulatedNetwork::getWiFiStatus() == WL_CONNECTED && !DM_SimulatedWorld::isDown(DM_LINK_INTERNET, DM_SimulatedNetwork::_getNowMs());
+}
+
+/**
+ * Make a TCP connection to a server (this waits for the handshake).
+ * Without Wi-Fi this fails at once, without internet after the timeout, and a broker that is down refuses the connection after one round trip.
+ *
+ * @param host The server.
+ * @param port The port (1883 and 8883 are MQTT brokers).
+ * @param secure True to add the TLS handshake.
+ * @param timeoutMs The longest time to wait.
+ *
+ * @return True if the connection was made.
+ */
+bool DM_SimulatedNetwork::connect(const char *host, uint16_t port, bool secure, uint32_t timeoutMs)
+{
+    // Nothing can be reached without Wi-Fi, and nothing answers without internet
+    if (DM_SimulatedNetwork::getWiFiStatus() != WL_CONNECTED)
+        return false;
+    if (DM_SimulatedWorld::isDown(DM_LINK_INTERNET, DM_SimulatedNetwork::_getNowMs()))
+    {
+        DM_Simulator::sleep((uint64_t)timeoutMs * 1000);
+        return false;
+    }
+
+    // A broker that is down refuses the connection
+    uint32_t handshakeMs = DM_SimulatedNetwork::_drawLatencyMs(TCPHandshakeMs);
+    if ((port == 1883 || port == 8883) && DM_SimulatedWorld::isDown(DM_LINK_MQTT, DM_SimulatedNetwork::_getNowMs()))
+    {
+        DM_Simulator::sleep((uint64_t)handshakeMs * 1000);
+        return false;
+    }
+
+    // Wait for the handshake
+    if (secure)
+        handshakeMs += DM_SimulatedNetwork::_drawLatencyMs(TLSHandshakeMs);
+    DM_Simulator::sleep((uint64_t)std::min(handshakeMs, timeoutMs) * 1000);
+    return handshakeMs <= timeoutMs && DM_SimulatedNetwork::getWiFiStatus() == WL_CONNECTED;
+}
+
+/**
+ * Check if a TCP connection still works (it breaks when the Wi-Fi it was made over is gone, or when the internet or the broker was down since it was made).
+ *
+ * @param session The Wi-Fi connection the TCP connection was made over.
+ * @param port The port of the server.
+ * @param sinceMs The moment the TCP connection was made.
+ *
+ * @return True if the connection still works.
+ */
+bool DM_SimulatedNetwork::isConnectionAlive(uint32_t session, uint16_t port, uint64_t sinceMs)
+{
+    uint64_t nowMs = DM_SimulatedNetwork::_getNowMs();
+    return DM_SimulatedNetwork::getWiFiStatus() == WL_CONNECTED && session == DM_SimulatedNetwork::_WiFiSession && !DM_SimulatedWorld::wasDown(DM_LINK_INTERNET, sinceMs, nowMs) &&
+           !((port == 1883 || port == 8883) && DM_SimulatedWorld::wasDown(DM_LINK_MQTT, sinceMs, nowMs));
+}
+
+/**
+ * Let a server answer an HTTP request over a connection that is made (this waits for the answer).
+ *
+ * @param host The server.
+ * @param authorization The "Authorization" header of the request (empty if there is none).
+ * @param body The body of the request.
+ * @param length The length of the body.
+ * @param timeoutMs The longest time to wait for the answer.
+ * @param responseHeaders The headers of the answer (filled in).
+ *
+ * @return The status code of the answer, or "HTTPC_ERROR_READ_TIMEOUT" if the connection broke before the answer.
+ */
+int DM_SimulatedNetwork::answerHTTPRequest(const char *host, const char *authorization, const uint8_t *body, size_t length, uint32_t timeoutMs, DM_HTTPHeaders &responseHeaders)
+{
+    // The answer never comes if the Wi-Fi or the internet goes down before it arrives
+    uint64_t nowMs = DM_SimulatedNetwork::_getNowMs();
+    uint32_t answerMs = DM_SimulatedNetwork::_drawLatencyMs(serverTimeMs + (uint32_t)(serverJitterMs * DM_SimulatedWorld::drawUniform(DM_RANDOM_NETWORK)));
+    responseHeaders.clear();
+    if (answerMs > timeoutMs || DM_SimulatedWorld::wasDown(DM_LINK_WIFI, nowMs, nowMs + answerMs) || DM_SimulatedWorld::wasDown(DM_LINK_INTERNET, nowMs, nowMs + answerMs))
+    {
+        DM_Simulator::sleep((uint64_t)timeoutMs * 1000);
+        return HTTPReadTimeout;
+    }
+
+    // Let the server handle the request when it arrives
+    int statusCode;
+    if (strstr(host, "thingspeak.com") != nullptr)
+    {
+        // The bulk update API of ThingSpeak accepts one request every 15 seconds (every update in the body is an object)
+        DM_SimulatedNetwork::_ThingSpeak.requests += 1;
+        if (DM_SimulatedNetwork::_ThingSpeak.requests > 1 && nowMs - DM_SimulatedNetwork::_lastBulkUpdateMs < ThingSpeakBulkIntervalMs)
+        {
+            DM_SimulatedNetwork::_ThingSpeak.limited += 1;
+            statusCode = 429;
+        }
+        else
+        {
+            DM_SimulatedNetwork::_ThingSpeak.accepted += 1;
+            DM_SimulatedNetwork::_ThingSpeak.items += DM_SimulatedNetwork::_count(body, length, '{') - 1;
+            DM_SimulatedNetwork::_ThingSpeak.bytes += length;
+            DM_SimulatedNetwork::_addMeasurementAges(body, length, nowMs);
+            statusCode = 202;
+        }
+        DM_SimulatedNetwork::_lastBulkUpdateMs = nowMs;
+    }
+    else if (strncmp(authorization, "Token ", 6) == 0)
+    {
+        // The write API of InfluxDB accepts every request (one measurement per line)
+        DM_SimulatedNetwork::_Influx.requests += 1;
+        DM_SimulatedNetwork::_Influx.accepted += 1;
+        DM_SimulatedNetwork::_Influx.items += DM_SimulatedNetwork::_count(body, length, '\n') + (length > 0 && body[length - 1] != '\n' ? 1 : 0);
+        DM_SimulatedNetwork::_Influx.bytes += length;
+        statusCode = 204;
+    }
+    else
+    {
+        // A Discord webhook accepts a few messages per window, and tells how many are left and when the window ends
+        DM_SimulatedNetwork::_Discord.requests += 1;
+        if (nowMs >= DM_SimulatedNetwork::_DiscordWindowStartMs + DiscordRateWindowMs)
+        {
+            DM_SimulatedNetwork::_DiscordWindowStartMs = nowMs;
+            DM_SimulatedNetwork::_DiscordRemaining = DiscordRateLimit;
+        }
+        char resetAfter[16];
+        snprintf(resetAfter, sizeof(resetAfter), "%.3f", (DM_SimulatedNetwork::_DiscordWindowStartMs + DiscordRateWindowMs - nowMs) / 1000.0);
+        if (DM_SimulatedNetwork::_DiscordRemaining == 0)
+        {
+            DM_SimulatedNetwork::_Discord.limited += 1;
+            responseHeaders.push_back({"Retry-After", resetAfter});
+            responseHeaders.push_back({"X-RateLimit-Remaining", "0"});
+            statusCode = 429;
+        }
+        else
+        {
+            DM_SimulatedNetwork::_DiscordRemaining -= 1;
+            DM_SimulatedNetwork::_Discord.accepted += 1;
+            DM_SimulatedNetwork::_Discord.items += 1;
+            DM_SimulatedNetwork::_Discord.bytes += length;
+            responseHeaders.push_back({"X-RateLimit-Limit", std::to_string(DiscordRateLimit)});
+            responseHeaders.push_back({"X-RateLimit-Remaining", std::to_string(DM_SimulatedNetwork::_DiscordRemaining)});
+            statusCode = 204;
+        }
+        responseHeaders.push_back({"X-RateLimit-Reset-After", resetAfter});
+    }
+
+    // Wait for the answer
+    DM_Simulator::sleep((uint64_t)answerMs * 1000);
+    return statusCode;
+}
+
+/**
+ * Let the broker answer the CONNECT packet of a client over a connection that is made (this waits for the answer, the credentials are always accepted).
+ *
+ * @param host The broker.
+ * @param clientID The client ID.
+ *
+ * @return True if the broker accepted the client.
+ */
+bool DM_SimulatedNetwork::connectMQTT(const char *host, const char *clientID)
+{
+    DM_Simulator::sleep((uint64_t)DM_SimulatedNetwork::_drawLatencyMs(TCPHandshakeMs) * 1000);
+    if (!DM_SimulatedNetwork::isInternetReachable() || DM_SimulatedWorld::isDown(DM_LINK_MQTT, DM_SimulatedNetwork::_getNowMs()))
+        return false;
+    DM_SimulatedNetwork::_amountOfMQTTConnects += 1;
+    return true;
+}
+
+/**
+ * Hand an MQTT message to the TCP stack, the broker counts it per topic.
+ *
+ * @param host The broker.
+ * @param topic The topic.
+ * @param payload The message.
+ * @param length The length of the message.
+ *
+ * @return True if the message was sent.
+ */
+bool DM_SimulatedNetwork::publishMQTT(const char *host, const char *topic, const uint8_t *payload, size_t length)
+{
+    DM_Simulator::sleep((uint64_t)MQTTWriteMs * 1000);
+    DM_SimulatedNetwork::_MQTTMessages[std::string(host) + " " + topic] += 1;
+    DM_SimulatedNetwork::_MQTT.requests += 1;
+    DM_SimulatedNetwork::_MQTT.accepted += 1;
+    DM_SimulatedNetwork::_MQTT.items += 1;
+    DM_SimulatedNetwork::_MQTT.bytes += length;
+    return true;
+}
+
+/**
+ * Send a UDP datagram to the listener of InfluxDB (it is on the local network, so only the Wi-Fi is needed).
+ *
+ * @param host The listener.
+ * @param port The port of the listener.
+ * @param data The datagram.
+ * @param length The length of the datagram.
+ *
+ * @return True if the datagram was sent.
+ */
+bool DM_SimulatedNetwork::sendUDP(const char *host, uint16_t port, const uint8_t *data, size_t length)
+{
+    if (DM_SimulatedNetwork::getWiFiStatus() != WL_CONNECTED)
+        return false;
+    DM_SimulatedNetwork::_InfluxUDP.requests += 1;
+    DM_SimulatedNetwork::_InfluxUDP.accepted += 1;
+    DM_SimulatedNetwork::_InfluxUDP.items += DM_SimulatedNetwork::_count(data, length, '\n') + (length > 0 && data[length - 1] != '\n' ? 1 : 0);
+    DM_SimulatedNetwork::_InfluxUDP.bytes += length;
+    return true;
+}
+
+/**
+ * Request a page of the web server of the station and show the answer (the chunks are requested like the TCP stack does, one segment at a time).
+ *
+ * @param path The path of the page, with the query (e.g. "/history?from=1714521600").
+ */
+void DM_SimulatedNetwork::printPage(const char *path)
+{
+    // Let the server handle the request
+    AsyncWebServerRequest request(path);
+    if (!AsyncWebServer::handleRequest(&request))
+    {
+        printf("--- GET %s: the web server was not started ---\n", path);
+        return;
+    }
+    AsyncWebServerResponse *response = request.getResponse();
+    if (response == nullptr)
+    {
+        printf("--- GET %s: no response was sent ---\n", path);
+        return;
+    }
+
+    // Show the answer (a chunked answer is filled until the filler says it is done, and given up if it keeps asking to try again)
+    printf("--- GET %s: %d %s ---\n", path, response->getCode(), response->getContentType());
+    uint8_t buffer[pageChunkSize];
+    size_t index = 0;
+    int attemptsLeft = 3;
+    for (;;)
+    {
+        size_t length = response->fill(buffer, sizeof(buffer), index);
+        if (length == RESPONSE_TRY_AGAIN && --attemptsLeft > 0)
+            continue;
+        if (length == 0 || length == RESPONSE_TRY_AGAIN)
+            break;
+        fwrite(buffer, 1, length, stdout);
+        index += length;
+        attemptsLeft = 3;
+    }
+    if (attemptsLeft == 0)
+        printf("--- The response stopped after %lu bytes ---\n", (unsigned long)index);
+}
+
+/**
+ * Show what the access points and the servers saw of the station.
+ */
+void DM_SimulatedNetwork::printSummary()
+{
+    printf("Wi-Fi: %lu connections, %lu scans\n", (unsigned long)DM_SimulatedNetwork::_amountOfWiFiConnects, (unsigned long)DM_SimulatedNetwork::_amountOfScans);
+    printf("ThingSpeak bulk updates: %lu requests, %lu accepted with %lu measurements, %lu refused by the rate limit\n", (unsigned long)DM_SimulatedNetwork::_ThingSpeak.requests,
+           (unsigned long)DM_SimulatedNetwork::_ThingSpeak.accepted, (unsigned long)DM_SimulatedNetwork::_ThingSpeak.items, (unsigned long)DM_SimulatedNetwork::_ThingSpeak.limited);
+    if (DM_SimulatedNetwork::_ThingSpeakAgedItems > 0)
+        printf("ThingSpeak measurement age: mean %.1f s, max %lu s, %lu sent twice\n", (double)DM_SimulatedNetwork::_ThingSpeakAgeSumSeconds / DM_SimulatedNetwork::_ThingSpeakAgedItems,
+               (unsigned long)DM_SimulatedNetwork::_ThingSpeakMaxAgeSeconds, (unsigned long)DM_SimulatedNetwork::_ThingSpeakDuplicates);
+    if (DM_SimulatedNetwork::_replayMs > 0)
+        printf("ThingSpeak replay: %lu measurements in %.0f s (%.1f per minute)\n", (unsigned long)DM_SimulatedNetwork::_replayedItems, DM_SimulatedNetwork::_replayMs / 1000.0,
+               DM_SimulatedNetwork::_replayedItems * 60000.0 / DM_SimulatedNetwork::_replayMs);
+    printf("Discord: %lu requests, %lu messages accepted, %lu refused by the rate limit\n", (unsigned long)DM_SimulatedNetwork::_Discord.requests, (unsigned long)DM_SimulatedNetwork::_Discord.accepted,
+           (unsigned long)DM_SimulatedNetwork::_Discord.limited);
+    if (DM_SimulatedNetwork::_Influx.requests > 0)
+        printf("InfluxDB (HTTP): %lu requests with %lu lines\n", (unsigned long)DM_SimulatedNetwork::_Influx.requests, (unsigned long)DM_SimulatedNetwork::_Influx.items);
+    if (DM_SimulatedNetwork::_InfluxUDP.requests > 0)
+        printf("InfluxDB (UDP): %lu datagrams with %lu lines\n", (unsigned long)DM_SimulatedNetwork::_InfluxUDP.requests, (unsigned long)DM_SimulatedNetwork::_InfluxUDP.items);
+    printf("MQTT: %lu connections\n", (unsigned long)DM_SimulatedNetwork::_amountOfMQTTConnects);
+    for (const auto &topic : DM_SimulatedNetwork::_MQTTMessages)
+        printf("  %s: %lu messages\n", topic.first.c_str(), (unsigned long)topic.second);
+}
+
+/**
+ * Write what the servers received as the "uplink" member of the benchmark results (JSON): the requests, the measurements and the bytes per destination, and the age of the measurements ThingSpeak received.
+ *
+ * @param file The file of the benchmark results.
+ */
+void DM_SimulatedNetwork::printBenchmark(FILE *file)
+{
+    const _Endpoint *endpoints[5] = {&DM_SimulatedNetwork::_ThingSpeak, &DM_SimulatedNetwork::_Discord, &DM_SimulatedNetwork::_Influx, &DM_SimulatedNetwork::_InfluxUDP, &DM_SimulatedNetwork::_MQTT};
+    const char *names[5] = {"thingspeak", "discord", "influx_http", "influx_udp", "mqtt"};
+    double hours = DM_Simulator::getMicroseconds() / 3600e6;
+    fprintf(file, "  \"uplink\": {\n    \"wifi_connections\": %lu,\n    \"wifi_scans\": %lu,\n    \"mqtt_connections\": %lu,", (unsigned long)DM_SimulatedNetwork::_amountOfWiFiConnects,
+            (unsigned long)DM_SimulatedNetwork::_amountOfScans, (unsigned long)DM_SimulatedNetwork::_amountOfMQTTConnects);
+    for (int i = 0; i < 5; i++)
+        fprintf(file, "\n    \"%s\": {\"requests\": %lu, \"accepted\": %lu, \"rate_limited\": %lu, \"items\": %lu, \"bytes\": %llu, \"items_per_hour\": %.2f, \"bytes_per_hour\": %.1f},", names[i],
+                (unsigned long)endpoints[i]->requests, (unsigned long)endpoints[i]->accepted, (unsigned long)endpoints[i]->limited, (unsigned long)endpoints[i]->items, (unsigned long long)endpoints[i]->bytes,
+                hours > 0 ? endpoints[i]->items / hours : 0.0, hours > 0 ? endpoints[i]->bytes / hours : 0.0);
+    fprintf(file, "\n    \"thingspeak_mean_age_s\": %.1f,\n    \"thingspeak_max_age_s\": %lu,\n    \"thingspeak_duplicates\": %lu,",
+            DM_SimulatedNetwork::_ThingSpeakAgedItems > 0 ? (double)DM_SimulatedNetwork::_ThingSpeakAgeSumSeconds / DM_SimulatedNetwork::_ThingSpeakAgedItems : 0.0, (unsigned long)DM_SimulatedNetwork::_ThingSpeakMaxAgeSeconds,
+            (unsigned long)DM_SimulatedNetwork::_ThingSpeakDuplicates);
+
+    // The replay of the flash log after an outage (the throughput is 0 when every replay took a single bulk update)
+    fprintf(file, "\n    \"thingspeak_replay\": {\"items\": %lu, \"seconds\": %.1f, \"items_per_minute\": %.1f}\n  }", (unsigned long)DM_SimulatedNetwork::_replayedItems,
+            DM_SimulatedNetwork::_replayMs / 1000.0, DM_SimulatedNetwork::_replayMs > 0 ? DM_SimulatedNetwork::_replayedItems * 60000.0 / DM_SimulatedNetwork::_replayMs : 0.0);
+}
+
+/**
+ * Get the virtual time in milliseconds (the outages are planned in milliseconds).
+ *
+ * @return The time since the boot in ms.
+ */
+uint64_t DM_SimulatedNetwork::_getNowMs()
+{
+    return DM_Simulator::getMicroseconds() / 1000;
+}
+
+/**
+ * Create the access points the first time they are needed (the SSID of the home network can be changed with "--ssid" until then).
+ */
+void DM_SimulatedNetwork::_createAccessPoints()
+{
+    if (!DM_SimulatedNetwork::_accessPoints.empty())
+        return;
+    DM_SimulatedNetwork::_accessPoints.push_back({DM_SimulatedWorld::getSSID(), {0x24, 0x4B, 0xFE, 0x5A, 0x10, 0x01}, 1, -58});
+    DM_SimulatedNetwork::_accessPoints.push_back({DM_SimulatedWorld::getSSID(), {0x24, 0x4B, 0xFE, 0x5A, 0x10, 0x02}, 6, -71});
+    DM_SimulatedNetwork::_accessPoints.push_back({"NETGEAR42", {0xA0, 0x40, 0xA0, 0x7C, 0x33, 0x9E}, 11, -77});
+    DM_SimulatedNetwork::_accessPoints.push_back({"Proximus-Public-Wi-Fi", {0x02, 0x1E, 0x80, 0x4D, 0x61, 0xC2}, 6, -84});
+}
+
+/**
+ * Draw the duration of a network exchange: a fixed part plus an exponential delay (most exchanges are fast, a few are slow).
+ *
+ * @param baseMs The fixed part.
+ *
+ * @return The duration in ms.
+ */
+uint32_t DM_SimulatedNetwork::_drawLatencyMs(uint32_t baseMs)
+{
+    return baseMs + (uint32_t)(-log(1 - DM_SimulatedWorld::drawUniform(DM_RANDOM_NETWORK)) * networkJitterMs);
+}
+
+/**
+ * Count a character in a block of bytes.
+ *
+ * @param data The bytes.
+ * @param length The amount of bytes.
+ * @param character The character.
+ *
+ * @return The amount of times the character occurs.
+ */
+size_t DM_SimulatedNetwork::_count(const uint8_t *data, size_t length, char character)
+{
+    return std::count(data, data + length, (uint8_t)character);
+}
+
+/**
+ * Read the real time of every measurement in a bulk update of ThingSpeak ("created_at"), count how long ago it was measured, and how fast the replayed ones arrive.
+ *
+ * @param body The body of the request.
+ * @param length The length of the body.
+ * @param nowMs The moment the request arrived (since the boot).
+ */
+void DM_SimulatedNetwork::_addMeasurementAges(const uint8_t *body, size_t length, uint64_t nowMs)
+{
+    std::string text((const char *)body, length);
+    uint64_t nowEpochSeconds = DM_SimulatedWorld::getStartEpochSeconds() + nowMs / 1000;
+    uint32_t replayedItems = 0;
+    for (size_t position = text.find("\"created_at\":\""); position != std::string::npos; position = text.find("\"created_at\":\"", position + 1))
+    {
+        struct tm dateTime = {};
+        if (sscanf(text.c_str() + position + 14, "%4d-%2d-%2dT%2d:%2d:%2dZ", &dateTime.tm_year, &dateTime.tm_mon, &dateTime.tm_mday, &dateTime.tm_hour, &dateTime.tm_min, &dateTime.tm_sec) != 6)
+            continue;
+        dateTime.tm_year -= 1900;
+        dateTime.tm_mon -= 1;
+        uint64_t epochSeconds = (uint64_t)timegm(&dateTime);
+        uint32_t ageSeconds = epochSeconds < nowEpochSeconds ? (uint32_t)(nowEpochSeconds - epochSeconds) : 0;
+        DM_SimulatedNetwork::_ThingSpeakAgeSumSeconds += ageSeconds;
+        DM_SimulatedNetwork::_ThingSpeakMaxAgeSeconds = std::max(DM_SimulatedNetwork::_ThingSpeakMaxAgeSeconds, ageSeconds);
+        DM_SimulatedNetwork::_ThingSpeakAgedItems += 1;
+        replayedItems += ageSeconds > replayAgeSeconds ? 1 : 0;
+
+        // A measurement with the time of one that was received before was sent twice
+        bool counting = DM_SimulatedHeap::setCounting(false);
+        DM_SimulatedNetwork::_ThingSpeakDuplicates += DM_SimulatedNetwork::_ThingSpeakTimes.insert(epochSeconds).second ? 0 : 1;
+        DM_SimulatedHeap::setCounting(counting);
+    }
+
+    // A bulk update with replayed measurements shortly after the previous one belongs to the same replay, so the time between them counts
+    if (replayedItems == 0)
+        return;
+    if (DM_SimulatedNetwork::_lastReplayMs != 0 && nowMs - DM_SimulatedNetwork::_lastReplayMs <= replayGapMs)
+        DM_SimulatedNetwork::_replayMs += nowMs - DM_SimulatedNetwork::_lastReplayMs;
+    DM_SimulatedNetwork::_lastReplayMs = nowMs;
+    DM_SimulatedNetwork::_replayedItems += replayedItems;
+}
\ No newline at end of file
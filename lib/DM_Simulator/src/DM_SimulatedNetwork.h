@@ -0,0 +1,153 @@
+/** +----------------------------------------------+
+ *  |   DM_SimulatedNetwork - Wi-Fi and servers    |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef DM_SimulatedNetwork_h
+#define DM_SimulatedNetwork_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h> // Used to be able to use the "size_t" type
+#include <stdint.h> // Used to be able to use the fixed width integer types
+#include <stdio.h>  // Used to write the benchmark results
+#include <map>      // Used to count the messages per topic
+#include <set>      // Used to recognize a measurement ThingSpeak already received
+#include <string>   // Used to keep the names of the access points and the topics
+#include <utility>  // Used to keep the response headers as pairs
+#include <vector>   // Used to keep the access points and the response headers
+#include "WiFi.h"   // Used to be able to use "wl_status_t" and "IPAddress"
+
+// DECLARE THE STRUCT "DM_SimulatedAccessPoint" (an access point the station can see)
+struct DM_SimulatedAccessPoint
+{
+    std::string SSID; // The name of the network
+    uint8_t BSSID[6]; // The MAC address of the access point
+    int32_t channel;  // The channel
+    int8_t RSSI;      // The signal strength at the station in dBm (on average, every reading adds a little noise)
+};
+
+// DECLARE THE TYPE OF THE RESPONSE HEADERS (name and value)
+typedef std::vector<std::pair<std::string, std::string>> DM_HTTPHeaders;
+
+/**
+ * The network around the simulated station: the Wi-Fi chip with two access points of the home network and two of the neighbours, the internet behind the router, and the servers the station talks to.
+ *
+ * Connecting to Wi-Fi takes as long as on the ESP32 (finding the access point, the association and DHCP), which is why the fast path with the cached access point and IP address is faster here too.
+ * The servers answer like the real ones, with their rate limits:
+ *  - Every URL on "thingspeak.com" is the bulk update API of ThingSpeak (one bulk update every 15 seconds, otherwise 429).
+ *  - A request with an "Authorization: Token ..." header is the write API of InfluxDB.
+ *  - Every other URL is a Discord webhook (5 messages every 2 seconds, otherwise 429 with "Retry-After"), so the placeholder in "main.cpp" works as one.
+ *  - Every host accepts MQTT connections with any credentials, and counts the messages per topic.
+ * The outages of "DM_SimulatedWorld" break the connections that are open, and make new ones fail like they would on the station (at once without Wi-Fi, after the connect timeout without internet).
+ */
+class DM_SimulatedNetwork
+{
+public: // The public functions and constants
+    static constexpr uint32_t findFastMs = 50;                  // The time to find the access point when the channel and the BSSID are given
+    static constexpr uint32_t findScanMs = 2000;                // The time to find the access point by scanning all channels
+    static constexpr uint32_t associationMs = 300;              // The time of the authentication and the association
+    static constexpr uint32_t DHCPMs = 800;                     // The average time to get an IP address from DHCP
+    static constexpr uint32_t DHCPJitterMs = 400;               // The most the DHCP time differs from the average
+    static constexpr uint32_t DHCPLeaseSeconds = 86400;         // The lease time the router gives (a day, the default of most home routers)
+    static constexpr uint32_t scanMs = 2200;                    // The time a scan of all channels takes
+    static constexpr uint32_t TCPHandshakeMs = 30;              // The round trip to a server on the internet
+    static constexpr uint32_t TLSHandshakeMs = 200;             // The extra round trips and calculations of a TLS handshake
+    static constexpr uint32_t serverTimeMs = 150;               // The shortest time a server takes to answer an HTTP request
+    static constexpr uint32_t serverJitterMs = 150;             // The most the server time is longer (spread evenly)
+    static constexpr uint32_t networkJitterMs = 50;             // The average extra delay of the internet (spread exponentially, so there are a few slow requests)
+    static constexpr uint32_t MQTTWriteMs = 2;                  // The time to hand an MQTT message to the TCP stack
+    static constexpr uint32_t ThingSpeakBulkIntervalMs = 15000; // The shortest time between two bulk updates ThingSpeak accepts
+    static constexpr uint32_t DiscordRateLimit = 5;             // The amount of messages Discord accepts per window
+    static constexpr uint32_t DiscordRateWindowMs = 2000;       // The window of the Discord rate limit
+    static constexpr size_t pageChunkSize = 1460;               // The room for one chunk of a page of the web server (one TCP segment)
+    static constexpr uint32_t replayAgeSeconds = 600;           // The age above which a measurement ThingSpeak accepts counts as replayed (it waited longer than a batch, so it came from the flash log)
+    static constexpr uint32_t replayGapMs = 600000;             // The longest time between two bulk updates with replayed measurements that belong to the same replay
+
+    static void setWiFiMode(bool on);
+    static void beginWiFi(const char *SSID, int32_t channel, const uint8_t *BSSID);
+    static void configWiFi(IPAddress localIP, IPAddress gateway, IPAddress subnet, IPAddress DNS);
+    static void disconnectWiFi();
+    static wl_status_t getWiFiStatus();
+    static uint32_t getWiFiSession();
+    static IPAddress getLocalIP();
+    static IPAddress getGatewayIP();
+    static IPAddress getSubnetMask();
+    static IPAddress getDNSIP();
+    static DM_SimulatedAccessPoint *getAccessPoint();
+    static int8_t getRSSI();
+    static bool startScan();
+    static int16_t getScanResult();
+    static void deleteScan();
+    static DM_SimulatedAccessPoint *getScannedAccessPoint(uint8_t index);
+    static bool isInternetReachable();
+    static bool connect(const char *host, uint16_t port, bool secure, uint32_t timeoutMs);
+    static bool isConnectionAlive(uint32_t session, uint16_t port, uint64_t sinceMs);
+    static int answerHTTPRequest(const char *host, const char *authorization, const uint8_t *body, size_t length, uint32_t timeoutMs, DM_HTTPHeaders &responseHeaders);
+    static bool connectMQTT(const char *host, const char *clientID);
+    static bool publishMQTT(const char *host, const char *topic, const uint8_t *payload, size_t length);
+    static bool sendUDP(const char *host, uint16_t port, const uint8_t *data, size_t length);
+    static void printPage(const char *path);
+    static void printSummary();
+    static void printBenchmark(FILE *file);
+
+private: // The private functions and members
+    enum _WiFiStates
+    {
+        _WIFI_OFF,        // The chip is off
+        _WIFI_IDLE,       // The chip is on, but not connected
+        _WIFI_CONNECTING, // Finding the access point, associating and waiting for DHCP
+        _WIFI_CONNECTED,  // Connected with an IP address
+        _WIFI_NO_SSID,    // The access point was not found
+        _WIFI_LOST        // The connection was lost (until the next "begin()")
+    };
+    struct _Endpoint
+    {
+        uint32_t requests = 0; // The amount of requests
+        uint32_t accepted = 0; // The amount of requests that were accepted
+        uint32_t limited = 0;  // The amount of requests that were refused by the rate limit
+        uint32_t items = 0;    // The amount of measurements (or messages) in the accepted requests
+        uint64_t bytes = 0;    // The amount of bytes in the accepted requests (the bodies or the payloads)
+    };
+    static _WiFiStates _state;
+    static uint32_t _WiFiSession;
+    static uint32_t _amountOfWiFiConnects;
+    static uint64_t _WiFiStartMs;
+    static uint64_t _WiFiFoundMs;
+    static uint64_t _WiFiConnectedMs;
+    static DM_SimulatedAccessPoint *_accessPoint;
+    static IPAddress _staticIP[4];
+    static IPAddress _IP[4];
+    static std::vector<DM_SimulatedAccessPoint> _accessPoints;
+    static std::vector<DM_SimulatedAccessPoint> _scanResults;
+    static bool _scanStarted;
+    static uint64_t _scanEndMs;
+    static uint32_t _amountOfScans;
+    static _Endpoint _ThingSpeak;
+    static _Endpoint _Discord;
+    static _Endpoint _Influx;
+    static _Endpoint _InfluxUDP;
+    static uint64_t _lastBulkUpdateMs;
+    static uint64_t _DiscordWindowStartMs;
+    static uint32_t _DiscordRemaining;
+    static uint32_t _amountOfMQTTConnects;
+    static _Endpoint _MQTT;
+    static std::map<std::string, uint32_t> _MQTTMessages;
+    static uint64_t _ThingSpeakAgeSumSeconds;
+    static uint32_t _ThingSpeakMaxAgeSeconds;
+    static uint32_t _ThingSpeakAgedItems;
+    static std::set<uint64_t> _ThingSpeakTimes;
+    static uint32_t _ThingSpeakDuplicates;
+    static uint32_t _replayedItems;
+    static uint64_t _replayMs;
+    static uint64_t _lastReplayMs;
+    static uint64_t _getNowMs();
+    static void _createAccessPoints();
+    static uint32_t _drawLatencyMs(uint32_t baseMs);
+    static size_t _count(const uint8_t *data, size_t length, char character);
+    static void _addMeasurementAges(const uint8_t *body, size_t length, uint64_t nowMs);
+};
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,449 @@
+/** +----------------------------------------------+
+ *  |   DM_SimulatedSensors - BMP280 and BH1750    |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "DM_SimulatedSensors.h" // Include the header file where the declarations for this library are stored
+#include "DM_Simulator.h"        // Used to read the virtual clock
+#include "DM_SimulatedWorld.h"   // Used to read the weather and to draw the noise
+#include "DM_SimulatedCodec.h"   // Used to hand the readings to the compression benchmark
+#include <stdio.h>               // Used to show the summary
+#include <string.h>              // Used to clear the registers
+#include <math.h>                // Used to scale the noise with the oversampling
+#include <algorithm>             // Used to limit the oversampling and the counts ("std::min()" and "std::max()")
+
+// INITIALIZE THE CLASS MEMBERS (the "static" members of the class)
+DM_SimulatedBMP280 DM_SimulatedSensors::_BMP280;
+DM_SimulatedBH1750 DM_SimulatedSensors::_BH1750;
+double DM_SimulatedSensors::_glitchProbability = 0; // The chance that a conversion gives a glitched reading
+
+// OTHER VARIABLES
+const uint16_t BMP280Calibration[12] = {27504, 26435, (uint16_t)-1000, 36477, (uint16_t)-10685, 3024, 2855, 140, (uint16_t)-7, 15500, (uint16_t)-14600, 6000}; // T1 to T3 and P1 to P9 of the example in the datasheet
+const double BMP280TemperatureNoiseC = 0.01;                                                                                                                   // The noise of one temperature sample (it shrinks with the square root of the oversampling)
+const double BMP280PressureNoisePa = 5.2;                                                                                                                      // The noise of one pressure sample (1.3 Pa with 16 times oversampling, like the datasheet says)
+const double BH1750Noise = 0.005;                                                                                                                              // The noise of a light measurement, relative to the light level
+const double BMP280TemperatureGlitchC = 20;                                                                                                                    // The error of a glitched temperature reading
+const double BMP280PressureGlitchPa = -5000;                                                                                                                   // The error of a glitched air pressure reading
+const double BH1750GlitchFactor = 10;                                                                                                                          // The factor of a glitched light reading
+
+/**
+ * Count a conversion.
+ *
+ * @param timeUs The moment of the conversion.
+ */
+void DM_ConversionCounter::count(uint64_t timeUs)
+{
+    if (this->amount > 0)
+    {
+        this->gapSumUs += timeUs - this->lastUs;
+        this->longestGapUs = std::max(this->longestGapUs, timeUs - this->lastUs);
+    }
+    this->amount += 1;
+    this->lastUs = timeUs;
+}
+
+/**
+ * Get the average time between two conversions.
+ *
+ * @return The average time in µs (0 if there were less than two conversions).
+ */
+uint64_t DM_ConversionCounter::getMeanGapUs() const
+{
+    return this->amount > 1 ? this->gapSumUs / (this->amount - 1) : 0;
+}
+
+/**
+ * Create the BMP280 in the state after a power-on.
+ */
+DM_SimulatedBMP280::DM_SimulatedBMP280() : _registerPointer(0), _conversionEndUs(0)
+{
+    memset(this->_registers, 0, sizeof(this->_registers));
+    this->_registers[0xD0] = chipID;
+    for (int i = 0; i < 12; i++)
+    {
+        this->_registers[0x88 + 2 * i] = BMP280Calibration[i] & 0xFF;
+        this->_registers[0x89 + 2 * i] = BMP280Calibration[i] >> 8;
+    }
+    this->_registers[0xF7] = 0x80;
+    this->_registers[0xFA] = 0x80;
+}
+
+/**
+ * Handle a write transaction: the first byte selects the register that is read next, every pair of bytes writes a value to a register.
+ *
+ * @param data The bytes of the transaction.
+ * @param length The amount of bytes.
+ */
+void DM_SimulatedBMP280::write(const uint8_t *data, size_t length)
+{
+    if (length == 0)
+        return;
+    this->_registerPointer = data[0];
+    for (size_t i = 0; i + 1 < length; i += 2)
+        this->_writeRegister(data[i], data[i + 1]);
+}
+
+/**
+ * Handle a read transaction: the registers are read from the selected one on (the address goes up after every byte).
+ *
+ * @param buffer The buffer for the bytes.
+ * @param length The amount of bytes.
+ */
+void DM_SimulatedBMP280::read(uint8_t *buffer, size_t length)
+{
+    this->_update();
+    for (size_t i = 0; i < length; i++)
+    {
+        uint8_t reg = this->_registerPointer++;
+        buffer[i] = reg == 0xF3 ? (this->_conversionEndUs != 0 ? 0x08 : 0x00) : this->_registers[reg];
+    }
+}
+
+/**
+ * Get the conversions since the start.
+ *
+ * @return The amount of conversions and the time between them.
+ */
+const DM_ConversionCounter &DM_SimulatedBMP280::getConversions() const
+{
+    return this->_conversions;
+}
+
+/**
+ * Write a value to a register (only the reset, control and config registers can be written).
+ *
+ * @param reg The register.
+ * @param value The value.
+ */
+void DM_SimulatedBMP280::_writeRegister(uint8_t reg, uint8_t value)
+{
+    this->_update();
+    if (reg == 0xE0 && value == 0xB6)
+    {
+        // A soft reset puts the chip back in its power-on state
+        this->_registers[0xF4] = 0;
+        this->_registers[0xF5] = 0;
+        this->_conversionEndUs = 0;
+    }
+    else if (reg == 0xF5)
+        this->_registers[0xF5] = value;
+    else if (reg == 0xF4)
+    {
+        // Forced mode starts one conversion (the typical conversion time of the datasheet)
+        this->_registers[0xF4] = value;
+        uint8_t mode = value & 0x03;
+        if (mode == 0x01 || mode == 0x02)
+        {
+            uint8_t temperatureOversampling = this->_getOversampling(value >> 5);
+            uint8_t pressureOversampling = this->_getOversampling((value >> 2) & 0x07);
+            uint64_t durationUs = 1000 + 2000 * temperatureOversampling + (pressureOversampling > 0 ? 2000 * pressureOversampling + 500 : 0);
+            this->_conversionEndUs = DM_Simulator::getMicroseconds() + durationUs;
+        }
+    }
+}
+
+/**
+ * Finish the running conversion if its time has come (in normal mode the chip converts all the time, so the data registers always hold a fresh measurement).
+ */
+void DM_SimulatedBMP280::_update()
+{
+    if ((this->_registers[0xF4] & 0x03) == 0x03)
+        this->_convert();
+    else if (this->_conversionEndUs != 0 && DM_Simulator::getMicroseconds() >= this->_conversionEndUs)
+    {
+        this->_convert();
+        this->_conversionEndUs = 0;
+        this->_registers[0xF4] &= ~0x03;
+    }
+}
+
+/**
+ * Measure the weather and put the raw values in the data registers (the IIR filter is not simulated, the station turns it off).
+ */
+void DM_SimulatedBMP280::_convert()
+{
+    // Measure the weather with the noise of the chosen oversampling
+    uint64_t timeMs = DM_Simulator::getMicroseconds() / 1000;
+    uint8_t temperatureOversampling = this->_getOversampling(this->_registers[0xF4] >> 5);
+    uint8_t pressureOversampling = this->_getOversampling((this->_registers[0xF4] >> 2) & 0x07);
+    int32_t rawTemperature = 0x80000;
+    int32_t rawPressure = 0x80000;
+    double temperatureC = NAN;
+    double pressurePa = NAN;
+    bool glitch = DM_SimulatedSensors::drawGlitch();
+    this->_conversions.count(DM_Simulator::getMicroseconds());
+    this->_conversions.glitches += glitch ? 1 : 0;
+
+    // Find the raw temperature that gives the temperature back (the compensation goes up with the raw value)
+    if (temperatureOversampling > 0)
+    {
+        temperatureC = DM_SimulatedWorld::getTemperatureC(timeMs) + BMP280TemperatureNoiseC / sqrt(temperatureOversampling) * DM_SimulatedWorld::drawNormal(DM_RANDOM_SENSORS) + (glitch ? BMP280TemperatureGlitchC : 0);
+        int32_t wanted = (int32_t)lround(temperatureC * 100);
+        int32_t low = 0;
+        int32_t high = (1 << 20) - 1;
+        while (low < high)
+        {
+            int32_t middle = (low + high) / 2;
+            if (((this->_getFineTemperature(middle) * 5 + 128) >> 8) < wanted)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        rawTemperature = low;
+    }
+
+    // Find the raw pressure that gives the pressure back (the compensation goes down with the raw value, and needs the temperature)
+    if (pressureOversampling > 0 && temperatureOversampling > 0)
+    {
+        pressurePa = DM_SimulatedWorld::getPressurePa(timeMs) + BMP280PressureNoisePa / sqrt(pressureOversampling) * DM_SimulatedWorld::drawNormal(DM_RANDOM_SENSORS) + (glitch ? BMP280PressureGlitchPa : 0);
+        int64_t wanted = (int64_t)llround(pressurePa * 256);
+        int32_t fineTemperature = this->_getFineTemperature(rawTemperature);
+        int32_t low = 0;
+        int32_t high = (1 << 20) - 1;
+        while (low < high)
+        {
+            int32_t middle = (low + high) / 2;
+            if (this->_getPressure(middle, fineTemperature) > wanted)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        rawPressure = low;
+    }
+    DM_SimulatedCodec::setBMP280Reading(timeMs, temperatureC, pressurePa);
+
+    // Put the raw values in the data registers (20 bits each, the lowest 4 bits are in the high nibble of the last byte)
+    this->_registers[0xF7] = rawPressure >> 12;
+    this->_registers[0xF8] = (rawPressure >> 4) & 0xFF;
+    this->_registers[0xF9] = (rawPressure & 0x0F) << 4;
+    this->_registers[0xFA] = rawTemperature >> 12;
+    this->_registers[0xFB] = (rawTemperature >> 4) & 0xFF;
+    this->_registers[0xFC] = (rawTemperature & 0x0F) << 4;
+}
+
+/**
+ * Get the amount of samples of an oversampling setting.
+ *
+ * @param setting The 3 bits of the setting.
+ *
+ * @return The amount of samples (0 if the measurement is skipped).
+ */
+uint8_t DM_SimulatedBMP280::_getOversampling(uint8_t setting) const
+{
+    return setting == 0 ? 0 : 1 << (std::min(setting, (uint8_t)5) - 1);
+}
+
+/**
+ * Calculate the "fine temperature" from a raw temperature (the integer compensation from the datasheet).
+ *
+ * @param rawTemperature The raw temperature.
+ *
+ * @return The fine temperature (5120 times the temperature in °C).
+ */
+int32_t DM_SimulatedBMP280::_getFineTemperature(int32_t rawTemperature) const
+{
+    const int32_t T1 = BMP280Calibration[0];
+    const int32_t T2 = (int16_t)BMP280Calibration[1];
+    const int32_t T3 = (int16_t)BMP280Calibration[2];
+    int32_t var1 = (((rawTemperature >> 3) - (T1 << 1)) * T2) >> 11;
+    int32_t var2 = (((((rawTemperature >> 4) - T1) * ((rawTemperature >> 4) - T1)) >> 12) * T3) >> 14;
+    return var1 + var2;
+}
+
+/**
+ * Calculate the pressure from a raw pressure (the 64-bit integer compensation from the datasheet).
+ *
+ * @param rawPressure The raw pressure.
+ * @param fineTemperature The fine temperature of the same conversion.
+ *
+ * @return The pressure in 1/256 Pa.
+ */
+int64_t DM_SimulatedBMP280::_getPressure(int32_t rawPressure, int32_t fineTemperature) const
+{
+    int64_t P[10];
+    for (int i = 1; i <= 9; i++)
+        P[i] = i == 1 ? (int64_t)BMP280Calibration[3] : (int64_t)(int16_t)BMP280Calibration[2 + i];
+    int64_t var1 = (int64_t)fineTemperature - 128000;
+    int64_t var2 = var1 * var1 * P[6];
+    var2 = var2 + ((var1 * P[5]) << 17);
+    var2 = var2 + (P[4] << 35);
+    var1 = ((var1 * var1 * P[3]) >> 8) + ((var1 * P[2]) << 12);
+    var1 = ((((int64_t)1) << 47) + var1) * P[1] >> 33;
+    if (var1 == 0)
+        return 0;
+    int64_t pressure = 1048576 - rawPressure;
+    pressure = (((pressure << 31) - var2) * 3125) / var1;
+    var1 = (P[9] * (pressure >> 13) * (pressure >> 13)) >> 25;
+    var2 = (P[8] * pressure) >> 19;
+    return ((pressure + var1 + var2) >> 8) + (P[7] << 4);
+}
+
+/**
+ * Create the BH1750 in the state after a power-on (powered down, waiting for an opcode).
+ */
+DM_SimulatedBH1750::DM_SimulatedBH1750() : _poweredOn(false), _mode(0), _MTreg(defaultMTreg), _conversionEndUs(0), _counts(0)
+{
+}
+
+/**
+ * Handle a write transaction: every byte is an opcode.
+ *
+ * @param data The opcodes.
+ * @param length The amount of opcodes.
+ */
+void DM_SimulatedBH1750::write(const uint8_t *data, size_t length)
+{
+    this->_update();
+    for (size_t i = 0; i < length; i++)
+    {
+        uint8_t opcode = data[i];
+        if (opcode == 0x00)
+        {
+            // Power down (a running conversion is lost)
+            this->_poweredOn = false;
+            this->_mode = 0;
+        }
+        else if (opcode == 0x01)
+            this->_poweredOn = true;
+        else if (opcode == 0x07 && this->_poweredOn)
+            this->_counts = 0;
+        else if (opcode == 0x10 || opcode == 0x11 || opcode == 0x13 || opcode == 0x20 || opcode == 0x21 || opcode == 0x23)
+            this->_startConversion(opcode);
+        else if ((opcode & 0xF8) == 0x40)
+            this->_MTreg = (this->_MTreg & 0x1F) | ((opcode & 0x07) << 5);
+        else if ((opcode & 0xE0) == 0x60)
+            this->_MTreg = (this->_MTreg & 0xE0) | (opcode & 0x1F);
+    }
+}
+
+/**
+ * Handle a read transaction: the result of the last finished conversion (high byte first).
+ *
+ * @param buffer The buffer for the bytes.
+ * @param length The amount of bytes.
+ */
+void DM_SimulatedBH1750::read(uint8_t *buffer, size_t length)
+{
+    this->_update();
+    for (size_t i = 0; i < length; i++)
+        buffer[i] = i == 0 ? this->_counts >> 8 : (i == 1 ? this->_counts & 0xFF : 0xFF);
+}
+
+/**
+ * Get the conversions since the start.
+ *
+ * @return The amount of conversions and the time between them.
+ */
+const DM_ConversionCounter &DM_SimulatedBH1750::getConversions() const
+{
+    return this->_conversions;
+}
+
+/**
+ * Start a conversion (the typical conversion time of the datasheet, which grows with the measurement time register).
+ *
+ * @param mode The opcode of the measurement mode.
+ */
+void DM_SimulatedBH1750::_startConversion(uint8_t mode)
+{
+    bool lowResolution = (mode & 0x0F) == 0x03;
+    this->_poweredOn = true;
+    this->_mode = mode;
+    this->_conversionEndUs = DM_Simulator::getMicroseconds() + (lowResolution ? 16000ULL : 120000ULL) * this->_MTreg / defaultMTreg;
+}
+
+/**
+ * Finish the running conversion if its time has come (a one-time mode powers the chip down afterwards, a continuous mode starts the next conversion).
+ */
+void DM_SimulatedBH1750::_update()
+{
+    if (this->_mode == 0 || DM_Simulator::getMicroseconds() < this->_conversionEndUs)
+        return;
+
+    // Measure the light level, scaled like the chip does (1.2 counts per lux with the default measurement time, twice as many in high resolution mode 2)
+    uint64_t timeMs = DM_Simulator::getMicroseconds() / 1000;
+    double lux = DM_SimulatedWorld::getLightLevelLux(timeMs) * (1 + BH1750Noise * DM_SimulatedWorld::drawNormal(DM_RANDOM_SENSORS));
+    if (DM_SimulatedSensors::drawGlitch())
+    {
+        lux *= BH1750GlitchFactor;
+        this->_conversions.glitches++;
+    }
+    double counts = lux * 1.2 * this->_MTreg / defaultMTreg * ((this->_mode & 0x0F) == 0x01 ? 2 : 1);
+    this->_counts = (uint16_t)std::min(std::max(lround(counts), 0L), 65535L);
+    DM_SimulatedCodec::setBH1750Reading(lux);
+    this->_conversions.count(DM_Simulator::getMicroseconds());
+
+    // Power down after a one-time conversion, or start the next continuous conversion
+    uint8_t mode = this->_mode;
+    if (mode >= 0x20)
+    {
+        this->_mode = 0;
+        this->_poweredOn = false;
+    }
+    else
+        this->_startConversion(mode);
+}
+
+/**
+ * Connect the simulated sensors to the I2C bus.
+ */
+void DM_SimulatedSensors::begin()
+{
+    Wire.attachDevice(DM_SimulatedSensors::BMP280Address, &DM_SimulatedSensors::_BMP280);
+    Wire.attachDevice(DM_SimulatedSensors::BH1750Address, &DM_SimulatedSensors::_BH1750);
+}
+
+/**
+ * Let a part of the conversions give a glitched reading ("--glitches"), to check that the station rejects them.
+ *
+ * @param probability The chance that a conversion is glitched (0 to 1).
+ *
+ * @return False if the chance is not valid.
+ */
+bool DM_SimulatedSensors::setGlitchProbability(double probability)
+{
+    if (!(probability >= 0 && probability <= 1))
+        return false;
+    DM_SimulatedSensors::_glitchProbability = probability;
+    return true;
+}
+
+/**
+ * Decide if a conversion is glitched (draws from its own generator, so the glitches don't change the noise or the weather).
+ *
+ * @return True if the conversion gives a glitched reading.
+ */
+bool DM_SimulatedSensors::drawGlitch()
+{
+    return DM_SimulatedSensors::_glitchProbability > 0 && DM_SimulatedWorld::drawUniform(DM_RANDOM_GLITCHES) < DM_SimulatedSensors::_glitchProbability;
+}
+
+/**
+ * Show how many conversions the sensors made, and how regular they were.
+ */
+void DM_SimulatedSensors::printSummary()
+{
+    const DM_ConversionCounter &BMP280 = DM_SimulatedSensors::_BMP280.getConversions();
+    const DM_ConversionCounter &BH1750 = DM_SimulatedSensors::_BH1750.getConversions();
+    printf("Sensors: %lu BMP280 conversions (every %.1f ms, at most %.1f ms apart, %lu glitched), %lu BH1750 conversions (every %.1f ms, at most %.1f ms apart, %lu glitched)\n", (unsigned long)BMP280.amount,
+           BMP280.getMeanGapUs() / 1000.0, BMP280.longestGapUs / 1000.0, (unsigned long)BMP280.glitches, (unsigned long)BH1750.amount, BH1750.getMeanGapUs() / 1000.0, BH1750.longestGapUs / 1000.0, (unsigned long)BH1750.glitches);
+}
+
+/**
+ * Write the conversions of the sensors and the time between them as the "sensors" member of the benchmark results (JSON).
+ *
+ * @param file The file of the benchmark results.
+ */
+void DM_SimulatedSensors::printBenchmark(FILE *file)
+{
+    const DM_ConversionCounter *counters[2] = {&DM_SimulatedSensors::_BMP280.getConversions(), &DM_SimulatedSensors::_BH1750.getConversions()};
+    const char *names[2] = {"bmp280", "bh1750"};
+    fprintf(file, "  \"sensors\": {");
+    for (int i = 0; i < 2; i++)
+        fprintf(file, "%s\n    \"%s\": {\"conversions\": %lu, \"mean_cycle_us\": %llu, \"longest_cycle_us\": %llu, \"glitches\": %lu}", i == 0 ? "" : ",", names[i], (unsigned long)counters[i]->amount,
+                (unsigned long long)counters[i]->getMeanGapUs(), (unsigned long long)counters[i]->longestGapUs, (unsigned long)counters[i]->glitches);
+    fprintf(file, "\n  }");
+}
\ No newline at end of file
@@ -0,0 +1,110 @@
+/** +----------------------------------------------+
+ *  |   DM_SimulatedSensors - BMP280 and BH1750    |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef DM_SimulatedSensors_h
+#define DM_SimulatedSensors_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h> // Used to be able to use the "size_t" type
+#include <stdint.h> // Used to be able to use the fixed width integer types
+#include <stdio.h>  // Used to write the benchmark results
+#include "Wire.h"   // Used to connect the sensors to the I2C bus
+
+/**
+ * Counts the conversions of a simulated sensor and the time between two of them (the sampling cycle of the station, as the sensor sees it).
+ */
+struct DM_ConversionCounter
+{
+    uint32_t amount = 0;       // The amount of conversions since the start
+    uint64_t lastUs = 0;       // The moment of the last conversion
+    uint64_t gapSumUs = 0;     // The sum of the times between two conversions
+    uint64_t longestGapUs = 0; // The longest time between two conversions
+    uint32_t glitches = 0;     // The amount of conversions that gave a glitched reading
+
+    void count(uint64_t timeUs);
+    uint64_t getMeanGapUs() const;
+};
+
+/**
+ * A simulated BMP280 chip: the registers, the forced and normal mode and the conversion time of the datasheet.
+ *
+ * The chip has the calibration of the example in the datasheet, and a conversion turns the weather of "DM_SimulatedWorld" (plus noise that shrinks with the oversampling) into the raw values that give that weather back through the compensation of the datasheet.
+ * With "--glitches", a conversion now and then is off by far (like a disturbed bus or a flipped bit), to check that the station rejects it.
+ */
+class DM_SimulatedBMP280 : public DM_I2CDevice
+{
+public: // The public functions and constants
+    static constexpr uint8_t chipID = 0x58; // The value of the chip ID register
+
+    DM_SimulatedBMP280();
+    void write(const uint8_t *data, size_t length) override;
+    void read(uint8_t *buffer, size_t length) override;
+    const DM_ConversionCounter &getConversions() const;
+
+private: // The private functions and members
+    uint8_t _registers[256];           // The registers of the chip
+    uint8_t _registerPointer;          // The register that is read next
+    uint64_t _conversionEndUs;         // The moment the running conversion is done (0 if none is running)
+    DM_ConversionCounter _conversions; // The conversions since the start
+    void _writeRegister(uint8_t reg, uint8_t value);
+    void _update();
+    void _convert();
+    uint8_t _getOversampling(uint8_t setting) const;
+    int32_t _getFineTemperature(int32_t rawTemperature) const;
+    int64_t _getPressure(int32_t rawPressure, int32_t fineTemperature) const;
+};
+
+/**
+ * A simulated BH1750 chip: the opcodes, the measurement time register and the conversion times of the datasheet.
+ *
+ * A conversion measures the light level of "DM_SimulatedWorld" (plus a little noise), scaled by the measurement time like on the chip, so the auto-ranging of the station sees the same counts as it would outside.
+ * With "--glitches", a conversion now and then is off by far (like a flash of light on the sensor).
+ */
+class DM_SimulatedBH1750 : public DM_I2CDevice
+{
+public: // The public functions and constants
+    static constexpr uint8_t defaultMTreg = 69; // The measurement time register after a power-on
+
+    DM_SimulatedBH1750();
+    void write(const uint8_t *data, size_t length) override;
+    void read(uint8_t *buffer, size_t length) override;
+    const DM_ConversionCounter &getConversions() const;
+
+private: // The private functions and members
+    bool _poweredOn;                   // True if the chip is powered on
+    uint8_t _mode;                     // The measurement mode of the running conversion (0 if none is running)
+    uint8_t _MTreg;                    // The measurement time register
+    uint64_t _conversionEndUs;         // The moment the running conversion is done
+    uint16_t _counts;                  // The result of the last conversion
+    DM_ConversionCounter _conversions; // The conversions since the start
+    void _startConversion(uint8_t mode);
+    void _update();
+};
+
+/**
+ * The sensors of the simulated station, on the simulated I2C bus at the addresses of the station.
+ */
+class DM_SimulatedSensors
+{
+public: // The public functions and constants
+    static constexpr uint8_t BMP280Address = 0x76; // The address of the BMP280 (SDO to ground, like on the station)
+    static constexpr uint8_t BH1750Address = 0x23; // The address of the BH1750 (ADDR to ground, like on the station)
+
+    static void begin();
+    static bool setGlitchProbability(double probability);
+    static bool drawGlitch();
+    static void printSummary();
+    static void printBenchmark(FILE *file);
+
+private: // The private members
+    static DM_SimulatedBMP280 _BMP280;
+    static DM_SimulatedBH1750 _BH1750;
+    static double _glitchProbability;
+};
+
+#endif // End the header guard
\ No newline at end of file
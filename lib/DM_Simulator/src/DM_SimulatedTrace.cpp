@@ -0,0 +1,392 @@
+/** +----------------------------------------------+
+ *  |    DM_SimulatedTrace - Record and replay     |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "DM_SimulatedTrace.h" // Include the header file where the declarations for this library are stored
+#include <math.h>              // Used to round the readings to their steps
+#include <string.h>            // Used to read the header of the files
+#include <stdlib.h>            // Used to read the numbers of a CSV file
+#include <algorithm>           // Used to put the records of the trace in order of time
+#include "esp_heap_caps.h"     // Used to keep the recording out of the memory of the station
+
+// INITIALIZE THE CLASS MEMBERS (if we don't do this, the code will give errors saying these should be initialised first)
+std::string DM_SimulatedTrace::_recordPath;                                                           // The file the trace is written to (empty if nothing is recorded)
+std::vector<DM_SimulatedTrace::_Reading> DM_SimulatedTrace::_recorded[DM_AMOUNT_OF_TRACE_QUANTITIES]; // The recorded changes of every quantity
+std::vector<DM_SimulatedTrace::_Event> DM_SimulatedTrace::_events;                                    // The planned outages and commands (kept even without a record file, it can be set later)
+std::vector<DM_SimulatedTrace::_Reading> DM_SimulatedTrace::_replayed[DM_AMOUNT_OF_TRACE_QUANTITIES]; // The readings of every quantity that are replayed
+size_t DM_SimulatedTrace::_replayPositions[DM_AMOUNT_OF_TRACE_QUANTITIES] = {0};                      // The reading of every quantity that was replayed last
+uint64_t DM_SimulatedTrace::_replayDurationMs = 0;                                                    // The length of the replayed recording (0 if nothing is replayed)
+
+// OTHER VARIABLES
+const char traceMagic[4] = {'D', 'M', 'T', 'R'};                                                                // The first bytes of a trace file
+const char *const historyColumnNames[DM_AMOUNT_OF_TRACE_QUANTITIES] = {"Temperature", "Air pressure", "Light"}; // The start of the column names of every quantity in a CSV of "/history"
+
+/**
+ * Record what the station sees of the world into a trace file (it is written when the simulation ends).
+ *
+ * @param path The path of the file.
+ */
+void DM_SimulatedTrace::setRecordFile(const char *path)
+{
+    DM_SimulatedTrace::_recordPath = path;
+}
+
+/**
+ * Replay a trace file, or a CSV downloaded from "/history" of a station. The seed and the time of the boot of a trace are used, the outages and commands in it are planned.
+ *
+ * @param path The path of the file.
+ *
+ * @return False if the file can't be opened or is not valid.
+ */
+bool DM_SimulatedTrace::loadReplayFile(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == nullptr)
+        return false;
+
+    // A trace starts with its magic bytes, anything else is treated as CSV
+    char magic[sizeof(traceMagic)];
+    bool isTrace = fread(magic, 1, sizeof(magic), file) == sizeof(magic) && memcmp(magic, traceMagic, sizeof(magic)) == 0;
+    if (!isTrace)
+        rewind(file);
+    bool success = isTrace ? DM_SimulatedTrace::_loadTrace(file) : DM_SimulatedTrace::_loadHistory(file);
+    fclose(file);
+    return success;
+}
+
+/**
+ * Check if the readings of a quantity come from a replayed file (instead of the weather model).
+ *
+ * @param quantity The quantity.
+ *
+ * @return True if the quantity is replayed.
+ */
+bool DM_SimulatedTrace::isReplaying(DM_TraceQuantity quantity)
+{
+    return !DM_SimulatedTrace::_replayed[quantity].empty();
+}
+
+/**
+ * Get the length of the replayed recording (the simulation stops there, unless "--duration" says otherwise).
+ *
+ * @return The length in ms (0 if nothing is replayed).
+ */
+uint64_t DM_SimulatedTrace::getReplayDurationMs()
+{
+    return DM_SimulatedTrace::_replayDurationMs;
+}
+
+/**
+ * Get the replayed reading of a quantity: the last one at or before the moment (the sensors read the world in order of time, so this only moves forward).
+ *
+ * @param quantity The quantity (it has to be replayed).
+ * @param timeMs The moment (since the boot).
+ *
+ * @return The reading (it is recorded again if a trace is being recorded).
+ */
+float DM_SimulatedTrace::replayReading(DM_TraceQuantity quantity, uint64_t timeMs)
+{
+    const std::vector<_Reading> &readings = DM_SimulatedTrace::_replayed[quantity];
+    size_t &position = DM_SimulatedTrace::_replayPositions[quantity];
+    while (position + 1 < readings.size() && readings[position + 1].timeMs <= timeMs)
+        position += 1;
+    return DM_SimulatedTrace::recordReading(quantity, timeMs, readings[position].value / DM_SimulatedTrace::steps[quantity]);
+}
+
+/**
+ * Round a reading to the steps the trace keeps, and record it if it changed (the world always gives the rounded reading, so a replay gives exactly the same readings).
+ *
+ * @param quantity The quantity.
+ * @param timeMs The moment (since the boot).
+ * @param value The reading.
+ *
+ * @return The rounded reading.
+ */
+float DM_SimulatedTrace::recordReading(DM_TraceQuantity quantity, uint64_t timeMs, double value)
+{
+    int64_t steps = DM_SimulatedTrace::_toSteps(quantity, value);
+    std::vector<_Reading> &readings = DM_SimulatedTrace::_recorded[quantity];
+    if (!DM_SimulatedTrace::_recordPath.empty() && (readings.empty() || readings.back().value != steps))
+    {
+        bool counting = DM_SimulatedHeap::setCounting(false);
+        readings.push_back({timeMs, steps});
+        DM_SimulatedHeap::setCounting(counting);
+    }
+    return steps / DM_SimulatedTrace::steps[quantity];
+}
+
+/**
+ * Record a planned outage (called by "DM_SimulatedWorld").
+ *
+ * @param link The link that goes down.
+ * @param startMs The moment it goes down (since the boot).
+ * @param durationMs How long it stays down.
+ */
+void DM_SimulatedTrace::recordOutage(DM_Link link, uint64_t startMs, uint64_t durationMs)
+{
+    DM_SimulatedTrace::_events.push_back({startMs, _RECORD_OUTAGE, link, durationMs, ""});
+}
+
+/**
+ * Record a planned command of the serial monitor (called by "DM_SimulatedWorld").
+ *
+ * @param timeMs The moment it is typed (since the boot).
+ * @param text The command (without the end of the line).
+ */
+void DM_SimulatedTrace::recordSerialInput(uint64_t timeMs, const char *text)
+{
+    DM_SimulatedTrace::_events.push_back({timeMs, _RECORD_COMMAND, DM_LINK_WIFI, 0, text});
+}
+
+/**
+ * Write the recorded trace to its file (if a trace is being recorded).
+ *
+ * @param endMs The end of the recording (since the boot).
+ *
+ * @return False if the file can't be written.
+ */
+bool DM_SimulatedTrace::save(uint64_t endMs)
+{
+    if (DM_SimulatedTrace::_recordPath.empty())
+        return true;
+
+    // Put every record in order of time (the readings of one quantity already are, the events are planned in any order)
+    struct Entry
+    {
+        uint64_t timeMs; // The moment of the record
+        uint8_t type;    // The type of the record (with the quantity for a reading)
+        size_t index;    // The reading or the event
+    };
+    std::vector<Entry> entries;
+    for (uint8_t quantity = 0; quantity < DM_AMOUNT_OF_TRACE_QUANTITIES; quantity++)
+        for (size_t i = 0; i < DM_SimulatedTrace::_recorded[quantity].size(); i++)
+            entries.push_back({DM_SimulatedTrace::_recorded[quantity][i].timeMs, (uint8_t)(_RECORD_READING + quantity), i});
+    for (size_t i = 0; i < DM_SimulatedTrace::_events.size(); i++)
+        entries.push_back({DM_SimulatedTrace::_events[i].timeMs, DM_SimulatedTrace::_events[i].type, i});
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b)
+                     { return a.timeMs < b.timeMs; });
+
+    // Write the header, and every record as the change since the previous one
+    std::string output(traceMagic, sizeof(traceMagic));
+    output += (char)DM_SimulatedTrace::version;
+    uint32_t header[2] = {DM_SimulatedWorld::getSeed(), DM_SimulatedWorld::getStartEpochSeconds()};
+    for (uint32_t number : header)
+        for (int shift = 0; shift < 32; shift += 8)
+            output += (char)(number >> shift);
+    uint64_t previousMs = 0;
+    int64_t previousValues[DM_AMOUNT_OF_TRACE_QUANTITIES] = {0};
+    for (const Entry &entry : entries)
+    {
+        output += (char)entry.type;
+        DM_SimulatedTrace::_writeNumber(output, entry.timeMs - previousMs);
+        previousMs = entry.timeMs;
+        if (entry.type < _RECORD_OUTAGE)
+        {
+            // A reading: the zigzag encoded change in steps (small changes, up or down, take one byte)
+            uint8_t quantity = entry.type - _RECORD_READING;
+            int64_t value = DM_SimulatedTrace::_recorded[quantity][entry.index].value;
+            int64_t change = value - previousValues[quantity];
+            DM_SimulatedTrace::_writeNumber(output, ((uint64_t)change << 1) ^ (uint64_t)(change >> 63));
+            previousValues[quantity] = value;
+        }
+        else if (entry.type == _RECORD_OUTAGE)
+        {
+            output += (char)DM_SimulatedTrace::_events[entry.index].link;
+            DM_SimulatedTrace::_writeNumber(output, DM_SimulatedTrace::_events[entry.index].lengthMs);
+        }
+        else
+        {
+            const std::string &text = DM_SimulatedTrace::_events[entry.index].text;
+            DM_SimulatedTrace::_writeNumber(output, text.length());
+            output += text;
+        }
+    }
+    output += (char)_RECORD_END;
+    DM_SimulatedTrace::_writeNumber(output, endMs - std::min(previousMs, endMs));
+
+    // Write the file
+    FILE *file = fopen(DM_SimulatedTrace::_recordPath.c_str(), "wb");
+    if (file == nullptr)
+        return false;
+    bool success = fwrite(output.data(), 1, output.length(), file) == output.length();
+    success = fclose(file) == 0 && success;
+    printf("Trace: %lu records written to \"%s\" (%lu bytes)\n", (unsigned long)entries.size(), DM_SimulatedTrace::_recordPath.c_str(), (unsigned long)output.length());
+    return success;
+}
+
+/**
+ * Round a reading to the steps the trace keeps.
+ *
+ * @param quantity The quantity.
+ * @param value The reading.
+ *
+ * @return The reading in steps.
+ */
+int64_t DM_SimulatedTrace::_toSteps(DM_TraceQuantity quantity, double value)
+{
+    return llround(value * DM_SimulatedTrace::steps[quantity]);
+}
+
+/**
+ * Read the records of a trace file (after the magic bytes).
+ *
+ * @param file The file.
+ *
+ * @return False if the file is not valid.
+ */
+bool DM_SimulatedTrace::_loadTrace(FILE *file)
+{
+    // Read the header, and use the seed and the time of the boot of the recording
+    uint8_t header[9];
+    if (fread(header, 1, sizeof(header), file) != sizeof(header) || header[0] != DM_SimulatedTrace::version)
+        return false;
+    DM_SimulatedWorld::setSeed(header[1] | header[2] << 8 | header[3] << 16 | (uint32_t)header[4] << 24);
+    DM_SimulatedWorld::setStartEpochSeconds(header[5] | header[6] << 8 | header[7] << 16 | (uint32_t)header[8] << 24);
+
+    // Read the records until the end of the recording
+    uint64_t timeMs = 0;
+    int64_t values[DM_AMOUNT_OF_TRACE_QUANTITIES] = {0};
+    for (;;)
+    {
+        int type = fgetc(file);
+        uint64_t deltaMs, number;
+        if (type == EOF || !DM_SimulatedTrace::_readNumber(file, deltaMs))
+            return false;
+        timeMs += deltaMs;
+        if (type >= _RECORD_READING && type < _RECORD_READING + DM_AMOUNT_OF_TRACE_QUANTITIES)
+        {
+            // A reading: undo the zigzag encoding of the change
+            if (!DM_SimulatedTrace::_readNumber(file, number))
+                return false;
+            uint8_t quantity = type - _RECORD_READING;
+            values[quantity] += (int64_t)(number >> 1) ^ -(int64_t)(number & 1);
+            DM_SimulatedTrace::_replayed[quantity].push_back({timeMs, values[quantity]});
+        }
+        else if (type == _RECORD_OUTAGE)
+        {
+            int link = fgetc(file);
+            if (link == EOF || link >= DM_AMOUNT_OF_LINKS || !DM_SimulatedTrace::_readNumber(file, number))
+                return false;
+            DM_SimulatedWorld::addOutage((DM_Link)link, timeMs, number);
+        }
+        else if (type == _RECORD_COMMAND)
+        {
+            if (!DM_SimulatedTrace::_readNumber(file, number) || number > 1024)
+                return false;
+            std::string text(number, '\0');
+            if (fread(&text[0], 1, number, file) != number)
+                return false;
+            DM_SimulatedWorld::addSerialInput(timeMs, text.c_str());
+        }
+        else if (type == _RECORD_END)
+        {
+            DM_SimulatedTrace::_replayDurationMs = std::max(timeMs, (uint64_t)1);
+            return true;
+        }
+        else
+            return false;
+    }
+}
+
+/**
+ * Read the readings of a CSV downloaded from "/history" ("timestampMs,epochSeconds,<one column per value>"). The first line is replayed at the boot, and its real time becomes the time of the boot.
+ *
+ * @param file The file.
+ *
+ * @return False if the file is not valid.
+ */
+bool DM_SimulatedTrace::_loadHistory(FILE *file)
+{
+    // Find the column of every quantity in the header (a quantity without a column keeps the weather model)
+    char line[256];
+    int columns[DM_AMOUNT_OF_TRACE_QUANTITIES] = {-1, -1, -1};
+    if (fgets(line, sizeof(line), file) == nullptr || strncmp(line, "timestampMs,epochSeconds", 24) != 0)
+        return false;
+    int column = 0;
+    const char *name = line;
+    while (name != nullptr)
+    {
+        for (uint8_t quantity = 0; quantity < DM_AMOUNT_OF_TRACE_QUANTITIES; quantity++)
+            if (strncmp(name, historyColumnNames[quantity], strlen(historyColumnNames[quantity])) == 0)
+                columns[quantity] = column;
+        name = strchr(name, ',');
+        name = name != nullptr ? name + 1 : nullptr;
+        column += 1;
+    }
+
+    // Read one sample per line (a value that couldn't be measured is empty, the previous reading is kept then)
+    uint64_t firstMs = 0, timeMs = 0;
+    bool first = true;
+    while (fgets(line, sizeof(line), file) != nullptr)
+    {
+        char *cursor = line;
+        uint64_t stationMs = strtoull(cursor, &cursor, 10);
+        if (*cursor != ',')
+            continue;
+        uint32_t epochSeconds = strtoul(cursor + 1, &cursor, 10);
+        if (first)
+        {
+            firstMs = stationMs;
+            if (epochSeconds != 0)
+                DM_SimulatedWorld::setStartEpochSeconds(epochSeconds);
+            first = false;
+        }
+        timeMs = stationMs >= firstMs ? stationMs - firstMs : timeMs;
+        for (column = 2; *cursor == ','; column++)
+        {
+            char *end;
+            double value = strtod(cursor + 1, &end);
+            for (uint8_t quantity = 0; quantity < DM_AMOUNT_OF_TRACE_QUANTITIES; quantity++)
+                if (columns[quantity] == column && end != cursor + 1)
+                    DM_SimulatedTrace::_replayed[quantity].push_back({timeMs, DM_SimulatedTrace::_toSteps((DM_TraceQuantity)quantity, value)});
+            cursor = end != cursor + 1 ? end : cursor + 1;
+        }
+    }
+    if (first)
+        return false;
+    DM_SimulatedTrace::_replayDurationMs = timeMs + 1000;
+    return true;
+}
+
+/**
+ * Add a number as a variable-length number: 7 bits per byte, the highest bit says another byte follows.
+ *
+ * @param output The bytes of the trace.
+ * @param number The number.
+ */
+void DM_SimulatedTrace::_writeNumber(std::string &output, uint64_t number)
+{
+    while (number >= 0x80)
+    {
+        output += (char)(number | 0x80);
+        number >>= 7;
+    }
+    output += (char)number;
+}
+
+/**
+ * Read a variable-length number.
+ *
+ * @param file The file.
+ * @param number The number that was read.
+ *
+ * @return False if the file ended in the middle of the number.
+ */
+bool DM_SimulatedTrace::_readNumber(FILE *file, uint64_t &number)
+{
+    number = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        int byte = fgetc(file);
+        if (byte == EOF)
+            return false;
+        number |= (uint64_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
\ No newline at end of file
@@ -0,0 +1,95 @@
+/** +----------------------------------------------+
+ *  |    DM_SimulatedTrace - Record and replay     |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef DM_SimulatedTrace_h
+#define DM_SimulatedTrace_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h>            // Used to be able to use the "size_t" type
+#include <stdint.h>            // Used to be able to use the fixed width integer types
+#include <stdio.h>             // Used to read the trace files
+#include <string>              // Used to keep the file names and the typed commands
+#include <vector>              // Used to keep the records
+#include "DM_SimulatedWorld.h" // Used to know the links that can go down
+
+// DECLARE THE ENUM "DM_TraceQuantity" (the quantities of the weather a trace keeps)
+enum DM_TraceQuantity : uint8_t
+{
+    DM_TRACE_TEMPERATURE,         // The temperature in °C (kept in steps of 0.01 °C)
+    DM_TRACE_PRESSURE,            // The air pressure in Pa (kept in steps of 0.1 Pa)
+    DM_TRACE_LIGHT,               // The light level in lux (kept in steps of 0.01 lux)
+    DM_AMOUNT_OF_TRACE_QUANTITIES // The amount of quantities (not a quantity)
+};
+
+/**
+ * Records what the simulated station saw of the world into a compact trace file, and replays such a file instead of the weather model and the planned outages.
+ *
+ * A trace holds the readings of the sensors (only when the value changed, as a time step and a value step of a few bytes), the outages of every link and the commands typed in the serial monitor.
+ * A week of readings once a second takes a few MB. Replaying a trace with the same seed gives the station exactly the same inputs, so it behaves exactly the same.
+ *
+ * A CSV downloaded from "/history" of a real station can be replayed as well: the readings of the field then drive the simulated sensors (the outages can be added with "--outage").
+ * Replaying a CSV while recording turns it into a trace.
+ *
+ * The file starts with "DMTR", the version, the seed and the Unix time at the boot, followed by one record per change:
+ *  - a type byte, and the milliseconds since the previous record as a variable-length number;
+ *  - a reading: the change of its value in steps, zigzag encoded as a variable-length number;
+ *  - an outage: the link (a byte) and the milliseconds it lasts (a variable-length number);
+ *  - a command: its length (a variable-length number) and its characters;
+ *  - the end of the recording.
+ */
+class DM_SimulatedTrace
+{
+public: // The public functions and constants
+    static constexpr uint8_t version = 1;                                          // The version of the trace format
+    static constexpr double steps[DM_AMOUNT_OF_TRACE_QUANTITIES] = {100, 10, 100}; // The amount of steps per unit every quantity is kept in
+
+    static void setRecordFile(const char *path);
+    static bool loadReplayFile(const char *path);
+    static bool isReplaying(DM_TraceQuantity quantity);
+    static uint64_t getReplayDurationMs();
+    static float replayReading(DM_TraceQuantity quantity, uint64_t timeMs);
+    static float recordReading(DM_TraceQuantity quantity, uint64_t timeMs, double value);
+    static void recordOutage(DM_Link link, uint64_t startMs, uint64_t durationMs);
+    static void recordSerialInput(uint64_t timeMs, const char *text);
+    static bool save(uint64_t endMs);
+
+private: // The private functions and members
+    enum _RecordTypes : uint8_t
+    {
+        _RECORD_READING = 0x10, // A new value of a quantity (the quantity is added to the type)
+        _RECORD_OUTAGE = 0x20,  // An outage of a link
+        _RECORD_COMMAND = 0x30, // A command typed in the serial monitor
+        _RECORD_END = 0x40      // The end of the recording
+    };
+    struct _Reading
+    {
+        uint64_t timeMs; // The moment of the reading
+        int64_t value;   // The value in steps
+    };
+    struct _Event
+    {
+        uint64_t timeMs;   // The moment the outage starts or the command is typed
+        uint8_t type;      // "_RECORD_OUTAGE" or "_RECORD_COMMAND"
+        DM_Link link;      // The link that goes down
+        uint64_t lengthMs; // How long the link stays down
+        std::string text;  // The command
+    };
+    static std::string _recordPath;
+    static std::vector<_Reading> _recorded[DM_AMOUNT_OF_TRACE_QUANTITIES];
+    static std::vector<_Event> _events;
+    static std::vector<_Reading> _replayed[DM_AMOUNT_OF_TRACE_QUANTITIES];
+    static size_t _replayPositions[DM_AMOUNT_OF_TRACE_QUANTITIES];
+    static uint64_t _replayDurationMs;
+    static int64_t _toSteps(DM_TraceQuantity quantity, double value);
+    static bool _loadTrace(FILE *file);
+    static bool _loadHistory(FILE *file);
+    static void _writeNumber(std::string &output, uint64_t number);
+    static bool _readNumber(FILE *file, uint64_t &number);
+};
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,341 @@
+/** +----------------------------------------------+
+ *  |   DM_SimulatedWorld - Weather and outages    |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "DM_SimulatedWorld.h" // Include the header file where the declarations for this library are stored
+#include "DM_SimulatedTrace.h" // Used to record the world, or to replay a recording instead of the weather model
+#include <math.h>              // Used to calculate the daily cycle
+#include <string.h>            // Used to compare the names of the links
+#include <algorithm>           // Used to keep the typed commands in order
+
+// INITIALIZE THE CLASS MEMBERS (if we don't do this, the code will give errors saying these should be initialised first)
+uint32_t DM_SimulatedWorld::_seed = DM_SimulatedWorld::defaultSeed;                           // The seed of the weather and the random numbers
+uint32_t DM_SimulatedWorld::_startEpochSeconds = DM_SimulatedWorld::defaultStartEpochSeconds; // The real time at the boot
+std::string DM_SimulatedWorld::_SSID = DM_SimulatedWorld::defaultSSID;                        // The SSID of the access points
+std::vector<DM_SimulatedWorld::_Outage> DM_SimulatedWorld::_outages;                          // Every planned outage
+std::vector<DM_SimulatedWorld::_SerialInput> DM_SimulatedWorld::_serialInputs;                // Every planned command (in the order they are typed)
+size_t DM_SimulatedWorld::_serialInputIndex = 0;                                              // The command that is being read
+size_t DM_SimulatedWorld::_serialInputPosition = 0;                                           // The next character of that command
+std::mt19937 DM_SimulatedWorld::_generators[DM_AMOUNT_OF_RANDOM_SOURCES];                     // The random number generator of every model
+bool DM_SimulatedWorld::_generatorsSeeded = false;                                            // If the generators have been seeded
+
+// OTHER VARIABLES
+const char *const linkNames[DM_AMOUNT_OF_LINKS] = {"wifi", "internet", "mqtt"}; // The names of the links in the "--outage" option (in the order of "DM_Link")
+const uint32_t secondsPerDay = 86400;                                           // The amount of seconds in a day
+
+/**
+ * Set the seed of the weather and of every random number.
+ *
+ * @param seed The seed.
+ */
+void DM_SimulatedWorld::setSeed(uint32_t seed)
+{
+    DM_SimulatedWorld::_seed = seed;
+    DM_SimulatedWorld::_generatorsSeeded = false;
+}
+
+/**
+ * Get the seed of the weather and of every random number.
+ *
+ * @return The seed.
+ */
+uint32_t DM_SimulatedWorld::getSeed()
+{
+    return DM_SimulatedWorld::_seed;
+}
+
+/**
+ * Set the real time at the boot (it decides the time of day, so when it gets light).
+ *
+ * @param epochSeconds The Unix time at the boot.
+ */
+void DM_SimulatedWorld::setStartEpochSeconds(uint32_t epochSeconds)
+{
+    DM_SimulatedWorld::_startEpochSeconds = epochSeconds;
+}
+
+/**
+ * Get the real time at the boot (what the NTP servers tell the station, minus the time since the boot).
+ *
+ * @return The Unix time at the boot.
+ */
+uint32_t DM_SimulatedWorld::getStartEpochSeconds()
+{
+    return DM_SimulatedWorld::_startEpochSeconds;
+}
+
+/**
+ * Set the SSID of the access points.
+ *
+ * @param SSID The SSID.
+ */
+void DM_SimulatedWorld::setSSID(const char *SSID)
+{
+    DM_SimulatedWorld::_SSID = SSID;
+}
+
+/**
+ * Get the SSID of the access points.
+ *
+ * @return The SSID.
+ */
+const char *DM_SimulatedWorld::getSSID()
+{
+    return DM_SimulatedWorld::_SSID.c_str();
+}
+
+/**
+ * Plan an outage of a part of the network.
+ *
+ * @param linkName The name of the link ("wifi", "internet" or "mqtt").
+ * @param startMs The moment it goes down (since the boot).
+ * @param durationMs How long it stays down.
+ *
+ * @return False if the name of the link is not known.
+ */
+bool DM_SimulatedWorld::addOutage(const char *linkName, uint64_t startMs, uint64_t durationMs)
+{
+    for (uint8_t link = 0; link < DM_AMOUNT_OF_LINKS; link++)
+    {
+        if (strcmp(linkName, linkNames[link]) != 0)
+            continue;
+        DM_SimulatedWorld::addOutage((DM_Link)link, startMs, durationMs);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Plan an outage of a part of the network (it is kept in the trace, if one is recorded).
+ *
+ * @param link The link.
+ * @param startMs The moment it goes down (since the boot).
+ * @param durationMs How long it stays down.
+ */
+void DM_SimulatedWorld::addOutage(DM_Link link, uint64_t startMs, uint64_t durationMs)
+{
+    DM_SimulatedWorld::_outages.push_back({link, startMs, startMs + durationMs});
+    DM_SimulatedTrace::recordOutage(link, startMs, durationMs);
+}
+
+/**
+ * Check if a part of the network is down.
+ *
+ * @param link The link.
+ * @param timeMs The moment (since the boot).
+ *
+ * @return True if the link is down at that moment.
+ */
+bool DM_SimulatedWorld::isDown(DM_Link link, uint64_t timeMs)
+{
+    return DM_SimulatedWorld::wasDown(link, timeMs, timeMs);
+}
+
+/**
+ * Check if a part of the network went down at some moment of a period (a connection that was open during an outage is broken, even if the link is back now).
+ *
+ * @param link The link.
+ * @param fromMs The start of the period (since the boot).
+ * @param toMs The end of the period.
+ *
+ * @return True if the link was down at any moment of the period.
+ */
+bool DM_SimulatedWorld::wasDown(DM_Link link, uint64_t fromMs, uint64_t toMs)
+{
+    for (const _Outage &outage : DM_SimulatedWorld::_outages)
+        if (outage.link == link && outage.startMs <= toMs && outage.endMs > fromMs)
+            return true;
+    return false;
+}
+
+/**
+ * Plan a command that is typed in the serial monitor (it is kept in the trace, if one is recorded).
+ *
+ * @param timeMs The moment it is typed (since the boot).
+ * @param text The command (without the end of the line).
+ *
+ * @return The success rate of planning the command.
+ */
+bool DM_SimulatedWorld::addSerialInput(uint64_t timeMs, const char *text)
+{
+    DM_SimulatedTrace::recordSerialInput(timeMs, text);
+    _SerialInput input = {timeMs, std::string(text) + "\n"};
+    DM_SimulatedWorld::_serialInputs.insert(std::upper_bound(DM_SimulatedWorld::_serialInputs.begin(), DM_SimulatedWorld::_serialInputs.end(), input, [](const _SerialInput &a, const _SerialInput &b)
+                                                             { return a.timeMs < b.timeMs; }),
+                                            input);
+    return true;
+}
+
+/**
+ * Count the characters that have been typed in the serial monitor and not read yet.
+ *
+ * @param timeMs The current moment (since the boot).
+ *
+ * @return The amount of characters that can be read.
+ */
+size_t DM_SimulatedWorld::getAvailableSerialInput(uint64_t timeMs)
+{
+    size_t amount = 0;
+    for (size_t i = DM_SimulatedWorld::_serialInputIndex; i < DM_SimulatedWorld::_serialInputs.size() && DM_SimulatedWorld::_serialInputs[i].timeMs <= timeMs; i++)
+        amount += DM_SimulatedWorld::_serialInputs[i].text.length() - (i == DM_SimulatedWorld::_serialInputIndex ? DM_SimulatedWorld::_serialInputPosition : 0);
+    return amount;
+}
+
+/**
+ * Read the next character that has been typed in the serial monitor.
+ *
+ * @param timeMs The current moment (since the boot).
+ *
+ * @return The character, or -1 if nothing has been typed.
+ */
+int DM_SimulatedWorld::readSerialInput(uint64_t timeMs)
+{
+    if (DM_SimulatedWorld::getAvailableSerialInput(timeMs) == 0)
+        return -1;
+    const std::string &text = DM_SimulatedWorld::_serialInputs[DM_SimulatedWorld::_serialInputIndex].text;
+    char character = text[DM_SimulatedWorld::_serialInputPosition++];
+    if (DM_SimulatedWorld::_serialInputPosition == text.length())
+    {
+        DM_SimulatedWorld::_serialInputIndex += 1;
+        DM_SimulatedWorld::_serialInputPosition = 0;
+    }
+    return (uint8_t)character;
+}
+
+/**
+ * Get the outside temperature: a daily cycle around a level that changes with the weather fronts.
+ *
+ * @param timeMs The moment (since the boot).
+ *
+ * @return The temperature in degrees Celsius.
+ */
+float DM_SimulatedWorld::getTemperatureC(uint64_t timeMs)
+{
+    if (DM_SimulatedTrace::isReplaying(DM_TRACE_TEMPERATURE))
+        return DM_SimulatedTrace::replayReading(DM_TRACE_TEMPERATURE, timeMs);
+    double dailyCycle = cos(2 * M_PI * (DM_SimulatedWorld::_getHourOfDay(timeMs) - 15) / 24);
+    return DM_SimulatedTrace::recordReading(DM_TRACE_TEMPERATURE, timeMs, 13 + 5 * DM_SimulatedWorld::_getNoise(0, timeMs, 2 * secondsPerDay * 1000ULL) + 6 * dailyCycle + 0.4 * DM_SimulatedWorld::_getNoise(1, timeMs, 20 * 60000));
+}
+
+/**
+ * Get the air pressure: slow changes with the weather fronts, and the small twice-daily atmospheric tide.
+ *
+ * @param timeMs The moment (since the boot).
+ *
+ * @return The air pressure in Pascal.
+ */
+float DM_SimulatedWorld::getPressurePa(uint64_t timeMs)
+{
+    if (DM_SimulatedTrace::isReplaying(DM_TRACE_PRESSURE))
+        return DM_SimulatedTrace::replayReading(DM_TRACE_PRESSURE, timeMs);
+    double tide = cos(2 * M_PI * (DM_SimulatedWorld::_getHourOfDay(timeMs) - 10) / 12);
+    return DM_SimulatedTrace::recordReading(DM_TRACE_PRESSURE, timeMs, 101325 + 1500 * DM_SimulatedWorld::_getNoise(2, timeMs, 3 * secondsPerDay * 1000ULL) + 150 * DM_SimulatedWorld::_getNoise(3, timeMs, 6 * 3600000) + 80 * tide);
+}
+
+/**
+ * Get the light level: daylight from 6 to 20 o'clock with a peak at 13 o'clock, dimmed by passing clouds, and a little light at night.
+ *
+ * @param timeMs The moment (since the boot).
+ *
+ * @return The light level in lux.
+ */
+float DM_SimulatedWorld::getLightLevelLux(uint64_t timeMs)
+{
+    if (DM_SimulatedTrace::isReplaying(DM_TRACE_LIGHT))
+        return DM_SimulatedTrace::replayReading(DM_TRACE_LIGHT, timeMs);
+    double hour = DM_SimulatedWorld::_getHourOfDay(timeMs);
+    double sunHeight = hour > 6 && hour < 20 ? sin(M_PI * (hour - 6) / 14) : 0;
+    double clouds = 0.6 + 0.25 * DM_SimulatedWorld::_getNoise(4, timeMs, 40 * 60000) + 0.15 * DM_SimulatedWorld::_getNoise(5, timeMs, 2 * 60000);
+    return DM_SimulatedTrace::recordReading(DM_TRACE_LIGHT, timeMs, 0.5 + 80000 * pow(sunHeight, 1.5) * clouds);
+}
+
+/**
+ * Draw a random number between 0 and 1.
+ *
+ * @param source The model that needs the number.
+ *
+ * @return The number (0 included, 1 not).
+ */
+double DM_SimulatedWorld::drawUniform(DM_RandomSource source)
+{
+    return std::uniform_real_distribution<double>(0, 1)(DM_SimulatedWorld::_getGenerator(source));
+}
+
+/**
+ * Draw a random number from the standard normal distribution.
+ *
+ * @param source The model that needs the number.
+ *
+ * @return The number (mean 0, standard deviation 1).
+ */
+double DM_SimulatedWorld::drawNormal(DM_RandomSource source)
+{
+    return std::normal_distribution<double>(0, 1)(DM_SimulatedWorld::_getGenerator(source));
+}
+
+/**
+ * Get smooth noise that only depends on the seed and the time: a random value every period, and a smooth curve in between.
+ *
+ * @param channel The number of the noise (every quantity uses its own).
+ * @param timeMs The moment (since the boot).
+ * @param periodMs The time between two random values (the larger, the slower the noise changes).
+ *
+ * @return The noise, between -1 and 1.
+ */
+double DM_SimulatedWorld::_getNoise(uint32_t channel, uint64_t timeMs, uint64_t periodMs)
+{
+    // Find the random values before and after the moment (a hash of the seed, the channel and the number of the period)
+    double values[2];
+    uint64_t period = timeMs / periodMs;
+    for (int i = 0; i < 2; i++)
+    {
+        uint64_t hash = ((uint64_t)DM_SimulatedWorld::_seed << 40) ^ ((uint64_t)channel << 32) ^ (period + i);
+        hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+        hash ^= hash >> 31;
+        values[i] = (hash >> 11) * (2.0 / 9007199254740992.0) - 1;
+    }
+
+    // Go smoothly from the first to the second value
+    double fraction = (double)(timeMs % periodMs) / periodMs;
+    fraction = fraction * fraction * (3 - 2 * fraction);
+    return values[0] + (values[1] - values[0]) * fraction;
+}
+
+/**
+ * Get the time of day (in UTC).
+ *
+ * @param timeMs The moment (since the boot).
+ *
+ * @return The hour of the day, with the minutes and seconds as fraction.
+ */
+double DM_SimulatedWorld::_getHourOfDay(uint64_t timeMs)
+{
+    uint64_t secondOfDay = (DM_SimulatedWorld::_startEpochSeconds + timeMs / 1000) % secondsPerDay;
+    return (secondOfDay + (timeMs % 1000) / 1000.0) / 3600.0;
+}
+
+/**
+ * Get the random number generator of a model (they are seeded on first use, so the seed can be set first).
+ *
+ * @param source The model.
+ *
+ * @return The generator.
+ */
+std::mt19937 &DM_SimulatedWorld::_getGenerator(DM_RandomSource source)
+{
+    if (!DM_SimulatedWorld::_generatorsSeeded)
+    {
+        for (uint8_t i = 0; i < DM_AMOUNT_OF_RANDOM_SOURCES; i++)
+        {
+            std::seed_seq seed = {DM_SimulatedWorld::_seed, (uint32_t)i};
+            DM_SimulatedWorld::_generators[i].seed(seed);
+        }
+        DM_SimulatedWorld::_generatorsSeeded = true;
+    }
+    return DM_SimulatedWorld::_generators[source];
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+/** +----------------------------------------------+
+ *  |   DM_SimulatedWorld - Weather and outages    |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef DM_SimulatedWorld_h
+#define DM_SimulatedWorld_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h> // Used to be able to use the "size_t" type
+#include <stdint.h> // Used to be able to use the fixed width integer types
+#include <random>   // Used to draw the sensor noise and the network latencies
+#include <string>   // Used to keep the SSID and the typed commands
+#include <vector>   // Used to keep the outages and the typed commands
+
+// DECLARE THE ENUM "DM_Link" (the parts of the network that can go down)
+enum DM_Link : uint8_t
+{
+    DM_LINK_WIFI,       // The access points (the station loses its Wi-Fi connection)
+    DM_LINK_INTERNET,   // The internet connection of the router (Wi-Fi stays up, but no server can be reached)
+    DM_LINK_MQTT,       // The MQTT brokers (Wi-Fi and HTTP keep working)
+    DM_AMOUNT_OF_LINKS  // The amount of links (not a link)
+};
+
+// DECLARE THE ENUM "DM_RandomSource" (every model draws from its own generator, so a change in one model doesn't change the numbers of another)
+enum DM_RandomSource : uint8_t
+{
+    DM_RANDOM_SENSORS,         // The noise of the sensors
+    DM_RANDOM_NETWORK,         // The latencies and the signal strength of the network
+    DM_RANDOM_STATION,         // The "random()" function of the station
+    DM_RANDOM_GLITCHES,        // The glitched readings of the sensors ("--glitches")
+    DM_AMOUNT_OF_RANDOM_SOURCES // The amount of sources (not a source)
+};
+
+/**
+ * The world around the simulated station: the weather the sensors measure, the outages of the network, the commands that are typed in the serial monitor, and the random numbers of the models.
+ *
+ * The weather is a function of the time only (unless a recording is replayed, see "DM_SimulatedTrace.h"): a daily cycle (warm and bright in the afternoon, cold and dark at night) with fronts and clouds from smooth noise that only depends on the seed.
+ * So the same seed always gives the same weather, no matter in which order or how often the sensors read it.
+ */
+class DM_SimulatedWorld
+{
+public: // The public functions and constants
+    static constexpr uint32_t defaultSeed = 1;                           // The seed unless "--seed" says otherwise
+    static constexpr uint32_t defaultStartEpochSeconds = 1714521600;     // The real time at the boot unless "--start" says otherwise (1 May 2024, 00:00 UTC)
+    static constexpr const char *defaultSSID = "xxxxxxxxxxxxxxxxxxxx";   // The SSID of the access points unless "--ssid" says otherwise (the placeholder in "main.cpp")
+
+    static void setSeed(uint32_t seed);
+    static uint32_t getSeed();
+    static void setStartEpochSeconds(uint32_t epochSeconds);
+    static uint32_t getStartEpochSeconds();
+    static void setSSID(const char *SSID);
+    static const char *getSSID();
+    static bool addOutage(const char *linkName, uint64_t startMs, uint64_t durationMs);
+    static void addOutage(DM_Link link, uint64_t startMs, uint64_t durationMs);
+    static bool isDown(DM_Link link, uint64_t timeMs);
+    static bool wasDown(DM_Link link, uint64_t fromMs, uint64_t toMs);
+    static bool addSerialInput(uint64_t timeMs, const char *text);
+    static size_t getAvailableSerialInput(uint64_t timeMs);
+    static int readSerialInput(uint64_t timeMs);
+    static float getTemperatureC(uint64_t timeMs);
+    static float getPressurePa(uint64_t timeMs);
+    static float getLightLevelLux(uint64_t timeMs);
+    static double drawUniform(DM_RandomSource source);
+    static double drawNormal(DM_RandomSource source);
+
+private: // The private functions and members
+    struct _Outage
+    {
+        DM_Link link;     // The link that is down
+        uint64_t startMs; // The moment it goes down
+        uint64_t endMs;   // The moment it is back
+    };
+    struct _SerialInput
+    {
+        uint64_t timeMs;  // The moment the command is typed
+        std::string text; // The command, with the end of the line
+    };
+    static uint32_t _seed;
+    static uint32_t _startEpochSeconds;
+    static std::string _SSID;
+    static std::vector<_Outage> _outages;
+    static std::vector<_SerialInput> _serialInputs;
+    static size_t _serialInputIndex;
+    static size_t _serialInputPosition;
+    static std::mt19937 _generators[DM_AMOUNT_OF_RANDOM_SOURCES];
+    static bool _generatorsSeeded;
+    static double _getNoise(uint32_t channel, uint64_t timeMs, uint64_t periodMs);
+    static double _getHourOfDay(uint64_t timeMs);
+    static std::mt19937 &_getGenerator(DM_RandomSource source);
+};
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,675 @@
+/** +----------------------------------------------+
+ *  |      DM_Simulator - Virtual time kernel      |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "DM_Simulator.h"        // Include the header file where the declarations for this library are stored
+#include "DM_SimulatedWorld.h"   // Used to set the weather, the outages and the typed commands from the options
+#include "DM_SimulatedNetwork.h" // Used to show what the simulated servers received, and to request pages from the web server of the station
+#include "DM_SimulatedSensors.h" // Used to connect the simulated sensors to the I2C bus
+#include "DM_SimulatedCodec.h"   // Used to show how well the readings were compressed
+#include "DM_SimulatedTrace.h"   // Used to record the world or replay a recording, from the options
+#include "esp_heap_caps.h"       // Used to show the lowest amount of free memory
+#include "freertos/task.h"       // Used to delete the tasks of the station when it goes into deep sleep
+#include <DM_Profiler.h>         // Used to write the latency of the hot paths of the station to the benchmark results (only when built with "-D DM_PROFILING")
+#include <stdio.h>               // Used to show the serial monitor and the summary
+#include <stdlib.h>              // Used to read the numbers in the options
+#include <string.h>              // Used to compare the options
+#include <unistd.h>              // Used to end the process without waiting for the threads of the tasks ("_exit()")
+#include <algorithm>             // Used to find the first task that wakes up ("std::min()")
+#include <chrono>                // Used to measure how much faster than real time the simulation ran
+#include <condition_variable>    // Used to hand the processor from one task to the next
+#include <mutex>                 // Used to let only one task run at a time
+#include <string>                // Used to keep the name of a task and the pages to request
+#include <thread>                // Used to give every task a thread of its own
+#include <vector>                // Used to keep the list of tasks
+
+// The functions of the station (see "main.cpp")
+void setup();
+void loop();
+
+// DECLARE THE STRUCT "DM_SimulatedWake" (thrown by a deep sleep, so the stack of "setup()" unwinds and the wake starts "setup()" again)
+struct DM_SimulatedWake
+{
+};
+
+// DECLARE THE STRUCT "DM_SimulatedTask"
+struct DM_SimulatedTask
+{
+    std::string name;                // The name of the task
+    uint32_t priority;               // The priority of the task (the highest ready task runs first)
+    void (*function)(void *);        // The function of the task
+    void *parameters;                // The parameters of the function
+    std::condition_variable turn;    // Signalled when the task may run
+    std::function<bool()> condition; // What the task waits for while it is blocked (empty when it only waits for the clock)
+    uint64_t wakeUs;                 // The moment the task stops waiting anyway ("forever" if it never does)
+    uint64_t readySequence;          // When the task became ready (tasks with the same priority run in that order)
+    uint32_t notifications;          // The notification value of the task ("xTaskNotifyGive()")
+    bool blocked;                    // If the task is waiting
+    bool deleted;                    // If the task has been deleted (it never runs again)
+};
+
+// OTHER VARIABLES
+std::mutex kernelLock;                                         // Held by the task that runs (and by the main thread while no task runs)
+std::condition_variable simulationEnded;                       // Signalled when the simulation ends
+thread_local std::unique_lock<std::mutex> *heldLock = nullptr; // The lock of the thread of the current task
+std::vector<DM_SimulatedTask *> tasks;                         // Every task that has been created
+DM_SimulatedTask *runningTask = nullptr;                       // The task that runs
+uint64_t nowUs = 0;                                            // The virtual clock
+uint64_t bootUs = 0;                                           // The moment of the last boot or wake (the start of "millis()")
+uint32_t amountOfWakes = 0;                                    // The amount of wakes from deep sleep
+uint64_t endUs = 0;                                            // The moment the simulation ends
+uint64_t lastReadySequence = 0;                                // The sequence number of the task that became ready last
+bool ended = false;                                            // If the simulation has ended
+const char *endReason = "";                                    // Why the simulation ended
+bool quiet = false;                                            // If the serial monitor is hidden
+std::vector<std::string> pagesToFetch;                         // The pages of the web server that are requested at the end
+std::string benchmarkPath;                                     // The file the benchmark results are written to (empty if they aren't)
+bool durationGiven = false;                                    // If "--duration" was given (otherwise a replay lasts as long as the recording)
+std::string serialLine;                                        // The line of the serial monitor that is being written
+uint64_t serialLineStartUs = 0;                                // The moment the first character of that line was written
+
+/**
+ * Run the station (called by "main()").
+ *
+ * @param argc The amount of command line arguments.
+ * @param argv The command line arguments (see "--help").
+ *
+ * @return The exit code of the process.
+ */
+int DM_Simulator::run(int argc, char **argv)
+{
+    // Read the options and build the world around the station
+    endUs = (uint64_t)DM_Simulator::defaultDurationHours * 3600000000ULL;
+    if (!DM_Simulator::_parseOptions(argc, argv))
+        return 2;
+    DM_SimulatedSensors::begin();
+
+    // Start the task that runs "setup()" and "loop()", and wait until the simulation ends
+    std::unique_lock<std::mutex> lock(kernelLock);
+    std::chrono::steady_clock::time_point realStart = std::chrono::steady_clock::now();
+    DM_Simulator::createTask(DM_Simulator::_loopTask, "loopTask", DM_Simulator::loopTaskPriority, nullptr);
+    runningTask = DM_Simulator::_pickNextTask();
+    runningTask->turn.notify_one();
+    simulationEnded.wait(lock, []
+                         { return ended; });
+    double realSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - realStart).count();
+
+    // Show what happened, and request the pages of the web server while every task is parked
+    if (!serialLine.empty())
+        DM_Simulator::showSerialOutput((const uint8_t *)"\n", 1);
+    DM_Simulator::_printSummary(realSeconds);
+    bool saved = DM_SimulatedTrace::save(nowUs / 1000) && (benchmarkPath.empty() || DM_Simulator::_writeBenchmark(realSeconds));
+    for (const std::string &path : pagesToFetch)
+        DM_SimulatedNetwork::printPage(path.c_str());
+
+    // End the process without destroying what the parked threads still wait on
+    if (!saved)
+        fprintf(stderr, "The trace or the benchmark results could not be written.\n");
+    fflush(stdout);
+    _exit(saved ? 0 : 1);
+}
+
+/**
+ * Read the virtual clock.
+ *
+ * @return The amount of microseconds since the boot.
+ */
+uint64_t DM_Simulator::getMicroseconds()
+{
+    return nowUs;
+}
+
+/**
+ * Read the clock of the station ("millis()" and "micros()" start over on every wake from deep sleep, like on the ESP32).
+ *
+ * @return The amount of microseconds since the boot or the last wake.
+ */
+uint64_t DM_Simulator::getMicrosecondsSinceBoot()
+{
+    return nowUs - bootUs;
+}
+
+/**
+ * Get how many times the station woke from deep sleep.
+ *
+ * @return The amount of wakes.
+ */
+uint32_t DM_Simulator::getAmountOfWakes()
+{
+    return amountOfWakes;
+}
+
+/**
+ * Convert a FreeRTOS timeout to microseconds of the virtual clock (one tick is one millisecond, like on the ESP32).
+ *
+ * @param ticks The timeout in ticks ("portMAX_DELAY" to wait forever).
+ *
+ * @return The timeout in µs.
+ */
+uint64_t DM_Simulator::ticksToMicroseconds(uint32_t ticks)
+{
+    return ticks == UINT32_MAX ? DM_Simulator::forever : (uint64_t)ticks * 1000;
+}
+
+/**
+ * Let time pass without letting another task run (like a busy wait, or a bus transfer the processor waits for).
+ *
+ * @param durationUs The time that passes in µs.
+ */
+void DM_Simulator::busyWait(uint64_t durationUs)
+{
+    nowUs += durationUs;
+}
+
+/**
+ * Block the current task for a while (the other tasks run in the meantime).
+ *
+ * @param durationUs The time to sleep in µs (0 lets the other ready tasks with the same priority run first).
+ */
+void DM_Simulator::sleep(uint64_t durationUs)
+{
+    uint64_t wakeUs = nowUs + durationUs;
+    DM_SimulatedTask *task = runningTask;
+    do
+    {
+        task->condition = nullptr;
+        task->wakeUs = wakeUs;
+        task->blocked = true;
+        DM_Simulator::_switchFrom(task);
+    } while (nowUs < wakeUs);
+}
+
+/**
+ * Block the current task until a condition comes true (the other tasks run in the meantime).
+ *
+ * @param condition The condition (it is checked every time a task blocks, so it has to be cheap).
+ * @param timeoutUs The longest time to wait in µs ("forever" to never stop waiting, 0 to only check the condition).
+ *
+ * @return False if the condition was still false when the timeout passed.
+ */
+bool DM_Simulator::waitUntil(const std::function<bool()> &condition, uint64_t timeoutUs)
+{
+    uint64_t wakeUs = timeoutUs == DM_Simulator::forever ? DM_Simulator::forever : nowUs + timeoutUs;
+    DM_SimulatedTask *task = runningTask;
+    while (!condition())
+    {
+        if (nowUs >= wakeUs)
+            return false;
+        task->condition = condition;
+        task->wakeUs = wakeUs;
+        task->blocked = true;
+        DM_Simulator::_switchFrom(task);
+    }
+    return true;
+}
+
+/**
+ * Create a task (it runs once the current task blocks, or right away when the simulation starts).
+ *
+ * @param function The function of the task.
+ * @param name The name of the task.
+ * @param priority The priority of the task.
+ * @param parameters The parameters of the function.
+ *
+ * @return The task.
+ */
+DM_SimulatedTask *DM_Simulator::createTask(void (*function)(void *), const char *name, uint32_t priority, void *parameters)
+{
+    // The stack and control block are counted by "xTaskCreatePinnedToCore()", the thread behind the task is not memory of the station
+    bool counting = DM_SimulatedHeap::setCounting(false);
+    DM_SimulatedTask *task = new DM_SimulatedTask();
+    task->name = name;
+    task->priority = priority;
+    task->function = function;
+    task->parameters = parameters;
+    task->wakeUs = DM_Simulator::forever;
+    task->readySequence = ++lastReadySequence;
+    task->notifications = 0;
+    task->blocked = false;
+    task->deleted = false;
+    tasks.push_back(task);
+    std::thread(DM_Simulator::_taskThread, task).detach();
+    DM_SimulatedHeap::setCounting(counting);
+    return task;
+}
+
+/**
+ * Get the task that runs.
+ *
+ * @return The current task.
+ */
+DM_SimulatedTask *DM_Simulator::getCurrentTask()
+{
+    return runningTask;
+}
+
+/**
+ * Delete a task (if it is the current task, this never returns).
+ *
+ * @param task The task.
+ */
+void DM_Simulator::deleteTask(DM_SimulatedTask *task)
+{
+    task->deleted = true;
+    if (task == runningTask)
+        DM_Simulator::_switchFrom(task);
+}
+
+/**
+ * Add one to the notification value of a task (it stops waiting in takeNotification()).
+ *
+ * @param task The task.
+ */
+void DM_Simulator::notifyTask(DM_SimulatedTask *task)
+{
+    task->notifications += 1;
+}
+
+/**
+ * Wait until the notification value of the current task is not zero, and take it.
+ *
+ * @param clear True to set the value back to zero, false to subtract one.
+ * @param timeoutUs The longest time to wait in µs.
+ *
+ * @return The notification value before it was taken (0 if the timeout passed).
+ */
+uint32_t DM_Simulator::takeNotification(bool clear, uint64_t timeoutUs)
+{
+    DM_SimulatedTask *task = runningTask;
+    if (!DM_Simulator::waitUntil([task]
+                                 { return task->notifications > 0; },
+                                 timeoutUs))
+        return 0;
+    uint32_t value = task->notifications;
+    task->notifications = clear ? 0 : value - 1;
+    return value;
+}
+
+/**
+ * End the simulation (e.g. when the station goes into deep sleep). The current task never runs again.
+ *
+ * @param reason Why the simulation ends (shown in the summary).
+ */
+void DM_Simulator::stop(const char *reason)
+{
+    ended = true;
+    endReason = reason;
+    simulationEnded.notify_one();
+    DM_SimulatedTask *task = runningTask;
+    for (;;)
+        task->turn.wait(*heldLock);
+}
+
+/**
+ * Go into deep sleep and wake up again after the timer (only from "setup()" or "loop()"): the other tasks are deleted, the time passes and "setup()" starts over.
+ * The simulation ends if the timer would only fire after the end.
+ *
+ * @param durationUs The time until the timer wakes the station.
+ */
+void DM_Simulator::deepSleep(uint64_t durationUs)
+{
+    // Sleep until the end if the station would not wake before it
+    if (nowUs + durationUs > endUs)
+    {
+        nowUs = endUs;
+        DM_Simulator::stop("the simulated time is over");
+    }
+
+    // Nothing but the RTC runs during a deep sleep (the stacks of the tasks go back to the heap)
+    for (DM_SimulatedTask *task : tasks)
+        if (task != runningTask && !task->deleted)
+            vTaskDelete(task);
+    nowUs += durationUs;
+    bootUs = nowUs;
+    amountOfWakes += 1;
+    throw DM_SimulatedWake();
+}
+
+/**
+ * Show what the station wrote to the serial port, one line at a time with the virtual time in front (unless "--quiet" is given).
+ *
+ * @param data The characters.
+ * @param length The amount of characters.
+ */
+void DM_Simulator::showSerialOutput(const uint8_t *data, size_t length)
+{
+    if (quiet)
+        return;
+    for (size_t i = 0; i < length; i++)
+    {
+        // Remember when a line starts, and collect its characters
+        if (serialLine.empty())
+            serialLineStartUs = nowUs;
+        if (data[i] != '\n' && data[i] != '\r' && serialLine.length() < DM_Simulator::serialOutputMaxLineLength)
+            serialLine += (char)data[i];
+        if (data[i] != '\n')
+            continue;
+
+        // Show the line
+        char time[24];
+        DM_Simulator::formatTime(serialLineStartUs, time, sizeof(time));
+        printf("[%s] %s\n", time, serialLine.c_str());
+        serialLine.clear();
+    }
+}
+
+/**
+ * Write a moment of the virtual clock as hours, minutes, seconds and milliseconds since the boot (e.g. "26:03:15.250").
+ *
+ * @param timeUs The moment in µs.
+ * @param buffer The buffer the time is written to.
+ * @param bufferSize The size of the buffer.
+ *
+ * @return The length of the text.
+ */
+size_t DM_Simulator::formatTime(uint64_t timeUs, char *buffer, size_t bufferSize)
+{
+    uint64_t timeMs = timeUs / 1000;
+    int length = snprintf(buffer, bufferSize, "%02lu:%02lu:%02lu.%03lu", (unsigned long)(timeMs / 3600000), (unsigned long)(timeMs / 60000 % 60), (unsigned long)(timeMs / 1000 % 60), (unsigned long)(timeMs % 1000));
+    return length > 0 ? std::min((size_t)length, bufferSize - 1) : 0;
+}
+
+/**
+ * Choose the task that runs next: the ready task with the highest priority (the one that waited longest if several have the same priority).
+ * Blocked tasks become ready when their condition came true or their timeout passed; when no task is ready, the clock jumps to the first timeout.
+ *
+ * @return The next task, or nullptr if no task will ever run again before the end of the simulation.
+ */
+DM_SimulatedTask *DM_Simulator::_pickNextTask()
+{
+    for (;;)
+    {
+        DM_SimulatedTask *next = nullptr;
+        uint64_t nextWakeUs = DM_Simulator::forever;
+        for (DM_SimulatedTask *task : tasks)
+        {
+            // Skip the deleted tasks, and wake up the blocked ones that may continue
+            if (task->deleted)
+                continue;
+            if (task->blocked)
+            {
+                if (task->wakeUs > nowUs && !(task->condition && task->condition()))
+                {
+                    nextWakeUs = std::min(nextWakeUs, task->wakeUs);
+                    continue;
+                }
+                task->blocked = false;
+                task->readySequence = ++lastReadySequence;
+            }
+
+            // Keep the ready task that goes first
+            if (next == nullptr || task->priority > next->priority || (task->priority == next->priority && task->readySequence < next->readySequence))
+                next = task;
+        }
+        if (next != nullptr)
+            return next;
+
+        // Let the time pass until the first task wakes up (unless that is after the end)
+        if (nextWakeUs == DM_Simulator::forever)
+        {
+            endReason = "every task waits for something that never happens";
+            return nullptr;
+        }
+        if (nextWakeUs > endUs)
+        {
+            nowUs = endUs;
+            endReason = "the simulated time is over";
+            return nullptr;
+        }
+        nowUs = nextWakeUs;
+    }
+}
+
+/**
+ * Hand the processor to the next task and wait until the given task may run again (called by the current task after it blocked or was deleted).
+ *
+ * @param task The current task.
+ */
+void DM_Simulator::_switchFrom(DM_SimulatedTask *task)
+{
+    // Let the next task run, or end the simulation if there is none
+    DM_SimulatedTask *next = DM_Simulator::_pickNextTask();
+    if (next == nullptr)
+    {
+        ended = true;
+        simulationEnded.notify_one();
+    }
+    else
+    {
+        runningTask = next;
+        if (next != task)
+            next->turn.notify_one();
+    }
+
+    // Wait for our turn (a deleted task, or a task at the end of the simulation, waits forever)
+    task->turn.wait(*heldLock, [task]
+                    { return runningTask == task && !ended; });
+}
+
+/**
+ * The thread of a task: wait for the first turn, then run the function of the task.
+ *
+ * @param task The task.
+ */
+void DM_Simulator::_taskThread(DM_SimulatedTask *task)
+{
+    std::unique_lock<std::mutex> lock(kernelLock);
+    heldLock = &lock;
+    task->turn.wait(lock, [task]
+                    { return runningTask == task && !ended; });
+
+    // Count everything the task allocates against the heap of the station (see "esp_heap_caps.h")
+    DM_SimulatedHeap::setCounting(true);
+    task->function(task->parameters);
+
+    // A FreeRTOS task may never return, so treat it as deleted
+    DM_Simulator::deleteTask(task);
+}
+
+/**
+ * The task that runs "setup()" once and "loop()" forever, like the "loopTask" of the Arduino core.
+ *
+ * @param parameters Unused.
+ */
+void DM_Simulator::_loopTask(void *parameters)
+{
+    // Start over after every wake from deep sleep
+    for (;;)
+    {
+        try
+        {
+            setup();
+            for (;;)
+                loop();
+        }
+        catch (const DM_SimulatedWake &)
+        {
+        }
+    }
+}
+
+/**
+ * Read the command line options.
+ *
+ * @param argc The amount of command line arguments.
+ * @param argv The command line arguments.
+ *
+ * @return False if an option is not valid (the usage has been shown).
+ */
+bool DM_Simulator::_parseOptions(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        // Every option but "--quiet" and "--help" has a value
+        const char *option = argv[i];
+        if (strcmp(option, "--quiet") == 0)
+        {
+            quiet = true;
+            continue;
+        }
+        if (strcmp(option, "--help") == 0 || i + 1 >= argc)
+        {
+            DM_Simulator::_printUsage(argv[0]);
+            return false;
+        }
+        const char *value = argv[++i];
+
+        // Read the value of the option
+        char link[16];
+        unsigned long start, duration, times = 1, every = 0;
+        int textStart = 0, amount;
+        bool valid = true;
+        if (strcmp(option, "--duration") == 0)
+        {
+            endUs = (uint64_t)(atof(value) * 3600000000.0);
+            durationGiven = true;
+        }
+        else if (strcmp(option, "--seed") == 0)
+            DM_SimulatedWorld::setSeed(strtoul(value, nullptr, 10));
+        else if (strcmp(option, "--start") == 0)
+            DM_SimulatedWorld::setStartEpochSeconds(strtoul(value, nullptr, 10));
+        else if (strcmp(option, "--ssid") == 0)
+            DM_SimulatedWorld::setSSID(value);
+        else if (strcmp(option, "--outage") == 0)
+        {
+            // An outage can repeat (e.g. a broker that flaps), every repetition is planned on its own
+            amount = sscanf(value, "%15[a-z]:%lu:%lu:%lu:%lu", link, &start, &duration, &times, &every);
+            valid = amount == 3 || (amount == 5 && times > 0 && every >= duration);
+            for (unsigned long repetition = 0; valid && repetition < times; repetition++)
+                valid = DM_SimulatedWorld::addOutage(link, (uint64_t)(start + repetition * every) * 60000, (uint64_t)duration * 60000);
+        }
+        else if (strcmp(option, "--glitches") == 0)
+            valid = DM_SimulatedSensors::setGlitchProbability(atof(value));
+        else if (strcmp(option, "--type") == 0)
+            valid = sscanf(value, "%lu:%n", &start, &textStart) == 1 && textStart > 0 && DM_SimulatedWorld::addSerialInput((uint64_t)start * 60000, value + textStart);
+        else if (strcmp(option, "--fetch") == 0)
+            pagesToFetch.push_back(value);
+        else if (strcmp(option, "--record") == 0)
+            DM_SimulatedTrace::setRecordFile(value);
+        else if (strcmp(option, "--replay") == 0)
+            valid = DM_SimulatedTrace::loadReplayFile(value);
+        else if (strcmp(option, "--benchmark") == 0)
+            benchmarkPath = value;
+        else
+            valid = false;
+
+        // Show how to use the options if something is wrong
+        if (!valid)
+        {
+            fprintf(stderr, "Invalid option: %s %s\n", option, value);
+            DM_Simulator::_printUsage(argv[0]);
+            return false;
+        }
+    }
+
+    // A replay lasts as long as the recording, unless the duration is given
+    if (!durationGiven && DM_SimulatedTrace::getReplayDurationMs() > 0)
+        endUs = DM_SimulatedTrace::getReplayDurationMs() * 1000;
+    return true;
+}
+
+/**
+ * Show the command line options.
+ *
+ * @param program The name of the program.
+ */
+void DM_Simulator::_printUsage(const char *program)
+{
+    fprintf(stderr, "Usage: %s [options]\n", program);
+    fprintf(stderr, "  --duration <hours>                  The virtual time to simulate (default %lu)\n", (unsigned long)DM_Simulator::defaultDurationHours);
+    fprintf(stderr, "  --seed <number>                     The seed of the weather, the sensor noise and the network latencies (default %lu)\n", (unsigned long)DM_SimulatedWorld::defaultSeed);
+    fprintf(stderr, "  --start <Unix time>                 The real time at the boot (default %lu)\n", (unsigned long)DM_SimulatedWorld::defaultStartEpochSeconds);
+    fprintf(stderr, "  --ssid <SSID>                       The SSID of the simulated access points (default \"%s\", the placeholder in \"main.cpp\")\n", DM_SimulatedWorld::getSSID());
+    fprintf(stderr, "  --outage <link>:<minute>:<minutes>[:<times>:<every minutes>]\n");
+    fprintf(stderr, "                                      Take \"wifi\", \"internet\" or \"mqtt\" down for a while, once or a number of times (can be repeated)\n");
+    fprintf(stderr, "  --glitches <chance>                 Let this part of the sensor conversions give a reading that is off by far, e.g. 0.01 (default 0)\n");
+    fprintf(stderr, "  --type <minute>:<command>           Type a command in the serial monitor, e.g. \"30:window 300 60\" (can be repeated)\n");
+    fprintf(stderr, "  --fetch <path>                      Request a page of the web server when the simulation ends, e.g. \"/metrics\" (can be repeated)\n");
+    fprintf(stderr, "  --record <file>                     Record the readings, the outages and the commands into a trace file\n");
+    fprintf(stderr, "  --replay <file>                     Replay a trace file (with its seed and start), or a CSV of \"/history\" of a station, instead of the weather model\n");
+    fprintf(stderr, "  --benchmark <file>                  Write the cycle times, the latencies, the memory and the uplink throughput as JSON when the simulation ends\n");
+    fprintf(stderr, "  --quiet                             Don't show the serial monitor\n");
+}
+
+/**
+ * Show how long the simulation took, and what the simulated world saw of the station.
+ *
+ * @param realSeconds The real time the simulation took.
+ */
+void DM_Simulator::_printSummary(double realSeconds)
+{
+    char time[24];
+    DM_Simulator::formatTime(nowUs, time, sizeof(time));
+    printf("--- Simulation ended at %s (%s) ---\n", time, endReason);
+    if (amountOfWakes > 0)
+        printf("Deep sleep: %lu wakes\n", (unsigned long)amountOfWakes);
+    printf("Real time: %.2f s (%.0fx faster than real time)\n", realSeconds, realSeconds > 0 ? nowUs / 1e6 / realSeconds : 0.0);
+    DM_SimulatedSensors::printSummary();
+    DM_SimulatedCodec::printSummary();
+    DM_SimulatedNetwork::printSummary();
+    printf("Memory: %lu bytes free at the end, %lu bytes at the lowest point\n", (unsigned long)heap_caps_get_free_size(MALLOC_CAP_8BIT), (unsigned long)heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT));
+}
+
+/**
+ * Write the benchmark results as JSON: what the station did per simulated hour, how long its hot paths took, and how much memory it needed.
+ * Everything but the "host" member only depends on the options, so the results of two commits can be compared directly.
+ *
+ * @param realSeconds The real time the simulation took.
+ *
+ * @return False if the file can't be written.
+ */
+bool DM_Simulator::_writeBenchmark(double realSeconds)
+{
+    FILE *file = fopen(benchmarkPath.c_str(), "w");
+    if (file == nullptr)
+        return false;
+
+    // The simulation itself
+    fprintf(file, "{\n  \"format\": 1,\n  \"seed\": %lu,\n  \"start\": %lu,\n  \"simulated_hours\": %.3f,\n  \"end_reason\": \"%s\",\n  \"wakes\": %lu,\n", (unsigned long)DM_SimulatedWorld::getSeed(),
+            (unsigned long)DM_SimulatedWorld::getStartEpochSeconds(), nowUs / 3600e6, endReason, (unsigned long)amountOfWakes);
+
+    // The sampling cycle as the sensors saw it, and the latency of every hot path the profiler measured (empty without "-D DM_PROFILING")
+    DM_SimulatedSensors::printBenchmark(file);
+    fprintf(file, ",\n");
+    DM_SimulatedCodec::printBenchmark(file);
+    fprintf(file, ",\n  \"stages\": {");
+#ifdef DM_PROFILING
+    for (uint8_t stage = 0; stage < DM_AMOUNT_OF_STAGES; stage++)
+    {
+        fprintf(file, "%s\n    \"%s\": {\"samples\": %lu", stage == 0 ? "" : ",", DM_Profiler::getStageName((DM_Stage)stage), (unsigned long)DM_Profiler::getAmountOfSamples((DM_Stage)stage));
+        for (uint16_t perMille : DM_Profiler::percentiles)
+            fprintf(file, ", \"p%u_us\": %lu", (unsigned)(perMille / 10), (unsigned long)DM_Profiler::getPercentileMicroseconds((DM_Stage)stage, perMille));
+        fprintf(file, ", \"max_us\": %lu}", (unsigned long)DM_Profiler::getMaximumMicroseconds((DM_Stage)stage));
+    }
+#endif
+
+    // The memory, and what reached the servers
+    size_t heapBytes = heap_caps_get_total_size(MALLOC_CAP_8BIT);
+    size_t minimumFreeBytes = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    fprintf(file, "\n  },\n  \"memory\": {\"heap_bytes\": %lu, \"free_at_end_bytes\": %lu, \"minimum_free_bytes\": %lu, \"high_water_mark_bytes\": %lu, \"allocations\": %lu, \"uncounted_blocks\": %lu},\n",
+            (unsigned long)heapBytes, (unsigned long)heap_caps_get_free_size(MALLOC_CAP_8BIT), (unsigned long)minimumFreeBytes, (unsigned long)(heapBytes - minimumFreeBytes),
+            (unsigned long)DM_SimulatedHeap::getAmountOfAllocations(), (unsigned long)DM_SimulatedHeap::getAmountOfUncountedBlocks());
+    DM_SimulatedNetwork::printBenchmark(file);
+
+    // The computer that ran the simulation (this changes from run to run)
+    fprintf(file, ",\n  \"host\": {\"real_seconds\": %.3f, \"speedup\": %.0f, \"encode_ns_per_sample\": %.1f, \"decode_ns_per_sample\": %.1f}\n}\n", realSeconds, realSeconds > 0 ? nowUs / 1e6 / realSeconds : 0.0,
+            DM_SimulatedCodec::getEncodeNanosecondsPerSample(), DM_SimulatedCodec::getDecodeNanosecondsPerSample());
+    return fclose(file) == 0;
+}
+
+/**
+ * Start the simulation.
+ *
+ * @param argc The amount of command line arguments.
+ * @param argv The command line arguments.
+ *
+ * @return The exit code of the process.
+ */
+int main(int argc, char **argv)
+{
+    return DM_Simulator::run(argc, argv);
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+/** +----------------------------------------------+
+ *  |      DM_Simulator - Virtual time kernel      |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef DM_Simulator_h
+#define DM_Simulator_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h>   // Used to be able to use the "size_t" type
+#include <stdint.h>   // Used to be able to use the fixed width integer types
+#include <functional> // Used to pass the condition a task waits for
+
+// DECLARE THE STRUCT "DM_SimulatedTask" (a FreeRTOS task of the station, the members are only used by the kernel)
+struct DM_SimulatedTask;
+
+/**
+ * Runs the station on Linux (the "native" environment in "platformio.ini"): "setup()" and "loop()" run unchanged in a simulated "loopTask", every FreeRTOS task they start gets a thread of its own.
+ *
+ * The threads take turns: exactly one task runs at a time, and it only hands over the processor when it blocks (vTaskDelay(), delay(), a queue, a notification, a network request, ...).
+ * The virtual clock behind "millis()" and "micros()" stands still while a task runs, and jumps straight to the next wake-up when every task is blocked, so a day of the station is simulated in seconds.
+ * The order in which the tasks run only depends on their priorities and the virtual clock, so a simulation with the same options always gives the same result.
+ *
+ * The Arduino, ESP32 and FreeRTOS headers next to this one replace the real ones with the same interfaces, on top of the simulated sensors (see "DM_SimulatedSensors.h"), the simulated network (see "DM_SimulatedNetwork.h") and this clock.
+ * Because of that, none of the classes of the station needs to know it runs in the simulator.
+ *
+ * A deep sleep lets the virtual time pass and starts "setup()" again, like the wake of an ESP32: every other task is gone, "millis()" starts over, and only the clock and the state the station keeps itself survive.
+ * The memory of the station is not cleared (the simulator can't tell it apart from its own, and there is no RTC memory apart from the normal one), so the state of a wake has to be set in "begin()" or "resume()" instead of being left to its initial value.
+ * What isn't (like the time per state of the Wi-Fi connection) still shows the previous wakes.
+ *
+ * A run can be recorded into a trace and replayed exactly (see "DM_SimulatedTrace.h"), and can write its cycle times, latencies, memory and uplink throughput as JSON ("--benchmark", collected per scenario by "tools/benchmark.py").
+ */
+class DM_Simulator
+{
+public: // The public functions and constants
+    static constexpr uint64_t forever = UINT64_MAX;            // A timeout that never passes
+    static constexpr uint32_t defaultDurationHours = 24;       // The virtual time that is simulated unless "--duration" says otherwise
+    static constexpr uint32_t loopTaskPriority = 1;            // The priority of the task that runs "setup()" and "loop()" (the same as on the ESP32)
+    static constexpr uint32_t serialOutputMaxLineLength = 256; // The longest line that is shown from the serial monitor (longer lines are cut off)
+
+    static int run(int argc, char **argv);
+    static uint64_t getMicroseconds();
+    static uint64_t getMicrosecondsSinceBoot();
+    static uint32_t getAmountOfWakes();
+    static uint64_t ticksToMicroseconds(uint32_t ticks);
+    static void busyWait(uint64_t durationUs);
+    static void sleep(uint64_t durationUs);
+    static bool waitUntil(const std::function<bool()> &condition, uint64_t timeoutUs);
+    static DM_SimulatedTask *createTask(void (*function)(void *), const char *name, uint32_t priority, void *parameters);
+    static DM_SimulatedTask *getCurrentTask();
+    static void deleteTask(DM_SimulatedTask *task);
+    static void notifyTask(DM_SimulatedTask *task);
+    static uint32_t takeNotification(bool clear, uint64_t timeoutUs);
+    [[noreturn]] static void stop(const char *reason);
+    [[noreturn]] static void deepSleep(uint64_t durationUs);
+    static void showSerialOutput(const uint8_t *data, size_t length);
+    static size_t formatTime(uint64_t timeUs, char *buffer, size_t bufferSize);
+
+private: // The private functions and members
+    static DM_SimulatedTask *_pickNextTask();
+    static void _switchFrom(DM_SimulatedTask *task);
+    static void _taskThread(DM_SimulatedTask *task);
+    static void _loopTask(void *parameters);
+    static bool _parseOptions(int argc, char **argv);
+    static void _printUsage(const char *program);
+    static void _printSummary(double realSeconds);
+    static bool _writeBenchmark(double realSeconds);
+};
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,282 @@
+/** +----------------------------------------------+
+ *  |     ESPAsyncWebServer - Simulated server     |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "ESPAsyncWebServer.h" // Include the header file where the declarations for this library are stored
+#include <string.h>            // Used to split the query
+
+// INITIALIZE THE CLASS MEMBERS (the "static" members of the class)
+AsyncWebServer *AsyncWebServer::_startedServer = nullptr; // The server that listens (NULL as long as none is started)
+
+/**
+ * Create a parameter.
+ *
+ * @param name The name of the parameter.
+ * @param value The value of the parameter.
+ */
+AsyncWebParameter::AsyncWebParameter(const char *name, const char *value) : _name(name), _value(value)
+{
+}
+
+/**
+ * Get the name of the parameter.
+ *
+ * @return The name.
+ */
+const String &AsyncWebParameter::name() const
+{
+    return this->_name;
+}
+
+/**
+ * Get the value of the parameter.
+ *
+ * @return The value.
+ */
+const String &AsyncWebParameter::value() const
+{
+    return this->_value;
+}
+
+/**
+ * Create an answer with a fixed content.
+ *
+ * @param code The status code.
+ * @param contentType The content type.
+ * @param content The content.
+ */
+AsyncWebServerResponse::AsyncWebServerResponse(int code, const char *contentType, const char *content) : _code(code), _contentType(contentType), _content(content)
+{
+}
+
+/**
+ * Create an answer with a content that is filled chunk by chunk.
+ *
+ * @param contentType The content type.
+ * @param filler The filler.
+ */
+AsyncWebServerResponse::AsyncWebServerResponse(const char *contentType, AwsResponseFiller filler) : _code(200), _contentType(contentType), _filler(filler)
+{
+}
+
+/**
+ * Get the status code.
+ *
+ * @return The status code.
+ */
+int AsyncWebServerResponse::getCode() const
+{
+    return this->_code;
+}
+
+/**
+ * Get the content type.
+ *
+ * @return The content type.
+ */
+const char *AsyncWebServerResponse::getContentType() const
+{
+    return this->_contentType.c_str();
+}
+
+/**
+ * Fill the next part of the content.
+ *
+ * @param buffer The buffer for the part.
+ * @param maxLength The size of the buffer.
+ * @param index The amount of bytes that were filled before.
+ *
+ * @return The amount of bytes filled (0 at the end, "RESPONSE_TRY_AGAIN" if the filler has nothing yet).
+ */
+size_t AsyncWebServerResponse::fill(uint8_t *buffer, size_t maxLength, size_t index)
+{
+    if (this->_filler)
+        return this->_filler(buffer, maxLength, index);
+    size_t length = index < this->_content.size() ? std::min(maxLength, this->_content.size() - index) : 0;
+    memcpy(buffer, this->_content.data() + index, length);
+    return length;
+}
+
+/**
+ * Create a request.
+ *
+ * @param URL The path with the query (e.g. "/history?from=1714521600&to=1714608000").
+ */
+AsyncWebServerRequest::AsyncWebServerRequest(const char *URL) : _response(nullptr)
+{
+    // Split the path from the query
+    const char *query = strchr(URL, '?');
+    this->_path.assign(URL, query != nullptr ? query - URL : strlen(URL));
+
+    // Read the parameters of the query ("name=value", separated by "&")
+    while (query != nullptr)
+    {
+        const char *start = query + 1;
+        query = strchr(start, '&');
+        std::string parameter(start, query != nullptr ? query - start : strlen(start));
+        size_t equals = parameter.find('=');
+        std::string name = parameter.substr(0, equals);
+        std::string value = equals != std::string::npos ? parameter.substr(equals + 1) : "";
+        if (!name.empty())
+            this->_params.emplace(name, AsyncWebParameter(name.c_str(), value.c_str()));
+    }
+}
+
+/**
+ * Delete the request and its answer.
+ */
+AsyncWebServerRequest::~AsyncWebServerRequest()
+{
+    delete this->_response;
+}
+
+/**
+ * Get the path of the request.
+ *
+ * @return The path, without the query.
+ */
+const char *AsyncWebServerRequest::url() const
+{
+    return this->_path.c_str();
+}
+
+/**
+ * Check if the query has a parameter.
+ *
+ * @param name The name of the parameter.
+ *
+ * @return True if the query has it.
+ */
+bool AsyncWebServerRequest::hasParam(const char *name)
+{
+    return this->_params.count(name) > 0;
+}
+
+/**
+ * Get a parameter of the query.
+ *
+ * @param name The name of the parameter.
+ *
+ * @return The parameter (NULL if the query doesn't have it).
+ */
+AsyncWebParameter *AsyncWebServerRequest::getParam(const char *name)
+{
+    auto parameter = this->_params.find(name);
+    return parameter != this->_params.end() ? &parameter->second : nullptr;
+}
+
+/**
+ * Create an answer that is filled chunk by chunk.
+ *
+ * @param contentType The content type.
+ * @param filler The filler.
+ *
+ * @return The answer (it belongs to the request once it is sent).
+ */
+AsyncWebServerResponse *AsyncWebServerRequest::beginChunkedResponse(const char *contentType, AwsResponseFiller filler)
+{
+    return new AsyncWebServerResponse(contentType, filler);
+}
+
+/**
+ * Send an answer (the request takes it over).
+ *
+ * @param response The answer.
+ */
+void AsyncWebServerRequest::send(AsyncWebServerResponse *response)
+{
+    delete this->_response;
+    this->_response = response;
+}
+
+/**
+ * Send an answer with a fixed content.
+ *
+ * @param code The status code.
+ * @param contentType The content type.
+ * @param content The content.
+ */
+void AsyncWebServerRequest::send(int code, const char *contentType, const char *content)
+{
+    this->send(new AsyncWebServerResponse(code, contentType, content));
+}
+
+/**
+ * Get the answer that was sent.
+ *
+ * @return The answer (NULL if none was sent).
+ */
+AsyncWebServerResponse *AsyncWebServerRequest::getResponse()
+{
+    return this->_response;
+}
+
+/**
+ * Create the server.
+ *
+ * @param port The port it listens on.
+ */
+AsyncWebServer::AsyncWebServer(uint16_t port) : _port(port)
+{
+}
+
+/**
+ * Add a handler for a path.
+ *
+ * @param URI The path.
+ * @param method The methods the handler answers (only GET requests are made by the simulator).
+ * @param onRequest The handler.
+ */
+void AsyncWebServer::on(const char *URI, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest)
+{
+    this->_handlers.push_back({URI, onRequest});
+}
+
+/**
+ * Set the handler of every path without a handler of its own.
+ *
+ * @param onRequest The handler.
+ */
+void AsyncWebServer::onNotFound(ArRequestHandlerFunction onRequest)
+{
+    this->_onNotFound = onRequest;
+}
+
+/**
+ * Start listening.
+ */
+void AsyncWebServer::begin()
+{
+    AsyncWebServer::_startedServer = this;
+}
+
+/**
+ * Let the started server handle a request.
+ *
+ * @param request The request.
+ *
+ * @return True if a server was started (the request has an answer then, unless the handler didn't send one).
+ */
+bool AsyncWebServer::handleRequest(AsyncWebServerRequest *request)
+{
+    AsyncWebServer *server = AsyncWebServer::_startedServer;
+    if (server == nullptr)
+        return false;
+    for (const _Handler &handler : server->_handlers)
+    {
+        if (handler.URI == request->url())
+        {
+            handler.onRequest(request);
+            return true;
+        }
+    }
+    if (server->_onNotFound)
+        server->_onNotFound(request);
+    else
+        request->send(404);
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,114 @@
+/** +----------------------------------------------+
+ *  |     ESPAsyncWebServer - Simulated server     |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef ESPAsyncWebServer_h
+#define ESPAsyncWebServer_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h>   // Used to be able to use the "size_t" type
+#include <stdint.h>   // Used to be able to use the fixed width integer types
+#include <functional> // Used to keep the handlers and the fillers
+#include <map>        // Used to keep the parameters of a request
+#include <string>     // Used to keep the paths and the contents
+#include <vector>     // Used to keep the handlers
+#include "Arduino.h"  // Used to be able to use "String"
+
+// DECLARE THE TYPES OF THE SERVER (the same names and values as in the real library)
+#define RESPONSE_TRY_AGAIN 0xFFFFFFFF // What a filler returns when it has nothing to send yet
+typedef enum
+{
+    HTTP_GET = 0b00000001,
+    HTTP_POST = 0b00000010,
+    HTTP_ANY = 0b01111111
+} WebRequestMethod;
+typedef uint8_t WebRequestMethodComposite;
+class AsyncWebServerRequest;
+typedef std::function<void(AsyncWebServerRequest *request)> ArRequestHandlerFunction;
+typedef std::function<size_t(uint8_t *buffer, size_t maxLength, size_t index)> AwsResponseFiller;
+
+/**
+ * A parameter of the query of a request.
+ */
+class AsyncWebParameter
+{
+public: // The public functions
+    AsyncWebParameter(const char *name, const char *value);
+    const String &name() const;
+    const String &value() const;
+
+private: // The private members
+    String _name;  // The name of the parameter
+    String _value; // The value of the parameter
+};
+
+/**
+ * The answer to a request: a fixed content, or a content that is filled chunk by chunk.
+ */
+class AsyncWebServerResponse
+{
+public: // The public functions
+    AsyncWebServerResponse(int code, const char *contentType, const char *content);
+    AsyncWebServerResponse(const char *contentType, AwsResponseFiller filler);
+    int getCode() const;
+    const char *getContentType() const;
+    size_t fill(uint8_t *buffer, size_t maxLength, size_t index);
+
+private: // The private members
+    int _code;                 // The status code
+    std::string _contentType;  // The content type
+    std::string _content;      // The fixed content
+    AwsResponseFiller _filler; // The filler of a chunked content (empty for a fixed content)
+};
+
+/**
+ * A request to the web server, with the part of the interface of the real library the station uses.
+ */
+class AsyncWebServerRequest
+{
+public: // The public functions
+    AsyncWebServerRequest(const char *URL);
+    ~AsyncWebServerRequest();
+    const char *url() const;
+    bool hasParam(const char *name);
+    AsyncWebParameter *getParam(const char *name);
+    AsyncWebServerResponse *beginChunkedResponse(const char *contentType, AwsResponseFiller filler);
+    void send(AsyncWebServerResponse *response);
+    void send(int code, const char *contentType = "", const char *content = "");
+    AsyncWebServerResponse *getResponse();
+
+private: // The private members
+    std::string _path;                                // The path of the request, without the query
+    std::map<std::string, AsyncWebParameter> _params; // The parameters of the query
+    AsyncWebServerResponse *_response;                // The answer (NULL as long as none was sent)
+};
+
+/**
+ * The web server, with the part of the interface of the real library the station uses (the simulator requests the pages itself, see "DM_SimulatedNetwork::printPage()").
+ */
+class AsyncWebServer
+{
+public: // The public functions
+    AsyncWebServer(uint16_t port);
+    void on(const char *URI, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest);
+    void onNotFound(ArRequestHandlerFunction onRequest);
+    void begin();
+    static bool handleRequest(AsyncWebServerRequest *request);
+
+private: // The private members
+    struct _Handler
+    {
+        std::string URI;                    // The path the handler answers
+        ArRequestHandlerFunction onRequest; // The handler
+    };
+    uint16_t _port;                       // The port of the server
+    std::vector<_Handler> _handlers;      // The handlers of the paths
+    ArRequestHandlerFunction _onNotFound; // The handler of every other path
+    static AsyncWebServer *_startedServer;
+};
+
+#endif // End the header guard
\ No newline at end of file
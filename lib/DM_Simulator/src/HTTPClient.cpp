@@ -0,0 +1,200 @@
+/** +----------------------------------------------+
+ *  |      HTTPClient - Simulated HTTP client      |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "HTTPClient.h" // Include the header file where the declarations for this library are stored
+#include <stdlib.h>     // Used to read the port in the URL
+#include <string.h>     // Used to find the parts of the URL
+#include <strings.h>    // Used to compare the names of the headers without looking at the case
+
+/**
+ * Prepare a request to a URL over a connection of the client itself.
+ *
+ * @param URL The URL.
+ *
+ * @return True if the URL could be read.
+ */
+bool HTTPClient::begin(const char *URL)
+{
+    bool secure;
+    if (!this->_parseURL(URL, secure))
+        return false;
+    this->_ownClient.reset(secure ? new WiFiClientSecure() : new WiFiClient());
+    this->_client = this->_ownClient.get();
+    return true;
+}
+
+/**
+ * Prepare a request to a URL over a given connection (it stays open between requests when reuse is on).
+ *
+ * @param client The connection.
+ * @param URL The URL.
+ *
+ * @return True if the URL could be read.
+ */
+bool HTTPClient::begin(WiFiClient &client, const char *URL)
+{
+    bool secure;
+    if (!this->_parseURL(URL, secure))
+        return false;
+    this->_ownClient.reset();
+    this->_client = &client;
+    return true;
+}
+
+/**
+ * Choose if the connection stays open after a request.
+ *
+ * @param reuse True to keep it open.
+ */
+void HTTPClient::setReuse(bool reuse)
+{
+    this->_reuse = reuse;
+}
+
+/**
+ * Set the longest time to wait for the answer.
+ *
+ * @param timeoutMs The time in ms.
+ */
+void HTTPClient::setTimeout(uint16_t timeoutMs)
+{
+    this->_timeoutMs = timeoutMs;
+}
+
+/**
+ * Set the longest time to wait for the connection.
+ *
+ * @param connectTimeoutMs The time in ms.
+ */
+void HTTPClient::setConnectTimeout(int32_t connectTimeoutMs)
+{
+    this->_connectTimeoutMs = connectTimeoutMs;
+}
+
+/**
+ * Choose the response headers that are kept (all others are ignored, like in the real client).
+ *
+ * @param headerKeys The names of the headers.
+ * @param amountOfHeaderKeys The amount of names.
+ */
+void HTTPClient::collectHeaders(const char *headerKeys[], const size_t amountOfHeaderKeys)
+{
+    this->_headerKeys.assign(headerKeys, headerKeys + amountOfHeaderKeys);
+}
+
+/**
+ * Add a header to the request (only the "Authorization" header matters to the simulated servers).
+ *
+ * @param name The name of the header.
+ * @param value The value of the header.
+ */
+void HTTPClient::addHeader(const char *name, const char *value)
+{
+    if (strcasecmp(name, "Authorization") == 0)
+        this->_authorization = value;
+}
+
+/**
+ * Send a POST request and wait for the answer (the connection is made first if there is none to the server).
+ *
+ * @param payload The body.
+ * @param size The length of the body.
+ *
+ * @return The status code of the answer, or a negative error code.
+ */
+int HTTPClient::POST(uint8_t *payload, size_t size)
+{
+    // Make the connection if there is no open one to the server
+    this->_responseHeaders.clear();
+    if (this->_client == nullptr)
+        return HTTPC_ERROR_CONNECTION_REFUSED;
+    if (!this->_client->connected() || this->_host != this->_client->getHost())
+    {
+        if (!this->_client->connect(this->_host.c_str(), this->_port, this->_connectTimeoutMs))
+            return HTTPC_ERROR_CONNECTION_REFUSED;
+    }
+
+    // Send the request and keep the headers that are collected
+    DM_HTTPHeaders headers;
+    int statusCode = DM_SimulatedNetwork::answerHTTPRequest(this->_host.c_str(), this->_authorization.c_str(), payload, size, this->_timeoutMs, headers);
+    if (statusCode < 0)
+    {
+        this->_client->stop();
+        return statusCode;
+    }
+    for (const auto &header : headers)
+        for (const std::string &key : this->_headerKeys)
+            if (strcasecmp(header.first.c_str(), key.c_str()) == 0)
+                this->_responseHeaders.push_back(header);
+    return statusCode;
+}
+
+/**
+ * Get a collected header of the last answer.
+ *
+ * @param name The name of the header.
+ *
+ * @return The value (empty if the answer didn't have it).
+ */
+String HTTPClient::header(const char *name)
+{
+    for (const auto &header : this->_responseHeaders)
+        if (strcasecmp(header.first.c_str(), name) == 0)
+            return String(header.second);
+    return String();
+}
+
+/**
+ * Check if the last answer had a collected header.
+ *
+ * @param name The name of the header.
+ *
+ * @return True if the answer had the header.
+ */
+bool HTTPClient::hasHeader(const char *name)
+{
+    return this->header(name).length() > 0;
+}
+
+/**
+ * Finish the request (the connection is closed unless reuse is on).
+ */
+void HTTPClient::end()
+{
+    if (this->_client != nullptr && !this->_reuse)
+        this->_client->stop();
+    this->_authorization.clear();
+}
+
+/**
+ * Read the server, the port and the scheme of a URL.
+ *
+ * @param URL The URL.
+ * @param secure Set to true if the URL needs TLS.
+ *
+ * @return True if the URL has a server.
+ */
+bool HTTPClient::_parseURL(const char *URL, bool &secure)
+{
+    // The scheme (TLS unless it is "http")
+    const char *scheme = strstr(URL, "://");
+    const char *host = scheme != nullptr ? scheme + 3 : URL;
+    secure = scheme == nullptr || strncmp(URL, "http://", 7) != 0;
+
+    // The server and the port, up to the path
+    size_t hostLength = strcspn(host, "/?");
+    this->_host.assign(host, hostLength);
+    this->_port = secure ? 443 : 80;
+    size_t colon = this->_host.find(':');
+    if (colon != std::string::npos)
+    {
+        this->_port = atoi(this->_host.c_str() + colon + 1);
+        this->_host.resize(colon);
+    }
+    return !this->_host.empty();
+}
\ No newline at end of file
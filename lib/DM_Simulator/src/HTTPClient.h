@@ -0,0 +1,62 @@
+/** +----------------------------------------------+
+ *  |      HTTPClient - Simulated HTTP client      |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef HTTPClient_h
+#define HTTPClient_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h>              // Used to be able to use the "size_t" type
+#include <stdint.h>              // Used to be able to use the fixed width integer types
+#include <memory>                // Used to own the connection when none is given
+#include <string>                // Used to keep the server and the headers
+#include <vector>                // Used to keep the headers that are collected
+#include "Arduino.h"             // Used to be able to use "String"
+#include "WiFiClientSecure.h"    // Used to make the connection to the server
+#include "DM_SimulatedNetwork.h" // Used to be able to use "DM_HTTPHeaders"
+
+// DECLARE THE ERROR CODES OF THE HTTP CLIENT (the same values as in the ESP32 core)
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+#define HTTPCLIENT_DEFAULT_TCP_TIMEOUT (5000)
+
+/**
+ * An HTTP client over the simulated network, with the part of the interface of the ESP32 "HTTPClient" the station uses.
+ *
+ * Like the real client it makes its own connection for a URL (TLS for "https"), or uses the one it is given and keeps it open between requests when reuse is on.
+ * A URL without a scheme (like the placeholders in "main.cpp") is sent over TLS to the host it starts with, so the simulated servers can answer it (see "DM_SimulatedNetwork").
+ */
+class HTTPClient
+{
+public: // The public functions
+    bool begin(const char *URL);
+    bool begin(WiFiClient &client, const char *URL);
+    void setReuse(bool reuse);
+    void setTimeout(uint16_t timeoutMs);
+    void setConnectTimeout(int32_t connectTimeoutMs);
+    void collectHeaders(const char *headerKeys[], const size_t amountOfHeaderKeys);
+    void addHeader(const char *name, const char *value);
+    int POST(uint8_t *payload, size_t size);
+    String header(const char *name);
+    bool hasHeader(const char *name);
+    void end();
+
+private: // The private functions and members
+    WiFiClient *_client = nullptr;                              // The connection that is used
+    std::unique_ptr<WiFiClient> _ownClient;                     // The connection the client made itself (when none was given)
+    std::string _host;                                          // The server of the URL
+    uint16_t _port = 0;                                         // The port of the server
+    bool _reuse = true;                                         // True to keep the connection open after a request
+    uint16_t _timeoutMs = HTTPCLIENT_DEFAULT_TCP_TIMEOUT;       // The longest time to wait for the answer
+    int32_t _connectTimeoutMs = HTTPCLIENT_DEFAULT_TCP_TIMEOUT; // The longest time to wait for the connection
+    std::string _authorization;                                 // The "Authorization" header of the request
+    std::vector<std::string> _headerKeys;                       // The response headers that are collected
+    DM_HTTPHeaders _responseHeaders;                            // The collected headers of the last answer
+    bool _parseURL(const char *URL, bool &secure);
+};
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,272 @@
+/** +----------------------------------------------+
+ *  |       LittleFS - Simulated flash files       |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "LittleFS.h"     // Include the header file where the declarations for this library are stored
+#include "DM_Simulator.h" // Used to let the time of the flash pass
+#include <string.h>       // Used to copy the contents
+#include <algorithm>      // Used to limit the reads and writes ("std::min()")
+
+// OTHER VARIABLES
+LittleFSFS LittleFS; // The file system of the station
+
+/**
+ * Check if the file is open.
+ *
+ * @return True if the file is open.
+ */
+File::operator bool() const
+{
+    return this->_open;
+}
+
+/**
+ * Get the name of the file.
+ *
+ * @return The name, without the directory.
+ */
+const char *File::name() const
+{
+    return this->_name.c_str();
+}
+
+/**
+ * Get the size of the file.
+ *
+ * @return The size in bytes (0 for a directory).
+ */
+size_t File::size() const
+{
+    auto file = LittleFS._files.find(this->_path);
+    return this->_open && file != LittleFS._files.end() ? file->second.size() : 0;
+}
+
+/**
+ * Check if this is a directory.
+ *
+ * @return True for a directory.
+ */
+bool File::isDirectory() const
+{
+    return this->_directory;
+}
+
+/**
+ * Move to a position in the file.
+ *
+ * @param position The position in bytes from the start.
+ *
+ * @return True if the position is inside the file.
+ */
+bool File::seek(uint32_t position)
+{
+    if (!this->_open || this->_directory || position > this->size())
+        return false;
+    this->_position = position;
+    return true;
+}
+
+/**
+ * Read bytes from the position on.
+ *
+ * @param buffer The buffer for the bytes.
+ * @param size The amount of bytes to read.
+ *
+ * @return The amount of bytes that were read.
+ */
+size_t File::read(uint8_t *buffer, size_t size)
+{
+    auto file = LittleFS._files.find(this->_path);
+    if (!this->_open || file == LittleFS._files.end() || this->_position >= file->second.size())
+        return 0;
+    size_t length = std::min(size, file->second.size() - this->_position);
+    memcpy(buffer, file->second.data() + this->_position, length);
+    this->_position += length;
+    DM_Simulator::busyWait((uint64_t)length * LittleFSFS::readTimeNsPerByte / 1000);
+    return length;
+}
+
+/**
+ * Write bytes from the position on (as much as fits on the partition).
+ *
+ * @param buffer The bytes.
+ * @param size The amount of bytes to write.
+ *
+ * @return The amount of bytes that were written.
+ */
+size_t File::write(const uint8_t *buffer, size_t size)
+{
+    auto file = LittleFS._files.find(this->_path);
+    if (!this->_open || !this->_writable || file == LittleFS._files.end())
+        return 0;
+    std::vector<uint8_t> &content = file->second;
+    size_t growth = this->_position + size > content.size() ? this->_position + size - content.size() : 0;
+    size_t room = LittleFSFS::capacity - LittleFS._usedBytes;
+    size_t length = growth > room ? size - (growth - room) : size;
+    if (this->_position + length > content.size())
+    {
+        LittleFS._usedBytes += this->_position + length - content.size();
+        content.resize(this->_position + length);
+    }
+    memcpy(content.data() + this->_position, buffer, length);
+    this->_position += length;
+    DM_Simulator::busyWait((uint64_t)length * LittleFSFS::writeTimeNsPerByte / 1000);
+    return length;
+}
+
+/**
+ * Open the next entry of a directory.
+ *
+ * @return The entry (a closed file when there are no more entries).
+ */
+File File::openNextFile()
+{
+    // Only a directory has entries
+    if (!this->_open || !this->_directory)
+        return File();
+
+    // Find the entry with the next number (the subdirectories first, then the files, both in alphabetical order)
+    std::string prefix = this->_path == "/" ? "/" : this->_path + "/";
+    size_t entry = 0;
+    for (const std::string &directory : LittleFS._directories)
+        if (directory.size() > prefix.size() && directory.compare(0, prefix.size(), prefix) == 0 && directory.find('/', prefix.size()) == std::string::npos && entry++ == this->_nextEntry)
+        {
+            this->_nextEntry += 1;
+            return LittleFS.open(directory.c_str());
+        }
+    for (const auto &file : LittleFS._files)
+        if (file.first.compare(0, prefix.size(), prefix) == 0 && file.first.find('/', prefix.size()) == std::string::npos && entry++ == this->_nextEntry)
+        {
+            this->_nextEntry += 1;
+            return LittleFS.open(file.first.c_str());
+        }
+    return File();
+}
+
+/**
+ * Close the file.
+ */
+void File::close()
+{
+    this->_open = false;
+}
+
+/**
+ * Mount the file system.
+ *
+ * @param formatOnFail Unused (the simulated partition always mounts).
+ *
+ * @return True.
+ */
+bool LittleFSFS::begin(bool formatOnFail)
+{
+    return true;
+}
+
+/**
+ * Check if a file or directory exists.
+ *
+ * @param path The path.
+ *
+ * @return True if it exists.
+ */
+bool LittleFSFS::exists(const char *path)
+{
+    return this->_files.count(path) > 0 || this->_directories.count(path) > 0;
+}
+
+/**
+ * Create a directory.
+ *
+ * @param path The path.
+ *
+ * @return True if the directory exists now.
+ */
+bool LittleFSFS::mkdir(const char *path)
+{
+    if (this->_files.count(path) > 0)
+        return false;
+    this->_directories.insert(path);
+    return true;
+}
+
+/**
+ * Open a file or directory.
+ *
+ * @param path The path.
+ * @param mode "r" to read, "w" to write a new file, "a" to add to the end of a file ("w" and "a" create the file).
+ *
+ * @return The file (closed if it couldn't be opened).
+ */
+File LittleFSFS::open(const char *path, const char *mode)
+{
+    // Look the path up
+    File file;
+    DM_Simulator::busyWait(openTimeUs);
+    bool directory = this->_directories.count(path) > 0;
+    bool write = mode[0] == 'w' || mode[0] == 'a';
+    if (directory ? write : (!write && this->_files.count(path) == 0))
+        return file;
+
+    // Create or empty the file if needed
+    if (write)
+    {
+        std::vector<uint8_t> &content = this->_files[path];
+        if (mode[0] == 'w')
+        {
+            this->_usedBytes -= content.size();
+            content.clear();
+        }
+        file._position = content.size();
+    }
+
+    // Open it
+    const char *slash = strrchr(path, '/');
+    file._open = true;
+    file._directory = directory;
+    file._writable = write;
+    file._path = path;
+    file._name = slash != nullptr ? slash + 1 : path;
+    return file;
+}
+
+/**
+ * Delete a file.
+ *
+ * @param path The path.
+ *
+ * @return True if the file was deleted.
+ */
+bool LittleFSFS::remove(const char *path)
+{
+    auto file = this->_files.find(path);
+    if (file == this->_files.end())
+        return false;
+    this->_usedBytes -= file->second.size();
+    this->_files.erase(file);
+    return true;
+}
+
+/**
+ * Get the size of the partition.
+ *
+ * @return The size in bytes.
+ */
+size_t LittleFSFS::totalBytes()
+{
+    return capacity;
+}
+
+/**
+ * Get the space the files use.
+ *
+ * @return The size in bytes.
+ */
+size_t LittleFSFS::usedBytes()
+{
+    return this->_usedBytes;
+}
\ No newline at end of file
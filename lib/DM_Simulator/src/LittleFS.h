@@ -0,0 +1,76 @@
+/** +----------------------------------------------+
+ *  |       LittleFS - Simulated flash files       |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef LittleFS_h
+#define LittleFS_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h> // Used to be able to use the "size_t" type
+#include <stdint.h> // Used to be able to use the fixed width integer types
+#include <map>      // Used to keep the files by their path
+#include <set>      // Used to keep the directories
+#include <string>   // Used to keep the paths
+#include <vector>   // Used to keep the contents of the files
+
+/**
+ * An open file or directory, with the part of the interface of the ESP32 "File" the station uses.
+ */
+class File
+{
+public: // The public functions
+    operator bool() const;
+    const char *name() const;
+    size_t size() const;
+    bool isDirectory() const;
+    bool seek(uint32_t position);
+    size_t read(uint8_t *buffer, size_t size);
+    size_t write(const uint8_t *buffer, size_t size);
+    File openNextFile();
+    void close();
+
+private: // The private members
+    friend class LittleFSFS;
+    bool _open = false;      // True if the file is open
+    bool _directory = false; // True if this is a directory
+    bool _writable = false;  // True if the file was opened to write
+    std::string _path;       // The full path
+    std::string _name;       // The name, without the directory (like the ESP32 core 2 and newer)
+    size_t _position = 0;    // The position of the next read or write
+    size_t _nextEntry = 0;   // The entry of a directory that "openNextFile()" opens next
+};
+
+/**
+ * The file system on the flash, with the part of the interface of the ESP32 "LittleFS" the station uses.
+ *
+ * The files are kept in memory (they start empty with every simulation), on a partition of the size of the default one of the ESP32, and reading and writing take about as long as on the flash.
+ */
+class LittleFSFS
+{
+public: // The public functions and constants
+    static constexpr size_t capacity = 1536 * 1024;       // The size of the partition
+    static constexpr uint32_t openTimeUs = 500;           // The time to find a file in the metadata
+    static constexpr uint32_t readTimeNsPerByte = 1000;   // The time to read one byte
+    static constexpr uint32_t writeTimeNsPerByte = 10000; // The time to write one byte (the flash has to be erased and programmed)
+
+    bool begin(bool formatOnFail = false);
+    bool exists(const char *path);
+    bool mkdir(const char *path);
+    File open(const char *path, const char *mode = "r");
+    bool remove(const char *path);
+    size_t totalBytes();
+    size_t usedBytes();
+
+private: // The private members
+    friend class File;
+    std::map<std::string, std::vector<uint8_t>> _files; // The contents of the files, by their path
+    std::set<std::string> _directories = {"/"};         // The directories
+    size_t _usedBytes = 0;                              // The total size of the files
+};
+extern LittleFSFS LittleFS;
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,104 @@
+/** +----------------------------------------------+
+ *  |         Preferences - Simulated NVS          |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "Preferences.h" // Include the header file where the declarations for this library are stored
+#include <string.h>      // Used to copy the values
+
+// INITIALIZE THE CLASS MEMBERS (the "static" members of the class)
+std::map<std::string, std::map<std::string, std::vector<uint8_t>>> Preferences::_storage; // The values of every namespace
+
+/**
+ * Open a namespace (a namespace that was never written can't be opened to read only, like on the ESP32).
+ *
+ * @param name The name of the namespace.
+ * @param readOnly True to only read.
+ *
+ * @return True if the namespace is open.
+ */
+bool Preferences::begin(const char *name, bool readOnly)
+{
+    if (readOnly && Preferences::_storage.count(name) == 0)
+        return false;
+    Preferences::_storage[name];
+    this->_namespace = name;
+    this->_readOnly = readOnly;
+    return true;
+}
+
+/**
+ * Close the namespace.
+ */
+void Preferences::end()
+{
+    this->_namespace.clear();
+}
+
+/**
+ * Get the length of a value.
+ *
+ * @param key The key of the value.
+ *
+ * @return The length in bytes (0 if there is no such value).
+ */
+size_t Preferences::getBytesLength(const char *key)
+{
+    if (this->_namespace.empty())
+        return 0;
+    auto &values = Preferences::_storage[this->_namespace];
+    auto value = values.find(key);
+    return value != values.end() ? value->second.size() : 0;
+}
+
+/**
+ * Read a value.
+ *
+ * @param key The key of the value.
+ * @param buffer The buffer for the value.
+ * @param maxLength The size of the buffer.
+ *
+ * @return The length of the value (0 if there is no such value or it doesn't fit).
+ */
+size_t Preferences::getBytes(const char *key, void *buffer, size_t maxLength)
+{
+    size_t length = this->getBytesLength(key);
+    if (length == 0 || length > maxLength)
+        return 0;
+    memcpy(buffer, Preferences::_storage[this->_namespace][key].data(), length);
+    return length;
+}
+
+/**
+ * Write a value.
+ *
+ * @param key The key of the value.
+ * @param value The value.
+ * @param length The length of the value.
+ *
+ * @return The length that was written (0 if the namespace isn't open to write).
+ */
+size_t Preferences::putBytes(const char *key, const void *value, size_t length)
+{
+    if (this->_namespace.empty() || this->_readOnly || value == nullptr)
+        return 0;
+    Preferences::_storage[this->_namespace][key].assign((const uint8_t *)value, (const uint8_t *)value + length);
+    return length;
+}
+
+/**
+ * Remove a value.
+ *
+ * @param key The key of the value.
+ *
+ * @return True if the value was removed (false if the namespace isn't open to write or there is no such value).
+ */
+bool Preferences::remove(const char *key)
+{
+    if (this->_namespace.empty() || this->_readOnly)
+        return false;
+    return Preferences::_storage[this->_namespace].erase(key) > 0;
+}
\ No newline at end of file
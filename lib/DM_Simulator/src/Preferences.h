@@ -0,0 +1,38 @@
+/** +----------------------------------------------+
+ *  |         Preferences - Simulated NVS          |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef Preferences_h
+#define Preferences_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h> // Used to be able to use the "size_t" type
+#include <stdint.h> // Used to be able to use the fixed width integer types
+#include <map>      // Used to keep the namespaces and their keys
+#include <string>   // Used to keep the names
+#include <vector>   // Used to keep the values
+
+/**
+ * The non-volatile storage, with the part of the interface of the ESP32 "Preferences" the station uses (the values are kept in memory, so they start empty with every simulation).
+ */
+class Preferences
+{
+public: // The public functions
+    bool begin(const char *name, bool readOnly = false);
+    void end();
+    size_t getBytesLength(const char *key);
+    size_t getBytes(const char *key, void *buffer, size_t maxLength);
+    size_t putBytes(const char *key, const void *value, size_t length);
+    bool remove(const char *key);
+
+private: // The private members
+    std::string _namespace; // The open namespace (empty if none is open)
+    bool _readOnly = false; // True if the namespace was opened to read only
+    static std::map<std::string, std::map<std::string, std::vector<uint8_t>>> _storage;
+};
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,168 @@
+/** +----------------------------------------------+
+ *  |     PubSubClient - Simulated MQTT client     |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "PubSubClient.h"        // Include the header file where the declarations for this library are stored
+#include "DM_SimulatedNetwork.h" // Used to let the broker answer
+#include <string.h>              // Used to measure the topic and the payload
+
+/**
+ * Create the client.
+ *
+ * @param client The connection to the broker.
+ */
+PubSubClient::PubSubClient(Client &client) : _client(&client)
+{
+}
+
+/**
+ * Set the broker.
+ *
+ * @param domain The broker.
+ * @param port The port of the broker.
+ *
+ * @return The client.
+ */
+PubSubClient &PubSubClient::setServer(const char *domain, uint16_t port)
+{
+    this->_domain = domain;
+    this->_port = port;
+    return *this;
+}
+
+/**
+ * Set the longest time to wait for the broker.
+ *
+ * @param timeoutSeconds The time in seconds.
+ *
+ * @return The client.
+ */
+PubSubClient &PubSubClient::setSocketTimeout(uint16_t timeoutSeconds)
+{
+    this->_socketTimeoutSeconds = timeoutSeconds;
+    return *this;
+}
+
+/**
+ * Set the size of the buffer for one packet (a message that doesn't fit can't be published).
+ *
+ * @param size The size in bytes.
+ *
+ * @return True.
+ */
+bool PubSubClient::setBufferSize(uint16_t size)
+{
+    if (size == 0)
+        return false;
+    this->_bufferSize = size;
+    return true;
+}
+
+/**
+ * Connect to the broker (this waits for the TCP connection and the answer of the broker).
+ *
+ * @param clientID The client ID.
+ * @param username The username (every username is accepted).
+ * @param password The password (every password is accepted).
+ *
+ * @return True if the client is connected.
+ */
+bool PubSubClient::connect(const char *clientID, const char *username, const char *password)
+{
+    if (this->connected())
+        return true;
+    if (!this->_client->connect(this->_domain.c_str(), this->_port))
+    {
+        this->_state = MQTT_CONNECT_FAILED;
+        return false;
+    }
+    if (!DM_SimulatedNetwork::connectMQTT(this->_domain.c_str(), clientID))
+    {
+        this->_state = MQTT_CONNECTION_TIMEOUT;
+        this->_client->stop();
+        return false;
+    }
+    this->_state = MQTT_CONNECTED;
+    return true;
+}
+
+/**
+ * Disconnect from the broker.
+ */
+void PubSubClient::disconnect()
+{
+    this->_state = MQTT_DISCONNECTED;
+    this->_client->stop();
+}
+
+/**
+ * Check if the client is still connected (a broken connection changes the state to "MQTT_CONNECTION_LOST").
+ *
+ * @return True if the client is connected.
+ */
+bool PubSubClient::connected()
+{
+    if (this->_client->connected())
+        return this->_state == MQTT_CONNECTED;
+    if (this->_state == MQTT_CONNECTED)
+    {
+        this->_state = MQTT_CONNECTION_LOST;
+        this->_client->stop();
+    }
+    return false;
+}
+
+/**
+ * Keep the connection alive (nothing is subscribed, so there is nothing to receive).
+ *
+ * @return True if the client is still connected.
+ */
+bool PubSubClient::loop()
+{
+    return this->connected();
+}
+
+/**
+ * Publish a text message.
+ *
+ * @param topic The topic.
+ * @param payload The message.
+ *
+ * @return True if the message was sent.
+ */
+bool PubSubClient::publish(const char *topic, const char *payload)
+{
+    return this->publish(topic, (const uint8_t *)payload, payload != nullptr ? strlen(payload) : 0);
+}
+
+/**
+ * Publish a message (it has to fit in the buffer with the topic and the header).
+ *
+ * @param topic The topic.
+ * @param payload The message.
+ * @param length The length of the message.
+ *
+ * @return True if the message was sent.
+ */
+bool PubSubClient::publish(const char *topic, const uint8_t *payload, unsigned int length)
+{
+    if (!this->connected())
+        return false;
+    if (this->_bufferSize < MQTT_MAX_HEADER_SIZE + 2 + strnlen(topic, this->_bufferSize) + length)
+        return false;
+    return DM_SimulatedNetwork::publishMQTT(this->_domain.c_str(), topic, payload, length);
+}
+
+/**
+ * Get the state of the client.
+ *
+ * @return The state ("MQTT_CONNECTED" or one of the errors).
+ */
+int PubSubClient::state()
+{
+    return this->_state;
+}
\ No newline at end of file
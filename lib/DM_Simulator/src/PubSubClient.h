@@ -0,0 +1,56 @@
+/** +----------------------------------------------+
+ *  |     PubSubClient - Simulated MQTT client     |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef PubSubClient_h
+#define PubSubClient_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h> // Used to be able to use the "size_t" type
+#include <stdint.h> // Used to be able to use the fixed width integer types
+#include <string>   // Used to remember the broker
+#include "Client.h" // Used to make the connection to the broker
+
+// DECLARE THE STATES OF THE CLIENT (the same values as in the real library)
+#define MQTT_CONNECTION_TIMEOUT -4
+#define MQTT_CONNECTION_LOST -3
+#define MQTT_CONNECT_FAILED -2
+#define MQTT_DISCONNECTED -1
+#define MQTT_CONNECTED 0
+#define MQTT_MAX_PACKET_SIZE 256 // The default size of the buffer for one packet
+#define MQTT_MAX_HEADER_SIZE 5   // The largest fixed header of a packet
+
+/**
+ * The "PubSubClient" library (knolleary/PubSubClient 2.8) with the part of the interface the station uses, on a connection of the simulated network.
+ *
+ * The client loses its connection like the real one: "connected()" notices that the TCP connection broke and changes the state to "MQTT_CONNECTION_LOST".
+ */
+class PubSubClient
+{
+public: // The public functions
+    PubSubClient(Client &client);
+    PubSubClient &setServer(const char *domain, uint16_t port);
+    PubSubClient &setSocketTimeout(uint16_t timeoutSeconds);
+    bool setBufferSize(uint16_t size);
+    bool connect(const char *clientID, const char *username = nullptr, const char *password = nullptr);
+    void disconnect();
+    bool connected();
+    bool loop();
+    bool publish(const char *topic, const char *payload);
+    bool publish(const char *topic, const uint8_t *payload, unsigned int length);
+    int state();
+
+private: // The private members
+    Client *_client;                             // The connection to the broker
+    std::string _domain;                         // The broker
+    uint16_t _port = 1883;                       // The port of the broker
+    uint16_t _socketTimeoutSeconds = 15;         // The longest time to wait for the broker
+    uint16_t _bufferSize = MQTT_MAX_PACKET_SIZE; // The size of the buffer for one packet
+    int _state = MQTT_DISCONNECTED;              // The state of the client
+};
+
+#endif // End the header guard
\ No newline at end of file
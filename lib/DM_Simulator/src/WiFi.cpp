@@ -0,0 +1,246 @@
+/** +----------------------------------------------+
+ *  |         WiFi - Simulated Wi-Fi chip          |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "WiFi.h"                // Include the header file where the declarations for this library are stored
+#include "DM_SimulatedNetwork.h" // Used to connect to the simulated access points
+#include "DM_Simulator.h"        // Used to wait for a scan
+
+// OTHER VARIABLES
+WiFiClass WiFi; // The Wi-Fi chip of the station
+
+/**
+ * Turn the chip on in a mode, or off.
+ *
+ * @param mode The mode ("WIFI_OFF" turns the chip off).
+ *
+ * @return True.
+ */
+bool WiFiClass::mode(wifi_mode_t mode)
+{
+    DM_SimulatedNetwork::setWiFiMode(mode != WIFI_OFF);
+    return true;
+}
+
+/**
+ * Start connecting to an access point (this returns right away).
+ *
+ * @param SSID The name of the network.
+ * @param password The password (every password is accepted).
+ * @param channel The channel of the access point (0 if unknown).
+ * @param BSSID The MAC address of the access point (NULL if unknown).
+ * @param connect False to only store the settings.
+ *
+ * @return The status right after the start.
+ */
+wl_status_t WiFiClass::begin(const char *SSID, const char *password, int32_t channel, const uint8_t *BSSID, bool connect)
+{
+    if (connect)
+    {
+        DM_SimulatedNetwork::setWiFiMode(true);
+        DM_SimulatedNetwork::beginWiFi(SSID, channel, BSSID);
+    }
+    return this->status();
+}
+
+/**
+ * Set static addresses for the next connection ("INADDR_NONE" everywhere goes back to DHCP).
+ *
+ * @return True.
+ */
+bool WiFiClass::config(IPAddress localIP, IPAddress gateway, IPAddress subnet, IPAddress DNS1, IPAddress DNS2)
+{
+    DM_SimulatedNetwork::configWiFi(localIP, gateway, subnet, DNS1);
+    return true;
+}
+
+/**
+ * Disconnect from the access point.
+ *
+ * @param WiFiOff True to turn the chip off too.
+ * @param eraseAP Unused (nothing is stored by the simulated chip).
+ *
+ * @return True.
+ */
+bool WiFiClass::disconnect(bool WiFiOff, bool eraseAP)
+{
+    DM_SimulatedNetwork::disconnectWiFi();
+    if (WiFiOff)
+        DM_SimulatedNetwork::setWiFiMode(false);
+    return true;
+}
+
+/**
+ * Get the status of the connection.
+ *
+ * @return The status.
+ */
+wl_status_t WiFiClass::status()
+{
+    return DM_SimulatedNetwork::getWiFiStatus();
+}
+
+/**
+ * Get the IP address of the station.
+ *
+ * @return The address.
+ */
+IPAddress WiFiClass::localIP()
+{
+    return DM_SimulatedNetwork::getLocalIP();
+}
+
+/**
+ * Get the IP address of the router.
+ *
+ * @return The address.
+ */
+IPAddress WiFiClass::gatewayIP()
+{
+    return DM_SimulatedNetwork::getGatewayIP();
+}
+
+/**
+ * Get the subnet mask.
+ *
+ * @return The mask.
+ */
+IPAddress WiFiClass::subnetMask()
+{
+    return DM_SimulatedNetwork::getSubnetMask();
+}
+
+/**
+ * Get the IP address of the DNS server.
+ *
+ * @param index Unused (there is only one DNS server).
+ *
+ * @return The address.
+ */
+IPAddress WiFiClass::dnsIP(uint8_t index)
+{
+    return DM_SimulatedNetwork::getDNSIP();
+}
+
+/**
+ * Get the MAC address of the access point.
+ *
+ * @return The 6 bytes of the address (NULL without a connection).
+ */
+uint8_t *WiFiClass::BSSID()
+{
+    DM_SimulatedAccessPoint *accessPoint = DM_SimulatedNetwork::getAccessPoint();
+    return accessPoint != nullptr ? accessPoint->BSSID : nullptr;
+}
+
+/**
+ * Get the channel of the access point.
+ *
+ * @return The channel (0 without a connection).
+ */
+int32_t WiFiClass::channel()
+{
+    DM_SimulatedAccessPoint *accessPoint = DM_SimulatedNetwork::getAccessPoint();
+    return accessPoint != nullptr ? accessPoint->channel : 0;
+}
+
+/**
+ * Read the signal strength of the connection.
+ *
+ * @return The signal strength in dBm (0 without a connection).
+ */
+int8_t WiFiClass::RSSI()
+{
+    return DM_SimulatedNetwork::getRSSI();
+}
+
+/**
+ * Scan all channels for access points.
+ *
+ * @param async True to return right away (the result is read with "scanComplete()").
+ *
+ * @return "WIFI_SCAN_RUNNING" for an asynchronous scan, otherwise the amount of access points found ("WIFI_SCAN_FAILED" if the scan couldn't start).
+ */
+int16_t WiFiClass::scanNetworks(bool async)
+{
+    if (!DM_SimulatedNetwork::startScan())
+        return WIFI_SCAN_FAILED;
+    if (async)
+        return WIFI_SCAN_RUNNING;
+    DM_Simulator::sleep((uint64_t)DM_SimulatedNetwork::scanMs * 1000);
+    return this->scanComplete();
+}
+
+/**
+ * Get the result of the scan.
+ *
+ * @return The amount of access points found, "WIFI_SCAN_RUNNING" or "WIFI_SCAN_FAILED".
+ */
+int16_t WiFiClass::scanComplete()
+{
+    return DM_SimulatedNetwork::getScanResult();
+}
+
+/**
+ * Forget the result of the scan.
+ */
+void WiFiClass::scanDelete()
+{
+    DM_SimulatedNetwork::deleteScan();
+}
+
+/**
+ * Get the name of a network the scan found.
+ *
+ * @param index The number of the access point.
+ *
+ * @return The name (empty if there is no such access point).
+ */
+String WiFiClass::SSID(uint8_t index)
+{
+    DM_SimulatedAccessPoint *accessPoint = DM_SimulatedNetwork::getScannedAccessPoint(index);
+    return accessPoint != nullptr ? String(accessPoint->SSID) : String();
+}
+
+/**
+ * Get the signal strength of an access point the scan found.
+ *
+ * @param index The number of the access point.
+ *
+ * @return The signal strength in dBm (0 if there is no such access point).
+ */
+int32_t WiFiClass::RSSI(uint8_t index)
+{
+    DM_SimulatedAccessPoint *accessPoint = DM_SimulatedNetwork::getScannedAccessPoint(index);
+    return accessPoint != nullptr ? accessPoint->RSSI : 0;
+}
+
+/**
+ * Get the MAC address of an access point the scan found.
+ *
+ * @param index The number of the access point.
+ *
+ * @return The 6 bytes of the address (NULL if there is no such access point).
+ */
+uint8_t *WiFiClass::BSSID(uint8_t index)
+{
+    DM_SimulatedAccessPoint *accessPoint = DM_SimulatedNetwork::getScannedAccessPoint(index);
+    return accessPoint != nullptr ? accessPoint->BSSID : nullptr;
+}
+
+/**
+ * Get the channel of an access point the scan found.
+ *
+ * @param index The number of the access point.
+ *
+ * @return The channel (0 if there is no such access point).
+ */
+int32_t WiFiClass::channel(uint8_t index)
+{
+    DM_SimulatedAccessPoint *accessPoint = DM_SimulatedNetwork::getScannedAccessPoint(index);
+    return accessPoint != nullptr ? accessPoint->channel : 0;
+}
\ No newline at end of file
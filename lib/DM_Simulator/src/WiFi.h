@@ -0,0 +1,66 @@
+/** +----------------------------------------------+
+ *  |         WiFi - Simulated Wi-Fi chip          |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef WiFi_h
+#define WiFi_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "Arduino.h"    // Used to be able to use "String" and "IPAddress"
+#include "WiFiClient.h" // The ESP32 core makes "WiFiClient" available to every file that includes "WiFi.h"
+
+// DECLARE THE TYPES OF THE WI-FI CHIP (the same values as in the ESP32 core)
+typedef enum
+{
+    WL_NO_SHIELD = 255,
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_SCAN_COMPLETED = 2,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+typedef enum
+{
+    WIFI_OFF = 0,
+    WIFI_STA = 1,
+    WIFI_AP = 2,
+    WIFI_AP_STA = 3
+} wifi_mode_t;
+#define WIFI_SCAN_RUNNING (-1)
+#define WIFI_SCAN_FAILED (-2)
+
+/**
+ * The Wi-Fi chip, with the part of the interface of the ESP32 "WiFiClass" the station uses (the model behind it is in "DM_SimulatedNetwork").
+ */
+class WiFiClass
+{
+public: // The public functions
+    bool mode(wifi_mode_t mode);
+    wl_status_t begin(const char *SSID, const char *password = nullptr, int32_t channel = 0, const uint8_t *BSSID = nullptr, bool connect = true);
+    bool config(IPAddress localIP, IPAddress gateway, IPAddress subnet, IPAddress DNS1 = (uint32_t)0, IPAddress DNS2 = (uint32_t)0);
+    bool disconnect(bool WiFiOff = false, bool eraseAP = false);
+    wl_status_t status();
+    IPAddress localIP();
+    IPAddress gatewayIP();
+    IPAddress subnetMask();
+    IPAddress dnsIP(uint8_t index = 0);
+    uint8_t *BSSID();
+    int32_t channel();
+    int8_t RSSI();
+    int16_t scanNetworks(bool async = false);
+    int16_t scanComplete();
+    void scanDelete();
+    String SSID(uint8_t index);
+    int32_t RSSI(uint8_t index);
+    uint8_t *BSSID(uint8_t index);
+    int32_t channel(uint8_t index);
+};
+extern WiFiClass WiFi;
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,99 @@
+/** +----------------------------------------------+
+ *  |    WiFiClient - Simulated TCP connection     |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "WiFiClient.h"          // Include the header file where the declarations for this library are stored
+#include "WiFiClientSecure.h"    // Include the header file where the declarations of the TLS connection are stored
+#include "DM_Simulator.h"        // Used to read the virtual clock
+#include "DM_SimulatedNetwork.h" // Used to make the connection and to check if it still works
+
+/**
+ * Connect to a server (this waits for the handshake).
+ *
+ * @param host The server.
+ * @param port The port.
+ *
+ * @return 1 if the connection was made, 0 otherwise.
+ */
+int WiFiClient::connect(const char *host, uint16_t port)
+{
+    return this->connect(host, port, defaultConnectTimeoutMs);
+}
+
+/**
+ * Connect to a server (this waits for the handshake, or for the timeout if the server can't be reached).
+ *
+ * @param host The server.
+ * @param port The port.
+ * @param timeoutMs The longest time to wait.
+ *
+ * @return 1 if the connection was made, 0 otherwise.
+ */
+int WiFiClient::connect(const char *host, uint16_t port, uint32_t timeoutMs)
+{
+    this->stop();
+    if (!DM_SimulatedNetwork::connect(host, port, this->_secure, timeoutMs))
+        return 0;
+    this->_open = true;
+    this->_host = host;
+    this->_port = port;
+    this->_session = DM_SimulatedNetwork::getWiFiSession();
+    this->_connectedMs = DM_Simulator::getMicroseconds() / 1000;
+    return 1;
+}
+
+/**
+ * Check if the connection still works.
+ *
+ * @return 1 if the connection is open and nothing broke it since it was made.
+ */
+uint8_t WiFiClient::connected()
+{
+    return this->_open && DM_SimulatedNetwork::isConnectionAlive(this->_session, this->_port, this->_connectedMs);
+}
+
+/**
+ * Close the connection.
+ */
+void WiFiClient::stop()
+{
+    this->_open = false;
+}
+
+/**
+ * Get the server of the connection.
+ *
+ * @return The server (empty if no connection was ever made).
+ */
+const char *WiFiClient::getHost() const
+{
+    return this->_host.c_str();
+}
+
+/**
+ * Create a TLS connection.
+ */
+WiFiClientSecure::WiFiClientSecure()
+{
+    this->_secure = true;
+}
+
+/**
+ * Don't check the certificate of the server (they are never checked in the simulator).
+ */
+void WiFiClientSecure::setInsecure()
+{
+}
+
+/**
+ * Set the certificate the server is checked against (they are never checked in the simulator).
+ *
+ * @param rootCA The certificate.
+ */
+void WiFiClientSecure::setCACert(const char *rootCA)
+{
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+/** +----------------------------------------------+
+ *  |    WiFiClient - Simulated TCP connection     |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef WiFiClient_h
+#define WiFiClient_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stdint.h> // Used to be able to use the fixed width integer types
+#include <string>   // Used to remember the server
+#include "Client.h" // Used to be able to use "Client" as the base class
+
+/**
+ * A TCP connection over the simulated Wi-Fi, with the part of the interface of the ESP32 "WiFiClient" the station and the network libraries use.
+ *
+ * Making the connection takes the round trip of the handshake (see "DM_SimulatedNetwork::connect()"), and the connection breaks when the Wi-Fi or the link to the server goes down, even if it comes back later.
+ */
+class WiFiClient : public Client
+{
+public: // The public functions and constants
+    static constexpr uint32_t defaultConnectTimeoutMs = 3000; // The time "connect()" waits for a server that doesn't answer (the same as the ESP32 core)
+
+    int connect(const char *host, uint16_t port) override;
+    int connect(const char *host, uint16_t port, uint32_t timeoutMs);
+    uint8_t connected() override;
+    void stop() override;
+    const char *getHost() const;
+
+protected: // The protected members
+    bool _secure = false; // True if the connection uses TLS (see "WiFiClientSecure")
+
+private: // The private members
+    bool _open = false;        // True if the connection was made and not stopped
+    std::string _host;         // The server
+    uint16_t _port = 0;        // The port of the server
+    uint32_t _session = 0;     // The Wi-Fi connection the TCP connection was made over
+    uint64_t _connectedMs = 0; // The moment the connection was made
+};
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,26 @@
+/** +----------------------------------------------+
+ *  |       WiFiClientSecure - Simulated TLS       |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef WiFiClientSecure_h
+#define WiFiClientSecure_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "WiFiClient.h" // Used to be able to use "WiFiClient" as the base class
+
+/**
+ * A TLS connection over the simulated Wi-Fi: a "WiFiClient" with the extra round trips of the TLS handshake (the certificates are not checked).
+ */
+class WiFiClientSecure : public WiFiClient
+{
+public: // The public functions
+    WiFiClientSecure();
+    void setInsecure();
+    void setCACert(const char *rootCA);
+};
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,65 @@
+/** +----------------------------------------------+
+ *  |        WiFiUdp - Simulated UDP socket        |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "WiFiUdp.h"             // Include the header file where the declarations for this library are stored
+#include "DM_SimulatedNetwork.h" // Used to deliver the datagram
+
+/**
+ * Start a datagram.
+ *
+ * @param host The destination.
+ * @param port The port of the destination.
+ *
+ * @return 1.
+ */
+int WiFiUDP::beginPacket(const char *host, uint16_t port)
+{
+    this->_host = host;
+    this->_port = port;
+    this->_packet.clear();
+    return 1;
+}
+
+/**
+ * Add a byte to the datagram.
+ *
+ * @param data The byte.
+ *
+ * @return The amount of bytes that were added.
+ */
+size_t WiFiUDP::write(uint8_t data)
+{
+    this->_packet.push_back(data);
+    return 1;
+}
+
+/**
+ * Add bytes to the datagram.
+ *
+ * @param data The bytes.
+ * @param length The amount of bytes.
+ *
+ * @return The amount of bytes that were added.
+ */
+size_t WiFiUDP::write(const uint8_t *data, size_t length)
+{
+    this->_packet.insert(this->_packet.end(), data, data + length);
+    return length;
+}
+
+/**
+ * Send the datagram.
+ *
+ * @return 1 if it was sent (there is no answer, so it might still be lost), 0 without Wi-Fi.
+ */
+int WiFiUDP::endPacket()
+{
+    bool sent = DM_SimulatedNetwork::sendUDP(this->_host.c_str(), this->_port, this->_packet.data(), this->_packet.size());
+    this->_packet.clear();
+    return sent ? 1 : 0;
+}
\ No newline at end of file
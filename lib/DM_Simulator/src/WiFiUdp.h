@@ -0,0 +1,35 @@
+/** +----------------------------------------------+
+ *  |        WiFiUdp - Simulated UDP socket        |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef WiFiUdp_h
+#define WiFiUdp_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h> // Used to be able to use the "size_t" type
+#include <stdint.h> // Used to be able to use the fixed width integer types
+#include <string>   // Used to remember the destination
+#include <vector>   // Used to collect the datagram
+
+/**
+ * A UDP socket over the simulated Wi-Fi, with the part of the interface of the ESP32 "WiFiUDP" the station uses.
+ */
+class WiFiUDP
+{
+public: // The public functions
+    int beginPacket(const char *host, uint16_t port);
+    size_t write(uint8_t data);
+    size_t write(const uint8_t *data, size_t length);
+    int endPacket();
+
+private: // The private members
+    std::string _host;            // The destination of the datagram
+    uint16_t _port = 0;           // The port of the destination
+    std::vector<uint8_t> _packet; // The datagram that is being written
+};
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,161 @@
+/** +----------------------------------------------+
+ *  |           Wire - Simulated I2C bus           |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "Wire.h"         // Include the header file where the declarations for this library are stored
+#include "DM_Simulator.h" // Used to let the bus time pass
+
+// OTHER VARIABLES
+TwoWire Wire; // The I2C bus of the station
+
+/**
+ * Start the bus.
+ *
+ * @return True (the bus always starts).
+ */
+bool TwoWire::begin()
+{
+    return true;
+}
+
+/**
+ * Set the clock of the bus.
+ *
+ * @param clockHz The clock in Hz.
+ */
+void TwoWire::setClock(uint32_t clockHz)
+{
+    if (clockHz > 0)
+        this->_clockHz = clockHz;
+}
+
+/**
+ * Connect a simulated chip to the bus.
+ *
+ * @param address The 7-bit address of the chip.
+ * @param device The chip (it has to live as long as the simulation).
+ */
+void TwoWire::attachDevice(uint8_t address, DM_I2CDevice *device)
+{
+    this->_devices[address] = device;
+}
+
+/**
+ * Start writing to a device.
+ *
+ * @param address The 7-bit address of the device.
+ */
+void TwoWire::beginTransmission(uint8_t address)
+{
+    this->_transmitAddress = address;
+    this->_transmitBuffer.clear();
+}
+
+/**
+ * Add a byte to the transaction.
+ *
+ * @param data The byte.
+ *
+ * @return The amount of bytes that were added.
+ */
+size_t TwoWire::write(uint8_t data)
+{
+    this->_transmitBuffer.push_back(data);
+    return 1;
+}
+
+/**
+ * Add bytes to the transaction.
+ *
+ * @param data The bytes.
+ * @param length The amount of bytes.
+ *
+ * @return The amount of bytes that were added.
+ */
+size_t TwoWire::write(const uint8_t *data, size_t length)
+{
+    this->_transmitBuffer.insert(this->_transmitBuffer.end(), data, data + length);
+    return length;
+}
+
+/**
+ * Send the transaction to the device.
+ *
+ * @param sendStop Unused (the bus is never shared in the simulator).
+ *
+ * @return 0 on success, 2 if no device acknowledged the address.
+ */
+uint8_t TwoWire::endTransmission(bool sendStop)
+{
+    auto device = this->_devices.find(this->_transmitAddress);
+    if (device == this->_devices.end())
+    {
+        this->_useBus(1);
+        return 2;
+    }
+    this->_useBus(1 + this->_transmitBuffer.size());
+    device->second->write(this->_transmitBuffer.data(), this->_transmitBuffer.size());
+    this->_transmitBuffer.clear();
+    return 0;
+}
+
+/**
+ * Read bytes from a device (they are returned by "read()" afterwards).
+ *
+ * @param address The 7-bit address of the device.
+ * @param length The amount of bytes.
+ * @param sendStop Unused (the bus is never shared in the simulator).
+ *
+ * @return The amount of bytes that were read (0 if no device acknowledged the address).
+ */
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t length, bool sendStop)
+{
+    this->_receiveBuffer.assign(length, 0);
+    this->_receivePosition = 0;
+    auto device = this->_devices.find(address);
+    if (device == this->_devices.end())
+    {
+        this->_receiveBuffer.clear();
+        this->_useBus(1);
+        return 0;
+    }
+    this->_useBus(1 + length);
+    device->second->read(this->_receiveBuffer.data(), length);
+    return length;
+}
+
+/**
+ * Get the amount of bytes that can still be read.
+ *
+ * @return The amount of bytes.
+ */
+int TwoWire::available()
+{
+    return this->_receiveBuffer.size() - this->_receivePosition;
+}
+
+/**
+ * Get the next byte that was read.
+ *
+ * @return The byte, or -1 if there is none.
+ */
+int TwoWire::read()
+{
+    if (this->_receivePosition >= this->_receiveBuffer.size())
+        return -1;
+    return this->_receiveBuffer[this->_receivePosition++];
+}
+
+/**
+ * Let the time pass that a number of bytes take on the bus (the task that uses the bus keeps the processor).
+ *
+ * @param bytes The amount of bytes.
+ */
+void TwoWire::_useBus(size_t bytes)
+{
+    DM_Simulator::busyWait((uint64_t)bytes * bitsPerByte * 1000000 / this->_clockHz);
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+/** +----------------------------------------------+
+ *  |           Wire - Simulated I2C bus           |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef Wire_h
+#define Wire_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h> // Used to be able to use the "size_t" type
+#include <stdint.h> // Used to be able to use the fixed width integer types
+#include <map>      // Used to find a device by its address
+#include <vector>   // Used to keep the bytes of a transaction
+
+/**
+ * A simulated chip on the I2C bus (see "DM_SimulatedSensors.h").
+ */
+class DM_I2CDevice
+{
+public: // The public functions
+    virtual ~DM_I2CDevice() {}
+    virtual void write(const uint8_t *data, size_t length) = 0;
+    virtual void read(uint8_t *buffer, size_t length) = 0;
+};
+
+/**
+ * The I2C bus, with the part of the interface of the Arduino "TwoWire" class the station and the sensor libraries use.
+ *
+ * Every transaction takes the time it would take on the bus (9 clock cycles per byte, the address included), so a task that talks to a sensor is busy for as long as it would be on the station.
+ * A transaction to an address without a device is not acknowledged, like on the real bus.
+ */
+class TwoWire
+{
+public: // The public functions and constants
+    static constexpr uint32_t defaultClockHz = 100000; // The clock of the bus unless "setClock()" says otherwise
+    static constexpr uint32_t bitsPerByte = 9;         // The clock cycles per byte (8 data bits and the acknowledge bit)
+
+    bool begin();
+    void setClock(uint32_t clockHz);
+    void attachDevice(uint8_t address, DM_I2CDevice *device);
+    void beginTransmission(uint8_t address);
+    size_t write(uint8_t data);
+    size_t write(const uint8_t *data, size_t length);
+    uint8_t endTransmission(bool sendStop = true);
+    uint8_t requestFrom(uint8_t address, uint8_t length, bool sendStop = true);
+    int available();
+    int read();
+
+private: // The private functions and members
+    uint32_t _clockHz = defaultClockHz;         // The clock of the bus
+    std::map<uint8_t, DM_I2CDevice *> _devices; // The devices on the bus, by their address
+    uint8_t _transmitAddress = 0;               // The address of the transaction that is being written
+    std::vector<uint8_t> _transmitBuffer;       // The bytes that are written
+    std::vector<uint8_t> _receiveBuffer;        // The bytes that were read
+    size_t _receivePosition = 0;                // The next byte that is returned by "read()"
+    void _useBus(size_t bytes);
+};
+extern TwoWire Wire;
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,298 @@
+/** +----------------------------------------------+
+ *  |       esp_heap_caps - Simulated memory       |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "esp_heap_caps.h" // Include the header file where the declarations for this library are stored
+#include <stdlib.h>        // Used to take the memory from Linux
+#include <string.h>        // Used to clear the memory of "calloc()"
+#include <atomic>          // Used to guard the table of counted blocks (a lock that never allocates)
+
+// DECLARE THE ALLOCATOR OF THE C LIBRARY (the replaced functions below hand the memory out through these)
+#ifdef __GLIBC__
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_realloc(void *pointer, size_t size);
+extern "C" void __libc_free(void *pointer);
+#define DM_takeMemory __libc_malloc
+#define DM_giveMemoryBack __libc_free
+#else
+#define DM_takeMemory malloc
+#define DM_giveMemoryBack free
+#endif
+
+// OTHER VARIABLES
+const size_t internalHeapSize = 200 * 1024; // The free internal heap of an ESP32 after the Wi-Fi stack, the web server and the tasks of the station are started
+const size_t largestBlockShare = 55;        // The largest free block in percent of the free heap (the heap of the ESP32 is split over several regions and fragments)
+struct CountedBlock
+{
+    void *pointer; // The block (nullptr if the slot is empty)
+    size_t size;   // The size of the block
+};
+CountedBlock countedBlocks[DM_SimulatedHeap::maxCountedBlocks]; // The blocks that are counted, by a hash of their address (open addressing, so the table itself never allocates)
+std::atomic_flag countedBlocksLock = ATOMIC_FLAG_INIT;          // Held while the table is read or changed (the simulator runs one task at a time, but its own threads free memory as well)
+size_t allocatedBytes = 0;                                      // The total size of the blocks that are counted
+size_t amountOfCountedBlocks = 0;                               // The amount of blocks in the table
+size_t minimumFreeBytes = internalHeapSize;                     // The lowest amount of free memory so far
+uint32_t amountOfAllocations = 0;                               // The amount of blocks that have been counted since the start
+uint32_t amountOfUncountedBlocks = 0;                           // The amount of blocks that should have been counted, but didn't fit in the table
+thread_local bool countingThisThread = false;                   // If the allocations of this thread are counted (only the threads of the tasks of the station)
+
+/**
+ * Find the slot of a block in the table (hold the lock).
+ *
+ * @param pointer The block.
+ *
+ * @return The slot of the block, or the empty slot where it would go.
+ */
+static size_t findSlot(void *pointer)
+{
+    size_t slot = ((uintptr_t)pointer >> 4) * 2654435761u % DM_SimulatedHeap::maxCountedBlocks;
+    while (countedBlocks[slot].pointer != nullptr && countedBlocks[slot].pointer != pointer)
+        slot = (slot + 1) % DM_SimulatedHeap::maxCountedBlocks;
+    return slot;
+}
+
+/**
+ * Count a block against the heap of the station.
+ *
+ * @param pointer The block.
+ * @param size The size of the block.
+ */
+static void countBlock(void *pointer, size_t size)
+{
+    while (countedBlocksLock.test_and_set(std::memory_order_acquire))
+        ;
+    size_t slot = findSlot(pointer);
+    if (countedBlocks[slot].pointer == nullptr && amountOfCountedBlocks < DM_SimulatedHeap::maxCountedBlocks * 3 / 4)
+    {
+        countedBlocks[slot] = {pointer, size};
+        allocatedBytes += size;
+        amountOfCountedBlocks++;
+        amountOfAllocations++;
+        size_t freeBytes = allocatedBytes > internalHeapSize ? 0 : internalHeapSize - allocatedBytes;
+        if (freeBytes < minimumFreeBytes)
+            minimumFreeBytes = freeBytes;
+    }
+    else
+        amountOfUncountedBlocks++;
+    countedBlocksLock.clear(std::memory_order_release);
+}
+
+/**
+ * Stop counting a block (nothing happens if it wasn't counted).
+ *
+ * @param pointer The block.
+ */
+static void forgetBlock(void *pointer)
+{
+    while (countedBlocksLock.test_and_set(std::memory_order_acquire))
+        ;
+    size_t slot = findSlot(pointer);
+    if (countedBlocks[slot].pointer != nullptr)
+    {
+        allocatedBytes -= countedBlocks[slot].size;
+        amountOfCountedBlocks--;
+        countedBlocks[slot].pointer = nullptr;
+
+        // Move the blocks after it back, so every block can still be found from its own slot ("backward shift deletion")
+        size_t empty = slot;
+        for (size_t next = (slot + 1) % DM_SimulatedHeap::maxCountedBlocks; countedBlocks[next].pointer != nullptr; next = (next + 1) % DM_SimulatedHeap::maxCountedBlocks)
+        {
+            size_t home = ((uintptr_t)countedBlocks[next].pointer >> 4) * 2654435761u % DM_SimulatedHeap::maxCountedBlocks;
+            if ((next > empty && (home <= empty || home > next)) || (next < empty && home <= empty && home > next))
+            {
+                countedBlocks[empty] = countedBlocks[next];
+                countedBlocks[next].pointer = nullptr;
+                empty = next;
+            }
+        }
+    }
+    countedBlocksLock.clear(std::memory_order_release);
+}
+
+#ifdef __GLIBC__
+/**
+ * Allocate a block of memory (replaces the one of the C library, "new" uses it as well).
+ *
+ * @param size The size of the block in bytes.
+ *
+ * @return The block, or NULL if Linux has no memory left.
+ */
+extern "C" void *malloc(size_t size)
+{
+    void *pointer = __libc_malloc(size);
+    if (pointer != nullptr && countingThisThread)
+        countBlock(pointer, size);
+    return pointer;
+}
+
+/**
+ * Allocate a cleared block of memory for a number of items.
+ *
+ * @param amount The amount of items.
+ * @param size The size of one item in bytes.
+ *
+ * @return The block, or NULL if the size overflows or Linux has no memory left.
+ */
+extern "C" void *calloc(size_t amount, size_t size)
+{
+    if (size != 0 && amount > SIZE_MAX / size)
+        return nullptr;
+    void *pointer = malloc(amount * size);
+    if (pointer != nullptr)
+        memset(pointer, 0, amount * size);
+    return pointer;
+}
+
+/**
+ * Change the size of a block (the block may move).
+ *
+ * @param pointer The block (NULL allocates a new one).
+ * @param size The new size in bytes.
+ *
+ * @return The block, or NULL if Linux has no memory left (the old block is kept then).
+ */
+extern "C" void *realloc(void *pointer, size_t size)
+{
+    void *newPointer = __libc_realloc(pointer, size);
+    if (newPointer == nullptr && size != 0)
+        return nullptr;
+    if (pointer != nullptr)
+        forgetBlock(pointer);
+    if (newPointer != nullptr && countingThisThread)
+        countBlock(newPointer, size);
+    return newPointer;
+}
+
+/**
+ * Free a block (NULL is ignored).
+ *
+ * @param pointer The block.
+ */
+extern "C" void free(void *pointer)
+{
+    if (pointer == nullptr)
+        return;
+    forgetBlock(pointer);
+    __libc_free(pointer);
+}
+#endif
+
+/**
+ * Allocate a block of memory (always counted, no matter which thread asks for it).
+ *
+ * @param size The size of the block in bytes.
+ * @param capabilities The kind of memory ("MALLOC_CAP_...").
+ *
+ * @return The block, or NULL if there isn't enough memory of that kind.
+ */
+void *heap_caps_malloc(size_t size, uint32_t capabilities)
+{
+    // There is no external RAM, and a block can't be larger than the largest free block
+    if ((capabilities & MALLOC_CAP_SPIRAM) || size == 0 || size > heap_caps_get_largest_free_block(capabilities))
+        return nullptr;
+
+    // Take the memory and count it
+    void *pointer = DM_takeMemory(size);
+    if (pointer != nullptr)
+        countBlock(pointer, size);
+    return pointer;
+}
+
+/**
+ * Free a block that was allocated with "heap_caps_malloc()" (NULL is ignored).
+ *
+ * @param pointer The block.
+ */
+void heap_caps_free(void *pointer)
+{
+    if (pointer == nullptr)
+        return;
+    forgetBlock(pointer);
+    DM_giveMemoryBack(pointer);
+}
+
+/**
+ * Get the amount of memory of a kind.
+ *
+ * @param capabilities The kind of memory ("MALLOC_CAP_...").
+ *
+ * @return The size of the heap in bytes (always 0 for the external RAM).
+ */
+size_t heap_caps_get_total_size(uint32_t capabilities)
+{
+    return (capabilities & MALLOC_CAP_SPIRAM) ? 0 : internalHeapSize;
+}
+
+/**
+ * Get the amount of free memory of a kind.
+ *
+ * @param capabilities The kind of memory ("MALLOC_CAP_...").
+ *
+ * @return The free memory in bytes (always 0 for the external RAM).
+ */
+size_t heap_caps_get_free_size(uint32_t capabilities)
+{
+    return (capabilities & MALLOC_CAP_SPIRAM) || allocatedBytes > internalHeapSize ? 0 : internalHeapSize - allocatedBytes;
+}
+
+/**
+ * Get the largest block of a kind that can be allocated at once.
+ *
+ * @param capabilities The kind of memory ("MALLOC_CAP_...").
+ *
+ * @return The size of the largest free block in bytes.
+ */
+size_t heap_caps_get_largest_free_block(uint32_t capabilities)
+{
+    return heap_caps_get_free_size(capabilities) * largestBlockShare / 100;
+}
+
+/**
+ * Get the lowest amount of free memory of a kind since the boot.
+ *
+ * @param capabilities The kind of memory ("MALLOC_CAP_...").
+ *
+ * @return The lowest free memory in bytes.
+ */
+size_t heap_caps_get_minimum_free_size(uint32_t capabilities)
+{
+    return (capabilities & MALLOC_CAP_SPIRAM) ? 0 : minimumFreeBytes;
+}
+
+/**
+ * Turn the counting of the allocations of this thread on or off (the simulator turns it on for the thread of every task, and off around its own bookkeeping).
+ *
+ * @param counting True to count the blocks this thread allocates.
+ *
+ * @return If they were counted before (to turn the counting back to what it was).
+ */
+bool DM_SimulatedHeap::setCounting(bool counting)
+{
+    bool wasCounting = countingThisThread;
+    countingThisThread = counting;
+    return wasCounting;
+}
+
+/**
+ * Get the amount of blocks that have been counted against the heap of the station since the start.
+ *
+ * @return The amount of allocations.
+ */
+uint32_t DM_SimulatedHeap::getAmountOfAllocations()
+{
+    return amountOfAllocations;
+}
+
+/**
+ * Get the amount of blocks that should have been counted, but didn't fit in the table (the memory of the station is higher than shown if this isn't 0).
+ *
+ * @return The amount of uncounted blocks.
+ */
+uint32_t DM_SimulatedHeap::getAmountOfUncountedBlocks()
+{
+    return amountOfUncountedBlocks;
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+/** +----------------------------------------------+
+ *  |       esp_heap_caps - Simulated memory       |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef esp_heap_caps_h
+#define esp_heap_caps_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h> // Used to be able to use the "size_t" type
+#include <stdint.h> // Used to be able to use the fixed width integer types
+
+// DECLARE THE CAPABILITIES OF THE MEMORY (the same bits as in the ESP-IDF)
+#define MALLOC_CAP_SPIRAM (1 << 10)   // The external RAM (the simulated board has none, like the ESP32 DOIT DevKit V1)
+#define MALLOC_CAP_INTERNAL (1 << 11) // The RAM inside the ESP32
+#define MALLOC_CAP_8BIT (1 << 2)      // Memory that can be read byte by byte (all internal RAM the station uses)
+
+// DECLARE THE FUNCTIONS OF THE HEAP (the memory is taken from Linux, but counted against the free heap of an ESP32 that runs the station, so a history that doesn't fit on the board doesn't fit in the simulator either)
+void *heap_caps_malloc(size_t size, uint32_t capabilities);
+void heap_caps_free(void *pointer);
+size_t heap_caps_get_total_size(uint32_t capabilities);
+size_t heap_caps_get_free_size(uint32_t capabilities);
+size_t heap_caps_get_largest_free_block(uint32_t capabilities);
+size_t heap_caps_get_minimum_free_size(uint32_t capabilities);
+
+/**
+ * The part of the simulated heap the ESP-IDF doesn't have: which allocations are counted against the heap of the station, and how many there were.
+ *
+ * "heap_caps_malloc()" is always counted. Besides that, "malloc()", "calloc()", "realloc()" and "free()" are replaced (so "new", "std::string" and every container are included):
+ * a block is counted when it is allocated by the thread of a task of the station (see "DM_Simulator::createTask()"), unless that thread turned the counting off for the bookkeeping of the simulator itself (e.g. the trace that is being recorded).
+ * The blocks are only counted, never refused: only "heap_caps_malloc()" fails when the simulated heap is full.
+ */
+class DM_SimulatedHeap
+{
+public: // The public functions and constants
+    static constexpr size_t maxCountedBlocks = 1 << 17; // The size of the table of counted blocks (at most 3/4 of it is used, more blocks are handed out, but not counted)
+
+    static bool setCounting(bool counting);
+    static uint32_t getAmountOfAllocations();
+    static uint32_t getAmountOfUncountedBlocks();
+};
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,40 @@
+/** +----------------------------------------------+
+ *  |   esp_netif - Simulated network interface    |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "esp_netif.h"           // Include the header file where the declarations for this library are stored
+#include "esp_netif_net_stack.h" // Include the header file with the lwIP side of the interfaces
+#include "DM_SimulatedNetwork.h" // Used to know the lease time of the simulated router
+#include <string.h>              // Used to compare the key of the interface
+
+// OTHER VARIABLES
+struct dhcp stationDHCP = {DM_SimulatedNetwork::DHCPLeaseSeconds}; // The DHCP client of the Wi-Fi station (the simulated router always gives the same lease)
+struct netif stationInterface = {&stationDHCP};                    // The Wi-Fi station interface
+
+/**
+ * Find a network interface by its key.
+ *
+ * @param key The key of the interface ("WIFI_STA_DEF" for the Wi-Fi station).
+ *
+ * @return The interface, or NULL if there is no interface with this key.
+ */
+esp_netif_t *esp_netif_get_handle_from_ifkey(const char *key)
+{
+    return strcmp(key, "WIFI_STA_DEF") == 0 ? &stationInterface : nullptr;
+}
+
+/**
+ * Get the lwIP interface behind a network interface.
+ *
+ * @param netif The network interface.
+ *
+ * @return The lwIP interface.
+ */
+void *esp_netif_get_netif_impl(esp_netif_t *netif)
+{
+    return netif;
+}
\ No newline at end of file
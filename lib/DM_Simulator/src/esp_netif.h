@@ -0,0 +1,21 @@
+/** +----------------------------------------------+
+ *  |   esp_netif - Simulated network interface    |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef esp_netif_h
+#define esp_netif_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "lwip/dhcp.h" // Used to hand out the DHCP client of the interface
+
+// DECLARE THE TYPE OF A NETWORK INTERFACE (only the Wi-Fi station, with the DHCP client the simulated router talks to)
+typedef struct netif esp_netif_t;
+
+// DECLARE THE FUNCTIONS OF THE NETWORK INTERFACES (the lwIP interface behind one is in "esp_netif_net_stack.h")
+esp_netif_t *esp_netif_get_handle_from_ifkey(const char *key);
+
+#endif // End the header guard
\ No newline at end of file
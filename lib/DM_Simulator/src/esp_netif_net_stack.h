@@ -0,0 +1,18 @@
+/** +----------------------------------------------+
+ *  |    esp_netif_net_stack - lwIP interfaces     |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef esp_netif_net_stack_h
+#define esp_netif_net_stack_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "esp_netif.h" // Used to be able to use "esp_netif_t" as a type for an argument
+
+// DECLARE THE FUNCTIONS OF THE NETWORK STACK BEHIND THE INTERFACES
+void *esp_netif_get_netif_impl(esp_netif_t *netif);
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,55 @@
+/** +----------------------------------------------+
+ *  |      esp_sleep - Simulated sleep modes       |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "esp_sleep.h"    // Include the header file where the declarations for this library are stored
+#include "DM_Simulator.h" // Used to let the time pass and to end the simulation
+
+// OTHER VARIABLES
+uint64_t timerWakeupUs = 0; // The duration of the next sleep
+
+/**
+ * Set how long the next sleep takes.
+ *
+ * @param durationUs The duration in µs.
+ *
+ * @return ESP_OK.
+ */
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t durationUs)
+{
+    timerWakeupUs = durationUs;
+    return ESP_OK;
+}
+
+/**
+ * Sleep until the timer wakes the station up (the other tasks are paused on the ESP32, but they can't run anyway in the simulator while the current task sleeps with the processor).
+ *
+ * @return ESP_OK.
+ */
+esp_err_t esp_light_sleep_start()
+{
+    DM_Simulator::busyWait(timerWakeupUs);
+    return ESP_OK;
+}
+
+/**
+ * Go into deep sleep: the station restarts with "setup()" after the timer (see "DM_Simulator::deepSleep()").
+ */
+void esp_deep_sleep_start()
+{
+    DM_Simulator::deepSleep(timerWakeupUs);
+}
+
+/**
+ * Get why the station started (the simulation starts with a reset, every other start is a wake from deep sleep).
+ *
+ * @return ESP_SLEEP_WAKEUP_TIMER after a deep sleep, ESP_SLEEP_WAKEUP_UNDEFINED at the first boot.
+ */
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause()
+{
+    return DM_Simulator::getAmountOfWakes() > 0 ? ESP_SLEEP_WAKEUP_TIMER : ESP_SLEEP_WAKEUP_UNDEFINED;
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+/** +----------------------------------------------+
+ *  |      esp_sleep - Simulated sleep modes       |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef esp_sleep_h
+#define esp_sleep_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stdint.h> // Used to be able to use the fixed width integer types
+
+// DECLARE THE TYPES OF THE SLEEP MODES
+typedef int esp_err_t;
+#define ESP_OK 0
+typedef enum
+{
+    ESP_SLEEP_WAKEUP_UNDEFINED = 0, // The ESP32 was reset (not woken up from a deep sleep)
+    ESP_SLEEP_WAKEUP_TIMER = 4      // The ESP32 was woken up by the timer
+} esp_sleep_wakeup_cause_t;
+
+// DECLARE THE FUNCTIONS OF THE SLEEP MODES (a light sleep lets the virtual time pass, a deep sleep also lets the time pass and restarts the station)
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t durationUs);
+esp_err_t esp_light_sleep_start();
+[[noreturn]] void esp_deep_sleep_start();
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause();
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,40 @@
+/** +----------------------------------------------+
+ *  |       FreeRTOS - Simulated task kernel       |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef FreeRTOS_h
+#define FreeRTOS_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stdint.h> // Used to be able to use the fixed width integer types
+
+// DECLARE THE TYPES AND MACROS OF FREERTOS (with the same values as in the ESP32 port)
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+#define pdFAIL pdFALSE
+#define pdPASS pdTRUE
+#define errQUEUE_FULL ((BaseType_t)0)
+#define errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY ((BaseType_t)-1)
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define configTICK_RATE_HZ 1000
+#define portTICK_PERIOD_MS ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(timeInMs) ((TickType_t)(((TickType_t)(timeInMs) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000U))
+
+// DECLARE THE CRITICAL SECTIONS (only one task runs at a time in the simulator, so there is nothing to keep out)
+typedef struct
+{
+    uint32_t owner; // Unused
+    uint32_t count; // Unused
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0, 0}
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,126 @@
+/** +----------------------------------------------+
+ *  |       FreeRTOS - Simulated task kernel       |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "queue.h"         // Include the header file where the declarations for this library are stored
+#include "DM_Simulator.h"  // Used to block the tasks that wait for a queue on the virtual clock
+#include "esp_heap_caps.h" // Used to take the storage of a queue from the heap, like FreeRTOS does on the ESP32
+#include <string.h>        // Used to copy the items in and out of the queue
+#include <deque>           // Used to keep the items in the order they are received
+#include <vector>          // Used to keep the bytes of an item
+
+// DEFINE THE STRUCT "DM_SimulatedQueue"
+struct DM_SimulatedQueue
+{
+    UBaseType_t length;                     // The maximum amount of items in the queue
+    UBaseType_t itemSize;                   // The size of one item in bytes
+    std::deque<std::vector<uint8_t>> items; // The items, the oldest one first
+    void *storage;                          // The memory the queue takes from the simulated heap (the items are kept in "items")
+};
+
+// OTHER VARIABLES
+const uint32_t queueControlBlockSize = 84; // The memory FreeRTOS takes for the administration of a queue on the ESP32 (next to the storage of the items)
+
+/**
+ * Put an item at the back or the front of a queue, and wait for room if it is full.
+ */
+static BaseType_t send(QueueHandle_t queue, const void *item, TickType_t ticksToWait, bool toFront)
+{
+    if (!DM_Simulator::waitUntil([queue]() { return queue->items.size() < queue->length; }, DM_Simulator::ticksToMicroseconds(ticksToWait)))
+        return errQUEUE_FULL;
+    std::vector<uint8_t> copy((const uint8_t *)item, (const uint8_t *)item + queue->itemSize);
+    if (toFront)
+        queue->items.push_front(std::move(copy));
+    else
+        queue->items.push_back(std::move(copy));
+    return pdPASS;
+}
+
+/**
+ * Create a queue for a number of items of a fixed size (the storage is taken from the simulated heap, like on the ESP32).
+ */
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+    if (length == 0)
+        return nullptr;
+    void *storage = heap_caps_malloc(length * itemSize + queueControlBlockSize, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (storage == nullptr)
+        return nullptr;
+    return new DM_SimulatedQueue{length, itemSize, {}, storage};
+}
+
+/**
+ * Delete a queue.
+ */
+void vQueueDelete(QueueHandle_t queue)
+{
+    heap_caps_free(queue->storage);
+    delete queue;
+}
+
+/**
+ * Put an item at the back of a queue.
+ */
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticksToWait)
+{
+    return send(queue, item, ticksToWait, false);
+}
+
+/**
+ * Put an item at the back of a queue.
+ */
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void *item, TickType_t ticksToWait)
+{
+    return send(queue, item, ticksToWait, false);
+}
+
+/**
+ * Put an item at the front of a queue (it is received first).
+ */
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void *item, TickType_t ticksToWait)
+{
+    return send(queue, item, ticksToWait, true);
+}
+
+/**
+ * Take the oldest item out of a queue, and wait for one if the queue is empty.
+ */
+BaseType_t xQueueReceive(QueueHandle_t queue, void *buffer, TickType_t ticksToWait)
+{
+    if (!DM_Simulator::waitUntil([queue]() { return !queue->items.empty(); }, DM_Simulator::ticksToMicroseconds(ticksToWait)))
+        return pdFALSE;
+    memcpy(buffer, queue->items.front().data(), queue->itemSize);
+    queue->items.pop_front();
+    return pdPASS;
+}
+
+/**
+ * Copy the oldest item of a queue without taking it out, and wait for one if the queue is empty.
+ */
+BaseType_t xQueuePeek(QueueHandle_t queue, void *buffer, TickType_t ticksToWait)
+{
+    if (!DM_Simulator::waitUntil([queue]() { return !queue->items.empty(); }, DM_Simulator::ticksToMicroseconds(ticksToWait)))
+        return pdFALSE;
+    memcpy(buffer, queue->items.front().data(), queue->itemSize);
+    return pdPASS;
+}
+
+/**
+ * Get the amount of items in a queue.
+ */
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    return queue->items.size();
+}
+
+/**
+ * Get the amount of items that still fit in a queue.
+ */
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue)
+{
+    return queue->length - queue->items.size();
+}
\ No newline at end of file
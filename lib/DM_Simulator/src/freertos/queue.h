@@ -0,0 +1,30 @@
+/** +----------------------------------------------+
+ *  |       FreeRTOS - Simulated task kernel       |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef FreeRTOS_queue_h
+#define FreeRTOS_queue_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "FreeRTOS.h" // Used to be able to use the FreeRTOS types
+
+// DECLARE THE TYPE OF THE QUEUES (the items are copied into the queue, like in FreeRTOS)
+struct DM_SimulatedQueue;
+typedef DM_SimulatedQueue *QueueHandle_t;
+
+// DECLARE THE FUNCTIONS OF THE QUEUES
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+void vQueueDelete(QueueHandle_t queue);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticksToWait);
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void *item, TickType_t ticksToWait);
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void *item, TickType_t ticksToWait);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *buffer, TickType_t ticksToWait);
+BaseType_t xQueuePeek(QueueHandle_t queue, void *buffer, TickType_t ticksToWait);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue);
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,107 @@
+/** +----------------------------------------------+
+ *  |       FreeRTOS - Simulated task kernel       |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "task.h"          // Include the header file where the declarations for this library are stored
+#include "DM_Simulator.h"  // Used to create, block and wake the tasks on the virtual clock
+#include "esp_heap_caps.h" // Used to take the stack of a task from the heap, like FreeRTOS does on the ESP32
+#include <map>             // Used to find the stack of a task that is deleted
+
+// OTHER VARIABLES
+const uint32_t taskControlBlockSize = 352; // The memory FreeRTOS takes for the administration of a task on the ESP32 (next to its stack)
+std::map<TaskHandle_t, void *> taskStacks; // The memory that is taken from the heap for every task
+
+/**
+ * Create a task. The core is ignored and the task runs on the stack of a thread, but the stack depth (bytes on the ESP32) is taken from the simulated heap, so the tasks cost the same memory as on the station.
+ */
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stackDepth, void *parameters, UBaseType_t priority, TaskHandle_t *createdTask, BaseType_t core)
+{
+    void *stack = heap_caps_malloc(stackDepth + taskControlBlockSize, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (stack == nullptr)
+        return errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY;
+    TaskHandle_t task = DM_Simulator::createTask(function, name, priority, parameters);
+    taskStacks[task] = stack;
+    if (createdTask != nullptr)
+        *createdTask = task;
+    return pdPASS;
+}
+
+/**
+ * Create a task.
+ */
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stackDepth, void *parameters, UBaseType_t priority, TaskHandle_t *createdTask)
+{
+    return xTaskCreatePinnedToCore(function, name, stackDepth, parameters, priority, createdTask, 0);
+}
+
+/**
+ * Delete a task (NULL deletes the current task, this never returns then).
+ */
+void vTaskDelete(TaskHandle_t task)
+{
+    // Give the stack back to the heap (the idle task does that on the ESP32), and delete the task
+    task = task != nullptr ? task : DM_Simulator::getCurrentTask();
+    std::map<TaskHandle_t, void *>::iterator stack = taskStacks.find(task);
+    if (stack != taskStacks.end())
+    {
+        heap_caps_free(stack->second);
+        taskStacks.erase(stack);
+    }
+    DM_Simulator::deleteTask(task);
+}
+
+/**
+ * Block the current task for a number of ticks (0 only lets the other ready tasks with the same priority run first).
+ */
+void vTaskDelay(TickType_t ticks)
+{
+    DM_Simulator::sleep(DM_Simulator::ticksToMicroseconds(ticks));
+}
+
+/**
+ * Block the current task until a fixed time after the last wake-up.
+ */
+void vTaskDelayUntil(TickType_t *previousWakeTime, TickType_t period)
+{
+    *previousWakeTime += period;
+    TickType_t now = xTaskGetTickCount();
+    if ((int32_t)(*previousWakeTime - now) > 0)
+        vTaskDelay(*previousWakeTime - now);
+}
+
+/**
+ * Read the tick counter.
+ */
+TickType_t xTaskGetTickCount()
+{
+    return (TickType_t)(DM_Simulator::getMicrosecondsSinceBoot() / (1000000 / configTICK_RATE_HZ));
+}
+
+/**
+ * Get the current task.
+ */
+TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+    return DM_Simulator::getCurrentTask();
+}
+
+/**
+ * Add one to the notification value of a task.
+ */
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    DM_Simulator::notifyTask(task);
+    return pdPASS;
+}
+
+/**
+ * Wait until the notification value of the current task is not zero, and take it.
+ */
+uint32_t ulTaskNotifyTake(BaseType_t clearCountOnExit, TickType_t ticksToWait)
+{
+    return DM_Simulator::takeNotification(clearCountOnExit != pdFALSE, DM_Simulator::ticksToMicroseconds(ticksToWait));
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+/** +----------------------------------------------+
+ *  |       FreeRTOS - Simulated task kernel       |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef FreeRTOS_task_h
+#define FreeRTOS_task_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "FreeRTOS.h" // Used to be able to use the FreeRTOS types
+
+// DECLARE THE TYPES OF THE TASKS (a task is a task of the simulator, see "DM_Simulator.h")
+struct DM_SimulatedTask;
+typedef DM_SimulatedTask *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+// DECLARE THE FUNCTIONS OF THE TASKS (the core is ignored: only one task runs at a time)
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stackDepth, void *parameters, UBaseType_t priority, TaskHandle_t *createdTask, BaseType_t core);
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stackDepth, void *parameters, UBaseType_t priority, TaskHandle_t *createdTask);
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t *previousWakeTime, TickType_t period);
+TickType_t xTaskGetTickCount();
+TaskHandle_t xTaskGetCurrentTaskHandle();
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+uint32_t ulTaskNotifyTake(BaseType_t clearCountOnExit, TickType_t ticksToWait);
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,30 @@
+/** +----------------------------------------------+
+ *  |      lwip/dhcp - Simulated DHCP client       |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef lwip_dhcp_h
+#define lwip_dhcp_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stdint.h> // Used to be able to use the fixed width integer types
+
+// DECLARE THE STRUCT "dhcp" (only the part of the DHCP client of lwIP the station reads)
+struct dhcp
+{
+    uint32_t offered_t0_lease; // The lease time the DHCP server gave, in seconds
+};
+
+// DECLARE THE STRUCT "netif" (a network interface of lwIP, only with its DHCP client)
+struct netif
+{
+    struct dhcp *dhcp; // The DHCP client of the interface
+};
+
+// Get the DHCP client of an interface (lwIP keeps it in the client data of the interface)
+#define netif_dhcp_data(netif) ((netif)->dhcp)
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,16 @@
+/** +----------------------------------------------+
+ *  |   lwip/tcpip - Simulated TCP/IP core lock    |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef lwip_tcpip_h
+#define lwip_tcpip_h
+
+// Lock and unlock the TCP/IP core (there is no TCP/IP task in the simulator, and only one task runs at a time, so nothing else can change the DHCP client in the meantime)
+#define LOCK_TCPIP_CORE()
+#define UNLOCK_TCPIP_CORE()
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,249 @@
+/** +----------------------------------------------+
+ *  |      DM_Codec - Time series compression      |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES (no Arduino library, this file also builds on a computer)
+#include "DM_Codec.h" // Include the header file where the declarations for this library are stored
+#include <string.h>   // Used to copy an encoded sample into the stream
+
+/**
+ * Turn a signed difference into an unsigned number where small values stay small in both directions (0, -1, 1, -2, 2, ... become 0, 1, 2, 3, 4, ...).
+ *
+ * @param value The difference (calculated modulo 2^32).
+ *
+ * @return The zig-zag encoded value.
+ */
+static uint32_t zigZagEncode(uint32_t value)
+{
+    return (value << 1) ^ (uint32_t)((int32_t)value >> 31);
+}
+
+/**
+ * Undo "zigZagEncode()".
+ *
+ * @param value The zig-zag encoded value.
+ *
+ * @return The difference (modulo 2^32).
+ */
+static uint32_t zigZagDecode(uint32_t value)
+{
+    return (value >> 1) ^ (0 - (value & 1));
+}
+
+/**
+ * Write a number as a varint (7 bits per byte, the highest bit means "another byte follows", also used for the header of "DM_Payload.h").
+ *
+ * @param buffer The buffer to write to (it needs room for 5 bytes).
+ * @param value The number to write.
+ *
+ * @return The amount of bytes written.
+ */
+size_t DM_Encoder::writeVarint(uint8_t *buffer, uint32_t value)
+{
+    size_t length = 0;
+    while (value >= 0x80)
+    {
+        buffer[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    buffer[length++] = (uint8_t)value;
+    return length;
+}
+
+/**
+ * Read a varint.
+ *
+ * @param buffer The stream (or another buffer, like the header of "DM_Payload.h").
+ * @param length The length of the stream.
+ * @param position The position to read from (moved past the varint).
+ * @param value The variable the number will be copied into.
+ *
+ * @return False if the stream ended in the middle of the varint (or the varint is longer than 5 bytes).
+ */
+bool DM_Decoder::readVarint(const uint8_t *buffer, size_t length, size_t &position, uint32_t &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 35 && position < length; shift += 7)
+    {
+        uint8_t part = buffer[position++];
+        value |= (uint32_t)(part & 0x7F) << shift;
+        if ((part & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+/**
+ * Create an encoder (it can't write anything before "begin()" is called).
+ */
+DM_Encoder::DM_Encoder() : _buffer(nullptr), _capacity(0), _length(0), _amount(0)
+{
+}
+
+/**
+ * Start a new stream.
+ *
+ * @param buffer The buffer the stream is written to.
+ * @param capacity The size of the buffer.
+ */
+void DM_Encoder::begin(uint8_t *buffer, size_t capacity)
+{
+    _buffer = buffer;
+    _capacity = capacity;
+    _length = 0;
+    _amount = 0;
+    _previousTimestampDelta = 0;
+    _previousEpochDelta = 0;
+}
+
+/**
+ * Add a sample to the stream.
+ *
+ * @param sample The sample to add.
+ * @param epochSeconds The Unix time of the sample (0 if it is unknown).
+ *
+ * @return False if the sample doesn't fit in the buffer anymore (the stream is left as it was).
+ */
+bool DM_Encoder::add(const DM_PackedSample &sample, uint32_t epochSeconds)
+{
+    // Encode the sample in a small buffer first, so a sample that doesn't fit is never half written
+    uint8_t encoded[maxEncodedSampleSize];
+    size_t length = 0;
+    uint32_t timestampDelta = sample.timestampMs - _previous.timestampMs;
+    uint32_t epochDelta = epochSeconds - _previousEpochSeconds;
+    if (_amount == 0)
+    {
+        // The first sample is written as it is
+        length += writeVarint(encoded + length, sample.timestampMs);
+        length += writeVarint(encoded + length, epochSeconds);
+        length += writeVarint(encoded + length, zigZagEncode((uint32_t)(int32_t)sample.temperature));
+        length += writeVarint(encoded + length, sample.airPressure);
+        length += writeVarint(encoded + length, sample.lightIntensity);
+    }
+    else
+    {
+        // The timestamps change by (almost) the same amount every time, so only the change of that change is written
+        length += writeVarint(encoded + length, zigZagEncode(timestampDelta - _previousTimestampDelta));
+        length += writeVarint(encoded + length, zigZagEncode(epochDelta - _previousEpochDelta));
+
+        // The values change slowly, so only the change is written
+        length += writeVarint(encoded + length, zigZagEncode((uint32_t)((int32_t)sample.temperature - (int32_t)_previous.temperature)));
+        length += writeVarint(encoded + length, zigZagEncode(sample.airPressure - _previous.airPressure));
+        length += writeVarint(encoded + length, zigZagEncode((uint32_t)((int32_t)sample.lightIntensity - (int32_t)_previous.lightIntensity)));
+    }
+
+    // Don't add the sample if it doesn't fit
+    if (_buffer == nullptr || _length + length > _capacity)
+        return false;
+
+    // Add the sample to the stream and remember it for the next one
+    memcpy(_buffer + _length, encoded, length);
+    _length += length;
+    _previousTimestampDelta = _amount == 0 ? 0 : timestampDelta;
+    _previousEpochDelta = _amount == 0 ? 0 : epochDelta;
+    _previous = sample;
+    _previousEpochSeconds = epochSeconds;
+    _amount += 1;
+
+    // Return the success rate
+    return true;
+}
+
+/**
+ * Get the length of the stream.
+ *
+ * @return The amount of bytes written.
+ */
+size_t DM_Encoder::getLength() const
+{
+    return _length;
+}
+
+/**
+ * Get the amount of samples in the stream.
+ *
+ * @return The amount of samples written.
+ */
+uint32_t DM_Encoder::getAmount() const
+{
+    return _amount;
+}
+
+/**
+ * Create a decoder (it can't read anything before "begin()" is called).
+ */
+DM_Decoder::DM_Decoder() : _buffer(nullptr), _length(0), _position(0), _amount(0), _decoded(0)
+{
+}
+
+/**
+ * Start reading a stream.
+ *
+ * @param buffer The stream.
+ * @param length The length of the stream (bytes after the last sample are ignored, so a padded page can be given as a whole).
+ * @param amount The amount of samples in the stream.
+ */
+void DM_Decoder::begin(const uint8_t *buffer, size_t length, uint32_t amount)
+{
+    _buffer = buffer;
+    _length = length;
+    _position = 0;
+    _amount = amount;
+    _decoded = 0;
+    _previousTimestampDelta = 0;
+    _previousEpochDelta = 0;
+}
+
+/**
+ * Read the next sample of the stream.
+ *
+ * @param sample The variable the sample will be copied into.
+ * @param epochSeconds The variable the Unix time of the sample will be copied into.
+ *
+ * @return False if every sample has been read (or the stream is broken).
+ */
+bool DM_Decoder::next(DM_PackedSample &sample, uint32_t &epochSeconds)
+{
+    // Stop after the last sample
+    if (_buffer == nullptr || _decoded >= _amount)
+        return false;
+
+    // Read the five numbers of the sample
+    uint32_t numbers[5];
+    for (int i = 0; i < 5; i++)
+        if (!readVarint(_buffer, _length, _position, numbers[i]))
+            return false;
+
+    // Rebuild the sample
+    if (_decoded == 0)
+    {
+        // The first sample is written as it is
+        sample.timestampMs = numbers[0];
+        epochSeconds = numbers[1];
+        sample.temperature = (int16_t)zigZagDecode(numbers[2]);
+        sample.airPressure = numbers[3];
+        sample.lightIntensity = (uint16_t)numbers[4];
+    }
+    else
+    {
+        // Add the changes to the previous sample
+        _previousTimestampDelta += zigZagDecode(numbers[0]);
+        _previousEpochDelta += zigZagDecode(numbers[1]);
+        sample.timestampMs = _previous.timestampMs + _previousTimestampDelta;
+        epochSeconds = _previousEpochSeconds + _previousEpochDelta;
+        sample.temperature = (int16_t)(_previous.temperature + (int32_t)zigZagDecode(numbers[2]));
+        sample.airPressure = _previous.airPressure + zigZagDecode(numbers[3]);
+        sample.lightIntensity = (uint16_t)(_previous.lightIntensity + (int32_t)zigZagDecode(numbers[4]));
+    }
+
+    // Remember the sample for the next one
+    _previous = sample;
+    _previousEpochSeconds = epochSeconds;
+    _decoded += 1;
+
+    // Return the success rate
+    return true;
+}
\ No newline at end of file
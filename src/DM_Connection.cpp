@@ -0,0 +1,170 @@
+/** +----------------------------------------------+
+ *  |   DM_Connection - Connection state machine   |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "Arduino.h"       // Include the Arduino library
+#include "DM_Connection.h" // Include the header file where the declarations for this library are stored
+#include <DM_Log.h>        // Include the self-made library that prints the status messages without waiting for the serial port
+#include <DM_Format.h>     // Include the self-made library that writes the time per state without allocating memory
+
+/**
+ * Create a state machine for one connection (it starts in the IDLE state).
+ *
+ * @param name The name that is used as prefix when printing status messages (e.g. "DM_WiFi").
+ * @param connectTimeoutMs The time a connection attempt may take before it is seen as failed.
+ * @param initialBackoffMs The time to wait after the first failed attempt (this doubles after every next failure).
+ * @param maxBackoffMs The highest time we will ever wait between two attempts.
+ */
+DM_ConnectionStateMachine::DM_ConnectionStateMachine(const char *name, uint32_t connectTimeoutMs, uint32_t initialBackoffMs, uint32_t maxBackoffMs)
+    : _name(name), _state(DM_STATE_IDLE), _stateEnteredMs(0), _connectTimeoutMs(connectTimeoutMs), _initialBackoffMs(initialBackoffMs), _maxBackoffMs(maxBackoffMs),
+      _nextBackoffMs(initialBackoffMs), _currentBackoffMs(0), _amountOfConnects(0), _disconnectedSinceMs(0), _lastOutageMs(0)
+{
+    // Start with no time spent in any state
+    for (int i = 0; i < DM_AMOUNT_OF_STATES; i++)
+        _timeInStateMs[i] = 0;
+}
+
+/**
+ * Get the current state of the connection.
+ *
+ * @return The current state.
+ */
+DM_ConnectionState DM_ConnectionStateMachine::getState()
+{
+    return _state;
+}
+
+/**
+ * Move to a new state, keep the time statistics up to date and calculate the backoff when moving to the BACKOFF state.
+ *
+ * @param newState The state to move to.
+ */
+void DM_ConnectionStateMachine::changeState(DM_ConnectionState newState)
+{
+    // Add the time spent in the state we are leaving to its total
+    uint32_t now = millis();
+    _timeInStateMs[_state] += now - _stateEnteredMs;
+
+    // Remember the moment the connection got lost
+    if (_state == DM_STATE_CONNECTED)
+        _disconnectedSinceMs = now;
+
+    // Handle the things that need to happen when entering the new state
+    if (newState == DM_STATE_CONNECTED)
+    {
+        // Store how long we were without a connection and start the backoff from the beginning the next time
+        _lastOutageMs = now - _disconnectedSinceMs;
+        _nextBackoffMs = _initialBackoffMs;
+        _amountOfConnects += 1;
+    }
+    else if (newState == DM_STATE_BACKOFF)
+    {
+        // Wait a random time between half and the whole backoff, so many stations that lost the same access point don't retry at the same moment
+        _currentBackoffMs = _nextBackoffMs / 2 + random(_nextBackoffMs / 2 + 1);
+
+        // Double the backoff for the next failure (but never go above the maximum)
+        _nextBackoffMs = min(_nextBackoffMs * 2, _maxBackoffMs);
+
+        // Inform the user
+        DM_LOG_INFO(_name, "Retrying in %lu ms.", (unsigned long)_currentBackoffMs);
+    }
+
+    // Enter the new state
+    _state = newState;
+    _stateEnteredMs = now;
+}
+
+/**
+ * Check if the current connection attempt has been running for too long.
+ *
+ * @return True if we are connecting for longer than the connect timeout.
+ */
+bool DM_ConnectionStateMachine::hasConnectTimedOut()
+{
+    return _state == DM_STATE_CONNECTING && millis() - _stateEnteredMs >= _connectTimeoutMs;
+}
+
+/**
+ * Check if we waited long enough in the BACKOFF state to try again.
+ *
+ * @return True if the backoff time has passed.
+ */
+bool DM_ConnectionStateMachine::isBackoffOver()
+{
+    return _state == DM_STATE_BACKOFF && millis() - _stateEnteredMs >= _currentBackoffMs;
+}
+
+/**
+ * Get the total time spent in a state since boot (including the time in the current state).
+ *
+ * @param state The state to get the time of.
+ *
+ * @return The time in milliseconds.
+ */
+uint32_t DM_ConnectionStateMachine::getTimeInStateMs(DM_ConnectionState state)
+{
+    return _timeInStateMs[state] + (state == _state ? millis() - _stateEnteredMs : 0);
+}
+
+/**
+ * Get the amount of times the connection has been established since boot.
+ *
+ * @return The amount of (re)connects.
+ */
+uint32_t DM_ConnectionStateMachine::getAmountOfConnects()
+{
+    return _amountOfConnects;
+}
+
+/**
+ * Get the time it took to (re)connect the last time (from losing the connection until being connected again).
+ *
+ * @return The duration of the last outage in milliseconds.
+ */
+uint32_t DM_ConnectionStateMachine::getLastOutageMs()
+{
+    return _lastOutageMs;
+}
+
+/**
+ * Print the amount of connects, the duration of the last outage and the time spent in every state.
+ */
+void DM_ConnectionStateMachine::printStatistics()
+{
+    DM_LOG_INFO(_name, "Connected %lu time(s), last outage took %lu ms.", (unsigned long)_amountOfConnects, (unsigned long)_lastOutageMs);
+
+    // Print the time spent in every state (on a line of its own, so it fits in one log message)
+    char states[sizeof(DM_LogEntry::text)];
+    DM_Formatter output(states, sizeof(states));
+    for (int i = 0; i < DM_AMOUNT_OF_STATES; i++)
+        output.appendLiteral(" ").append(getStateName((DM_ConnectionState)i)).appendLiteral("=").appendUnsigned(getTimeInStateMs((DM_ConnectionState)i)).appendLiteral(" ms");
+    DM_LOG_INFO(_name, "Time per state:%s", output.c_str());
+}
+
+/**
+ * Get a readable name for a state.
+ *
+ * @param state The state to get the name of.
+ *
+ * @return The name of the state.
+ */
+const char *DM_ConnectionStateMachine::getStateName(DM_ConnectionState state)
+{
+    switch (state)
+    {
+    case DM_STATE_IDLE:
+        return "IDLE";
+    case DM_STATE_CONNECTING:
+        return "CONNECTING";
+    case DM_STATE_CONNECTED:
+        return "CONNECTED";
+    case DM_STATE_BACKOFF:
+        return "BACKOFF";
+    default:
+        return "UNKNOWN";
+    }
+}
\ No newline at end of file
@@ -6,52 +6,223 @@
  */
 
 // IMPORT THE NECESSARY LIBRARIES
-#include "Arduino.h"    // Include the Arduino library
-#include "DM_Discord.h" // Include the header file where the declarations for this library are stored
-#include <HTTPClient.h> // Used to create an object based on the class defined in this library
-using namespace std;    // Used to be able to use the string type without needing to say "std::string" every time
+#include "Arduino.h"          // Include the Arduino library
+#include "DM_Discord.h"       // Include the header file where the declarations for this library are stored
+#include <HTTPClient.h>       // Used to create an object based on the class defined in this library
+#include <WiFiClientSecure.h> // Used to keep one TLS connection to Discord open between messages
+#include <DM_Format.h>        // Include the self-made library that writes the JSON without allocating memory
+#include <DM_Time.h>          // Include the self-made library that formats the time of the measurements
+#include <DM_Profiler.h>      // Include the self-made library that measures the latency of the POST requests
+#include <DM_Log.h>           // Include the self-made library that prints the status messages without waiting for the serial port
+using namespace std;          // Used to be able to use the string type without needing to say "std::string" every time
+
+// INITIALIZE THE CLASS MEMBERS (if we don't do this, the code will give errors saying these should be initialised first)
+string DM_WebhookConnector::_webhookURL;                      // The URL of the Discord webhook
+const DM_Field *DM_WebhookConnector::_fields = nullptr;       // The values of a measurement that are shown
+size_t DM_WebhookConnector::_amountOfFields = 0;              // The amount of fields
+uint32_t DM_WebhookConnector::_nextSendMs = 0;                // The moment Discord accepts the next message (set from its rate limit headers)
+char DM_WebhookConnector::_message[1280];                     // The buffer the embed is written into (a full message with three values takes about 1 KB)
+uint32_t DM_WebhookConnector::_newConnectionLatencyMs = 0;    // The total time of the messages that needed a new connection (TCP and TLS handshake)
+uint32_t DM_WebhookConnector::_amountOfNewConnections = 0;    // The amount of messages that needed a new connection
+uint32_t DM_WebhookConnector::_reusedConnectionLatencyMs = 0; // The total time of the messages that were sent over the open connection
+uint32_t DM_WebhookConnector::_amountOfReusedConnections = 0; // The amount of messages that were sent over the open connection
+
+// OTHER VARIABLES
+WiFiClientSecure WiFiClientForDiscord;                                                                 // The TLS connection to Discord (kept open between messages)
+HTTPClient HTTPClientForDiscord;                                                                       // The HTTP client that sends the messages over it
+const char *DiscordHeaderKeys[] = {"Retry-After", "X-RateLimit-Remaining", "X-RateLimit-Reset-After"}; // The response headers that tell when Discord accepts the next message
+const uint32_t DiscordRetryDelayMs = 5000;                                                             // The time to wait after a message failed without a rate limit (e.g. the connection dropped)
 
 /**
- * Send a message to the specified Discord webhook.
+ * Set the URL of the Discord webhook.
  *
  * @param webhookURL The URL of the Discord webhook.
- * @param message The message you want to send to the Discord webhook.
  */
-void DM_WebhookConnector::sendMessage(string webhookURL, string message)
+void DM_WebhookConnector::setWebhookURL(string webhookURL)
 {
-    // Construct a HTTP client
-    HTTPClient HTTPClientForDiscord;
+    DM_WebhookConnector::_webhookURL = webhookURL;
+}
 
-    // Specify the Discord webhook URL
-    HTTPClientForDiscord.begin(String(webhookURL.c_str()));
+/**
+ * Set the values of a measurement that are shown (normally the fields of the sensor set).
+ *
+ * @param fields The table of fields (it has to stay valid).
+ * @param amountOfFields The amount of fields.
+ */
+void DM_WebhookConnector::setFields(const DM_Field *fields, size_t amountOfFields)
+{
+    DM_WebhookConnector::_fields = fields;
+    DM_WebhookConnector::_amountOfFields = amountOfFields;
+}
+
+/**
+ * Show a number of measurements in one message (Discord allows only a few messages per webhook per minute, so sending several measurements together stays far from its rate limit).
+ *
+ * @param samples The measurements to show (oldest first).
+ * @param amount The amount of measurements (at most "maxSamplesPerMessage").
+ *
+ * @return If Discord accepted the message, if it didn't, or if the measurements don't fit in one message (then they can never be sent).
+ */
+DM_DiscordResult DM_WebhookConnector::sendSamples(const DM_Sample *samples, size_t amount)
+{
+    // Build one embed for the measurements
+    size_t messageLength = DM_WebhookConnector::embedBuilder(DM_WebhookConnector::_message, sizeof(DM_WebhookConnector::_message), samples, min(amount, maxSamplesPerMessage), DM_WebhookConnector::_fields, DM_WebhookConnector::_amountOfFields);
+    if (messageLength == 0)
+    {
+        DM_LOG_ERROR("DM_Discord", "The measurements do not fit in one message, they are dropped.");
+        return DM_DISCORD_TOO_LARGE;
+    }
+
+    // Send it
+    return DM_WebhookConnector::sendMessage(DM_WebhookConnector::_message, messageLength) ? DM_DISCORD_SENT : DM_DISCORD_FAILED;
+}
+
+/**
+ * Check if Discord accepts a new message (after a 429, or when the last message used up the rate limit, it tells us how long to wait).
+ *
+ * @return True if a message may be sent now.
+ */
+bool DM_WebhookConnector::isRateLimitOver()
+{
+    return (int32_t)(millis() - DM_WebhookConnector::_nextSendMs) >= 0;
+}
+
+/**
+ * Send a message to the Discord webhook over the connection that is kept open (only the first message, or the first one after the connection dropped, pays for the TCP and TLS handshake).
+ * The rate limit headers of the response decide when the next message may be sent.
+ *
+ * @param message The message you want to send to the Discord webhook.
+ * @param messageLength The length of the message.
+ *
+ * @return True if Discord accepted the message.
+ */
+bool DM_WebhookConnector::sendMessage(const char *message, size_t messageLength)
+{
+    // Use the open connection if there is one (the certificate of Discord is not checked, like before)
+    uint32_t startUs = micros();
+    bool reusedConnection = WiFiClientForDiscord.connected();
+    WiFiClientForDiscord.setInsecure();
+    HTTPClientForDiscord.setReuse(true);
+    HTTPClientForDiscord.begin(WiFiClientForDiscord, DM_WebhookConnector::_webhookURL.c_str());
+    HTTPClientForDiscord.collectHeaders(DiscordHeaderKeys, sizeof(DiscordHeaderKeys) / sizeof(DiscordHeaderKeys[0]));
 
     // Add the header to the POST request
     HTTPClientForDiscord.addHeader("Content-Type", "application/json");
 
-    // Send the HTTP POST request
-    int responseCode = HTTPClientForDiscord.POST(String(message.c_str()));
+    // Send the HTTP POST request, read the rate limit headers and finish the request (the connection stays open for the next message)
+    int responseCode = HTTPClientForDiscord.POST((uint8_t *)message, messageLength);
+    float retryAfterSeconds = atof(HTTPClientForDiscord.header("Retry-After").c_str());
+    bool rateLimitReached = HTTPClientForDiscord.hasHeader("X-RateLimit-Remaining") && HTTPClientForDiscord.header("X-RateLimit-Remaining").toInt() == 0;
+    float resetAfterSeconds = atof(HTTPClientForDiscord.header("X-RateLimit-Reset-After").c_str());
+    HTTPClientForDiscord.end();
+    uint32_t latencyUs = micros() - startUs;
+    uint32_t latencyMs = latencyUs / 1000;
+    DM_PROFILE_MICROSECONDS(DM_STAGE_DISCORD_POST, latencyUs);
+
+    // Wait as long as Discord asks: after a 429, or when this message used up the rate limit
+    if (responseCode == 429)
+        DM_WebhookConnector::_nextSendMs = millis() + max((uint32_t)(retryAfterSeconds * 1000), (uint32_t)1000);
+    else if (rateLimitReached)
+        DM_WebhookConnector::_nextSendMs = millis() + (uint32_t)(resetAfterSeconds * 1000);
+    else if (responseCode < 0)
+        DM_WebhookConnector::_nextSendMs = millis() + DiscordRetryDelayMs;
+
+    // Close the connection after a connection error, so the next message starts with a fresh one
+    if (responseCode < 0)
+        WiFiClientForDiscord.stop();
 
     // Inform the user based on the result
-    if (responseCode == 200 || responseCode == 201 || responseCode == 204) // 200 = successful; 201 = the creation of something was succesful; 204 = successful but no content returned
+    bool sent = responseCode == 200 || responseCode == 201 || responseCode == 204; // 200 = successful; 201 = the creation of something was succesful; 204 = successful but no content returned
+    if (sent)
     {
-        Serial.println("\n[DM_Discord] Information successfully sent the Discord webhook!");
+        // Keep track of the time a message takes on a new and on a reused connection
+        if (reusedConnection)
+        {
+            DM_WebhookConnector::_reusedConnectionLatencyMs += latencyMs;
+            DM_WebhookConnector::_amountOfReusedConnections += 1;
+        }
+        else
+        {
+            DM_WebhookConnector::_newConnectionLatencyMs += latencyMs;
+            DM_WebhookConnector::_amountOfNewConnections += 1;
+        }
+        DM_LOG_INFO("DM_Discord", "Information successfully sent the Discord webhook in %lu ms (%s connection).", (unsigned long)latencyMs, reusedConnection ? "reused" : "new");
+        DM_WebhookConnector::printStatistics();
+    }
+    else if (responseCode == 429)
+    {
+        DM_LOG_WARNING("DM_Discord", "Rate limited by Discord, retrying in %.2f s.", retryAfterSeconds);
     }
     else
     {
-        Serial.println("\n[DM_Discord] Something went wrong while sending the information to the Discord webhook.");
+        DM_LOG_WARNING("DM_Discord", "Something went wrong while sending the information to the Discord webhook (response code %d).", responseCode);
     }
+
+    // Return the success rate
+    return sent;
 }
 
 /**
- * Build the JSON for the embed to send via a POST request.
+ * Build the JSON for one embed that shows a number of measurements (written into the given buffer, nothing is allocated). Every value is one embed field, with one line per measurement.
  *
- * @param temperatureC The temperature in Celsius.
- * @param lightIntensityLux The light intensity in lux.
- * @param airPressureBar The air pressure in bar.
+ * @param buffer The buffer the JSON will be written to.
+ * @param bufferSize The size of the buffer (about 1 KB is enough for eight measurements with three values).
+ * @param samples The measurements to show (oldest first).
+ * @param amount The amount of measurements.
+ * @param fields The values of the measurements to show (one embed field per value).
+ * @param amountOfFields The amount of fields.
  *
- * @return The JSON string.
+ * @return The length of the JSON (0 if it didn't fit in the buffer).
+ */
+size_t DM_WebhookConnector::embedBuilder(char *buffer, size_t bufferSize, const DM_Sample *samples, size_t amount, const DM_Field *fields, size_t amountOfFields)
+{
+    // Start the embed, and show the time of every measurement in the first field
+    DM_Formatter JSON(buffer, bufferSize);
+    JSON.appendLiteral("{\"content\": null, \"embeds\": [{\"description\": \"**");
+    if (amount > 1)
+        JSON.appendUnsigned(amount).appendLiteral(" NEW MEASUREMENTS**");
+    else
+        JSON.appendLiteral("NEW MEASUREMENT**");
+    JSON.appendLiteral("\", \"color\": 4176032, \"fields\": [{\"name\": \"Time (UTC)\", \"value\": \"");
+    for (size_t j = 0; j < amount; j++)
+    {
+        // Only show the time of the day of the ISO 8601 timestamp ("2024-05-01T12:00:00Z" → "12:00:00")
+        char timestamp[24];
+        JSON.append(j == 0 ? "`" : "\\n`");
+        if (samples[j].epochSeconds != 0 && DM_Time::formatISO8601(samples[j].epochSeconds, timestamp, sizeof(timestamp)) >= 19)
+            JSON.append(timestamp + 11, 8);
+        else
+            JSON.appendLiteral("--:--:--");
+        JSON.appendLiteral("`");
+    }
+    JSON.appendLiteral("\", \"inline\": true}");
+
+    // Fill in the values between the parts of the embed that never change
+    for (size_t i = 0; i < amountOfFields; i++)
+    {
+        JSON.appendLiteral(", {\"name\": \"").append(fields[i].name).appendLiteral("\", \"value\": \"");
+        for (size_t j = 0; j < amount; j++)
+        {
+            JSON.append(j == 0 ? "`" : "\\n`")
+                .appendFixed(samples[j].*fields[i].member, 2)
+                .appendLiteral(" ")
+                .append(fields[i].unit)
+                .appendLiteral("`");
+        }
+        JSON.appendLiteral("\", \"inline\": true}");
+    }
+    JSON.appendLiteral("]}], \"attachments\": []}");
+
+    // Return the length of the JSON (an embed that was cut off is not valid JSON, so don't send it)
+    return JSON.hasOverflowed() ? 0 : JSON.length();
+}
+
+/**
+ * Print the average time a message takes on a new connection and on a reused one, and the amount of dropped measurements.
  */
-string DM_WebhookConnector::embedBuilder(float temperatureC, float lightIntensityLux, float airPressureBar)
+void DM_WebhookConnector::printStatistics()
 {
-    return "{\"content\": null, \"embeds\": [{\"description\": \"**NEW MEASUREMENT**\", \"color\": 4176032, \"fields\": [{\"name\": \"Temperature\", \"value\": \"`" + std::to_string(temperatureC) + " °C`\", \"inline\": true}, {\"name\": \"Light intensity\", \"value\": \"`" + std::to_string(lightIntensityLux) + " lux`\", \"inline\": true}, {\"name\": \"Air pressure\", \"value\": \"`" + std::to_string(airPressureBar) + " Pa`\", \"inline\": true}]}], \"attachments\": []}";
+    DM_LOG_INFO("DM_Discord", "Average per message: %lu ms on a new connection (%lux), %lu ms on a reused connection (%lux).",
+                (unsigned long)(DM_WebhookConnector::_amountOfNewConnections > 0 ? DM_WebhookConnector::_newConnectionLatencyMs / DM_WebhookConnector::_amountOfNewConnections : 0), (unsigned long)DM_WebhookConnector::_amountOfNewConnections,
+                (unsigned long)(DM_WebhookConnector::_amountOfReusedConnections > 0 ? DM_WebhookConnector::_reusedConnectionLatencyMs / DM_WebhookConnector::_amountOfReusedConnections : 0), (unsigned long)DM_WebhookConnector::_amountOfReusedConnections);
 }
\ No newline at end of file
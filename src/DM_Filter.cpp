@@ -0,0 +1,258 @@
+/** +----------------------------------------------+
+ *  |        DM_Filter - Outlier rejection         |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "DM_Filter.h"   // Include the header file where the declarations for this library are stored
+#include <math.h>        // Used to take the distance to the rolling median ("fabsf()", "fmaxf()") and to round to the fixed point ("lroundf()")
+#include <string.h>      // Used to copy the window to and from a saved state
+#include <DM_Profiler.h> // Include the self-made library that measures the time one burst takes
+
+// OTHER VARIABLES (the sorting networks: the pairs of places that are compared and swapped, one network per amount of readings)
+const uint8_t sortingNetwork2[][2] = {{0, 1}};
+const uint8_t sortingNetwork3[][2] = {{0, 1}, {1, 2}, {0, 1}};
+const uint8_t sortingNetwork4[][2] = {{0, 1}, {2, 3}, {0, 2}, {1, 3}, {1, 2}};
+const uint8_t sortingNetwork5[][2] = {{0, 1}, {3, 4}, {2, 4}, {2, 3}, {0, 3}, {0, 2}, {1, 4}, {1, 3}, {1, 2}};
+const uint8_t sortingNetwork6[][2] = {{1, 2}, {4, 5}, {0, 2}, {3, 5}, {0, 1}, {3, 4}, {2, 5}, {0, 3}, {1, 4}, {2, 4}, {1, 3}, {2, 3}};
+const uint8_t sortingNetwork7[][2] = {{1, 2}, {3, 4}, {5, 6}, {0, 2}, {3, 5}, {4, 6}, {0, 1}, {4, 5}, {2, 6}, {0, 4}, {1, 5}, {0, 3}, {2, 5}, {1, 3}, {2, 4}, {2, 3}};
+const struct
+{
+    const uint8_t (*pairs)[2]; // The pairs of the network
+    uint8_t amountOfPairs;     // The amount of pairs
+} sortingNetworks[DM_Filter::maxBurstSize + 1] = {
+    {nullptr, 0},
+    {nullptr, 0},
+    {sortingNetwork2, sizeof(sortingNetwork2) / sizeof(sortingNetwork2[0])},
+    {sortingNetwork3, sizeof(sortingNetwork3) / sizeof(sortingNetwork3[0])},
+    {sortingNetwork4, sizeof(sortingNetwork4) / sizeof(sortingNetwork4[0])},
+    {sortingNetwork5, sizeof(sortingNetwork5) / sizeof(sortingNetwork5[0])},
+    {sortingNetwork6, sizeof(sortingNetwork6) / sizeof(sortingNetwork6[0])},
+    {sortingNetwork7, sizeof(sortingNetwork7) / sizeof(sortingNetwork7[0])},
+};
+const float MADToStandardDeviation = 1.4826; // The MAD of normally distributed readings times this is their standard deviation
+const uint32_t filterStateMagic = 0x444D4601; // The value of "magic" for a saved state
+
+/**
+ * Create a filter.
+ *
+ * @param resolution The value of one step of the moving average (e.g. 0.01 for °C), the value divided by the resolution has to stay below 2^21.
+ * @param EMAShift The weight of a new reading in the moving average as a power of two, e.g. 2 for 1/4 (0 turns the moving average off).
+ * @param spikeThreshold The distance from the rolling median (in scaled MADs) above which a burst is a spike (0 turns the spike check off).
+ * @param minimumDeviation The lowest scaled MAD that is used, in the unit of the value (keeps a steady value from flagging every small change).
+ * @param minimumRelativeDeviation The lowest scaled MAD that is used, as a part of the rolling median (e.g. 0.05 for 5 %, 0 to only use "minimumDeviation").
+ */
+DM_Filter::DM_Filter(float resolution, uint8_t EMAShift, float spikeThreshold, float minimumDeviation, float minimumRelativeDeviation)
+    : _resolution(resolution), _EMAShift(EMAShift), _spikeThreshold(spikeThreshold), _minimumDeviation(minimumDeviation), _minimumRelativeDeviation(minimumRelativeDeviation), _amountOfSpikes(0)
+{
+    clear();
+}
+
+/**
+ * Add one reading to the running burst (invalid readings and readings beyond "maxBurstSize" are ignored).
+ *
+ * @param reading The reading to add.
+ */
+void DM_Filter::addReading(float reading)
+{
+    if (!isnan(reading) && _burstLength < maxBurstSize)
+        _burst[_burstLength++] = reading;
+}
+
+/**
+ * Turn the running burst into one reading (the median, checked for a spike and smoothed) and start a new burst.
+ *
+ * @return The filtered reading, or NAN if the burst didn't hold a single valid reading.
+ */
+float DM_Filter::filterBurst()
+{
+    // Measure the time the burst takes
+    DM_PROFILE_SCOPE(DM_STAGE_FILTER);
+
+    // Nothing to filter if every reading of the burst failed
+    _lastWasSpike = false;
+    if (_burstLength == 0)
+        return NAN;
+
+    // Take the median of the burst (this removes a glitch within the burst)
+    float burstMedian = median(_burst, _burstLength);
+    float value = burstMedian;
+    _burstLength = 0;
+    _lastMedian = burstMedian;
+
+    // Compare the median with the rolling median of the last bursts, and replace it if it lies too far out (this removes a glitch that lasts the whole burst)
+    if (_spikeThreshold > 0 && _windowLength >= minimumWindowSize)
+    {
+        float sorted[windowSize];
+        for (uint8_t i = 0; i < _windowLength; i++)
+            sorted[i] = _window[i];
+        float rollingMedian = median(sorted, _windowLength);
+        for (uint8_t i = 0; i < _windowLength; i++)
+            sorted[i] = fabsf(_window[i] - rollingMedian);
+        float deviation = median(sorted, _windowLength) * MADToStandardDeviation;
+        float minimumDeviation = fmaxf(_minimumDeviation, _minimumRelativeDeviation * fabsf(rollingMedian));
+        deviation = deviation > minimumDeviation ? deviation : minimumDeviation;
+        if (fabsf(burstMedian - rollingMedian) > _spikeThreshold * deviation)
+        {
+            value = rollingMedian;
+            _lastWasSpike = true;
+            _amountOfSpikes++;
+        }
+    }
+
+    // Keep the median in the window (also a spike, so a real step is accepted once it fills half of the window)
+    _window[_windowIndex] = burstMedian;
+    _windowIndex = (_windowIndex + 1) % windowSize;
+    if (_windowLength < windowSize)
+        _windowLength++;
+
+    // Smooth the reading with the moving average (in fixed point: a step of the resolution is "1 << EMAFractionBits")
+    if (_EMAShift == 0)
+        return value;
+    int32_t fixedPoint = _toFixedPoint(value);
+    if (!_EMAStarted)
+    {
+        _EMA = fixedPoint;
+        _EMAStarted = true;
+    }
+    else
+        _EMA += (fixedPoint - _EMA) / (1 << _EMAShift);
+    return _EMA * _resolution / (1 << EMAFractionBits);
+}
+
+/**
+ * Forget the running burst, the window and the moving average (the amount of spikes is kept).
+ */
+void DM_Filter::clear()
+{
+    _burstLength = 0;
+    _windowLength = 0;
+    _windowIndex = 0;
+    _EMA = 0;
+    _EMAStarted = false;
+    _lastWasSpike = false;
+    _lastMedian = NAN;
+}
+
+/**
+ * Copy what the filter remembers from the bursts before (the window, the moving average and the amount of spikes), e.g. to RTC memory before a deep sleep.
+ *
+ * @param state The state to copy to.
+ */
+void DM_Filter::saveState(DM_FilterState &state) const
+{
+    state.magic = filterStateMagic;
+    memcpy(state.window, _window, sizeof(_window));
+    state.windowLength = _windowLength;
+    state.windowIndex = _windowIndex;
+    state.EMAStarted = _EMAStarted;
+    state.EMA = _EMA;
+    state.amountOfSpikes = _amountOfSpikes;
+}
+
+/**
+ * Continue from a state saved by "saveState()" (the running burst is dropped).
+ *
+ * @param state The saved state.
+ *
+ * @return False if the state was never saved (the filter is cleared, as after a cold boot).
+ */
+bool DM_Filter::restoreState(const DM_FilterState &state)
+{
+    clear();
+    if (state.magic != filterStateMagic || state.windowLength > windowSize || state.windowIndex >= windowSize)
+        return false;
+    memcpy(_window, state.window, sizeof(_window));
+    _windowLength = state.windowLength;
+    _windowIndex = state.windowIndex;
+    _EMAStarted = state.EMAStarted;
+    _EMA = state.EMA;
+    _amountOfSpikes = state.amountOfSpikes;
+    return true;
+}
+
+/**
+ * Check if the last burst was flagged as a spike (its reading was replaced by the rolling median).
+ *
+ * @return True if the last burst was a spike.
+ */
+bool DM_Filter::wasSpike() const
+{
+    return _lastWasSpike;
+}
+
+/**
+ * Get the median of the last burst, before the spike check and the moving average (used to show what was rejected).
+ *
+ * @return The median of the last burst (NAN before the first burst).
+ */
+float DM_Filter::getLastMedian() const
+{
+    return _lastMedian;
+}
+
+/**
+ * Get the amount of bursts that were flagged as a spike since the start.
+ *
+ * @return The amount of spikes.
+ */
+uint32_t DM_Filter::getAmountOfSpikes() const
+{
+    return _amountOfSpikes;
+}
+
+/**
+ * Take the median of a few values (the values are sorted in place): up to "maxBurstSize" values with a sorting network, more with an insertion sort (at most "windowSize" values are passed in).
+ *
+ * @param values The values (sorted afterwards).
+ * @param amount The amount of values.
+ *
+ * @return The median (the average of the middle two for an even amount), or NAN if there are no values.
+ */
+float DM_Filter::median(float *values, uint8_t amount)
+{
+    // Sort the values
+    if (amount <= maxBurstSize)
+    {
+        for (uint8_t i = 0; i < sortingNetworks[amount].amountOfPairs; i++)
+        {
+            float &low = values[sortingNetworks[amount].pairs[i][0]];
+            float &high = values[sortingNetworks[amount].pairs[i][1]];
+            float smallest = low < high ? low : high;
+            high = low < high ? high : low;
+            low = smallest;
+        }
+    }
+    else
+    {
+        for (uint8_t i = 1; i < amount; i++)
+        {
+            float value = values[i];
+            uint8_t j = i;
+            for (; j > 0 && values[j - 1] > value; j--)
+                values[j] = values[j - 1];
+            values[j] = value;
+        }
+    }
+
+    // Take the middle value
+    if (amount == 0)
+        return NAN;
+    return amount % 2 == 1 ? values[amount / 2] : (values[amount / 2 - 1] + values[amount / 2]) / 2;
+}
+
+/**
+ * Turn a value into a step count of the moving average (limited, so the difference of two of them always fits in 32 bits).
+ *
+ * @param value The value.
+ *
+ * @return The value in steps of the resolution, with "EMAFractionBits" more bits.
+ */
+int32_t DM_Filter::_toFixedPoint(float value) const
+{
+    const float limit = (float)(1 << 29);
+    float scaled = value / _resolution * (1 << EMAFractionBits);
+    return (int32_t)lroundf(scaled < -limit ? -limit : (scaled > limit ? limit : scaled));
+}
\ No newline at end of file
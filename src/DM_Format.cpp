@@ -0,0 +1,214 @@
+/** +----------------------------------------------+
+ *  |    DM_Format - Allocation-free formatting    |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "DM_Format.h" // Include the header file where the declarations for this library are stored
+#include <string.h>    // Used to copy text into the buffer
+
+// OTHER VARIABLES
+const uint32_t powersOfTen[] = {1, 10, 100, 1000, 10000, 100000, 1000000}; // Used to scale a number to the amount of decimals (at most 6)
+
+/**
+ * Create a formatter that writes into the given buffer (the formatter never allocates memory).
+ *
+ * @param buffer The buffer to write into.
+ * @param capacity The size of the buffer (including the closing zero).
+ */
+DM_Formatter::DM_Formatter(char *buffer, size_t capacity) : _buffer(buffer), _capacity(capacity), _length(0), _overflowed(false)
+{
+    // Start with an empty text
+    clear();
+}
+
+/**
+ * Empty the buffer, so it can be reused for the next payload.
+ */
+void DM_Formatter::clear()
+{
+    _length = 0;
+    _overflowed = false;
+    if (_capacity > 0)
+        _buffer[0] = '\0';
+}
+
+/**
+ * Append a zero-terminated text.
+ *
+ * @param text The text to append.
+ *
+ * @return The formatter itself, so calls can be chained.
+ */
+DM_Formatter &DM_Formatter::append(const char *text)
+{
+    return append(text, strlen(text));
+}
+
+/**
+ * Append a text of which the length is known (whatever doesn't fit is cut off and marks the formatter as overflowed).
+ *
+ * @param text The text to append.
+ * @param length The length of the text.
+ *
+ * @return The formatter itself, so calls can be chained.
+ */
+DM_Formatter &DM_Formatter::append(const char *text, size_t length)
+{
+    // Cut the text off if it doesn't fit (keep one byte for the closing zero)
+    if (_capacity == 0 || _length + length > _capacity - 1)
+    {
+        _overflowed = true;
+        length = _capacity == 0 ? 0 : _capacity - 1 - _length;
+    }
+
+    // Copy the text and close it with a zero
+    memcpy(_buffer + _length, text, length);
+    _length += length;
+    if (_capacity > 0)
+        _buffer[_length] = '\0';
+
+    // Return the formatter itself
+    return *this;
+}
+
+/**
+ * Append a positive whole number.
+ *
+ * @param number The number to append.
+ *
+ * @return The formatter itself, so calls can be chained.
+ */
+DM_Formatter &DM_Formatter::appendUnsigned(uint32_t number)
+{
+    // Write the digits from right to left into a small buffer (a 32-bit number has at most 10 digits)
+    char digits[10];
+    size_t position = sizeof(digits);
+    do
+    {
+        digits[--position] = '0' + number % 10;
+        number /= 10;
+    } while (number > 0);
+
+    // Append the digits
+    return append(digits + position, sizeof(digits) - position);
+}
+
+/**
+ * Append a whole number (which can be negative).
+ *
+ * @param number The number to append.
+ *
+ * @return The formatter itself, so calls can be chained.
+ */
+DM_Formatter &DM_Formatter::appendInteger(int32_t number)
+{
+    // Write the sign first and then the digits of the absolute value (calculated in 32 bits without a sign, so the lowest value also works)
+    if (number < 0)
+    {
+        append("-", 1);
+        return appendUnsigned(0u - (uint32_t)number);
+    }
+    return appendUnsigned((uint32_t)number);
+}
+
+/**
+ * Append a decimal number with a fixed amount of decimals, rounded to the nearest value (halves are rounded away from zero).
+ * This works on whole numbers only, so it is a lot faster than printf() and doesn't allocate anything.
+ *
+ * @param number The number to append.
+ * @param decimals The amount of decimals (at most 6).
+ *
+ * @return The formatter itself, so calls can be chained.
+ */
+DM_Formatter &DM_Formatter::appendFixed(float number, uint8_t decimals)
+{
+    // Take the number apart (IEEE 754: the sign, 8 bits of exponent and 23 bits of mantissa), so the value is "mantissa × 2^exponent"
+    uint32_t bits;
+    memcpy(&bits, &number, sizeof(bits));
+    bool negative = (bits >> 31) != 0;
+    int32_t exponent = (bits >> 23) & 0xFF;
+    uint64_t mantissa = bits & 0x7FFFFF;
+
+    // A number that can't be written (NaN and infinity) becomes "null" (so the JSON stays valid)
+    if (exponent == 0xFF)
+        return appendLiteral("null");
+    if (exponent == 0)
+        exponent = 1;
+    else
+        mantissa |= 0x800000;
+    exponent -= 127 + 23;
+
+    // Scale the number to a whole number of the smallest unit (e.g. hundredths) and round it (below 2^44 before the shift, so nothing overflows)
+    if (decimals > 6)
+        decimals = 6;
+    uint64_t scaled = mantissa * powersOfTen[decimals];
+    uint64_t units;
+    if (exponent > 19)
+        return appendLiteral("null"); // At least 2^43, far more than a whole part of 32 bits
+    else if (exponent >= 0)
+        units = scaled << exponent;
+    else if (exponent > -64)
+        units = (scaled + (1ull << (-exponent - 1))) >> -exponent;
+    else
+        units = 0;
+
+    // Numbers with a whole part beyond 32 bits are not something a sensor measures, write them as "null" as well (checked before the sign, so no "-null" is written)
+    uint64_t wholePart = units / powersOfTen[decimals];
+    uint32_t fractionalPart = units % powersOfTen[decimals];
+    if (wholePart > 0xFFFFFFFF)
+        return appendLiteral("null");
+
+    // Write the sign (but not for a value that rounds to zero) and the whole part
+    if (negative && units != 0)
+        append("-", 1);
+    appendUnsigned((uint32_t)wholePart);
+
+    // Write the decimals (with the leading zeros)
+    if (decimals > 0)
+    {
+        char digits[7];
+        digits[0] = '.';
+        for (uint8_t i = decimals; i > 0; i--)
+        {
+            digits[i] = '0' + fractionalPart % 10;
+            fractionalPart /= 10;
+        }
+        append(digits, decimals + 1);
+    }
+
+    // Return the formatter itself
+    return *this;
+}
+
+/**
+ * Get the text that has been written.
+ *
+ * @return The zero-terminated text.
+ */
+const char *DM_Formatter::c_str() const
+{
+    return _buffer;
+}
+
+/**
+ * Get the length of the text that has been written.
+ *
+ * @return The length (without the closing zero).
+ */
+size_t DM_Formatter::length() const
+{
+    return _length;
+}
+
+/**
+ * Check if something did not fit in the buffer.
+ *
+ * @return True if the text has been cut off.
+ */
+bool DM_Formatter::hasOverflowed() const
+{
+    return _overflowed;
+}
\ No newline at end of file
@@ -0,0 +1,190 @@
+/** +----------------------------------------------+
+ *  |     DM_History - Compact sample history      |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "Arduino.h"       // Include the Arduino library
+#include "DM_History.h"    // Include the header file where the declarations for this library are stored
+#include <esp_heap_caps.h> // Used to check if the external RAM (PSRAM) can hold the history, and to use it when it can
+#include <DM_Log.h>        // Include the self-made library that prints the status messages without waiting for the serial port
+
+/**
+ * Create an empty history (it can't hold anything before "begin()" is called).
+ */
+DM_History::DM_History()
+    : _timestampsMs(nullptr), _airPressures(nullptr), _temperatures(nullptr), _lightIntensities(nullptr), _capacity(0), _next(0), _amount(0)
+{
+}
+
+/**
+ * Reserve the memory for the history, with a fixed capacity for each kind of memory: the external RAM is used when the board has enough of it, otherwise the internal memory.
+ * The capacity is never taken from the free memory at boot: the Wi-Fi stack, TLS and the tasks only take their memory later, and would be left without it.
+ *
+ * @param externalCapacity The amount of samples the history holds in the external RAM (e.g. a day of samples taken every second: 86400 samples, about 1 MB).
+ * @param internalCapacity The amount of samples the history holds in the internal memory when there is no (or not enough) external RAM.
+ *
+ * @return The amount of samples the history can hold (0 if the memory could not be reserved).
+ */
+size_t DM_History::begin(size_t externalCapacity, size_t internalCapacity)
+{
+    // Use the external RAM if it can hold the whole history, otherwise the internal memory
+    uint32_t capabilities = heap_caps_get_free_size(MALLOC_CAP_SPIRAM) >= externalCapacity * sizeof(DM_PackedSample) ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT;
+    size_t capacity = capabilities == MALLOC_CAP_SPIRAM ? externalCapacity : internalCapacity;
+
+    // Reserve one array per value
+    _timestampsMs = (uint32_t *)heap_caps_malloc(capacity * sizeof(uint32_t), capabilities);
+    _airPressures = (uint32_t *)heap_caps_malloc(capacity * sizeof(uint32_t), capabilities);
+    _temperatures = (int16_t *)heap_caps_malloc(capacity * sizeof(int16_t), capabilities);
+    _lightIntensities = (uint16_t *)heap_caps_malloc(capacity * sizeof(uint16_t), capabilities);
+    if (capacity == 0 || !_timestampsMs || !_airPressures || !_temperatures || !_lightIntensities)
+    {
+        // Give back what was reserved and keep no history
+        heap_caps_free(_timestampsMs);
+        heap_caps_free(_airPressures);
+        heap_caps_free(_temperatures);
+        heap_caps_free(_lightIntensities);
+        _timestampsMs = nullptr;
+        _airPressures = nullptr;
+        _temperatures = nullptr;
+        _lightIntensities = nullptr;
+        capacity = 0;
+        DM_LOG_ERROR("DM_History", "There is not enough memory for the history.");
+    }
+    _capacity = capacity;
+
+    // Inform the user
+    DM_LOG_INFO("DM_History", "Room for %lu samples (%lu KB of %s).", (unsigned long)_capacity, (unsigned long)(_capacity * sizeof(DM_PackedSample) / 1024), capabilities == MALLOC_CAP_SPIRAM ? "external RAM" : "internal memory");
+
+    // Return the capacity
+    return _capacity;
+}
+
+/**
+ * Add a sample to the history (the oldest sample is overwritten when the history is full).
+ *
+ * @param sample The sample to add.
+ */
+void DM_History::push(const DM_Sample &sample)
+{
+    // Nothing to do without memory
+    if (_capacity == 0)
+        return;
+
+    // Pack the sample before taking the lock, so the lock is held as short as possible
+    DM_PackedSample packed = DM_PackedSample::pack(sample);
+
+    // Write every value to its own array
+    portENTER_CRITICAL(&_lock);
+    _timestampsMs[_next] = packed.timestampMs;
+    _airPressures[_next] = packed.airPressure;
+    _temperatures[_next] = packed.temperature;
+    _lightIntensities[_next] = packed.lightIntensity;
+    _next = (_next + 1) % _capacity;
+    _amount = min(_amount + 1, _capacity);
+    portEXIT_CRITICAL(&_lock);
+}
+
+/**
+ * Read a sample from the history.
+ *
+ * @param index The position of the sample (0 is the oldest one).
+ * @param sample The variable the sample will be copied into (in display units).
+ *
+ * @return False if there is no sample at this position.
+ */
+bool DM_History::get(size_t index, DM_Sample &sample)
+{
+    // Copy the packed values while holding the lock
+    DM_PackedSample packed;
+    portENTER_CRITICAL(&_lock);
+    bool found = index < _amount;
+    if (found)
+    {
+        size_t slot = (_next + _capacity - _amount + index) % _capacity;
+        packed.timestampMs = _timestampsMs[slot];
+        packed.airPressure = _airPressures[slot];
+        packed.temperature = _temperatures[slot];
+        packed.lightIntensity = _lightIntensities[slot];
+    }
+    portEXIT_CRITICAL(&_lock);
+
+    // Convert the values to display units
+    if (found)
+        sample = DM_PackedSample::unpack(packed);
+
+    // Return if the sample was found
+    return found;
+}
+
+/**
+ * Find the oldest sample that was taken at or after a moment (a binary search, the samples are stored in the order they were taken).
+ * Looking up a moment instead of keeping an index is what lets a reader continue where it stopped, while new samples push the old ones out.
+ *
+ * @param timestampMs The moment (in milliseconds since boot).
+ * @param sample The variable the sample will be copied into.
+ *
+ * @return False if no sample was taken at or after that moment.
+ */
+bool DM_History::findFirst(uint32_t timestampMs, DM_Sample &sample)
+{
+    // Search while holding the lock (at most 17 steps for a day of samples), the times are compared relative to the oldest sample so the search survives the overflow of "millis()"
+    DM_PackedSample packed;
+    portENTER_CRITICAL(&_lock);
+    size_t oldestSlot = _amount > 0 ? (_next + _capacity - _amount) % _capacity : 0;
+    uint32_t oldestMs = _amount > 0 ? _timestampsMs[oldestSlot] : 0;
+    uint32_t wanted = timestampMs - oldestMs;
+    if ((int32_t)wanted < 0)
+        wanted = 0;
+    size_t low = 0, high = _amount;
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+        if (_timestampsMs[(oldestSlot + middle) % _capacity] - oldestMs < wanted)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    bool found = low < _amount;
+    if (found)
+    {
+        size_t slot = (oldestSlot + low) % _capacity;
+        packed.timestampMs = _timestampsMs[slot];
+        packed.airPressure = _airPressures[slot];
+        packed.temperature = _temperatures[slot];
+        packed.lightIntensity = _lightIntensities[slot];
+    }
+    portEXIT_CRITICAL(&_lock);
+
+    // Convert the values to display units
+    if (found)
+        sample = DM_PackedSample::unpack(packed);
+
+    // Return if a sample was found
+    return found;
+}
+
+/**
+ * Get the amount of samples in the history.
+ *
+ * @return The amount of samples.
+ */
+size_t DM_History::getAmount()
+{
+    portENTER_CRITICAL(&_lock);
+    size_t amount = _amount;
+    portEXIT_CRITICAL(&_lock);
+    return amount;
+}
+
+/**
+ * Get the amount of samples the history can hold.
+ *
+ * @return The capacity of the history.
+ */
+size_t DM_History::getCapacity()
+{
+    return _capacity;
+}
\ No newline at end of file
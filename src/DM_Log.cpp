@@ -0,0 +1,133 @@
+/** +----------------------------------------------+
+ *  |        DM_Log - Asynchronous logging         |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "Arduino.h"     // Include the Arduino library
+#include "DM_Log.h"      // Include the header file where the declarations for this library are stored
+#include <stdarg.h>      // Used to pass the arguments of a message on to the formatter
+#include <stdio.h>       // Used to format the messages ("vsnprintf()")
+#include <DM_Profiler.h> // Include the self-made library that measures how long the serial port takes per message
+
+// INITIALIZE THE CLASS MEMBERS (if we don't do this, the code will give errors saying these should be initialised first)
+DM_MPSCRingBuffer<DM_LogEntry, DM_Log::queueCapacity> DM_Log::_queue; // The messages that are waiting to be printed
+TaskHandle_t DM_Log::_taskHandle = NULL;                              // The handle of the printing task (NULL as long as it isn't started)
+uint32_t DM_Log::_reportedDrops = 0;                                  // The amount of dropped messages the printing task already reported
+
+// OTHER VARIABLES
+const char *const levelPrefixes[] = {"", "ERROR: ", "WARNING: ", "", ""}; // The text in front of a message of every log level
+
+/**
+ * Start the task that prints the messages (call this right after "Serial.begin()").
+ *
+ * @param core The core to run the task on.
+ * @param priority The priority of the task (keep it low: printing is never more important than measuring or sending).
+ *
+ * @return The success rate of starting the task.
+ */
+bool DM_Log::begin(BaseType_t core, UBaseType_t priority)
+{
+    if (xTaskCreatePinnedToCore(DM_Log::_task, "DM_Log", 3072, NULL, priority, &DM_Log::_taskHandle, core) == pdPASS)
+        return true;
+    DM_Log::_taskHandle = NULL;
+    return false;
+}
+
+/**
+ * Format a message into the queue (use the "DM_LOG_..." macros instead, so the messages above the log level are left out of the build). This never waits for the serial port.
+ *
+ * @param level The log level of the message.
+ * @param tag The module that logs the message (a string literal, it is printed between square brackets), or nullptr for a message without prefix.
+ * @param format The message, with the same placeholders as "printf()".
+ */
+void DM_Log::write(uint8_t level, const char *tag, const char *format, ...)
+{
+    // Format the message straight into a free slot (if there is none, the message is dropped and counted by the queue)
+    va_list arguments;
+    va_start(arguments, format);
+    DM_Log::_queue.push([&](DM_LogEntry &entry)
+                        {
+                            entry.tag = tag;
+                            entry.level = level;
+                            vsnprintf(entry.text, sizeof(entry.text), format, arguments); });
+    va_end(arguments);
+}
+
+/**
+ * Wait until every message that has been logged so far is printed (e.g. before a deep sleep). Without the printing task, the messages are printed by the caller.
+ */
+void DM_Log::flush()
+{
+    if (DM_Log::_taskHandle == NULL)
+    {
+        while (DM_Log::_printNext())
+        {
+        }
+    }
+    else
+    {
+        while (DM_Log::_queue.getDepth() > 0)
+            vTaskDelay(pdMS_TO_TICKS(DM_Log::drainPeriodMs));
+    }
+    Serial.flush();
+}
+
+/**
+ * Get the amount of messages that were dropped because the queue was full.
+ *
+ * @return The amount of dropped messages since the boot.
+ */
+uint32_t DM_Log::getAmountOfDroppedMessages()
+{
+    return DM_Log::_queue.getOverruns();
+}
+
+/**
+ * Print the queue, and sleep a little while when it is empty (runs forever in the printing task).
+ *
+ * @param parameters Unused (required by FreeRTOS).
+ */
+void DM_Log::_task(void *parameters)
+{
+    for (;;)
+    {
+        // Print every waiting message (the serial port makes this task wait while its buffer is full, which is fine at a low priority)
+        while (DM_Log::_printNext())
+        {
+        }
+
+        // Tell the user how many messages were lost since the last time
+        uint32_t drops = DM_Log::_queue.getOverruns();
+        if (drops != DM_Log::_reportedDrops)
+        {
+            Serial.print("[DM_Log] ");
+            Serial.print(drops - DM_Log::_reportedDrops);
+            Serial.println(" message(s) dropped because the log queue was full.");
+            DM_Log::_reportedDrops = drops;
+        }
+        vTaskDelay(pdMS_TO_TICKS(DM_Log::drainPeriodMs));
+    }
+}
+
+/**
+ * Print the oldest message in the queue (only called by one task at a time: the printing task, or the caller of flush() when that task doesn't exist).
+ *
+ * @return False if there was nothing to print.
+ */
+bool DM_Log::_printNext()
+{
+    return DM_Log::_queue.pop([](const DM_LogEntry &entry)
+                              {
+                                  DM_PROFILE_SCOPE(DM_STAGE_SERIAL_PRINT);
+                                  if (entry.tag != nullptr)
+                                  {
+                                      Serial.print("[");
+                                      Serial.print(entry.tag);
+                                      Serial.print("] ");
+                                  }
+                                  Serial.print(levelPrefixes[entry.level]);
+                                  Serial.println(entry.text); });
+}
\ No newline at end of file
@@ -10,10 +10,39 @@
 #include "DM_Measurer.h"     // Include the header file where the declarations for this library are stored
 #include <BH1750.h>          // Used to create an object based on the class defined in this library
 #include <Adafruit_BMP280.h> // Used to create an object based on the class defined in this library
-#include <DM_Utils.h>        // Include the self-made library that contains the rounding function
+#include <Wire.h>            // Used to talk to the BMP280 and BH1750 chips directly over the I2C bus
+#include <DM_Profiler.h>     // Used to measure the latency of the I2C transactions
+#include <DM_Log.h>          // Include the self-made library that prints the status messages without waiting for the serial port
 
-// INITIALIZE THE CLASS MEMBERS (if we don't do this, the code will give errors saying these should be initialised first)
-Adafruit_BMP280 DM_Measurer::_BMP280Chip; // The BMP280 chip
+// INITIALIZE THE CLASS MEMBERS (if we don't do this, the code will give errors saying these should be initialised first, the ones in RTC memory are kept during deep sleep)
+RTC_DATA_ATTR DM_BMP280Calibration DM_Measurer::_BMP280Calibration; // The factory calibration of the BMP280 chip
+RTC_DATA_ATTR bool DM_Measurer::_BMP280calibrationRead = false;     // If the calibration has been read from the chip (it never changes, so it is only read on the first boot)
+uint8_t DM_Measurer::_i2cTransactions = 0;                          // The amount of I2C transactions of the current measurement
+uint32_t DM_Measurer::_i2cBusTimeUs = 0;                            // The time spent on the I2C bus during the current measurement
+uint32_t DM_Measurer::_BMP280conversionStartMs = 0;                 // The moment the last BMP280 measurement was started
+RTC_DATA_ATTR uint8_t DM_Measurer::_BH1750MTreg = 69;               // The measurement time register of the BH1750 that the auto-ranging wants for the next conversion (69 is the default)
+uint8_t DM_Measurer::_BH1750appliedMTreg = 69;                      // The measurement time register that is currently set in the BH1750 (0 if it is not known)
+uint32_t DM_Measurer::_BH1750conversionStartMs = 0;                 // The moment the last BH1750 conversion was started
+
+// OTHER VARIABLES
+const uint8_t BMP280Address = 0x76;                                         // The I2C address of the BMP280 chip
+const uint8_t BMP280CalibrationRegister = 0x88;                             // The first of the 24 calibration registers
+const uint8_t BMP280StatusRegister = 0xF3;                                  // The status register (bit 3 is set while a conversion is running)
+const uint8_t BMP280ControlRegister = 0xF4;                                 // The register that holds the oversampling settings and the mode
+const uint8_t BMP280DataRegister = 0xF7;                                    // The first of the 6 data registers (3 bytes pressure, then 3 bytes temperature)
+const uint8_t BMP280ForcedMeasurement = (0b010 << 5) | (0b101 << 2) | 0b01; // Temperature oversampling x2, pressure oversampling x16, forced mode
+const uint32_t BMP280ConversionTimeMs = 44;                                 // The longest time a conversion with these oversampling settings takes (1.25 + 2.3 × 2 + 2.3 × 16 + 0.575 ms, rounded up)
+const uint8_t BH1750Address = 0x23;                                         // The I2C address of the BH1750 chip (ADDR pin to ground)
+const uint8_t BH1750OneTimeHighResMode = 0x20;                              // The opcode that starts one conversion in high resolution mode (the chip powers down by itself afterwards)
+const uint8_t BH1750MTregHighBits = 0b01000 << 3;                           // The opcode that sets the upper 3 bits of the measurement time register (in its lowest 3 bits)
+const uint8_t BH1750MTregLowBits = 0b011 << 5;                              // The opcode that sets the lower 5 bits of the measurement time register (in its lowest 5 bits)
+const uint8_t BH1750DefaultMTreg = 69;                                      // The measurement time register after a power-on
+const uint32_t BH1750ConversionTimeMs = 180;                                // The longest time a conversion in high resolution mode takes with the default measurement time (it grows with the register)
+const uint8_t BH1750MinimumMTreg = 31;                                      // The lowest measurement time register the BH1750 accepts (shortest conversion, highest range)
+const uint8_t BH1750MaximumMTreg = 254;                                     // The highest measurement time register the BH1750 accepts (longest conversion, best resolution in the dark)
+const uint16_t BH1750LowCounts = 1000;                                      // Below this raw value the resolution gets poor, so the measurement time is made longer
+const uint16_t BH1750HighCounts = 50000;                                    // Above this raw value the sensor gets close to saturating (65535), so the measurement time is made shorter
+const uint16_t BH1750TargetCounts = 20000;                                  // The raw value the auto-ranging aims for when it changes the measurement time
 
 /**
  * Initialize the BH1750 light sensor.
@@ -24,13 +53,13 @@ Adafruit_BMP280 DM_Measurer::_BMP280Chip; // The BMP280 chip
  */
 bool DM_Measurer::initializeBH1750(BH1750 &measurementChip)
 {
-    // Initialize the light sensor in high resulution mode (this is default, so no parameters should be given)
-    bool success = measurementChip.begin();
+    // Initialize the light sensor in one-time high resolution mode (the sensor powers down by itself after every conversion, every measurement is started with "BH1750startConversion()")
+    bool success = measurementChip.begin(BH1750::ONE_TIME_HIGH_RES_MODE);
 
     // Return an error message if an error happened
     if (!success)
     {
-        Serial.println("\n[DM_Measurer] ERROR: An error occured while initializing the BH1750 sensor.");
+        DM_LOG_ERROR("DM_Measurer", "An error occured while initializing the BH1750 sensor.");
     }
 
     // Return the success rate
@@ -46,9 +75,6 @@ bool DM_Measurer::initializeBH1750(BH1750 &measurementChip)
  */
 bool DM_Measurer::initializeBMP280(Adafruit_BMP280 &measurementChip)
 {
-    // Print an empty line
-    Serial.println();
-
     // Initialize the BMP280 sensor on the I2C address bus "76"
     bool success = measurementChip.begin(0x76);
 
@@ -56,28 +82,70 @@ bool DM_Measurer::initializeBMP280(Adafruit_BMP280 &measurementChip)
     if (!success)
     {
         // Print an error message
-        Serial.println("[DM_Measurer] ERROR: A valid BMP280 sensor could not be found. Please check the wiring...");
+        DM_LOG_ERROR("DM_Measurer", "A valid BMP280 sensor could not be found. Please check the wiring...");
     }
     else
     {
         // Print a success message
-        Serial.println("[DM_Measurer] A valid BMP280 sensor was found!");
+        DM_LOG_INFO("DM_Measurer", "A valid BMP280 sensor was found!");
 
         // Set what data the BMP280 chip should read
-        measurementChip.setSampling(Adafruit_BMP280::MODE_NORMAL,     // We use "normal" for the operation mode because we want the sensor to automatically switch between a measurement and being standby (this is good for filtering distrubances.)
-                                    Adafruit_BMP280::SAMPLING_X2,     // We set the sampling rate for temperature measurements to 2, what means that we read each value twice and the average of those two values will be the measurement.
-                                    Adafruit_BMP280::SAMPLING_X16,    // We set the sampling rate for pressure measurements to 16, what means that we read each value 16 times and the average of those two values will be the measurement.
-                                    Adafruit_BMP280::FILTER_X16,      //
-                                    Adafruit_BMP280::STANDBY_MS_500); // Set the standby time to a duration of 500 milliseconds
-
-        // Assign the initialized sensor to the class member
-        DM_Measurer::_BMP280Chip = measurementChip;
+        measurementChip.setSampling(Adafruit_BMP280::MODE_SLEEP,    // We use "sleep" for the operation mode because we start every measurement ourselves ("forced" mode), so the chip sleeps between two measurements
+                                    Adafruit_BMP280::SAMPLING_X2,   // We set the sampling rate for temperature measurements to 2, what means that we read each value twice and the average of those two values will be the measurement.
+                                    Adafruit_BMP280::SAMPLING_X16,  // We set the sampling rate for pressure measurements to 16, what means that we read each value 16 times and the average of those two values will be the measurement.
+                                    Adafruit_BMP280::FILTER_OFF,    // The IIR filter is turned off, because with seconds between two forced measurements it would only make the values lag behind
+                                    Adafruit_BMP280::STANDBY_MS_1); // The standby time is only used in "normal" mode
+
+        // Read the factory calibration once (24 bytes in one burst), so every measurement can be calculated from the raw values
+        uint8_t calibration[24];
+        success = DM_Measurer::_BMP280readRegisters(BMP280CalibrationRegister, calibration, sizeof(calibration));
+        DM_Measurer::_BMP280Calibration.T1 = (uint16_t)(calibration[1] << 8 | calibration[0]);
+        DM_Measurer::_BMP280Calibration.T2 = (int16_t)(calibration[3] << 8 | calibration[2]);
+        DM_Measurer::_BMP280Calibration.T3 = (int16_t)(calibration[5] << 8 | calibration[4]);
+        DM_Measurer::_BMP280Calibration.P1 = (uint16_t)(calibration[7] << 8 | calibration[6]);
+        DM_Measurer::_BMP280Calibration.P2 = (int16_t)(calibration[9] << 8 | calibration[8]);
+        DM_Measurer::_BMP280Calibration.P3 = (int16_t)(calibration[11] << 8 | calibration[10]);
+        DM_Measurer::_BMP280Calibration.P4 = (int16_t)(calibration[13] << 8 | calibration[12]);
+        DM_Measurer::_BMP280Calibration.P5 = (int16_t)(calibration[15] << 8 | calibration[14]);
+        DM_Measurer::_BMP280Calibration.P6 = (int16_t)(calibration[17] << 8 | calibration[16]);
+        DM_Measurer::_BMP280Calibration.P7 = (int16_t)(calibration[19] << 8 | calibration[18]);
+        DM_Measurer::_BMP280Calibration.P8 = (int16_t)(calibration[21] << 8 | calibration[20]);
+        DM_Measurer::_BMP280Calibration.P9 = (int16_t)(calibration[23] << 8 | calibration[22]);
+
+        // Print an error message if the calibration could not be read
+        if (!success)
+            DM_LOG_ERROR("DM_Measurer", "The calibration of the BMP280 sensor could not be read.");
+        DM_Measurer::_BMP280calibrationRead = success;
     }
 
     // Return the success rate
     return success;
 }
 
+/**
+ * Get the BMP280 ready again after a deep sleep. The chip stays powered and keeps its settings, and the calibration is kept in RTC memory, so this doesn't use the I2C bus at all.
+ *
+ * @param measurementChip The BMP280 sensor object (only used if the chip has to be initialized completely).
+ *
+ * @return The success rate (the chip is initialized completely if the calibration was never read).
+ */
+bool DM_Measurer::resumeBMP280(Adafruit_BMP280 &measurementChip)
+{
+    return DM_Measurer::_BMP280calibrationRead || DM_Measurer::initializeBMP280(measurementChip);
+}
+
+/**
+ * Get the BH1750 ready again after a deep sleep. The chip stays powered, and every conversion is started with an opcode of its own, so this doesn't use the I2C bus at all.
+ * The auto-ranged measurement time is kept in RTC memory, the next conversion sets it again (the one in the chip isn't known anymore).
+ *
+ * @return The success rate.
+ */
+bool DM_Measurer::resumeBH1750()
+{
+    DM_Measurer::_BH1750appliedMTreg = 0;
+    return true;
+}
+
 /**
  * Convert a decimal value of pressure in Pascals to a decimal value of pressure in bars.
  *
@@ -87,47 +155,236 @@ bool DM_Measurer::initializeBMP280(Adafruit_BMP280 &measurementChip)
  */
 float DM_Measurer::_convertPaToBar(float decimalPa)
 {
-    return DM_Utils::roundTwoDecimals(decimalPa / 100000.0);
+    return decimalPa / 100000.0;
 };
 
 /**
- * Read the temperature from the BMP280 sensor and return it as a float.
+ * Let the BMP280 start one measurement ("forced" mode, the chip sleeps again afterwards). This returns right away, the result can be collected with "BMP280collectSnapshot()" once "BMP280isConversionReady()" says so.
  *
- * @return The temperature in Celsius.
+ * @return The success rate of starting the measurement.
  */
-float DM_Measurer::BMP280readTemperatureC()
+bool DM_Measurer::BMP280startConversion()
 {
-    return DM_Utils::roundTwoDecimals(DM_Measurer::_BMP280Chip.readTemperature());
+    // Start counting the I2C transactions and bus time of this measurement
+    DM_Measurer::_i2cTransactions = 0;
+    DM_Measurer::_i2cBusTimeUs = 0;
+
+    // Start one measurement and remember when it started
+    DM_Measurer::_BMP280conversionStartMs = millis();
+    return DM_Measurer::_BMP280writeRegister(BMP280ControlRegister, BMP280ForcedMeasurement);
 }
 
 /**
- * Read the pressure from the BMP280 sensor and return it in Pascal.
+ * Check if the measurement that was started with "BMP280startConversion()" is finished (this never waits and doesn't use the I2C bus).
  *
- * @return The pressure in Pa.
+ * @return True if the longest conversion time has passed.
  */
-float DM_Measurer::BMP280readPressurePa()
+bool DM_Measurer::BMP280isConversionReady()
 {
-    return DM_Utils::roundTwoDecimals(DM_Measurer::_BMP280Chip.readPressure());
+    return millis() - DM_Measurer::_BMP280conversionStartMs >= BMP280ConversionTimeMs;
 }
 
 /**
- * Read the pressure from the BMP280 sensor and converts it to bar.
+ * Read the raw temperature and pressure of the last measurement in one burst and calculate every unit from that same data.
+ * This replaces reading the temperature and pressure separately (which read the temperature again for every pressure reading).
  *
- * @return The pressure in bar.
+ * @return The snapshot with the temperature and pressure, and the amount of I2C transactions and bus time it took.
+ */
+DM_BMP280Snapshot DM_Measurer::BMP280collectSnapshot()
+{
+    // Check that the conversion is done (it always should be after the longest conversion time, so this normally only reads the status once)
+    DM_BMP280Snapshot snapshot;
+    uint8_t status = 0x08;
+    snapshot.valid = true;
+    for (int attempt = 0; snapshot.valid && (status & 0x08) && attempt < 5; attempt++)
+    {
+        if (attempt > 0)
+            delay(2);
+        snapshot.valid = DM_Measurer::_BMP280readRegisters(BMP280StatusRegister, &status, 1);
+    }
+
+    // Read the raw pressure and temperature in one burst
+    uint8_t data[6];
+    snapshot.valid = snapshot.valid && DM_Measurer::_BMP280readRegisters(BMP280DataRegister, data, sizeof(data));
+    snapshot.i2cTransactions = DM_Measurer::_i2cTransactions;
+    snapshot.i2cBusTimeUs = DM_Measurer::_i2cBusTimeUs;
+    if (!snapshot.valid)
+    {
+        snapshot.temperatureC = NAN;
+        snapshot.pressurePa = NAN;
+        snapshot.pressureBar = NAN;
+        return snapshot;
+    }
+    int32_t rawPressure = (int32_t)data[0] << 12 | (int32_t)data[1] << 4 | data[2] >> 4;
+    int32_t rawTemperature = (int32_t)data[3] << 12 | (int32_t)data[4] << 4 | data[5] >> 4;
+
+    // Calculate the temperature (this is the integer compensation from the datasheet, "fineTemperature" is also needed for the pressure)
+    const DM_BMP280Calibration &calibration = DM_Measurer::_BMP280Calibration;
+    int32_t var1 = ((((rawTemperature >> 3) - ((int32_t)calibration.T1 << 1))) * ((int32_t)calibration.T2)) >> 11;
+    int32_t var2 = (((((rawTemperature >> 4) - ((int32_t)calibration.T1)) * ((rawTemperature >> 4) - ((int32_t)calibration.T1))) >> 12) * ((int32_t)calibration.T3)) >> 14;
+    int32_t fineTemperature = var1 + var2;
+    snapshot.temperatureC = ((fineTemperature * 5 + 128) >> 8) / 100.0;
+
+    // Calculate the pressure from the same raw data (64-bit integer compensation from the datasheet, the result is in 1/256 Pa)
+    int64_t pressureVar1 = (int64_t)fineTemperature - 128000;
+    int64_t pressureVar2 = pressureVar1 * pressureVar1 * (int64_t)calibration.P6;
+    pressureVar2 = pressureVar2 + ((pressureVar1 * (int64_t)calibration.P5) << 17);
+    pressureVar2 = pressureVar2 + (((int64_t)calibration.P4) << 35);
+    pressureVar1 = ((pressureVar1 * pressureVar1 * (int64_t)calibration.P3) >> 8) + ((pressureVar1 * (int64_t)calibration.P2) << 12);
+    pressureVar1 = (((((int64_t)1) << 47) + pressureVar1)) * ((int64_t)calibration.P1) >> 33;
+    if (pressureVar1 == 0)
+    {
+        // Avoid a division by zero (this only happens with an invalid calibration)
+        snapshot.valid = false;
+        snapshot.pressurePa = NAN;
+        snapshot.pressureBar = NAN;
+        return snapshot;
+    }
+    int64_t pressure = 1048576 - rawPressure;
+    pressure = (((pressure << 31) - pressureVar2) * 3125) / pressureVar1;
+    pressureVar1 = (((int64_t)calibration.P9) * (pressure >> 13) * (pressure >> 13)) >> 25;
+    pressureVar2 = (((int64_t)calibration.P8) * pressure) >> 19;
+    pressure = ((pressure + pressureVar1 + pressureVar2) >> 8) + (((int64_t)calibration.P7) << 4);
+
+    // Derive every unit from the same pressure (the values are kept at full precision, they are only rounded when they are formatted)
+    snapshot.pressurePa = pressure / 256.0;
+    snapshot.pressureBar = DM_Measurer::_convertPaToBar(pressure / 256.0);
+
+    // Return the snapshot
+    return snapshot;
+}
+
+/**
+ * Write one register of the BMP280 (one I2C transaction).
+ *
+ * @param reg The address of the register.
+ * @param value The value to write.
+ *
+ * @return The success rate of the write.
+ */
+bool DM_Measurer::_BMP280writeRegister(uint8_t reg, uint8_t value)
+{
+    // Write the register address and the value in one transaction, and count the time it takes
+    DM_PROFILE_SCOPE(DM_STAGE_I2C_BMP280);
+    uint32_t startUs = micros();
+    Wire.beginTransmission(BMP280Address);
+    Wire.write(reg);
+    Wire.write(value);
+    bool success = Wire.endTransmission() == 0;
+    DM_Measurer::_i2cBusTimeUs += micros() - startUs;
+    DM_Measurer::_i2cTransactions += 1;
+
+    // Return the success rate
+    return success;
+}
+
+/**
+ * Read a number of consecutive registers of the BMP280 in one burst (one transaction to set the register address, one to read).
+ *
+ * @param reg The address of the first register.
+ * @param buffer The buffer the values will be copied into.
+ * @param length The amount of registers to read.
+ *
+ * @return The success rate of the read.
+ */
+bool DM_Measurer::_BMP280readRegisters(uint8_t reg, uint8_t *buffer, uint8_t length)
+{
+    // Set the register address (without releasing the bus) and read all registers in one go, and count the time it takes
+    DM_PROFILE_SCOPE(DM_STAGE_I2C_BMP280);
+    uint32_t startUs = micros();
+    Wire.beginTransmission(BMP280Address);
+    Wire.write(reg);
+    bool success = Wire.endTransmission(false) == 0 && Wire.requestFrom(BMP280Address, length) == length;
+    for (uint8_t i = 0; success && i < length; i++)
+        buffer[i] = Wire.read();
+    DM_Measurer::_i2cBusTimeUs += micros() - startUs;
+    DM_Measurer::_i2cTransactions += 2;
+
+    // Return the success rate
+    return success;
+}
+
+/**
+ * Start one conversion of the BH1750 light sensor (this returns right away, the result can be collected with "BH1750collectLightLevelLux()" once "BH1750isConversionReady()" says so).
+ * A conversion takes about 120 to 180 ms with the default measurement time, so other work (like reading the BMP280) can be done in the meantime.
+ * The opcodes are written directly: the library waits 10 ms after every command it sends.
+ *
+ * @return The success rate of starting the conversion.
+ */
+bool DM_Measurer::BH1750startConversion()
+{
+    // Apply the measurement time the auto-ranging chose after the previous conversion, and start the conversion (all I2C transactions count as one pass through the stage)
+    DM_PROFILE_SCOPE(DM_STAGE_I2C_BH1750);
+    uint8_t MTreg = DM_Measurer::_BH1750MTreg;
+    if (MTreg != DM_Measurer::_BH1750appliedMTreg && DM_Measurer::_BH1750writeOpcode(BH1750MTregHighBits | (MTreg >> 5)) && DM_Measurer::_BH1750writeOpcode(BH1750MTregLowBits | (MTreg & 0b11111)))
+        DM_Measurer::_BH1750appliedMTreg = MTreg;
+    DM_Measurer::_BH1750conversionStartMs = millis();
+    return DM_Measurer::_BH1750writeOpcode(BH1750OneTimeHighResMode);
+}
+
+/**
+ * Check if the conversion that was started with "BH1750startConversion()" is finished (this never waits and doesn't use the I2C bus).
+ *
+ * @return True if the result can be collected.
+ */
+bool DM_Measurer::BH1750isConversionReady()
+{
+    // Use the longest conversion time of the datasheet (it grows with the measurement time register), so we never read an unfinished value
+    uint8_t MTreg = DM_Measurer::_BH1750appliedMTreg != 0 ? DM_Measurer::_BH1750appliedMTreg : BH1750MaximumMTreg;
+    return millis() - DM_Measurer::_BH1750conversionStartMs >= BH1750ConversionTimeMs * MTreg / BH1750DefaultMTreg;
+}
+
+/**
+ * Collect the result of the last conversion of the BH1750 light sensor and choose the measurement time for the next conversion (auto-ranging).
+ *
+ * @return The light level in lux (negative if the sensor could not be read).
+ */
+float DM_Measurer::BH1750collectLightLevelLux()
+{
+    // Read the raw value (2 bytes, most significant first)
+    uint16_t counts;
+    {
+        DM_PROFILE_SCOPE(DM_STAGE_I2C_BH1750);
+        if (DM_Measurer::_BH1750appliedMTreg == 0 || Wire.requestFrom(BH1750Address, (uint8_t)2) != 2)
+            return -1;
+        counts = Wire.read() << 8;
+        counts |= Wire.read();
+    }
+
+    // Calculate the light level (in high resolution mode: lux = counts / 1.2 × 69 / MTreg)
+    float lux = counts / 1.2 * BH1750DefaultMTreg / DM_Measurer::_BH1750appliedMTreg;
+
+    // Choose a longer measurement time in the dark (better resolution) and a shorter one in bright light (no saturation), it is applied when the next conversion starts
+    if (counts < BH1750LowCounts || counts > BH1750HighCounts)
+    {
+        float wantedMTreg = counts > 0 ? DM_Measurer::_BH1750appliedMTreg * ((float)BH1750TargetCounts / counts) : BH1750MaximumMTreg;
+        DM_Measurer::_BH1750MTreg = (uint8_t)constrain(wantedMTreg, BH1750MinimumMTreg, BH1750MaximumMTreg);
+    }
+
+    // Return the light level
+    return lux;
+}
+
+/**
+ * Get the measurement time register the auto-ranging chose for the BH1750.
+ *
+ * @return The measurement time register (31 to 254, 69 is the default).
  */
-float DM_Measurer::BMP280readPressureBar()
+uint8_t DM_Measurer::BH1750getMTreg()
 {
-    return DM_Measurer::_convertPaToBar(DM_Measurer::_BMP280Chip.readPressure());
+    return DM_Measurer::_BH1750MTreg;
 }
 
 /**
- * Read the light level from the BH1750 light sensor and return the value in lux.
+ * Send one opcode to the BH1750 (one I2C transaction, without the wait of the library).
  *
- * @param measurementChip The BH1750 object that is used to measure the light level.
+ * @param opcode The opcode.
  *
- * @return The light level in lux.
+ * @return The success rate of the write.
  */
-float DM_Measurer::BH1750readLightLevelLux(BH1750 measurementChip)
+bool DM_Measurer::_BH1750writeOpcode(uint8_t opcode)
 {
-    return DM_Utils::roundTwoDecimals(measurementChip.readLightLevel());
+    Wire.beginTransmission(BH1750Address);
+    Wire.write(opcode);
+    return Wire.endTransmission() == 0;
 }
\ No newline at end of file
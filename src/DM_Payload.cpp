@@ -0,0 +1,164 @@
+/** +----------------------------------------------+
+ *  |      DM_Payload - Binary uplink payload      |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES (no Arduino library, this file also builds on a computer)
+#include "DM_Payload.h" // Include the header file where the declarations for this library are stored
+#include <string.h>     // Used to copy the header into the buffer
+
+/**
+ * Create an encoder (it can't write anything before "begin()" is called).
+ */
+DM_PayloadEncoder::DM_PayloadEncoder() : _buffer(nullptr), _headerLength(0)
+{
+}
+
+/**
+ * Start a new payload by writing its header.
+ *
+ * @param buffer The buffer the payload is written to.
+ * @param capacity The size of the buffer ("maxHeaderSize" plus "DM_Encoder::maxEncodedSampleSize" per sample is always enough).
+ * @param stationID The ID of the station (e.g. its channel number).
+ * @param bootID A number the station picks at random when it boots (its sequence numbers start again at 0 with a new boot ID).
+ * @param sequence The sequence number of the first sample (the station counts its samples, so the server can tell a resent payload from a new one).
+ *
+ * @return False if the header doesn't fit in the buffer.
+ */
+bool DM_PayloadEncoder::begin(uint8_t *buffer, size_t capacity, uint32_t stationID, uint32_t bootID, uint32_t sequence)
+{
+    // Write the header (the amount is updated by every sample that is added)
+    uint8_t header[maxHeaderSize] = {version, schemaPackedSample, 0};
+    size_t length = 3;
+    length += DM_Encoder::writeVarint(header + length, stationID);
+    length += DM_Encoder::writeVarint(header + length, bootID);
+    length += DM_Encoder::writeVarint(header + length, sequence);
+    _buffer = length <= capacity ? buffer : nullptr;
+    if (_buffer == nullptr)
+        return false;
+    memcpy(_buffer, header, length);
+    _headerLength = length;
+
+    // The samples follow the header
+    _encoder.begin(_buffer + length, capacity - length);
+    return true;
+}
+
+/**
+ * Add a sample to the payload.
+ *
+ * @param sample The sample to add.
+ * @param epochSeconds The Unix time of the sample (0 if it is unknown).
+ *
+ * @return False if the sample doesn't fit in the buffer or the payload is full (the payload is left as it was).
+ */
+bool DM_PayloadEncoder::add(const DM_PackedSample &sample, uint32_t epochSeconds)
+{
+    if (_buffer == nullptr || _encoder.getAmount() >= maxSamplesPerPayload || !_encoder.add(sample, epochSeconds))
+        return false;
+    _buffer[2] = (uint8_t)_encoder.getAmount();
+    return true;
+}
+
+/**
+ * Get the length of the payload.
+ *
+ * @return The amount of bytes written (the header and the samples).
+ */
+size_t DM_PayloadEncoder::getLength() const
+{
+    return _buffer == nullptr ? 0 : _headerLength + _encoder.getLength();
+}
+
+/**
+ * Get the amount of samples in the payload.
+ *
+ * @return The amount of samples written.
+ */
+uint32_t DM_PayloadEncoder::getAmount() const
+{
+    return _encoder.getAmount();
+}
+
+/**
+ * Create a decoder (it can't read anything before "begin()" is called).
+ */
+DM_PayloadDecoder::DM_PayloadDecoder() : _stationID(0), _bootID(0), _sequence(0), _amount(0)
+{
+}
+
+/**
+ * Start reading a payload by reading its header.
+ *
+ * @param buffer The payload.
+ * @param length The length of the payload.
+ *
+ * @return False if the payload has a version or schema this decoder doesn't know, has no samples, or its header is cut off.
+ */
+bool DM_PayloadDecoder::begin(const uint8_t *buffer, size_t length)
+{
+    _amount = 0;
+    size_t position = 3;
+    if (length < position || buffer[0] != DM_PayloadEncoder::version || buffer[1] != DM_PayloadEncoder::schemaPackedSample || buffer[2] == 0)
+        return false;
+    if (!DM_Decoder::readVarint(buffer, length, position, _stationID) || !DM_Decoder::readVarint(buffer, length, position, _bootID) || !DM_Decoder::readVarint(buffer, length, position, _sequence))
+        return false;
+    _amount = buffer[2];
+    _decoder.begin(buffer + position, length - position, _amount);
+    return true;
+}
+
+/**
+ * Get the station ID in the header.
+ *
+ * @return The ID of the station.
+ */
+uint32_t DM_PayloadDecoder::getStationID() const
+{
+    return _stationID;
+}
+
+/**
+ * Get the boot ID in the header (the sequence numbers of a station only count up while its boot ID stays the same).
+ *
+ * @return The boot ID.
+ */
+uint32_t DM_PayloadDecoder::getBootID() const
+{
+    return _bootID;
+}
+
+/**
+ * Get the sequence number of the first sample (the sample that "next()" returns as the n-th one has this number plus n).
+ *
+ * @return The sequence number.
+ */
+uint32_t DM_PayloadDecoder::getSequence() const
+{
+    return _sequence;
+}
+
+/**
+ * Get the amount of samples in the payload.
+ *
+ * @return The amount of samples.
+ */
+uint32_t DM_PayloadDecoder::getAmount() const
+{
+    return _amount;
+}
+
+/**
+ * Read the next sample.
+ *
+ * @param sample The variable the sample will be copied into.
+ * @param epochSeconds The variable the Unix time of the sample will be copied into.
+ *
+ * @return False if all samples were read or the payload is broken.
+ */
+bool DM_PayloadDecoder::next(DM_PackedSample &sample, uint32_t &epochSeconds)
+{
+    return _decoder.next(sample, epochSeconds);
+}
\ No newline at end of file
@@ -0,0 +1,228 @@
+/** +----------------------------------------------+
+ *  |      DM_Power - Deep-sleep duty cycling      |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "Arduino.h"    // Include the Arduino library
+#include "DM_Power.h"   // Include the header file where the declarations for this library are stored
+#include <esp_sleep.h>  // Used to put the ESP32 in light and deep sleep
+#include <sys/time.h>   // Used to read the system clock, which the RTC keeps running during deep sleep
+#include <DM_Sample.h>  // Used to convert the samples to fixed-point before they are kept in RTC memory
+#include <DM_Log.h>     // Include the self-made library that prints the status messages without waiting for the serial port
+
+// INITIALIZE THE CLASS MEMBERS (if we don't do this, the code will give errors saying these should be initialised first)
+RTC_DATA_ATTR DM_PowerState DM_Power::_state; // Everything that has to survive a deep sleep
+bool DM_Power::_resumed = false;              // If this wake continues from a deep sleep
+uint32_t DM_Power::_stationOffsetMs = 0;      // The station clock at the moment "millis()" was 0
+uint32_t DM_Power::_wakeStationMs = 0;        // The moment (on the station clock) this wake started
+uint32_t DM_Power::_lightSleptMs = 0;         // The time spent in light sleep during this wake
+
+// OTHER VARIABLES
+const uint32_t powerStateMagic = 0x444D5001 + sizeof(DM_PowerState); // The value of "magic" for a valid state (it changes with the layout of the state)
+const uint32_t millisecondsPerHour = 3600000;                        // The length of one hour of the awake time statistics
+
+/**
+ * Check why the ESP32 started and pick up the state that was kept in RTC memory (call this first thing in "setup()").
+ *
+ * @return True if the station woke from deep sleep (the sensors can be resumed instead of initialized), false after a power-on or a reset.
+ */
+bool DM_Power::begin()
+{
+    // Only trust the state in RTC memory after a timer wake from deep sleep
+    DM_Power::_resumed = esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER && DM_Power::_state.magic == powerStateMagic;
+    if (!DM_Power::_resumed)
+    {
+        memset(&DM_Power::_state, 0, sizeof(DM_Power::_state));
+        DM_Power::_state.magic = powerStateMagic;
+    }
+    DM_Power::_state.amountOfWakes += 1;
+    DM_Power::_lightSleptMs = 0;
+
+    // Continue the station clock: the time spent since the deep sleep started (this includes the boot) is measured with the system clock, which the RTC kept running
+    if (DM_Power::_resumed)
+    {
+        uint32_t elapsedMs = (DM_Power::_systemClockUs() - DM_Power::_state.sleepStartUs) / 1000;
+        DM_Power::_stationOffsetMs = DM_Power::_state.stationMsAtSleep + elapsedMs - millis();
+        DM_Power::_wakeStationMs = DM_Power::_state.stationMsAtSleep + DM_Power::_state.plannedSleepMs;
+    }
+
+    // Return if the state was picked up
+    return DM_Power::_resumed;
+}
+
+/**
+ * Check if this wake continues from a deep sleep.
+ *
+ * @return True if the station woke from deep sleep.
+ */
+bool DM_Power::isResumed()
+{
+    return DM_Power::_resumed;
+}
+
+/**
+ * Get the station clock: the time since the first boot, also counting the time spent in deep sleep (use this instead of "millis()", which starts over on every wake).
+ *
+ * @return The amount of milliseconds since the first boot.
+ */
+uint32_t DM_Power::getStationMs()
+{
+    return DM_Power::_stationOffsetMs + millis();
+}
+
+/**
+ * Remember how long it took from the wake until the sample was taken (call this right after the sample was collected).
+ */
+void DM_Power::sampleTaken()
+{
+    // The wake started when the RTC timer fired (the boot is included), on the first boot when "millis()" started
+    uint32_t wakeToSampleMs = DM_Power::getStationMs() - DM_Power::_wakeStationMs;
+    DM_Power::_state.lastWakeToSampleMs = wakeToSampleMs;
+    DM_Power::_state.totalWakeToSampleMs += wakeToSampleMs;
+}
+
+/**
+ * Keep a sample in RTC memory until the radio is turned on.
+ *
+ * @param sample The sample to keep.
+ *
+ * @return False if the buffer is full (the sample is not kept).
+ */
+bool DM_Power::bufferSample(const DM_Sample &sample)
+{
+    // Check if there is room left
+    if (DM_Power::_state.amountOfSamples >= DM_PowerState::maxAmountOfSamples)
+        return false;
+
+    // Store the sample in fixed-point, next to its real time
+    DM_Power::_state.samples[DM_Power::_state.amountOfSamples] = DM_PackedSample::pack(sample);
+    DM_Power::_state.epochSeconds[DM_Power::_state.amountOfSamples] = sample.epochSeconds;
+    DM_Power::_state.amountOfSamples += 1;
+
+    // Return the success rate
+    return true;
+}
+
+/**
+ * Get the amount of samples that are waiting in RTC memory.
+ *
+ * @return The amount of samples.
+ */
+size_t DM_Power::getAmountOfBufferedSamples()
+{
+    return DM_Power::_state.amountOfSamples;
+}
+
+/**
+ * Copy the samples that are waiting in RTC memory (oldest first). They stay in the buffer until "clearBufferedSamples()" is called.
+ *
+ * @param samples The array the samples will be copied into.
+ * @param maxAmount The size of the array.
+ *
+ * @return The amount of samples that have been copied.
+ */
+size_t DM_Power::readBufferedSamples(DM_Sample *samples, size_t maxAmount)
+{
+    size_t amount = min((size_t)DM_Power::_state.amountOfSamples, maxAmount);
+    for (size_t i = 0; i < amount; i++)
+    {
+        samples[i] = DM_PackedSample::unpack(DM_Power::_state.samples[i]);
+        samples[i].epochSeconds = DM_Power::_state.epochSeconds[i];
+    }
+    return amount;
+}
+
+/**
+ * Forget the samples in RTC memory (once they have been sent or stored on flash).
+ */
+void DM_Power::clearBufferedSamples()
+{
+    DM_Power::_state.amountOfSamples = 0;
+}
+
+/**
+ * Check if the radio should be turned on during this wake.
+ *
+ * @param batchSize The amount of samples that make a full batch.
+ * @param maxLatencyMs The longest time a sample may wait in RTC memory.
+ *
+ * @return True if the batch is full, the buffer is full or the oldest sample waited long enough.
+ */
+bool DM_Power::isUplinkDue(size_t batchSize, uint32_t maxLatencyMs)
+{
+    uint32_t amount = DM_Power::_state.amountOfSamples;
+    return amount >= batchSize || amount >= DM_PowerState::maxAmountOfSamples || (amount > 0 && DM_Power::getStationMs() - DM_Power::_state.samples[0].timestampMs >= maxLatencyMs);
+}
+
+/**
+ * Light-sleep for a short time, e.g. while a conversion is running (the RAM and the state of the peripherals are kept, "millis()" keeps counting).
+ *
+ * @param durationMs The time to sleep.
+ */
+void DM_Power::lightSleep(uint32_t durationMs)
+{
+    uint32_t startMs = millis();
+    esp_sleep_enable_timer_wakeup((uint64_t)durationMs * 1000);
+    esp_light_sleep_start();
+    DM_Power::_lightSleptMs += millis() - startMs;
+}
+
+/**
+ * Update the awake time statistics and deep-sleep until the next sample is due (this never returns, the station boots again when it wakes).
+ *
+ * @param samplePeriodMs The time between two samples.
+ */
+void DM_Power::deepSleepUntilNextSample(uint32_t samplePeriodMs)
+{
+    // Plan the next sample at a fixed rate (unless we are more than a whole period late)
+    DM_PowerState &state = DM_Power::_state;
+    uint32_t now = DM_Power::getStationMs();
+    state.nextSampleMs = now - state.nextSampleMs >= samplePeriodMs ? now + samplePeriodMs : state.nextSampleMs + samplePeriodMs;
+
+    // Add the time of this wake to the awake time of the current hour, and close the hour once it is over
+    state.awakeMsThisHour += now - DM_Power::_wakeStationMs - DM_Power::_lightSleptMs;
+    if (now - state.hourStartMs >= millisecondsPerHour)
+    {
+        state.awakeMsLastHour = state.awakeMsThisHour;
+        state.awakeMsCompleteHours += state.awakeMsThisHour;
+        state.amountOfHours += 1;
+        state.awakeMsThisHour = 0;
+        state.hourStartMs = now;
+    }
+
+    // Remember when the deep sleep started, so the station clock can continue after the wake
+    state.plannedSleepMs = (int32_t)(state.nextSampleMs - now) > 0 ? state.nextSampleMs - now : 1;
+    state.stationMsAtSleep = now;
+    state.sleepStartUs = DM_Power::_systemClockUs();
+
+    // Let the log and the serial port finish sending, then go to deep sleep (only the RTC keeps running, the BMP280 and BH1750 stay powered and keep their settings)
+    DM_Log::flush();
+    esp_sleep_enable_timer_wakeup((uint64_t)state.plannedSleepMs * 1000);
+    esp_deep_sleep_start();
+}
+
+/**
+ * Print the amount of wakes, the wake-to-sample latency and the awake time per hour.
+ */
+void DM_Power::printStatistics()
+{
+    const DM_PowerState &state = DM_Power::_state;
+    DM_LOG_INFO("DM_Power", "%lu wakes, wake-to-sample %lu ms (average %lu ms), awake %lu ms in the last hour (average %lu ms per hour).",
+                (unsigned long)state.amountOfWakes, (unsigned long)state.lastWakeToSampleMs, (unsigned long)(state.amountOfWakes > 0 ? state.totalWakeToSampleMs / state.amountOfWakes : 0),
+                (unsigned long)state.awakeMsLastHour, (unsigned long)(state.amountOfHours > 0 ? state.awakeMsCompleteHours / state.amountOfHours : 0));
+}
+
+/**
+ * Read the system clock (the RTC keeps it running during deep sleep, unlike "millis()").
+ *
+ * @return The system clock in microseconds.
+ */
+int64_t DM_Power::_systemClockUs()
+{
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_usec;
+}
\ No newline at end of file
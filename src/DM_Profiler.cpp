@@ -0,0 +1,181 @@
+/** +----------------------------------------------+
+ *  |    DM_Profiler - Latency of the hot paths    |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "Arduino.h"     // Include the Arduino library
+#include "DM_Profiler.h" // Include the header file where the declarations for this library are stored
+#include <DM_Format.h>   // Include the self-made library that writes the lines of the report without allocating memory
+#include <DM_Log.h>      // Include the self-made library that prints the status messages without waiting for the serial port
+
+// Only keep the histograms when the probes exist
+#ifdef DM_PROFILING
+
+// INITIALIZE THE CLASS MEMBERS (if we don't do this, the code will give errors saying these should be initialised first)
+DM_Profiler::_Histogram DM_Profiler::_histograms[DM_AMOUNT_OF_STAGES] = {};           // The latency histogram of every stage
+uint32_t DM_Profiler::_ticksPerMicrosecond = DM_Profiler::defaultTicksPerMicrosecond; // The amount the clock of the probes advances per microsecond
+
+// OTHER VARIABLES
+const char *const stageNames[DM_AMOUNT_OF_STAGES] = {"i2c_bmp280", "i2c_bh1750", "mqtt_publish", "bulk_update", "discord_post", "wifi_connect", "mqtt_connect", "serial_print", "encode_payload", "filter"}; // The names of the stages (in the order of "DM_Stage")
+
+/**
+ * Read how fast the clock of the probes runs (call this once in the setup, a probe before that assumes 240 MHz).
+ */
+void DM_Profiler::begin()
+{
+#ifdef ARDUINO
+    DM_Profiler::_ticksPerMicrosecond = ESP.getCpuFreqMHz();
+#else
+    DM_Profiler::_ticksPerMicrosecond = 1;
+#endif
+}
+
+/**
+ * Record the latency of one pass through a stage (called by the probes).
+ *
+ * @param stage The stage.
+ * @param ticks The time the stage took, in ticks of "now()".
+ */
+void DM_Profiler::record(DM_Stage stage, uint32_t ticks)
+{
+    DM_Profiler::recordMicroseconds(stage, ticks / DM_Profiler::_ticksPerMicrosecond);
+}
+
+/**
+ * Record the latency of one pass through a stage that was measured in microseconds (for stages that take longer than the cycle counter can count).
+ *
+ * @param stage The stage.
+ * @param latencyUs The time the stage took in µs.
+ */
+void DM_Profiler::recordMicroseconds(DM_Stage stage, uint32_t latencyUs)
+{
+    // Count the latency in its bucket (only the counts have to be exact, so no ordering is needed)
+    _Histogram &histogram = DM_Profiler::_histograms[stage];
+    histogram.buckets[DM_Profiler::_getBucket(latencyUs)].fetch_add(1, std::memory_order_relaxed);
+    histogram.amount.fetch_add(1, std::memory_order_relaxed);
+
+    // Keep the highest latency (this only loops when another task raised it at the same moment)
+    uint32_t maximumUs = histogram.maximumUs.load(std::memory_order_relaxed);
+    while (latencyUs > maximumUs && !histogram.maximumUs.compare_exchange_weak(maximumUs, latencyUs, std::memory_order_relaxed))
+    {
+    }
+}
+
+/**
+ * Get the name of a stage (as used in the report and as label on "/metrics").
+ *
+ * @param stage The stage.
+ *
+ * @return The name of the stage.
+ */
+const char *DM_Profiler::getStageName(DM_Stage stage)
+{
+    return stageNames[stage];
+}
+
+/**
+ * Get the amount of latencies that were recorded for a stage.
+ *
+ * @param stage The stage.
+ *
+ * @return The amount of latencies since the boot.
+ */
+uint32_t DM_Profiler::getAmountOfSamples(DM_Stage stage)
+{
+    return DM_Profiler::_histograms[stage].amount.load(std::memory_order_relaxed);
+}
+
+/**
+ * Get a percentile of the latencies of a stage, read from its histogram (the upper bound of the bucket the percentile falls in, so it is never too optimistic).
+ *
+ * @param stage The stage.
+ * @param perMille The percentile in per mille (e.g. 990 for the 99th percentile).
+ *
+ * @return The percentile in µs (0 if nothing has been recorded).
+ */
+uint32_t DM_Profiler::getPercentileMicroseconds(DM_Stage stage, uint16_t perMille)
+{
+    // Find how many latencies lie at or below the percentile (at least one)
+    const _Histogram &histogram = DM_Profiler::_histograms[stage];
+    uint32_t amount = histogram.amount.load(std::memory_order_relaxed);
+    if (amount == 0)
+        return 0;
+    uint32_t rank = max((uint32_t)1, (uint32_t)(((uint64_t)amount * perMille + 999) / 1000));
+
+    // Walk through the buckets until that many latencies have been passed (the buckets may be counted a bit later than the amount, so the last bucket is the fallback)
+    uint32_t passed = 0;
+    for (size_t bucket = 0; bucket < amountOfBuckets; bucket++)
+    {
+        passed += histogram.buckets[bucket].load(std::memory_order_relaxed);
+        if (passed >= rank)
+            return (uint32_t)min(DM_Profiler::_getBucketLowerBound(bucket + 1) - 1, (uint64_t)histogram.maximumUs.load(std::memory_order_relaxed));
+    }
+    return histogram.maximumUs.load(std::memory_order_relaxed);
+}
+
+/**
+ * Get the highest latency of a stage.
+ *
+ * @param stage The stage.
+ *
+ * @return The highest latency in µs since the boot.
+ */
+uint32_t DM_Profiler::getMaximumMicroseconds(DM_Stage stage)
+{
+    return DM_Profiler::_histograms[stage].maximumUs.load(std::memory_order_relaxed);
+}
+
+/**
+ * Print the amount, the percentiles and the highest latency of every stage that has been passed.
+ */
+void DM_Profiler::printReport()
+{
+    DM_LOG_INFO("DM_Profiler", "Latency per stage (µs):");
+    for (uint8_t i = 0; i < DM_AMOUNT_OF_STAGES; i++)
+    {
+        DM_Stage stage = (DM_Stage)i;
+        if (DM_Profiler::getAmountOfSamples(stage) == 0)
+            continue;
+        char line[sizeof(DM_LogEntry::text)];
+        DM_Formatter output(line, sizeof(line));
+        output.append(DM_Profiler::getStageName(stage)).appendLiteral(": ").appendUnsigned(DM_Profiler::getAmountOfSamples(stage)).appendLiteral("x");
+        for (uint16_t perMille : DM_Profiler::percentiles)
+            output.appendLiteral(", p").appendUnsigned(perMille / 10).appendLiteral(" ").appendUnsigned(DM_Profiler::getPercentileMicroseconds(stage, perMille));
+        output.appendLiteral(", max ").appendUnsigned(DM_Profiler::getMaximumMicroseconds(stage));
+        DM_LOG_INFO("DM_Profiler", "%s", output.c_str());
+    }
+}
+
+/**
+ * Find the bucket of a latency: the values below "subBuckets" each have their own bucket, above that the highest bit chooses the power of two and the bits right below it the part of it.
+ *
+ * @param latencyUs The latency in µs.
+ *
+ * @return The index of the bucket.
+ */
+size_t DM_Profiler::_getBucket(uint32_t latencyUs)
+{
+    if (latencyUs < subBuckets)
+        return latencyUs;
+    uint8_t highestBit = 31 - __builtin_clz(latencyUs);
+    return (highestBit - subBucketBits + 1) * subBuckets + ((latencyUs >> (highestBit - subBucketBits)) & (subBuckets - 1));
+}
+
+/**
+ * Get the lowest latency that is counted in a bucket (the reverse of _getBucket()).
+ *
+ * @param bucket The index of the bucket (may be "amountOfBuckets" to get the end of the last bucket).
+ *
+ * @return The lowest latency of the bucket in µs.
+ */
+uint64_t DM_Profiler::_getBucketLowerBound(size_t bucket)
+{
+    if (bucket < subBuckets)
+        return bucket;
+    return (uint64_t)(subBuckets + bucket % subBuckets) << (bucket / subBuckets - 1);
+}
+
+#endif // End of the histograms
\ No newline at end of file
@@ -0,0 +1,159 @@
+/** +----------------------------------------------+
+ *  |   DM_Reporting - Deadband reporting policy   |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "Arduino.h"      // Include the Arduino library
+#include "DM_Reporting.h" // Include the header file where the declarations for this library are stored
+#include <DM_Log.h>       // Include the self-made library that prints the status messages without waiting for the serial port
+
+/**
+ * Create a reporting policy for the values of a summary (it starts with a heartbeat of 15 minutes and holds fast reporting for 5 minutes).
+ *
+ * @param fields The values to check (normally the fields of the sensor set, the table has to stay valid).
+ * @param amountOfFields The amount of fields (only the first "DM_WindowSummary::maxAmountOfFields" are checked).
+ */
+DM_ReportingPolicy::DM_ReportingPolicy(const DM_Field *fields, size_t amountOfFields)
+    : _fields(fields), _amountOfFields(min(amountOfFields, DM_WindowSummary::maxAmountOfFields)), _heartbeatMs(900000), _fastReportingHoldMs(300000), _published(false), _lastPublishMs(0),
+      _hasPrevious(false), _previousEndMs(0), _fastReporting(false), _lastFastChangeMs(0), _amountOfPublishes(0), _amountOfHeartbeats(0), _amountOfSuppressed(0)
+{
+}
+
+/**
+ * Set the heartbeat and how long fast reporting lasts.
+ *
+ * @param heartbeatMs The longest time without a publish (a summary is sent after this time, even when nothing changed).
+ * @param fastReportingHoldMs The time every value has to change slower than its "fastChangePerMinute" before fast reporting stops.
+ */
+void DM_ReportingPolicy::configure(uint32_t heartbeatMs, uint32_t fastReportingHoldMs)
+{
+    _heartbeatMs = heartbeatMs;
+    _fastReportingHoldMs = fastReportingHoldMs;
+}
+
+/**
+ * Decide if a summary is worth sending, and update the rate of change of every value.
+ *
+ * @param summary The summary of the window that just ended.
+ *
+ * @return The decision (every summary has to be evaluated, also the ones that are not sent, so the rates of change stay up to date).
+ */
+DM_ReportingDecision DM_ReportingPolicy::evaluate(const DM_WindowSummary &summary)
+{
+    // Check how fast every value changes, compared to the previous summary
+    bool changingFast = false;
+    if (_hasPrevious && summary.endMs != _previousEndMs)
+    {
+        float minutes = (summary.endMs - _previousEndMs) / 60000.0;
+        for (size_t i = 0; i < _amountOfFields && i < summary.amountOfFields; i++)
+            changingFast = changingFast || fabs(summary.fields[i].mean - _previous[i]) / minutes > _fields[i].fastChangePerMinute;
+    }
+    for (size_t i = 0; i < _amountOfFields && i < summary.amountOfFields; i++)
+        _previous[i] = summary.fields[i].mean;
+    _previousEndMs = summary.endMs;
+    _hasPrevious = true;
+
+    // Report fast while a value changes fast, and until every value was calm for long enough
+    if (changingFast)
+        _lastFastChangeMs = summary.endMs;
+    if (changingFast && !_fastReporting)
+        DM_LOG_INFO("DM_Reporting", "A value is changing fast, switching to fast reporting.");
+    else if (!changingFast && _fastReporting && summary.endMs - _lastFastChangeMs >= _fastReportingHoldMs)
+        DM_LOG_INFO("DM_Reporting", "Every value is calm again, switching back to normal reporting.");
+    _fastReporting = changingFast || (_fastReporting && summary.endMs - _lastFastChangeMs < _fastReportingHoldMs);
+
+    // Check if a value left its deadband (the first summary is always sent)
+    DM_ReportingDecision decision = DM_REPORT_SUPPRESS;
+    for (size_t i = 0; i < _amountOfFields && i < summary.amountOfFields; i++)
+        if (!_published || _hasChanged(summary.fields[i].mean, _lastPublished[i], _fields[i].deadband))
+            decision = DM_REPORT_CHANGED;
+
+    // Send a heartbeat if nothing has been sent for too long, so a silent station can be told apart from a broken one
+    if (decision == DM_REPORT_SUPPRESS && summary.endMs - _lastPublishMs >= _heartbeatMs)
+        decision = DM_REPORT_HEARTBEAT;
+
+    // Count the decision, and remember what was sent (the deadbands are measured from the last value that was sent, so a slow drift is still reported)
+    if (decision == DM_REPORT_SUPPRESS)
+    {
+        _amountOfSuppressed += 1;
+        return decision;
+    }
+    _amountOfPublishes += 1;
+    _amountOfHeartbeats += decision == DM_REPORT_HEARTBEAT ? 1 : 0;
+    for (size_t i = 0; i < _amountOfFields && i < summary.amountOfFields; i++)
+        _lastPublished[i] = summary.fields[i].mean;
+    _lastPublishMs = summary.endMs;
+    _published = true;
+
+    // Return the decision
+    return decision;
+}
+
+/**
+ * Check if the values are changing fast (the windows should be shorter, so the change is reported in more detail).
+ *
+ * @return True if fast reporting is on.
+ */
+bool DM_ReportingPolicy::isFastReporting() const
+{
+    return _fastReporting;
+}
+
+/**
+ * Get the amount of summaries that were worth sending since boot.
+ *
+ * @return The amount of publishes (including the heartbeats).
+ */
+uint32_t DM_ReportingPolicy::getAmountOfPublishes() const
+{
+    return _amountOfPublishes;
+}
+
+/**
+ * Get the amount of summaries that were only sent because the heartbeat was due.
+ *
+ * @return The amount of heartbeats.
+ */
+uint32_t DM_ReportingPolicy::getAmountOfHeartbeats() const
+{
+    return _amountOfHeartbeats;
+}
+
+/**
+ * Get the amount of summaries that were not sent because every value stayed within its deadband.
+ *
+ * @return The amount of suppressed publishes.
+ */
+uint32_t DM_ReportingPolicy::getAmountOfSuppressed() const
+{
+    return _amountOfSuppressed;
+}
+
+/**
+ * Print the amount of publishes, heartbeats and suppressed publishes (the share of suppressed publishes is the share of radio time and data that is saved).
+ */
+void DM_ReportingPolicy::printStatistics() const
+{
+    uint32_t amountOfSummaries = _amountOfPublishes + _amountOfSuppressed;
+    DM_LOG_INFO("DM_Reporting", "%lu published (%lu heartbeats), %lu suppressed (%.1f %% saved)%s", (unsigned long)_amountOfPublishes, (unsigned long)_amountOfHeartbeats, (unsigned long)_amountOfSuppressed,
+                amountOfSummaries > 0 ? 100.0 * _amountOfSuppressed / amountOfSummaries : 0.0, _fastReporting ? ", fast reporting" : "");
+}
+
+/**
+ * Check if a value moved more than its deadband away from the value that was sent last.
+ *
+ * @param value The new value.
+ * @param reference The value that was sent last.
+ * @param deadband The smallest change that counts.
+ *
+ * @return True if the value changed enough (a value that became valid or invalid also counts as a change).
+ */
+bool DM_ReportingPolicy::_hasChanged(float value, float reference, float deadband)
+{
+    if (isnan(value) || isnan(reference))
+        return isnan(value) != isnan(reference);
+    return fabs(value - reference) >= deadband;
+}
\ No newline at end of file
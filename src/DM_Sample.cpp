@@ -0,0 +1,70 @@
+/** +----------------------------------------------+
+ *  |     DM_Sample - Timestamped measurement      |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES (no Arduino library, this file also builds on a computer)
+#include "DM_Sample.h" // Include the header file where the declarations for this library are stored
+#include <math.h>      // Used to round the values and to recognise failed readings (NaN)
+#include <algorithm>   // Used to clamp the values that are out of range
+
+// OTHER VARIABLES
+const uint16_t lightIntensityCoarseFlag = 0x8000; // When this bit of a packed light intensity is set, the value is in steps of 4 lux (otherwise in steps of 0.01 lux)
+const float lightIntensityFineLimit = 327.67;     // The highest light intensity that is stored in steps of 0.01 lux
+
+/**
+ * Convert a sample to fixed-point (rounded to the nearest step, values outside the range are clamped).
+ * The light intensity is stored in steps of 0.01 lux up to 327.67 lux, and in steps of 4 lux above that (up to 131064 lux, direct sunlight), so the step is never more than 1.2 % of the value.
+ *
+ * @param sample The sample to convert.
+ *
+ * @return The packed sample.
+ */
+DM_PackedSample DM_PackedSample::pack(const DM_Sample &sample)
+{
+    DM_PackedSample packed;
+    packed.timestampMs = sample.timestampMs;
+
+    // The temperature in 1/100 °C
+    packed.temperature = isnan(sample.temperatureC) ? DM_PackedSample::invalidTemperature : (int16_t)std::min(std::max(lroundf(sample.temperatureC * 100), (long)INT16_MIN + 1), (long)INT16_MAX);
+
+    // The air pressure in 1/100 Pa above the base
+    packed.airPressure = isnan(sample.airPressurePa) ? DM_PackedSample::invalidAirPressure : (uint32_t)std::min(std::max(llroundf((sample.airPressurePa - DM_PackedSample::airPressureBasePa) * 100), 0LL), (long long)UINT32_MAX - 1);
+
+    // The light intensity in fine or coarse steps
+    if (isnan(sample.lightIntensityLux) || sample.lightIntensityLux < 0)
+        packed.lightIntensity = DM_PackedSample::invalidLightIntensity;
+    else if (sample.lightIntensityLux <= lightIntensityFineLimit)
+        packed.lightIntensity = (uint16_t)lroundf(sample.lightIntensityLux * 100);
+    else
+        packed.lightIntensity = lightIntensityCoarseFlag | (uint16_t)std::min(lroundf(sample.lightIntensityLux / 4), 0x7FFEL);
+
+    // Return the packed sample
+    return packed;
+}
+
+/**
+ * Convert a packed sample back to display units.
+ *
+ * @param packed The packed sample.
+ *
+ * @return The sample (failed readings are NaN, the Unix time is left at 0).
+ */
+DM_Sample DM_PackedSample::unpack(const DM_PackedSample &packed)
+{
+    DM_Sample sample;
+    sample.timestampMs = packed.timestampMs;
+    sample.epochSeconds = 0;
+    sample.temperatureC = packed.temperature == DM_PackedSample::invalidTemperature ? NAN : packed.temperature / 100.0;
+    sample.airPressurePa = packed.airPressure == DM_PackedSample::invalidAirPressure ? NAN : DM_PackedSample::airPressureBasePa + packed.airPressure / 100.0;
+    sample.airPressureBar = sample.airPressurePa / 100000.0;
+    if (packed.lightIntensity == DM_PackedSample::invalidLightIntensity)
+        sample.lightIntensityLux = NAN;
+    else if (packed.lightIntensity & lightIntensityCoarseFlag)
+        sample.lightIntensityLux = (packed.lightIntensity & ~lightIntensityCoarseFlag) * 4.0;
+    else
+        sample.lightIntensityLux = packed.lightIntensity / 100.0;
+    return sample;
+}
\ No newline at end of file
@@ -0,0 +1,217 @@
+/** +----------------------------------------------+
+ *  |     DM_Sensors - Sensors of the station      |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "Arduino.h"     // Include the Arduino library
+#include "DM_Sensors.h"  // Include the header file where the declarations for this library are stored
+#include <DM_Measurer.h> // Include the self-made library that talks to the chips
+#include <DM_Log.h>      // Include the self-made library that prints the status messages without waiting for the serial port
+
+// INITIALIZE THE CLASS MEMBERS
+RTC_DATA_ATTR DM_FilterState DM_BMP280Sensor::_savedTemperatureFilter; // The state of the temperature filter after the last measurement (kept in RTC memory during deep sleep)
+RTC_DATA_ATTR DM_FilterState DM_BMP280Sensor::_savedPressureFilter;    // The state of the air pressure filter after the last measurement (kept in RTC memory during deep sleep)
+RTC_DATA_ATTR DM_FilterState DM_BH1750Sensor::_savedLightFilter;       // The state of the light intensity filter after the last measurement (kept in RTC memory during deep sleep)
+
+/**
+ * Create the BMP280 sensor.
+ *
+ * @param measurementChip The BMP280 chip object (a reference to the already created object).
+ */
+DM_BMP280Sensor::DM_BMP280Sensor(Adafruit_BMP280 &measurementChip) : _measurementChip(measurementChip), _temperatureFilter(0.01, 2, 5, 0.5, 0), _pressureFilter(1, 2, 5, 50, 0)
+{
+    // No measurement has been taken yet
+    _lastSnapshot.valid = false;
+    _lastSnapshot.i2cTransactions = 0;
+    _lastSnapshot.i2cBusTimeUs = 0;
+}
+
+/**
+ * Initialize the BMP280 chip.
+ *
+ * @return The success rate of the initialization.
+ */
+bool DM_BMP280Sensor::begin()
+{
+    // Forget the filter state of before a reset (it is only picked up again after a deep sleep)
+    _temperatureFilter.saveState(_savedTemperatureFilter);
+    _pressureFilter.saveState(_savedPressureFilter);
+    return DM_Measurer::initializeBMP280(_measurementChip);
+}
+
+/**
+ * Get the BMP280 ready again after a deep sleep (the calibration and the state of the filters are kept in RTC memory).
+ *
+ * @return The success rate.
+ */
+bool DM_BMP280Sensor::resume()
+{
+    _temperatureFilter.restoreState(_savedTemperatureFilter);
+    _pressureFilter.restoreState(_savedPressureFilter);
+    return DM_Measurer::resumeBMP280(_measurementChip);
+}
+
+/**
+ * Start one measurement of the BMP280 (this returns right away).
+ *
+ * @return The success rate of starting the measurement.
+ */
+bool DM_BMP280Sensor::startConversion()
+{
+    return DM_Measurer::BMP280startConversion();
+}
+
+/**
+ * Check if the measurement is finished (this never waits).
+ *
+ * @return True if the result can be collected.
+ */
+bool DM_BMP280Sensor::isConversionReady()
+{
+    return DM_Measurer::BMP280isConversionReady();
+}
+
+/**
+ * Read the result of the measurement and add it to the burst (a failed reading is left out).
+ */
+void DM_BMP280Sensor::readConversion()
+{
+    // Read the temperature and pressure from one and the same measurement
+    _lastSnapshot = DM_Measurer::BMP280collectSnapshot();
+    if (!_lastSnapshot.valid)
+        return;
+    _temperatureFilter.addReading(_lastSnapshot.temperatureC);
+    _pressureFilter.addReading(_lastSnapshot.pressurePa);
+}
+
+/**
+ * Filter the readings of the burst and fill in the values of this sensor in the sample.
+ *
+ * @param sample The sample to fill in.
+ */
+void DM_BMP280Sensor::collect(DM_Sample &sample)
+{
+    // Turn every burst into one reading
+    sample.temperatureC = _temperatureFilter.filterBurst();
+    sample.airPressurePa = _pressureFilter.filterBurst();
+    sample.airPressureBar = sample.airPressurePa / 100000.0;
+    _temperatureFilter.saveState(_savedTemperatureFilter);
+    _pressureFilter.saveState(_savedPressureFilter);
+
+    // Show what was rejected
+    if (_temperatureFilter.wasSpike())
+        DM_LOG_WARNING("DM_Sensors", "Rejected a temperature spike of %.2f °C (replaced by %.2f °C).", _temperatureFilter.getLastMedian(), sample.temperatureC);
+    if (_pressureFilter.wasSpike())
+        DM_LOG_WARNING("DM_Sensors", "Rejected an air pressure spike of %.0f Pa (replaced by %.0f Pa).", _pressureFilter.getLastMedian(), sample.airPressurePa);
+}
+
+/**
+ * Get the last measurement of the BMP280 (used to show what a measurement costs on the I2C bus).
+ *
+ * @return A reference to the last snapshot.
+ */
+const DM_BMP280Snapshot &DM_BMP280Sensor::getLastSnapshot() const
+{
+    return _lastSnapshot;
+}
+
+/**
+ * Get the amount of temperature and air pressure readings that were rejected as a spike since the start.
+ *
+ * @return The amount of spikes.
+ */
+uint32_t DM_BMP280Sensor::getAmountOfSpikes() const
+{
+    return _temperatureFilter.getAmountOfSpikes() + _pressureFilter.getAmountOfSpikes();
+}
+
+/**
+ * Create the BH1750 sensor.
+ *
+ * @param measurementChip The BH1750 chip object (a reference to the already created object).
+ */
+DM_BH1750Sensor::DM_BH1750Sensor(BH1750 &measurementChip) : _measurementChip(measurementChip), _conversionStarted(false), _lightFilter(0.1, 0, 5, 2, 0.05)
+{
+}
+
+/**
+ * Initialize the BH1750 chip.
+ *
+ * @return The success rate of the initialization.
+ */
+bool DM_BH1750Sensor::begin()
+{
+    // Forget the filter state of before a reset (it is only picked up again after a deep sleep)
+    _lightFilter.saveState(_savedLightFilter);
+    return DM_Measurer::initializeBH1750(_measurementChip);
+}
+
+/**
+ * Get the BH1750 ready again after a deep sleep (the auto-ranged measurement time and the state of the filter are kept in RTC memory).
+ *
+ * @return The success rate.
+ */
+bool DM_BH1750Sensor::resume()
+{
+    _lightFilter.restoreState(_savedLightFilter);
+    return DM_Measurer::resumeBH1750();
+}
+
+/**
+ * Start one conversion of the BH1750 (this returns right away).
+ *
+ * @return The success rate of starting the conversion.
+ */
+bool DM_BH1750Sensor::startConversion()
+{
+    _conversionStarted = DM_Measurer::BH1750startConversion();
+    return _conversionStarted;
+}
+
+/**
+ * Check if the conversion is finished (this never waits).
+ *
+ * @return True if the result can be collected.
+ */
+bool DM_BH1750Sensor::isConversionReady()
+{
+    return !_conversionStarted || DM_Measurer::BH1750isConversionReady();
+}
+
+/**
+ * Read the result of the conversion and add it to the burst (nothing is added if the conversion couldn't be started or the result couldn't be read).
+ */
+void DM_BH1750Sensor::readConversion()
+{
+    if (!_conversionStarted)
+        return;
+    float lightIntensityLux = DM_Measurer::BH1750collectLightLevelLux();
+    _lightFilter.addReading(lightIntensityLux < 0 ? NAN : lightIntensityLux);
+}
+
+/**
+ * Filter the readings of the burst and fill in the value of this sensor in the sample.
+ *
+ * @param sample The sample to fill in.
+ */
+void DM_BH1750Sensor::collect(DM_Sample &sample)
+{
+    // Turn the burst into one reading and show what was rejected
+    sample.lightIntensityLux = _lightFilter.filterBurst();
+    _lightFilter.saveState(_savedLightFilter);
+    if (_lightFilter.wasSpike())
+        DM_LOG_WARNING("DM_Sensors", "Rejected a light intensity spike of %.1f lux (replaced by %.1f lux).", _lightFilter.getLastMedian(), sample.lightIntensityLux);
+}
+
+/**
+ * Get the amount of light intensity readings that were rejected as a spike since the start.
+ *
+ * @return The amount of spikes.
+ */
+uint32_t DM_BH1750Sensor::getAmountOfSpikes() const
+{
+    return _lightFilter.getAmountOfSpikes();
+}
\ No newline at end of file
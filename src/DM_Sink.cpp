@@ -0,0 +1,277 @@
+/** +----------------------------------------------+
+ *  |    DM_Sink - Fan-out of the measurements     |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "Arduino.h" // Include the Arduino library
+#include "DM_Sink.h" // Include the header file where the declarations for this library are stored
+#include <DM_Log.h>  // Include the self-made library that prints the status messages without waiting for the serial port
+
+// INITIALIZE THE CLASS MEMBERS (if we don't do this, the code will give errors saying these should be initialised first)
+volatile bool DM_Sink::_networkAvailable = false; // If we are connected to the Wi-Fi network
+
+/**
+ * Create a sink (its task is only started by start()).
+ *
+ * @param name The name that is used as prefix when printing status messages (e.g. "DM_Discord").
+ * @param maxSamplesPerBatch The most measurements the sink can deliver together (at most "maxBatchSize").
+ */
+DM_Sink::DM_Sink(const char *name, size_t maxSamplesPerBatch)
+    : _name(name), _maxSamplesPerBatch(max((size_t)1, min(maxSamplesPerBatch, maxBatchSize))), _samplesPerBatch(1), _maxDelayMs(0), _batchAmount(0), _oldestBatchedMs(0),
+      _retryDelayMs(initialRetryDelayMs), _nextAttemptMs(0), _taskHandle(NULL), _startMs(0), _deliveredSamples(0), _amountOfDeliveries(0), _failedDeliveries(0), _spilledSamples(0), _droppedSamples(0), _deliveryTimeMs(0)
+{
+}
+
+/**
+ * Set how many measurements are delivered together (call this before start()).
+ *
+ * @param samplesPerBatch The amount of measurements that fill a batch (1 delivers every measurement on its own, the highest value is the one the sink was created with).
+ * @param maxDelayMs The longest time a measurement may wait before its batch is delivered anyway.
+ */
+void DM_Sink::setBatchPolicy(size_t samplesPerBatch, uint32_t maxDelayMs)
+{
+    _samplesPerBatch = max((size_t)1, min(samplesPerBatch, _maxSamplesPerBatch));
+    _maxDelayMs = maxDelayMs;
+}
+
+/**
+ * Start the task of the sink.
+ *
+ * @param core The core to run the task on.
+ * @param priority The priority of the task.
+ * @param stackSize The size of the stack of the task in bytes (a sink that uses TLS needs more).
+ *
+ * @return The success rate of starting the task.
+ */
+bool DM_Sink::start(BaseType_t core, UBaseType_t priority, uint32_t stackSize)
+{
+    _startMs = millis();
+    if (xTaskCreatePinnedToCore(DM_Sink::_task, _name, stackSize, this, priority, &_taskHandle, core) == pdPASS)
+        return true;
+
+    // Inform the user
+    DM_LOG_ERROR(_name, "Not enough memory to start the task.");
+    _taskHandle = NULL;
+    return false;
+}
+
+/**
+ * Check if the task of the sink is running.
+ *
+ * @return True if the sink has been started.
+ */
+bool DM_Sink::isStarted() const
+{
+    return _taskHandle != NULL;
+}
+
+/**
+ * Offer a measurement to the sink (only call this from one task). This never waits: the measurement is copied into the queue of the sink and its task is woken up.
+ *
+ * @param sample The measurement to offer.
+ *
+ * @return False if the sink isn't started, or if its queue was full and the measurement has been dropped.
+ */
+bool DM_Sink::offer(const DM_Sample &sample)
+{
+    if (_taskHandle == NULL || !_queue.push(sample))
+        return false;
+    xTaskNotifyGive(_taskHandle);
+    return true;
+}
+
+/**
+ * Get the name of the sink.
+ *
+ * @return The name of the sink.
+ */
+const char *DM_Sink::getName() const
+{
+    return _name;
+}
+
+/**
+ * Get the amount of measurements the sink delivered since it was started.
+ *
+ * @return The amount of delivered measurements.
+ */
+uint32_t DM_Sink::getAmountOfDeliveredSamples() const
+{
+    return _deliveredSamples;
+}
+
+/**
+ * Get the amount of measurements that were dropped because the queue of the sink was full, or because they can never be delivered (see "dropSamples()").
+ *
+ * @return The amount of dropped measurements.
+ */
+uint32_t DM_Sink::getAmountOfDroppedSamples() const
+{
+    return _queue.getOverruns() + _droppedSamples;
+}
+
+/**
+ * Print the throughput of the sink, the result of its deliveries and the state of its queue.
+ */
+void DM_Sink::printStatistics() const
+{
+    uint32_t runningMs = millis() - _startMs;
+    DM_LOG_INFO(_name, "%lu measurement(s) delivered (%lu/h) in %lu batch(es), average %lu ms, %lu failed, %lu spilled, %lu waiting, %lu dropped.", (unsigned long)_deliveredSamples,
+                (unsigned long)(runningMs > 0 ? (uint64_t)_deliveredSamples * 3600000 / runningMs : 0), (unsigned long)_amountOfDeliveries, (unsigned long)(_amountOfDeliveries > 0 ? _deliveryTimeMs / _amountOfDeliveries : 0),
+                (unsigned long)_failedDeliveries, (unsigned long)_spilledSamples, (unsigned long)(_queue.getDepth() + _batchAmount), (unsigned long)getAmountOfDroppedSamples());
+}
+
+/**
+ * Tell every sink if we are connected to the Wi-Fi network.
+ *
+ * @param networkAvailable If we are connected to the Wi-Fi network.
+ */
+void DM_Sink::setNetworkAvailable(bool networkAvailable)
+{
+    DM_Sink::_networkAvailable = networkAvailable;
+}
+
+/**
+ * Do what the sink needs to do on every wakeup of its task (nothing by default).
+ */
+void DM_Sink::service()
+{
+}
+
+/**
+ * Check if a batch may be delivered now.
+ *
+ * @return True if the network is available (sinks that have a connection or a rate limit of their own check those as well).
+ */
+bool DM_Sink::isReady()
+{
+    return DM_Sink::isNetworkAvailable();
+}
+
+/**
+ * Handle a batch that is due but can't be delivered now, or whose delivery just failed (by default it is kept and retried).
+ *
+ * @param samples The measurements of the batch (oldest first).
+ * @param amount The amount of measurements.
+ *
+ * @return True if the batch has been taken care of (it is removed from the sink).
+ */
+bool DM_Sink::spill(const DM_Sample *samples, size_t amount)
+{
+    return false;
+}
+
+/**
+ * Get the amount of measurements that fill a batch.
+ *
+ * @return The amount of measurements per batch.
+ */
+size_t DM_Sink::getSamplesPerBatch() const
+{
+    return _samplesPerBatch;
+}
+
+/**
+ * Count measurements of the batch that can never be delivered (call it from deliver() and return true, so they are not retried).
+ *
+ * @param amount The amount of dropped measurements.
+ */
+void DM_Sink::dropSamples(size_t amount)
+{
+    _droppedSamples += amount;
+}
+
+/**
+ * Check if we are connected to the Wi-Fi network.
+ *
+ * @return True if the network is available.
+ */
+bool DM_Sink::isNetworkAvailable()
+{
+    return DM_Sink::_networkAvailable;
+}
+
+/**
+ * The task of a sink (FreeRTOS needs a plain function, so this passes control to the sink itself).
+ *
+ * @param parameters The sink.
+ */
+void DM_Sink::_task(void *parameters)
+{
+    static_cast<DM_Sink *>(parameters)->_run();
+}
+
+/**
+ * Move the offered measurements into the batch and deliver it when it is full or its oldest measurement waited long enough (runs forever in the task of the sink).
+ */
+void DM_Sink::_run()
+{
+    for (;;)
+    {
+        // Let the sink keep its connection alive
+        service();
+
+        // Move the waiting measurements into the batch
+        while (_batchAmount < _samplesPerBatch && _queue.pop(_batch[_batchAmount]))
+        {
+            if (_batchAmount == 0)
+                _oldestBatchedMs = millis();
+            _batchAmount += 1;
+        }
+
+        // Deliver the batch when it is due (and not waiting after a failure), or spill it when it can't be delivered now
+        uint32_t now = millis();
+        bool due = _batchAmount > 0 && (_batchAmount >= _samplesPerBatch || now - _oldestBatchedMs >= _maxDelayMs);
+        if (due && (int32_t)(now - _nextAttemptMs) >= 0)
+        {
+            if (isReady())
+            {
+                _deliverBatch();
+            }
+            else if (spill(_batch, _batchAmount))
+            {
+                _spilledSamples += _batchAmount;
+                _batchAmount = 0;
+            }
+        }
+
+        // Go on right away if the next batch is already waiting, otherwise sleep until a measurement is offered
+        if (_batchAmount == 0 && _queue.getDepth() >= _samplesPerBatch)
+            continue;
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(pollPeriodMs));
+    }
+}
+
+/**
+ * Deliver the batch. When that failed, hand it to spill(), or keep it for a retry (after a growing delay) if the sink doesn't take it.
+ */
+void DM_Sink::_deliverBatch()
+{
+    uint32_t startMs = millis();
+    uint32_t droppedSamples = _droppedSamples;
+    if (!deliver(_batch, _batchAmount))
+    {
+        // Let the sink keep the batch somewhere else, so the queue doesn't fill up while the destination is unreachable
+        _failedDeliveries += 1;
+        if (spill(_batch, _batchAmount))
+        {
+            _spilledSamples += _batchAmount;
+            _batchAmount = 0;
+        }
+
+        // Wait before the next try, and wait longer after every next failure
+        _nextAttemptMs = millis() + _retryDelayMs;
+        _retryDelayMs = min(_retryDelayMs * 2, maxRetryDelayMs);
+        return;
+    }
+
+    // Keep track of the throughput and empty the batch
+    _deliveryTimeMs += millis() - startMs;
+    _deliveredSamples += _batchAmount - (_droppedSamples - droppedSamples);
+    _amountOfDeliveries += 1;
+    _batchAmount = 0;
+    _retryDelayMs = initialRetryDelayMs;
+}
\ No newline at end of file
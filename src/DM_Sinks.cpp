@@ -0,0 +1,542 @@
+/** +----------------------------------------------+
+ *  | DM_Sinks - Destinations of the measurements  |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "Arduino.h"       // Include the Arduino library
+#include "DM_Sinks.h"      // Include the header file where the declarations for this library are stored
+#include <HTTPClient.h>    // Used to send the InfluxDB line protocol over HTTP
+#include <DM_ThingSpeak.h> // Include the self-made library that sends the measurements to ThingSpeak
+#include <DM_Discord.h>    // Include the self-made library that sends the measurements to Discord
+#include <DM_Storage.h>    // Include the self-made library that keeps the measurements on flash while we are offline
+#include <DM_Format.h>     // Include the self-made library that writes the payloads without allocating memory
+#include <DM_Sample.h>     // Include the self-made library that converts the measurements to fixed-point for the binary payloads
+#include <DM_Profiler.h>   // Include the self-made library that measures how long writing a payload takes
+#include <DM_Log.h>        // Include the self-made library that prints the status messages without waiting for the serial port
+using namespace std;       // Used to be able to use the string type without needing to say "std::string" every time
+
+// OTHER VARIABLES
+const uint32_t MQTTSinkConnectTimeoutMs = 0;    // The connect() call of the MQTT sink is synchronous (so no connect timeout)
+const uint32_t MQTTSinkInitialBackoffMs = 1000; // Wait 1 second after the first failed connection attempt
+const uint32_t MQTTSinkMaxBackoffMs = 60000;    // Never wait more than one minute between two connection attempts
+
+/**
+ * Append text to a line of the InfluxDB line protocol, with a backslash before the characters that have a meaning in it (spaces, commas and equal signs).
+ *
+ * @param line The line to append to.
+ * @param text The text to append.
+ */
+static void appendEscaped(DM_Formatter &line, const char *text)
+{
+    for (const char *character = text; *character != '\0'; character++)
+    {
+        if (*character == ' ' || *character == ',' || *character == '=')
+            line.append("\\", 1);
+        line.append(character, 1);
+    }
+}
+
+/**
+ * Create the ThingSpeak sink.
+ *
+ * @param replayBatch The buffer the stored measurements are read into before they are replayed (it has to stay valid).
+ * @param replayBatchSize The size of that buffer (at most "DM_ThingSpeak::maxBatchSize").
+ */
+DM_ThingSpeakSink::DM_ThingSpeakSink(DM_Sample *replayBatch, size_t replayBatchSize)
+    : DM_Sink("DM_ThingSpeak", DM_Sink::maxBatchSize), _replayBatch(replayBatch), _replayBatchSize(min(replayBatchSize, DM_ThingSpeak::maxBatchSize)),
+      _unreachable(false)
+{
+}
+
+/**
+ * Tell the MQTT service task if it can connect, and replay the measurements that were stored while we were offline in one batch (oldest first). They only leave the flash log once ThingSpeak accepted them.
+ */
+void DM_ThingSpeakSink::service()
+{
+    DM_ThingSpeak::setNetworkAvailable(isNetworkAvailable());
+    if (isNetworkAvailable() && !DM_StorageLog::isEmpty() && DM_ThingSpeak::isBulkUpdateAllowed())
+    {
+        size_t amount = DM_StorageLog::readBatch(_replayBatch, _replayBatchSize);
+        if (amount == 0)
+            return;
+        _unreachable = !DM_ThingSpeak::publishBatch(_replayBatch, amount);
+        if (!_unreachable)
+            DM_StorageLog::commitBatch(amount);
+    }
+}
+
+/**
+ * Check if a batch may be sent now: only when nothing older is waiting in the flash log (so everything arrives in order), and ThingSpeak accepts a bulk update or we are connected to the MQTT server.
+ *
+ * @return True if the batch may be sent.
+ */
+bool DM_ThingSpeakSink::isReady()
+{
+    if (!isNetworkAvailable() || !DM_StorageLog::isEmpty())
+        return false;
+    return getSamplesPerBatch() > 1 ? DM_ThingSpeak::isBulkUpdateAllowed() : DM_ThingSpeak::isConnected();
+}
+
+/**
+ * Send a batch in one bulk update, or hand every measurement to the MQTT service task when batching is off.
+ *
+ * @param samples The measurements (oldest first).
+ * @param amount The amount of measurements.
+ *
+ * @return The success rate of sending the batch.
+ */
+bool DM_ThingSpeakSink::deliver(const DM_Sample *samples, size_t amount)
+{
+    if (getSamplesPerBatch() > 1)
+    {
+        _unreachable = !DM_ThingSpeak::publishBatch(samples, amount);
+        return !_unreachable;
+    }
+
+    bool queued = true;
+    for (size_t i = 0; i < amount; i++)
+        queued = DM_ThingSpeak::publishInformation(samples[i]) && queued;
+    return queued;
+}
+
+/**
+ * Keep a batch that can't be sent (or whose bulk update failed) in the flash log, so it is replayed later (in order).
+ * Only a batch that waits for the next bulk update while ThingSpeak is reachable is kept in memory: with Wi-Fi but without internet the queue would fill up and drop the newest measurements.
+ *
+ * @param samples The measurements (oldest first).
+ * @param amount The amount of measurements.
+ *
+ * @return True if the batch has been stored.
+ */
+bool DM_ThingSpeakSink::spill(const DM_Sample *samples, size_t amount)
+{
+    // ThingSpeak is reachable but doesn't accept a bulk update yet, so just wait
+    if (isNetworkAvailable() && DM_StorageLog::isEmpty() && getSamplesPerBatch() > 1 && !_unreachable)
+        return false;
+
+    // Store the measurements
+    for (size_t i = 0; i < amount; i++)
+        DM_StorageLog::append(samples[i]);
+
+    // Inform the user
+    DM_LOG_INFO("DM_Storage", "%lu measurement(s) stored, %lu measurement(s) waiting to be replayed.", (unsigned long)amount, (unsigned long)DM_StorageLog::getAmountOfStoredSamples());
+    return true;
+}
+
+/**
+ * Create the Discord sink (one batch is one message).
+ */
+DM_DiscordSink::DM_DiscordSink() : DM_Sink("DM_Discord", DM_WebhookConnector::maxSamplesPerMessage)
+{
+}
+
+/**
+ * Check if a message may be sent now.
+ *
+ * @return True if the network is available and Discord's rate limit allows it.
+ */
+bool DM_DiscordSink::isReady()
+{
+    return isNetworkAvailable() && DM_WebhookConnector::isRateLimitOver();
+}
+
+/**
+ * Show a batch of measurements in one message (a batch that doesn't fit in one message is dropped instead of retried).
+ *
+ * @param samples The measurements (oldest first).
+ * @param amount The amount of measurements.
+ *
+ * @return The success rate of sending the message.
+ */
+bool DM_DiscordSink::deliver(const DM_Sample *samples, size_t amount)
+{
+    DM_DiscordResult result = DM_WebhookConnector::sendSamples(samples, amount);
+    if (result == DM_DISCORD_TOO_LARGE)
+        dropSamples(amount);
+    return result != DM_DISCORD_FAILED;
+}
+
+/**
+ * Create the InfluxDB sink (set the server with setUDPServer() or setHTTPServer() before it is started).
+ */
+DM_InfluxSink::DM_InfluxSink()
+    : DM_Sink("DM_Influx", DM_Sink::maxBatchSize), _port(0), _measurement("weather"), _station("station"), _fields(nullptr), _amountOfFields(0)
+{
+}
+
+/**
+ * Send the lines over UDP (InfluxDB 1.x has a UDP listener, Telegraf has the "socket_listener" input). There is no reply, so a line that is lost is not noticed.
+ *
+ * @param host The host of the UDP listener.
+ * @param port The port of the UDP listener.
+ */
+void DM_InfluxSink::setUDPServer(string host, uint16_t port)
+{
+    _host = host;
+    _port = port;
+}
+
+/**
+ * Send the lines over HTTP to the write API of InfluxDB 2.x.
+ *
+ * @param writeURL The URL of the write API with the organization, bucket and "precision=s" (e.g. "http://influx.local:8086/api/v2/write?org=home&bucket=weather&precision=s").
+ * @param token An API token that is allowed to write to the bucket.
+ */
+void DM_InfluxSink::setHTTPServer(string writeURL, string token)
+{
+    _writeURL = writeURL;
+    _token = token;
+    _port = 0;
+}
+
+/**
+ * Set the name of the measurement and the "station" tag of every line.
+ *
+ * @param measurement The name of the measurement.
+ * @param station The name of the station.
+ */
+void DM_InfluxSink::setMeasurement(string measurement, string station)
+{
+    _measurement = measurement;
+    _station = station;
+}
+
+/**
+ * Set the values of a measurement that are written (normally the fields of the sensor set).
+ *
+ * @param fields The table of fields (it has to stay valid).
+ * @param amountOfFields The amount of fields.
+ */
+void DM_InfluxSink::setFields(const DM_Field *fields, size_t amountOfFields)
+{
+    _fields = fields;
+    _amountOfFields = amountOfFields;
+}
+
+/**
+ * Write a batch of measurements over UDP or HTTP.
+ *
+ * @param samples The measurements (oldest first).
+ * @param amount The amount of measurements.
+ *
+ * @return The success rate of sending the batch.
+ */
+bool DM_InfluxSink::deliver(const DM_Sample *samples, size_t amount)
+{
+    return _port != 0 ? _sendUDP(samples, amount) : _sendHTTP(samples, amount);
+}
+
+/**
+ * Write one measurement as a line of the line protocol, e.g. "weather,station=garden Temperature=21.50,Air\ pressure=101325.00 1700000000".
+ * The values that couldn't be measured are left out, the time is left out if the clock wasn't synchronized (InfluxDB uses the time of arrival then).
+ *
+ * @param buffer The buffer the line will be written to.
+ * @param bufferSize The size of the buffer.
+ * @param sample The measurement.
+ *
+ * @return The length of the line including its newline (0 if it has no values or didn't fit in the buffer).
+ */
+size_t DM_InfluxSink::_writeLine(char *buffer, size_t bufferSize, const DM_Sample &sample)
+{
+    // Write the measurement and the tag
+    DM_Formatter line(buffer, bufferSize);
+    appendEscaped(line, _measurement.c_str());
+    line.appendLiteral(",station=");
+    appendEscaped(line, _station.c_str());
+
+    // Write the values
+    size_t amountOfValues = 0;
+    for (size_t i = 0; i < _amountOfFields; i++)
+    {
+        float value = sample.*_fields[i].member;
+        if (isnan(value) || isinf(value))
+            continue;
+        line.append(amountOfValues == 0 ? " " : ",", 1);
+        appendEscaped(line, _fields[i].name);
+        line.appendLiteral("=").appendFixed(value, 2);
+        amountOfValues += 1;
+    }
+
+    // Write the time and end the line
+    if (sample.epochSeconds != 0)
+        line.appendLiteral(" ").appendUnsigned(sample.epochSeconds);
+    line.appendLiteral("\n");
+    return amountOfValues == 0 || line.hasOverflowed() ? 0 : line.length();
+}
+
+/**
+ * Send the lines in as few datagrams as possible (every datagram stays below "maxDatagramSize").
+ *
+ * @param samples The measurements (oldest first).
+ * @param amount The amount of measurements.
+ *
+ * @return The success rate of sending the datagrams.
+ */
+bool DM_InfluxSink::_sendUDP(const DM_Sample *samples, size_t amount)
+{
+    bool sent = true;
+    size_t datagramLength = 0;
+    for (size_t i = 0; i <= amount; i++)
+    {
+        // Write the next line behind the ones that are waiting
+        size_t lineLength = i < amount ? _writeLine(_body + datagramLength, sizeof(_body) - datagramLength, samples[i]) : 0;
+
+        // Send the waiting lines when the datagram is full or when this was the last line
+        if (datagramLength > 0 && (i == amount || datagramLength + lineLength > maxDatagramSize))
+        {
+            sent = _UDP.beginPacket(_host.c_str(), _port) && _UDP.write((const uint8_t *)_body, datagramLength) == datagramLength && _UDP.endPacket() && sent;
+            memmove(_body, _body + datagramLength, lineLength);
+            datagramLength = 0;
+        }
+        datagramLength += lineLength;
+    }
+    return sent;
+}
+
+/**
+ * Send all lines in one request to the write API.
+ *
+ * @param samples The measurements (oldest first).
+ * @param amount The amount of measurements.
+ *
+ * @return The success rate of the request.
+ */
+bool DM_InfluxSink::_sendHTTP(const DM_Sample *samples, size_t amount)
+{
+    // Write the lines after each other
+    size_t bodyLength = 0;
+    for (size_t i = 0; i < amount; i++)
+        bodyLength += _writeLine(_body + bodyLength, sizeof(_body) - bodyLength, samples[i]);
+    if (bodyLength == 0)
+        return true;
+
+    // Send the request (204 = the lines have been written)
+    char authorization[96];
+    DM_Formatter(authorization, sizeof(authorization)).appendLiteral("Token ").append(_token.c_str());
+    HTTPClient HTTPClientForInflux;
+    HTTPClientForInflux.begin(_writeURL.c_str());
+    HTTPClientForInflux.addHeader("Authorization", authorization);
+    HTTPClientForInflux.addHeader("Content-Type", "text/plain; charset=utf-8");
+    int responseCode = HTTPClientForInflux.POST((uint8_t *)_body, bodyLength);
+    HTTPClientForInflux.end();
+
+    // Inform the user if something went wrong
+    if (responseCode != 204)
+    {
+        DM_LOG_WARNING("DM_Influx", "Something went wrong while writing to InfluxDB (response code %d).", responseCode);
+    }
+
+    // Return the success rate
+    return responseCode == 204;
+}
+
+/**
+ * Create the MQTT sink (set the broker with setBroker() before it is started).
+ */
+DM_MQTTSink::DM_MQTTSink()
+    : DM_Sink("DM_MQTT", DM_Sink::maxBatchSize), _port(1883), _topic("weather"), _fields(nullptr), _amountOfFields(0), _format(DM_PAYLOAD_JSON), _stationID(0), _bootID(0), _sequence(0), _MQTTClient(_WiFiClient),
+      _stateMachine("DM_MQTT", MQTTSinkConnectTimeoutMs, MQTTSinkInitialBackoffMs, MQTTSinkMaxBackoffMs)
+{
+}
+
+/**
+ * Set the broker and the credentials of the MQTT connection.
+ *
+ * @param host The host of the broker.
+ * @param port The port of the broker (normally 1883).
+ * @param clientID The client ID for the MQTT connection.
+ * @param username The username for the MQTT connection (empty if the broker doesn't need one).
+ * @param password The password for the MQTT connection.
+ */
+void DM_MQTTSink::setBroker(string host, uint16_t port, string clientID, string username, string password)
+{
+    _host = host;
+    _port = port;
+    _clientID = clientID;
+    _username = username;
+    _password = password;
+}
+
+/**
+ * Set the topic the measurements are published to.
+ *
+ * @param topic The topic.
+ */
+void DM_MQTTSink::setTopic(string topic)
+{
+    _topic = topic;
+}
+
+/**
+ * Set the values of a measurement that are published (normally the fields of the sensor set).
+ *
+ * @param fields The table of fields (it has to stay valid).
+ * @param amountOfFields The amount of fields.
+ */
+void DM_MQTTSink::setFields(const DM_Field *fields, size_t amountOfFields)
+{
+    _fields = fields;
+    _amountOfFields = amountOfFields;
+}
+
+/**
+ * Move the MQTT connection one step forward (IDLE → CONNECTING → CONNECTED, and BACKOFF after a failure) and let the client send its keepalive pings.
+ */
+void DM_MQTTSink::service()
+{
+    // Without a network there is nothing to connect to, so start from the beginning once the network is back
+    if (!isNetworkAvailable())
+    {
+        if (_stateMachine.getState() != DM_STATE_IDLE)
+        {
+            _MQTTClient.disconnect();
+            _stateMachine.changeState(DM_STATE_IDLE);
+        }
+        return;
+    }
+
+    // Do what is needed in the current state
+    switch (_stateMachine.getState())
+    {
+    case DM_STATE_IDLE:
+        _MQTTClient.setServer(_host.c_str(), _port);
+        _MQTTClient.setSocketTimeout(2);
+
+        // A binary payload of a full batch doesn't fit in the default buffer of the client (256 bytes), so make room for it, its topic and the header of the packet
+        if (_format == DM_PAYLOAD_BINARY)
+            _MQTTClient.setBufferSize(sizeof(_payload) + _topic.length() + MQTT_MAX_HEADER_SIZE + 2);
+        _stateMachine.changeState(DM_STATE_CONNECTING);
+        break;
+
+    case DM_STATE_CONNECTING:
+        // Connect (without credentials if the broker doesn't need them)
+        if (_MQTTClient.connect(_clientID.c_str(), _username.empty() ? nullptr : _username.c_str(), _username.empty() ? nullptr : _password.c_str()))
+        {
+            DM_LOG_INFO("DM_MQTT", "Successfully connected to the MQTT broker!");
+            _stateMachine.changeState(DM_STATE_CONNECTED);
+        }
+        else
+        {
+            DM_LOG_WARNING("DM_MQTT", "Something went wrong while connecting to the MQTT broker (state %d).", _MQTTClient.state());
+            _stateMachine.changeState(DM_STATE_BACKOFF);
+        }
+        break;
+
+    case DM_STATE_CONNECTED:
+        // Service the client, and reconnect when the connection has been lost
+        if (!_MQTTClient.loop())
+        {
+            DM_LOG_WARNING("DM_MQTT", "The connection to the MQTT broker has been disconnected. Trying to reconnect...");
+            _stateMachine.changeState(DM_STATE_IDLE);
+        }
+        break;
+
+    case DM_STATE_BACKOFF:
+        // Start a new attempt when we waited long enough
+        if (_stateMachine.isBackoffOver())
+            _stateMachine.changeState(DM_STATE_IDLE);
+        break;
+
+    default:
+        break;
+    }
+}
+
+/**
+ * Check if the measurements can be published now.
+ *
+ * @return True if we are connected to the broker.
+ */
+bool DM_MQTTSink::isReady()
+{
+    return isNetworkAvailable() && _stateMachine.getState() == DM_STATE_CONNECTED;
+}
+
+/**
+ * Choose the format of the payloads. A binary payload carries a whole batch (see "setBatchPolicy()") in one message, so set a batch size above 1 to get the most out of it.
+ *
+ * @param format The format of the payloads.
+ * @param stationID The station ID in a binary payload (e.g. the ThingSpeak channel number, the ingest server stores the measurements per station).
+ */
+void DM_MQTTSink::setPayloadFormat(DM_PayloadFormat format, uint32_t stationID)
+{
+    _format = format;
+    _stationID = stationID;
+
+    // Pick the boot ID ("random()" uses the hardware random number generator), the sequence numbers start again at 0
+    _bootID = (uint32_t)random(0x7FFFFFFF);
+    _sequence = 0;
+}
+
+/**
+ * Publish a batch in the chosen format.
+ *
+ * @param samples The measurements (oldest first).
+ * @param amount The amount of measurements.
+ *
+ * @return The success rate of publishing the batch (after a failure the whole batch is retried).
+ */
+bool DM_MQTTSink::deliver(const DM_Sample *samples, size_t amount)
+{
+    return _format == DM_PAYLOAD_BINARY ? _deliverBinary(samples, amount) : _deliverJSON(samples, amount);
+}
+
+/**
+ * Publish every measurement of a batch as one JSON message, e.g. {"epochSeconds":1700000000,"Temperature":21.50,"Light intensity":340.00}.
+ *
+ * @param samples The measurements (oldest first).
+ * @param amount The amount of measurements.
+ *
+ * @return The success rate of publishing all of them (after a failure the whole batch is retried, so a measurement can be published twice).
+ */
+bool DM_MQTTSink::_deliverJSON(const DM_Sample *samples, size_t amount)
+{
+    for (size_t i = 0; i < amount; i++)
+    {
+        // Build the JSON
+        char payload[192];
+        DM_Formatter JSON(payload, sizeof(payload));
+        {
+            DM_PROFILE_SCOPE(DM_STAGE_ENCODE_PAYLOAD);
+            JSON.appendLiteral("{\"epochSeconds\":").appendUnsigned(samples[i].epochSeconds);
+            for (size_t j = 0; j < _amountOfFields; j++)
+                JSON.appendLiteral(",\"").append(_fields[j].name).appendLiteral("\":").appendFixed(samples[i].*_fields[j].member, 2);
+            JSON.appendLiteral("}");
+        }
+
+        // Publish it, and stop at the first failure (the batch is retried later)
+        if (!JSON.hasOverflowed() && !_MQTTClient.publish(_topic.c_str(), JSON.c_str()))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Publish a batch as one binary message (see "DM_Payload.h"). The sequence number only moves on once the message is published,
+ * so a batch that is retried has the same boot ID and sequence numbers and the server skips the measurements it already has.
+ *
+ * @param samples The measurements (oldest first).
+ * @param amount The amount of measurements (at most "DM_Sink::maxBatchSize", so they always fit).
+ *
+ * @return The success rate of publishing the message.
+ */
+bool DM_MQTTSink::_deliverBinary(const DM_Sample *samples, size_t amount)
+{
+    // Build the payload
+    DM_PayloadEncoder encoder;
+    {
+        DM_PROFILE_SCOPE(DM_STAGE_ENCODE_PAYLOAD);
+        encoder.begin(_payload, sizeof(_payload), _stationID, _bootID, _sequence);
+        for (size_t i = 0; i < amount; i++)
+            encoder.add(DM_PackedSample::pack(samples[i]), samples[i].epochSeconds);
+    }
+
+    // Publish it
+    if (!_MQTTClient.publish(_topic.c_str(), _payload, encoder.getLength()))
+        return false;
+    _sequence += encoder.getAmount();
+    return true;
+}
\ No newline at end of file
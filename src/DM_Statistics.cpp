@@ -0,0 +1,305 @@
+/** +----------------------------------------------+
+ *  |     DM_Statistics - Windowed statistics      |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "Arduino.h"       // Include the Arduino library
+#include "DM_Statistics.h" // Include the header file where the declarations for this library are stored
+#include <DM_Log.h>        // Include the self-made library that prints the status messages without waiting for the serial port
+
+/**
+ * Create empty running statistics.
+ */
+DM_RunningStatistics::DM_RunningStatistics()
+{
+    clear();
+}
+
+/**
+ * Forget all readings.
+ */
+void DM_RunningStatistics::clear()
+{
+    _amount = 0;
+    _mean = 0;
+    _sumOfSquares = 0;
+    _minimum = NAN;
+    _maximum = NAN;
+    _last = NAN;
+}
+
+/**
+ * Add one reading (Welford's algorithm, this takes the same time no matter how many readings were added before).
+ *
+ * @param value The reading to add (invalid readings are ignored).
+ */
+void DM_RunningStatistics::add(float value)
+{
+    // Don't let a failed reading spoil the whole window
+    if (isnan(value))
+        return;
+
+    // Update the mean and the sum of squared differences (using the difference with the old and the new mean keeps this accurate in a float)
+    _amount += 1;
+    float difference = value - _mean;
+    _mean += difference / _amount;
+    _sumOfSquares += difference * (value - _mean);
+
+    // Update the extremes and the newest reading
+    _minimum = _amount == 1 || value < _minimum ? value : _minimum;
+    _maximum = _amount == 1 || value > _maximum ? value : _maximum;
+    _last = value;
+}
+
+/**
+ * Add the readings of other running statistics to these ones (Chan's formula, so the readings themselves are not needed). The other statistics have to be the newer ones, because their last reading is taken over.
+ *
+ * @param other The statistics to add.
+ */
+void DM_RunningStatistics::merge(const DM_RunningStatistics &other)
+{
+    // Nothing to add if the other statistics are empty, and nothing to combine with if these are
+    if (other._amount == 0)
+        return;
+    if (_amount == 0)
+    {
+        *this = other;
+        return;
+    }
+
+    // Combine the means and the sums of squared differences
+    uint32_t amount = _amount + other._amount;
+    float difference = other._mean - _mean;
+    _mean += difference * other._amount / amount;
+    _sumOfSquares += other._sumOfSquares + difference * difference * ((float)_amount * other._amount / amount);
+    _amount = amount;
+
+    // Combine the extremes and take over the newest reading
+    _minimum = min(_minimum, other._minimum);
+    _maximum = max(_maximum, other._maximum);
+    _last = other._last;
+}
+
+/**
+ * Get the amount of readings.
+ *
+ * @return The amount of readings that were added.
+ */
+uint32_t DM_RunningStatistics::getAmount() const
+{
+    return _amount;
+}
+
+/**
+ * Get the statistics of all readings that were added.
+ *
+ * @return The statistics (the mean, variance and extremes are NaN when there are no readings).
+ */
+DM_FieldStatistics DM_RunningStatistics::getStatistics() const
+{
+    DM_FieldStatistics statistics;
+    statistics.amount = _amount;
+    statistics.minimum = _minimum;
+    statistics.maximum = _maximum;
+    statistics.mean = _amount > 0 ? _mean : NAN;
+    statistics.variance = _amount > 0 ? _sumOfSquares / _amount : NAN;
+    statistics.last = _last;
+    return statistics;
+}
+
+/**
+ * Create the windowed statistics for the values of a sample (it starts with tumbling windows of one minute).
+ *
+ * @param fields The values of a sample to track (normally the fields of the sensor set, the table has to stay valid).
+ * @param amountOfFields The amount of fields (only the first "DM_WindowSummary::maxAmountOfFields" are tracked).
+ */
+DM_WindowedStatistics::DM_WindowedStatistics(const DM_Field *fields, size_t amountOfFields)
+    : _fields(fields), _amountOfFields(min(amountOfFields, DM_WindowSummary::maxAmountOfFields)), _windowMs(60000), _slideMs(60000), _panesPerWindow(1), _configurationRequested(false)
+{
+    _reset();
+}
+
+/**
+ * Check if a configuration is possible (see "configure()").
+ *
+ * @param windowMs The length of a window.
+ * @param slideMs The time between the start of two windows.
+ *
+ * @return True if the window length is a multiple of the slide, and holds at most "maxAmountOfPanes" slides.
+ */
+bool DM_WindowedStatistics::isValidConfiguration(uint32_t windowMs, uint32_t slideMs)
+{
+    return slideMs != 0 && windowMs >= slideMs && windowMs % slideMs == 0 && windowMs / slideMs <= maxAmountOfPanes;
+}
+
+/**
+ * Set the length of a window and the time between the start of two windows. Every window that is still being filled is thrown away.
+ * The window is split into slides ("panes"): a reading is only added to the statistics of its slide, and when a slide ends the statistics of the last slides are merged into one summary.
+ * With the slide equal to the window length, the windows are tumbling (they don't overlap); with a shorter slide, they are sliding (e.g. the last 5 minutes, every minute).
+ *
+ * @param windowMs The length of a window.
+ * @param slideMs The time between the start of two windows (the window length has to be a multiple of it, and hold at most "maxAmountOfPanes" slides).
+ *
+ * @return False if the configuration is not possible (the old one is kept).
+ */
+bool DM_WindowedStatistics::configure(uint32_t windowMs, uint32_t slideMs)
+{
+    // Check the configuration
+    if (!isValidConfiguration(windowMs, slideMs))
+    {
+        DM_LOG_ERROR("DM_Statistics", "The window has to be a multiple of the slide, and hold at most 16 slides.");
+        return false;
+    }
+
+    // Store the configuration and start over
+    _windowMs = windowMs;
+    _slideMs = slideMs;
+    _panesPerWindow = windowMs / slideMs;
+    _reset();
+
+    // Inform the user
+    DM_LOG_INFO("DM_Statistics", "Windows of %lu s, a new one every %lu s (%s).", (unsigned long)(windowMs / 1000), (unsigned long)(slideMs / 1000), _panesPerWindow == 1 ? "tumbling" : "sliding");
+
+    // Return the success rate
+    return true;
+}
+
+/**
+ * Ask for a new configuration from another task (it is applied by the task that adds the samples, right before it adds the next one).
+ *
+ * @param windowMs The length of a window.
+ * @param slideMs The time between the start of two windows.
+ */
+void DM_WindowedStatistics::requestConfiguration(uint32_t windowMs, uint32_t slideMs)
+{
+    // Store the values before raising the flag ("release"), so the other task sees both of them once it sees the flag
+    _requestedWindowMs = windowMs;
+    _requestedSlideMs = slideMs;
+    _configurationRequested.store(true, std::memory_order_release);
+}
+
+/**
+ * Add the values of a sample to the current window. This takes the same time for every sample, only the end of a slide merges the statistics of the slides in the window.
+ *
+ * @param sample The sample to add.
+ * @param summary The summary that is filled in when a window ended.
+ *
+ * @return True if a window ended and "summary" holds its statistics.
+ */
+bool DM_WindowedStatistics::add(const DM_Sample &sample, DM_WindowSummary &summary)
+{
+    // Apply a configuration that was asked for by another task
+    if (_configurationRequested.exchange(false, std::memory_order_acquire))
+        configure(_requestedWindowMs, _requestedSlideMs);
+
+    // Let the slides line up with multiples of the slide length
+    uint32_t now = sample.timestampMs;
+    if (!_started)
+    {
+        _paneStartMs = now - now % _slideMs;
+        _started = true;
+    }
+
+    // Close the current slide when the sample belongs to a later one
+    bool windowReady = false;
+    if (now - _paneStartMs >= _slideMs)
+    {
+        bool slidesWereSkipped = now - _paneStartMs >= 2 * _slideMs;
+        _closePane(summary, windowReady);
+        _paneStartMs += _slideMs;
+
+        // After a gap (no samples for more than a whole slide) the windows start over, they would only hold empty slides
+        if (slidesWereSkipped)
+        {
+            for (size_t pane = 0; pane < _panesPerWindow; pane++)
+                for (size_t field = 0; field < _amountOfFields; field++)
+                    _panes[pane][field].clear();
+            _amountOfClosedPanes = 0;
+            _paneStartMs = now - now % _slideMs;
+        }
+    }
+
+    // Add the values to the current slide
+    for (size_t field = 0; field < _amountOfFields; field++)
+        _panes[_currentPane][field].add(sample.*_fields[field].member);
+    _lastEpochSeconds = sample.epochSeconds;
+    _lastTimestampMs = now;
+
+    // Return if a window ended
+    return windowReady;
+}
+
+/**
+ * Throw away all slides and start with the next sample.
+ */
+void DM_WindowedStatistics::_reset()
+{
+    _currentPane = 0;
+    _amountOfClosedPanes = 0;
+    _started = false;
+    _lastEpochSeconds = 0;
+    _lastTimestampMs = 0;
+    for (size_t pane = 0; pane < maxAmountOfPanes; pane++)
+        for (size_t field = 0; field < DM_WindowSummary::maxAmountOfFields; field++)
+            _panes[pane][field].clear();
+}
+
+/**
+ * Close the current slide: fill in the summary of the window that ends with it (once the window holds enough slides), and empty the oldest slide so it can be reused.
+ *
+ * @param summary The summary that is filled in.
+ * @param windowReady Set to true if the summary was filled in.
+ */
+void DM_WindowedStatistics::_closePane(DM_WindowSummary &summary, bool &windowReady)
+{
+    // Fill in the summary once the first window is complete
+    _amountOfClosedPanes += 1;
+    uint32_t endMs = _paneStartMs + _slideMs;
+    if (_amountOfClosedPanes >= _panesPerWindow)
+    {
+        summary.startMs = endMs - _windowMs;
+        summary.endMs = endMs;
+        summary.epochSeconds = _lastEpochSeconds != 0 ? _lastEpochSeconds + (endMs - _lastTimestampMs) / 1000 : 0;
+        summary.amountOfFields = _amountOfFields;
+
+        // Merge the slides of the window (oldest first, so the newest reading ends up as the last one)
+        bool hasReadings = false;
+        for (size_t field = 0; field < _amountOfFields; field++)
+        {
+            DM_RunningStatistics window;
+            for (size_t pane = 1; pane <= _panesPerWindow; pane++)
+                window.merge(_panes[(_currentPane + pane) % _panesPerWindow][field]);
+            summary.fields[field] = window.getStatistics();
+            hasReadings = hasReadings || window.getAmount() > 0;
+        }
+        windowReady = hasReadings;
+    }
+
+    // Move on to the next slide, it holds the oldest readings, which leave the window now
+    _currentPane = (_currentPane + 1) % _panesPerWindow;
+    for (size_t field = 0; field < _amountOfFields; field++)
+        _panes[_currentPane][field].clear();
+}
+
+/**
+ * Get the length of a window.
+ *
+ * @return The window length in milliseconds.
+ */
+uint32_t DM_WindowedStatistics::getWindowMs() const
+{
+    return _windowMs;
+}
+
+/**
+ * Get the time between the start of two windows.
+ *
+ * @return The slide in milliseconds.
+ */
+uint32_t DM_WindowedStatistics::getSlideMs() const
+{
+    return _slideMs;
+}
\ No newline at end of file
@@ -0,0 +1,440 @@
+/** +----------------------------------------------+
+ *  |      DM_Storage - Store-and-forward log      |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "Arduino.h"    // Include the Arduino library
+#include "DM_Storage.h" // Include the header file where the declarations for this library are stored
+#include <LittleFS.h>   // Used to store the log on the flash file system (LittleFS spreads the writes over the flash itself)
+#include <DM_Sample.h>  // Used to convert the samples to fixed-point before they are compressed
+#include <DM_Log.h>     // Include the self-made library that prints the status messages without waiting for the serial port
+
+// INITIALIZE THE CLASS MEMBERS (if we don't do this, the code will give errors saying these should be initialised first)
+bool DM_StorageLog::_ready = false;                                          // If the file system has been mounted
+uint32_t DM_StorageLog::_oldestSegment = 0;                                  // The number of the oldest segment file (the one we read from)
+uint32_t DM_StorageLog::_newestSegment = 0;                                  // The number of the newest segment file (the one we append to)
+uint32_t DM_StorageLog::_newestSegmentPages = 0;                             // The amount of pages already written to the newest segment
+uint32_t DM_StorageLog::_readSample = 0;                                     // The index of the next sample to replay, counted from the start of the oldest segment
+RTC_DATA_ATTR DM_StorageReplayPosition DM_StorageLog::_replayPosition;       // The replay position at the last commit (kept in RTC memory during deep sleep)
+uint8_t DM_StorageLog::_page[DM_StorageLog::pageSize];                       // The page that is being filled in RAM (it comes logically after the newest segment)
+DM_Encoder DM_StorageLog::_pageEncoder;                                      // Compresses the samples into the RAM page (behind the page header)
+uint32_t DM_StorageLog::_segmentSamples[DM_StorageLog::maxAmountOfSegments]; // The amount of samples in every segment on flash (at the segment number modulo the maximum amount of segments)
+uint32_t DM_StorageLog::_droppedSamples = 0;                                 // The amount of samples that were dropped because the log was full
+
+// OTHER VARIABLES
+const char *storageLogDirectory = "/dm_log";     // The directory that holds the segment files
+const uint32_t replayPositionMagic = 0x444D4C01; // The value of "magic" for a valid replay position
+
+/**
+ * Mount the file system and find the segments that are still on flash from before the last reboot.
+ *
+ * @return The success rate of mounting the file system.
+ */
+bool DM_StorageLog::begin()
+{
+    // Mount the file system (and format it if this is the first time)
+    if (!LittleFS.begin(true))
+    {
+        DM_LOG_ERROR("DM_Storage", "The flash file system could not be mounted. Samples taken while offline will be lost.");
+        return false;
+    }
+
+    // Make sure the directory exists
+    if (!LittleFS.exists(storageLogDirectory))
+        LittleFS.mkdir(storageLogDirectory);
+
+    // Look for the oldest and the newest segment
+    bool foundSegment = false;
+    File directory = LittleFS.open(storageLogDirectory);
+    File file = directory.openNextFile();
+    while (file)
+    {
+        // The name of a segment is its number (the name can contain the directory, depending on the version of the core)
+        const char *name = strrchr(file.name(), '/');
+        uint32_t segment = strtoul(name ? name + 1 : file.name(), NULL, 10);
+
+        // Remember the lowest and highest number
+        if (!foundSegment || segment < _oldestSegment)
+            _oldestSegment = segment;
+        if (!foundSegment || segment >= _newestSegment)
+            _newestSegment = segment;
+        foundSegment = true;
+
+        // Go to the next file
+        file.close();
+        file = directory.openNextFile();
+    }
+    directory.close();
+
+    // Count the samples in every segment (the amount of samples in a page is in its header, and how many pages the newest segment holds)
+    char path[32];
+    for (uint32_t segment = _oldestSegment; segment <= _newestSegment; segment++)
+    {
+        _segmentPath(segment, path, sizeof(path));
+        _segmentSamples[segment % maxAmountOfSegments] = _countSamplesInFile(path, _newestSegmentPages);
+    }
+
+    // Start with an empty RAM page
+    memset(_page, 0, pageSize);
+    _pageEncoder.begin(_page + pageHeaderSize, pageSize - pageHeaderSize);
+
+    // Continue the replay where it was before a deep sleep (RTC memory only keeps the position if the oldest segment is still the same)
+    // After a power-on or a reset, everything on flash still needs to be replayed (samples that were replayed right before it can be sent twice, but they are never lost)
+    _readSample = 0;
+    if (_replayPosition.magic == replayPositionMagic && _replayPosition.segment == _oldestSegment && _replayPosition.sample <= getAmountOfStoredSamples())
+        _readSample = _replayPosition.sample;
+    _ready = true;
+
+    // Inform the user
+    DM_LOG_INFO("DM_Storage", "Flash log ready, %lu sample(s) waiting to be replayed.", (unsigned long)getAmountOfStoredSamples());
+
+    // Return the success rate
+    return true;
+}
+
+/**
+ * Add a sample to the end of the log. The sample is kept in RAM until a whole page is full, then the page is appended to the newest segment in one write.
+ *
+ * @param sample The sample to store.
+ *
+ * @return False if the file system is not available or the page could not be written.
+ */
+bool DM_StorageLog::append(const DM_Sample &sample)
+{
+    // Don't do anything without a file system
+    if (!_ready)
+        return false;
+
+    // Convert the sample to fixed-point and compress it into the RAM page
+    DM_PackedSample packedSample = DM_PackedSample::pack(sample);
+    if (_pageEncoder.add(packedSample, sample.epochSeconds))
+        return true;
+
+    // Write the page to flash once it is full, and start the next page with this sample
+    bool success = _flushPage();
+    _pageEncoder.add(packedSample, sample.epochSeconds);
+
+    // Return the success rate
+    return success;
+}
+
+/**
+ * Copy the oldest samples that have not been replayed yet. They stay in the log until commitBatch() is called, so a failed upload can simply be retried.
+ *
+ * @param samples The array the samples will be copied into.
+ * @param maxAmount The size of the array.
+ *
+ * @return The amount of samples that have been copied (this never crosses a segment, so it can be less than what is waiting).
+ */
+size_t DM_StorageLog::readBatch(DM_Sample *samples, size_t maxAmount)
+{
+    // Find the segment the next sample is in
+    uint32_t segment = _oldestSegment;
+    uint32_t position = _readSample;
+    while (segment <= _newestSegment && position >= _samplesInSegment(segment))
+    {
+        position -= _samplesInSegment(segment);
+        segment += 1;
+    }
+
+    // Read the samples from the segment file, or from the RAM page if everything on flash has been replayed
+    size_t amount = 0;
+    if (segment <= _newestSegment)
+    {
+        // Go through the segment page by page (whole, aligned pages), skip the pages that have been replayed and decode the rest
+        char path[32];
+        _segmentPath(segment, path, sizeof(path));
+        File file = LittleFS.open(path, "r");
+        uint8_t page[pageSize];
+        while (file && amount < maxAmount && file.read(page, pageSize) == pageSize)
+        {
+            // Skip the page if all of its samples have been replayed
+            uint32_t pageSamples = page[1] == pageFormat ? page[0] : 0;
+            if (position >= pageSamples)
+            {
+                position -= pageSamples;
+                continue;
+            }
+
+            // Decode the samples of the page that have not been replayed yet
+            size_t amountDecoded = _decodePage(page + pageHeaderSize, pageSize - pageHeaderSize, pageSamples, position, samples + amount, maxAmount - amount);
+            if (amountDecoded == 0)
+                break;
+            amount += amountDecoded;
+            position = 0;
+        }
+        file.close();
+    }
+    else
+    {
+        // Decode the RAM page
+        amount = _decodePage(_page + pageHeaderSize, _pageEncoder.getLength(), _pageEncoder.getAmount(), position, samples, maxAmount);
+    }
+
+    // Return the amount of samples that have been copied (this never crosses into the next segment, or into the RAM page)
+    return amount;
+}
+
+/**
+ * Mark samples as replayed (call this after they have been uploaded successfully). Segments that have been replayed completely are deleted.
+ *
+ * @param amount The amount of samples that have been uploaded.
+ */
+void DM_StorageLog::commitBatch(size_t amount)
+{
+    // Move the read position forward, clean up and remember the position for after a deep sleep
+    _readSample += amount;
+    DM_StorageLog::_dropConsumedSegments();
+    DM_StorageLog::_saveReplayPosition();
+}
+
+/**
+ * Write the RAM page to flash, even if it is not full yet (call this before a deep sleep, the RAM page is lost otherwise). The next sample starts a new page.
+ *
+ * @return False if the page could not be written.
+ */
+bool DM_StorageLog::flush()
+{
+    return !_ready || _pageEncoder.getAmount() == 0 || _flushPage();
+}
+
+/**
+ * Check if there are samples waiting to be replayed.
+ *
+ * @return True if there is nothing to replay.
+ */
+bool DM_StorageLog::isEmpty()
+{
+    return getAmountOfStoredSamples() == 0;
+}
+
+/**
+ * Get the amount of samples that are waiting to be replayed (on flash and in the RAM page).
+ *
+ * @return The amount of samples.
+ */
+uint32_t DM_StorageLog::getAmountOfStoredSamples()
+{
+    // Count the samples in every segment and in the RAM page
+    uint32_t amount = _pageEncoder.getAmount();
+    for (uint32_t segment = _oldestSegment; segment <= _newestSegment; segment++)
+        amount += _samplesInSegment(segment);
+
+    // Don't count the samples that have already been replayed
+    return amount - _readSample;
+}
+
+/**
+ * Get the amount of samples that have been dropped because the log was full.
+ *
+ * @return The amount of dropped samples.
+ */
+uint32_t DM_StorageLog::getAmountOfDroppedSamples()
+{
+    return _droppedSamples;
+}
+
+/**
+ * Append the RAM page to the newest segment (start a new segment when the newest one is full, and drop the oldest one when the log is full).
+ *
+ * @return The success rate of the write.
+ */
+bool DM_StorageLog::_flushPage()
+{
+    // Start a new segment if the newest one is full
+    if (_newestSegmentPages == pagesPerSegment)
+    {
+        // Drop the oldest segment first if the log would become too big (its counter is reused by the new segment)
+        if (_newestSegment + 1 - _oldestSegment + 1 > maxAmountOfSegments)
+            _dropOldestSegment();
+        _newestSegment += 1;
+        _newestSegmentPages = 0;
+        _segmentSamples[_newestSegment % maxAmountOfSegments] = 0;
+    }
+
+    // Fill in the page header (the amount of samples and the format) and clear the unused end of the page
+    uint32_t pageSamples = _pageEncoder.getAmount();
+    _page[0] = (uint8_t)pageSamples;
+    _page[1] = pageFormat;
+    memset(_page + pageHeaderSize + _pageEncoder.getLength(), 0, pageSize - pageHeaderSize - _pageEncoder.getLength());
+
+    // Append the page to the newest segment in one write
+    char path[32];
+    _segmentPath(_newestSegment, path, sizeof(path));
+    File file = LittleFS.open(path, "a");
+    bool success = file && file.write(_page, pageSize) == pageSize;
+    file.close();
+
+    // Inform the user if the write failed (the samples in the page that were not replayed yet are lost)
+    if (!success)
+    {
+        DM_LOG_ERROR("DM_Storage", "A page could not be written to flash.");
+        uint32_t samplesOnFlash = getAmountOfStoredSamples() + _readSample - pageSamples;
+        uint32_t replayedPageSamples = _readSample > samplesOnFlash ? _readSample - samplesOnFlash : 0;
+        _droppedSamples += pageSamples - replayedPageSamples;
+        _readSample -= replayedPageSamples;
+    }
+    else
+    {
+        _newestSegmentPages += 1;
+        _segmentSamples[_newestSegment % maxAmountOfSegments] += pageSamples;
+    }
+
+    // Start a new, empty RAM page (dropping a segment or a failed write moved the replay position)
+    memset(_page, 0, pageSize);
+    _pageEncoder.begin(_page + pageHeaderSize, pageSize - pageHeaderSize);
+    DM_StorageLog::_saveReplayPosition();
+
+    // Return the success rate
+    return success;
+}
+
+/**
+ * Keep the replay position in RTC memory, so the next wake continues the replay instead of sending the oldest segment again.
+ */
+void DM_StorageLog::_saveReplayPosition()
+{
+    _replayPosition.magic = replayPositionMagic;
+    _replayPosition.segment = _oldestSegment;
+    _replayPosition.sample = _readSample;
+}
+
+/**
+ * Delete the oldest segment to make room (the samples in it that were never replayed are counted as dropped).
+ */
+void DM_StorageLog::_dropOldestSegment()
+{
+    // Count the samples in the oldest segment that were never replayed
+    uint32_t samplesInOldestSegment = _samplesInSegment(_oldestSegment);
+    _droppedSamples += samplesInOldestSegment - min(_readSample, samplesInOldestSegment);
+    _readSample -= min(_readSample, samplesInOldestSegment);
+
+    // Delete the segment
+    char path[32];
+    _segmentPath(_oldestSegment, path, sizeof(path));
+    LittleFS.remove(path);
+    _oldestSegment += 1;
+}
+
+/**
+ * Delete the segments that have been replayed completely.
+ */
+void DM_StorageLog::_dropConsumedSegments()
+{
+    // Delete every segment (apart from the newest one) that has been replayed completely
+    char path[32];
+    while (_oldestSegment < _newestSegment && _readSample >= _samplesInSegment(_oldestSegment))
+    {
+        _readSample -= _samplesInSegment(_oldestSegment);
+        _segmentPath(_oldestSegment, path, sizeof(path));
+        LittleFS.remove(path);
+        _oldestSegment += 1;
+    }
+
+    // If everything (including the RAM page) has been replayed, start from a clean log
+    if (_oldestSegment == _newestSegment && _readSample >= _samplesInSegment(_newestSegment) + _pageEncoder.getAmount())
+    {
+        if (_newestSegmentPages > 0)
+        {
+            _segmentPath(_newestSegment, path, sizeof(path));
+            LittleFS.remove(path);
+            _newestSegment += 1;
+        }
+        _oldestSegment = _newestSegment;
+        _newestSegmentPages = 0;
+        _segmentSamples[_newestSegment % maxAmountOfSegments] = 0;
+        memset(_page, 0, pageSize);
+        _pageEncoder.begin(_page + pageHeaderSize, pageSize - pageHeaderSize);
+        _readSample = 0;
+    }
+}
+
+/**
+ * Get the amount of samples in a segment on flash.
+ *
+ * @param segment The number of the segment.
+ *
+ * @return The amount of samples.
+ */
+uint32_t DM_StorageLog::_samplesInSegment(uint32_t segment)
+{
+    return _segmentSamples[segment % maxAmountOfSegments];
+}
+
+/**
+ * Count the samples in a segment file by reading the header of every page.
+ *
+ * @param path The path of the segment file.
+ * @param pages The variable the amount of pages in the file will be copied into.
+ *
+ * @return The amount of samples (pages in another format are skipped).
+ */
+uint32_t DM_StorageLog::_countSamplesInFile(const char *path, uint32_t &pages)
+{
+    // Open the file
+    pages = 0;
+    File file = LittleFS.open(path, "r");
+    if (!file)
+        return 0;
+
+    // Add up the amounts in the page headers
+    uint32_t amount = 0;
+    uint8_t header[pageHeaderSize];
+    pages = file.size() / pageSize;
+    for (uint32_t page = 0; page < pages; page++)
+        if (file.seek(page * pageSize) && file.read(header, pageHeaderSize) == pageHeaderSize && header[1] == pageFormat)
+            amount += header[0];
+    file.close();
+
+    // Return the amount of samples
+    return amount;
+}
+
+/**
+ * Decode the samples of a page.
+ *
+ * @param stream The compressed samples (the page without its header).
+ * @param length The length of the compressed samples.
+ * @param pageSamples The amount of samples in the page.
+ * @param skip The amount of samples at the start of the page that have already been replayed.
+ * @param samples The array the samples will be copied into.
+ * @param maxAmount The size of the array.
+ *
+ * @return The amount of samples that have been copied.
+ */
+size_t DM_StorageLog::_decodePage(const uint8_t *stream, size_t length, uint32_t pageSamples, uint32_t skip, DM_Sample *samples, size_t maxAmount)
+{
+    // Every sample is stored as the change from the one before it, so the page is always decoded from the start
+    DM_Decoder decoder;
+    decoder.begin(stream, length, pageSamples);
+    DM_PackedSample packedSample;
+    uint32_t epochSeconds;
+    size_t amount = 0;
+    for (uint32_t i = 0; amount < maxAmount && decoder.next(packedSample, epochSeconds); i++)
+    {
+        // Convert the samples that have not been replayed yet back to normal samples
+        if (i < skip)
+            continue;
+        samples[amount] = DM_PackedSample::unpack(packedSample);
+        samples[amount].epochSeconds = epochSeconds;
+        amount += 1;
+    }
+
+    // Return the amount of samples that have been copied
+    return amount;
+}
+
+/**
+ * Build the path of a segment file.
+ *
+ * @param segment The number of the segment.
+ * @param path The buffer the path will be written to.
+ * @param pathSize The size of the buffer.
+ */
+void DM_StorageLog::_segmentPath(uint32_t segment, char *path, size_t pathSize)
+{
+    snprintf(path, pathSize, "%s/%08lu", storageLogDirectory, (unsigned long)segment);
+}
\ No newline at end of file
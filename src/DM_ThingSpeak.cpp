@@ -10,44 +10,246 @@
 #include "DM_ThingSpeak.h" // Include the header file where the declarations for this library are stored
 #include <WiFi.h>          // Include the "WiFi" library to communicate with the Wi-Fi chip on the ESP32
 #include <PubSubClient.h>  // Used to create an object based on the class defined in this library
-#include <DM_Utils.h>      // Include the self-made library that contains the rounding function
+#include <HTTPClient.h>    // Used to send a batch of samples to the bulk update API of ThingSpeak
+#include <DM_Time.h>       // Include the self-made library that formats the timestamps of the samples
+#include <DM_Format.h>     // Include the self-made library that writes the payloads without allocating memory
+#include <DM_Profiler.h>   // Include the self-made library that measures the latency of the publishes and the connects
+#include <DM_Log.h>        // Include the self-made library that prints the status messages without waiting for the serial port
 using namespace std;       // Used to be able to use the string type without needing to say "std::string" every time
 
 // INITIALIZE THE CLASS MEMBERS (if we don't do this, the code will give errors saying these should be initialised first)
-unsigned long DM_ThingSpeak::_channelNumber; // The ID of the channel on ThingSpeak to send messages to
-string DM_ThingSpeak::_MQTTClientID;         // The client ID for the MQTT connection
-string DM_ThingSpeak::_MQTTUsername;         // The username for the MQTT connection
-string DM_ThingSpeak::_MQTTPassword;         // The password for the MQTT connection
+unsigned long DM_ThingSpeak::_channelNumber;                  // The ID of the channel on ThingSpeak to send messages to
+string DM_ThingSpeak::_MQTTClientID;                          // The client ID for the MQTT connection
+string DM_ThingSpeak::_MQTTUsername;                          // The username for the MQTT connection
+string DM_ThingSpeak::_MQTTPassword;                          // The password for the MQTT connection
+string DM_ThingSpeak::_writeAPIKey;                           // The write API key of the channel (only needed for the bulk update API)
+uint32_t DM_ThingSpeak::_nextBulkUpdateMs = 0;                // The moment the next bulk update may be sent (ThingSpeak accepts one every 15 seconds)
+std::atomic<uint32_t> DM_ThingSpeak::_amountOfUplinkCalls(0); // The amount of publishes and bulk updates sent since boot
+
+char DM_ThingSpeak::_publishTopic[48];                                       // The MQTT topic to publish to (built once, when the channel number is set)
+char DM_ThingSpeak::_bulkUpdateLink[80];                                     // The URL of the bulk update API (built once, when the channel number is set)
+char DM_ThingSpeak::_bulkUpdateBody[DM_ThingSpeak::maxBatchSize * 112 + 96]; // The body of a bulk update (one entry with three fields takes at most 112 bytes, a body that doesn't fit is not sent)
+const DM_Field *DM_ThingSpeak::_fields = nullptr;                            // The values of a sample that are sent, and the ThingSpeak field each of them goes to
+size_t DM_ThingSpeak::_amountOfFields = 0;                                   // The amount of fields
+
+QueueHandle_t DM_ThingSpeak::_outboundQueue = NULL;           // The publishes that are waiting for the MQTT service task (created when the service is started)
+DM_MQTTMessage DM_ThingSpeak::_inFlight;                      // The message the service task is publishing (it only leaves the service task once it is sent or dropped)
+bool DM_ThingSpeak::_hasInFlight = false;                     // If there is a message being published
+volatile bool DM_ThingSpeak::_networkAvailable = false;       // If we are connected to the Wi-Fi network (written by the uplink task, read by the service task)
+volatile bool DM_ThingSpeak::_connected = false;              // If we are connected to the MQTT server (written by the service task, read by the uplink task)
+std::atomic<uint32_t> DM_ThingSpeak::_amountOfPublishes(0);   // The amount of messages published since boot (written by the service task)
+std::atomic<uint32_t> DM_ThingSpeak::_amountOfRetries(0);     // The amount of failed publishes that were retried (written by the service task)
+std::atomic<uint32_t> DM_ThingSpeak::_droppedMessages(0);     // The amount of messages dropped (because the queue was full or they failed too often, written by both tasks)
+std::atomic<uint32_t> DM_ThingSpeak::_publishLatencyMs(0);    // The total time between queueing and publishing of all published messages (written by the service task)
+std::atomic<uint32_t> DM_ThingSpeak::_maxPublishLatencyMs(0); // The longest time between queueing and publishing of a message (written by the service task)
+
+DM_ConnectionStateMachine DM_ThingSpeak::_stateMachine("DM_ThingSpeak", 0, 1000, 60000); // The connect() call is synchronous (so no connect timeout), wait 1 second after the first failure and never more than one minute
 
 // OTHER VARIABLES
 WiFiClient WiFiClientForMQTT;               // Construct a Wi-Fi client
 PubSubClient MQTTClient(WiFiClientForMQTT); // Construct a MQTT client
 
 /**
- * Publish the values to ThingSpeak.
+ * Set which values of a sample are sent to ThingSpeak, and to which field (normally the fields of the sensor set).
+ *
+ * @param fields The table of fields (it has to stay valid, it is not copied).
+ * @param amountOfFields The amount of fields in the table.
+ */
+void DM_ThingSpeak::setFields(const DM_Field *fields, size_t amountOfFields)
+{
+    // Update the class members
+    DM_ThingSpeak::_fields = fields;
+    DM_ThingSpeak::_amountOfFields = amountOfFields;
+}
+
+/**
+ * Start the task that keeps the MQTT connection alive and publishes the queued messages (it runs next to the uplink task and is the only one that uses the MQTT client).
+ *
+ * @param core The core to run the task on.
+ * @param priority The priority of the task.
+ *
+ * @return The success rate of starting the service.
+ */
+bool DM_ThingSpeak::startService(BaseType_t core, UBaseType_t priority)
+{
+    // Create the outbound queue (the messages are copied into it, so nothing is allocated per publish)
+    DM_ThingSpeak::_outboundQueue = xQueueCreate(DM_ThingSpeak::outboundQueueSize, sizeof(DM_MQTTMessage));
+    if (DM_ThingSpeak::_outboundQueue == NULL)
+    {
+        DM_LOG_ERROR("DM_ThingSpeak", "Not enough memory for the outbound queue.");
+        return false;
+    }
+
+    // Start the service task
+    return xTaskCreatePinnedToCore(DM_ThingSpeak::_serviceTask, "DM_MQTT", 4096, NULL, priority, NULL, core) == pdPASS;
+}
+
+/**
+ * Tell the MQTT service task if we are connected to the Wi-Fi network (it only connects to the MQTT server when we are).
  *
- * @param temperatureC The temperature in degrees Celsius.
- * @param lightIntensityLux The light intensity in lux.
- * @param airPressureBar The air pressure in bar.
+ * @param networkAvailable If we are connected to the Wi-Fi network.
  */
-void DM_ThingSpeak::publishInformation(float temperatureC, float lightIntensityLux, float airPressureBar)
+void DM_ThingSpeak::setNetworkAvailable(bool networkAvailable)
 {
-    // Build the variables used as arguments in the publish() function below
-    string publishLink = "channels/" + std::to_string(DM_ThingSpeak::_channelNumber) + "/publish";
-    string value = "field1=" + std::to_string(DM_Utils::roundTwoDecimals(temperatureC)) + "&field2=" + std::to_string(DM_Utils::roundTwoDecimals(lightIntensityLux)) + "&field3=" + std::to_string(DM_Utils::roundTwoDecimals(airPressureBar));
+    DM_ThingSpeak::_networkAvailable = networkAvailable;
+}
 
-    // Send the information to ThingSpeak and store the result code
-    bool sent = MQTTClient.publish(publishLink.c_str(), value.c_str());
+/**
+ * Check if the MQTT service task is connected to the MQTT server.
+ *
+ * @return True if we are connected.
+ */
+bool DM_ThingSpeak::isConnected()
+{
+    return DM_ThingSpeak::_connected;
+}
+
+/**
+ * Queue the values of a sample to be published to ThingSpeak by the MQTT service task (this returns immediately, it never waits for the network).
+ *
+ * @param sample The sample to publish.
+ *
+ * @return The success rate of queueing the message (if the queue was full, the oldest message was dropped to make room).
+ */
+bool DM_ThingSpeak::publishInformation(const DM_Sample &sample)
+{
+    // Nothing can be queued when the service isn't running
+    if (DM_ThingSpeak::_outboundQueue == NULL)
+        return false;
 
-    // Inform the user based on the result
+    // Build the payload used as argument in the publish() function (in the message itself, so nothing is allocated)
+    DM_MQTTMessage message;
+    DM_Formatter value(message.payload, sizeof(message.payload));
+    for (size_t i = 0; i < DM_ThingSpeak::_amountOfFields; i++)
+    {
+        const DM_Field &field = DM_ThingSpeak::_fields[i];
+        if (field.thingSpeakField == 0)
+            continue;
+        value.append(value.length() == 0 ? "field" : "&field").appendUnsigned(field.thingSpeakField).appendLiteral("=").appendFixed(sample.*field.member, 2);
+    }
+    message.queuedMs = millis();
+    message.attempts = 0;
+
+    // Add the message to the queue, and drop the oldest one if it is full (the newest values are the most useful ones)
+    if (xQueueSendToBack(DM_ThingSpeak::_outboundQueue, &message, 0) == pdTRUE)
+        return true;
+    DM_MQTTMessage oldest;
+    if (xQueueReceive(DM_ThingSpeak::_outboundQueue, &oldest, 0) == pdTRUE)
+        DM_ThingSpeak::_droppedMessages.fetch_add(1, std::memory_order_relaxed);
+    return xQueueSendToBack(DM_ThingSpeak::_outboundQueue, &message, 0) == pdTRUE;
+}
+
+/**
+ * Publish a batch of samples to ThingSpeak in one HTTP request (using the bulk update API), instead of one MQTT publish per sample.
+ *
+ * @param samples The samples to publish (oldest first).
+ * @param amount The amount of samples.
+ *
+ * @return The success rate of the request.
+ */
+bool DM_ThingSpeak::publishBatch(const DM_Sample *samples, size_t amount)
+{
+    // Use the real time of every sample if all of them have one, otherwise fall back to the amount of seconds since the previous entry
+    bool useRealTime = true;
+    for (size_t i = 0; i < amount; i++)
+        useRealTime = useRealTime && samples[i].epochSeconds != 0;
+
+    // Build the body of the request in the static buffer (so nothing is allocated)
+    DM_Formatter body(DM_ThingSpeak::_bulkUpdateBody, sizeof(DM_ThingSpeak::_bulkUpdateBody));
+    body.appendLiteral("{\"write_api_key\":\"").append(DM_ThingSpeak::_writeAPIKey.c_str()).appendLiteral("\",\"updates\":[");
+    for (size_t i = 0; i < amount; i++)
+    {
+        // Add the timestamp of the entry
+        body.append(i == 0 ? "{" : ",{");
+        if (useRealTime)
+        {
+            char timestamp[24];
+            DM_Time::formatISO8601(samples[i].epochSeconds, timestamp, sizeof(timestamp));
+            body.appendLiteral("\"created_at\":\"").append(timestamp).appendLiteral("\"");
+        }
+        else
+        {
+            uint32_t deltaSeconds = i == 0 || samples[i].timestampMs < samples[i - 1].timestampMs ? 0 : (samples[i].timestampMs - samples[i - 1].timestampMs) / 1000;
+            body.appendLiteral("\"delta_t\":").appendUnsigned(deltaSeconds);
+        }
+
+        // Add the fields of the entry
+        for (size_t j = 0; j < DM_ThingSpeak::_amountOfFields; j++)
+        {
+            const DM_Field &field = DM_ThingSpeak::_fields[j];
+            if (field.thingSpeakField != 0)
+                body.appendLiteral(",\"field").appendUnsigned(field.thingSpeakField).appendLiteral("\":").appendFixed(samples[i].*field.member, 2);
+        }
+        body.appendLiteral("}");
+    }
+    body.appendLiteral("]}");
+
+    // A body that was cut off is not valid JSON, so don't send it
+    if (body.hasOverflowed())
+    {
+        DM_LOG_ERROR("DM_ThingSpeak", "The batch does not fit in the bulk update buffer.");
+        return false;
+    }
+
+    // Send the request
+    int responseCode;
+    {
+        DM_PROFILE_SCOPE(DM_STAGE_BULK_UPDATE);
+        HTTPClient HTTPClientForThingSpeak;
+        HTTPClientForThingSpeak.begin(DM_ThingSpeak::_bulkUpdateLink);
+        HTTPClientForThingSpeak.addHeader("Content-Type", "application/json");
+        responseCode = HTTPClientForThingSpeak.POST((uint8_t *)body.c_str(), body.length());
+        HTTPClientForThingSpeak.end();
+    }
+    DM_ThingSpeak::_amountOfUplinkCalls.fetch_add(1, std::memory_order_relaxed);
+
+    // ThingSpeak accepts one bulk update every 15 seconds
+    DM_ThingSpeak::_nextBulkUpdateMs = millis() + 15000;
+
+    // Inform the user based on the result (202 = the batch has been accepted)
+    bool sent = responseCode == 200 || responseCode == 202;
     if (sent)
     {
-        Serial.println("[DM_ThingSpeak] Information successfully sent to ThingSpeak!");
+        DM_LOG_INFO("DM_ThingSpeak", "Batch of %lu sample(s) successfully sent to ThingSpeak!", (unsigned long)amount);
     }
     else
     {
-        Serial.println("[DM_ThingSpeak] Something went wrong while sending the information to ThingSpeak.");
+        DM_LOG_WARNING("DM_ThingSpeak", "Something went wrong while sending a batch to ThingSpeak (response code %d).", responseCode);
     }
+
+    // Return the success rate
+    return sent;
+}
+
+/**
+ * Check if ThingSpeak accepts a new bulk update (it accepts one every 15 seconds).
+ *
+ * @return True if a bulk update may be sent now.
+ */
+bool DM_ThingSpeak::isBulkUpdateAllowed()
+{
+    return (int32_t)(millis() - DM_ThingSpeak::_nextBulkUpdateMs) >= 0;
+}
+
+/**
+ * Get the amount of network calls (MQTT publishes and bulk updates) made since boot.
+ *
+ * @return The amount of uplink calls.
+ */
+uint32_t DM_ThingSpeak::getAmountOfUplinkCalls()
+{
+    return DM_ThingSpeak::_amountOfUplinkCalls.load(std::memory_order_relaxed);
+}
+
+/**
+ * Set the write API key of the channel (this is needed to publish batches through the bulk update API).
+ *
+ * @param writeAPIKey The write API key of the ThingSpeak channel.
+ */
+void DM_ThingSpeak::setWriteAPIKey(string writeAPIKey)
+{
+    // Update the class member
+    DM_ThingSpeak::_writeAPIKey = writeAPIKey;
 }
 
 /**
@@ -65,81 +267,198 @@ void DM_ThingSpeak::setConnectionParameters(unsigned long channelNumber, string
     DM_ThingSpeak::_MQTTClientID = MQTTClientID;
     DM_ThingSpeak::_MQTTUsername = MQTTUsername;
     DM_ThingSpeak::_MQTTPassword = MQTTPassword;
+
+    // Build the MQTT topic and the URL of the bulk update API once, so they don't have to be built for every publish
+    DM_Formatter publishTopic(DM_ThingSpeak::_publishTopic, sizeof(DM_ThingSpeak::_publishTopic));
+    publishTopic.appendLiteral("channels/").appendUnsigned(channelNumber).appendLiteral("/publish");
+    DM_Formatter bulkUpdateLink(DM_ThingSpeak::_bulkUpdateLink, sizeof(DM_ThingSpeak::_bulkUpdateLink));
+    bulkUpdateLink.appendLiteral("http://api.thingspeak.com/channels/").appendUnsigned(channelNumber).appendLiteral("/bulk_update.json");
 }
 
 /**
- * Connect to the MQTT server of ThingSpeak and return the success rate.
+ * Move the MQTT connection one step forward (IDLE → CONNECTING → CONNECTED, and BACKOFF after a failure). This is called by the MQTT service task: apart from the connect() call itself, it never waits.
  *
- * @return The success rate of the connection.
+ * @param networkAvailable If we are connected to the Wi-Fi network (when we are not, the MQTT connection is reset to IDLE).
+ *
+ * @return If we are connected to the MQTT server.
  */
-bool DM_ThingSpeak::connectToMQTT()
+bool DM_ThingSpeak::tick(bool networkAvailable)
 {
-    // Inform the user
-    Serial.println("\n[DM_ThingSpeak] Configuring MQTT connection parameters...");
-
-    // Set the server used for the MQTT connection
-    MQTTClient.setServer("mqtt3.thingspeak.com", 1883);
+    // Without a network there is nothing to connect to, so start from the beginning once the network is back
+    if (!networkAvailable)
+    {
+        if (_stateMachine.getState() != DM_STATE_IDLE)
+        {
+            MQTTClient.disconnect();
+            _stateMachine.changeState(DM_STATE_IDLE);
+        }
+        return false;
+    }
 
-    // Inform the user
-    Serial.println("\n[DM_ThingSpeak] Connecting to the MQTT server...");
+    // Do what is needed in the current state
+    switch (_stateMachine.getState())
+    {
+    case DM_STATE_IDLE:
+        // Inform the user
+        DM_LOG_INFO("DM_ThingSpeak", "Connecting to the MQTT server...");
 
-    // Initialize the fail counter
-    int amountOfFails = 0;
+        // Set the server used for the MQTT connection and limit how long a connection attempt may wait for the broker (in seconds)
+        MQTTClient.setServer("mqtt3.thingspeak.com", 1883);
+        MQTTClient.setSocketTimeout(2);
+        _stateMachine.changeState(DM_STATE_CONNECTING);
+        break;
 
-    // Keep looping until we are connected to the MQTT server or if the fail counter is higher than 11
-    while (!MQTTClient.connected() && amountOfFails < 12)
+    case DM_STATE_CONNECTING:
     {
         // Connect and check if the connection was established successfully
-        if (MQTTClient.connect(DM_ThingSpeak::_MQTTClientID.c_str(), DM_ThingSpeak::_MQTTUsername.c_str(), DM_ThingSpeak::_MQTTPassword.c_str()))
+        bool connected;
         {
-            Serial.println("\n[DM_ThingSpeak] Successfully connected to the MQTT broker!");
+            DM_PROFILE_SCOPE(DM_STAGE_MQTT_CONNECT);
+            connected = MQTTClient.connect(DM_ThingSpeak::_MQTTClientID.c_str(), DM_ThingSpeak::_MQTTUsername.c_str(), DM_ThingSpeak::_MQTTPassword.c_str());
+        }
+        if (connected)
+        {
+            DM_LOG_INFO("DM_ThingSpeak", "Successfully connected to the MQTT broker!");
+            _stateMachine.changeState(DM_STATE_CONNECTED);
+            _stateMachine.printStatistics();
         }
         else
         {
-            Serial.print("\n[DM_ThingSpeak] Something went wrong while connecting to the MQTT broker. Retrying in 5 seconds...");
+            DM_LOG_WARNING("DM_ThingSpeak", "Something went wrong while connecting to the MQTT broker (state %d).", MQTTClient.state());
+            _stateMachine.changeState(DM_STATE_BACKOFF);
         }
-
-        // Increase the fail counter
-        amountOfFails += 1;
-
-        // Wait 5 seconds
-        delay(5000);
+        break;
     }
 
-    // Check if the MQTT connection failed
-    if (amountOfFails > 11)
-    {
-        // Inform the user that the connection failed
-        Serial.println("\n[DM_ThingSpeak] WARNING: Connecting to the MQTT broker failed (tried for one minute). Everything that depends on a the MQTT connection will be disabled.");
+    case DM_STATE_CONNECTED:
+        if (!MQTTClient.connected())
+        {
+            // Inform the user that the connection has been lost and reconnect on the next tick
+            DM_LOG_WARNING("DM_ThingSpeak", "The connection to the MQTT server has been disconnected. Trying to reconnect...");
+            _stateMachine.changeState(DM_STATE_IDLE);
+        }
+        break;
 
-        // Give the user a little time to read the warning
-        delay(5000);
+    case DM_STATE_BACKOFF:
+        // Start a new attempt when we waited long enough
+        if (_stateMachine.isBackoffOver())
+            _stateMachine.changeState(DM_STATE_IDLE);
+        break;
 
-        // Return the success rate
-        return false;
+    default:
+        break;
     }
 
-    // Return the success rate (if we get to this point, we are successfully connected)
-    return true;
+    // Return if we are connected
+    return _stateMachine.getState() == DM_STATE_CONNECTED;
 }
 
 /**
- * If we are not connected to the MQTT server, connect to it and return the result of the reconnection attempt.
+ * Get the state machine of the MQTT connection (used to read the connection statistics).
  *
- * @return If we are (now) connected to a Wi-Fi network.
+ * @return A reference to the state machine.
  */
-bool DM_ThingSpeak::checkAndReconnectToMQTT()
+DM_ConnectionStateMachine &DM_ThingSpeak::getStateMachine()
 {
-    // Return true if we are connected, and of not connect to the WiFi and return that result
-    if (!MQTTClient.connected())
+    return _stateMachine;
+}
+
+/**
+ * Print the amount of reconnects, the publish latency and what happened to the queued messages.
+ */
+void DM_ThingSpeak::printStatistics()
+{
+    // Read every counter once (the service task keeps updating them)
+    uint32_t connects = _stateMachine.getAmountOfConnects();
+    uint32_t publishes = DM_ThingSpeak::_amountOfPublishes.load(std::memory_order_relaxed);
+    uint32_t latencyMs = DM_ThingSpeak::_publishLatencyMs.load(std::memory_order_relaxed);
+    DM_LOG_INFO("DM_ThingSpeak", "%lu reconnect(s), %lu publish(es) with an average latency of %lu ms (max %lu ms), %lu waiting, %lu retried, %lu dropped.", (unsigned long)(connects > 0 ? connects - 1 : 0),
+                (unsigned long)publishes, (unsigned long)(publishes > 0 ? latencyMs / publishes : 0), (unsigned long)DM_ThingSpeak::_maxPublishLatencyMs.load(std::memory_order_relaxed),
+                (unsigned long)(DM_ThingSpeak::_outboundQueue != NULL ? uxQueueMessagesWaiting(DM_ThingSpeak::_outboundQueue) : 0), (unsigned long)DM_ThingSpeak::_amountOfRetries.load(std::memory_order_relaxed),
+                (unsigned long)DM_ThingSpeak::_droppedMessages.load(std::memory_order_relaxed));
+}
+
+/**
+ * Keep the MQTT connection alive and publish the queued messages (runs as its own task). The client is serviced at least every "servicePeriodMs", so the keepalive pings are always sent in time.
+ *
+ * @param parameters Unused (required by FreeRTOS).
+ */
+void DM_ThingSpeak::_serviceTask(void *parameters)
+{
+    // Keep servicing forever
+    for (;;)
     {
-        // Inform the user that the connection has been lost
-        Serial.println("\n[DM_ThingSpeak] The connection to the MQTT server has been disconnected. Trying to reconnect...");
+        // Move the connection forward, and let the client send its keepalive pings and read what the broker sent
+        bool connected = DM_ThingSpeak::tick(DM_ThingSpeak::_networkAvailable);
+        if (connected)
+            connected = MQTTClient.loop();
+        DM_ThingSpeak::_connected = connected;
+
+        // Publish a few of the queued messages one after the other
+        if (connected)
+            DM_ThingSpeak::_publishQueuedMessages();
 
-        // (Re)connect
-        return DM_ThingSpeak::connectToMQTT();
+        // Come back right away if messages are still waiting; otherwise wait until a message is queued or the client needs servicing again
+        if (connected && (DM_ThingSpeak::_hasInFlight || uxQueueMessagesWaiting(DM_ThingSpeak::_outboundQueue) > 0))
+        {
+            vTaskDelay(1);
+        }
+        else if (connected)
+        {
+            DM_MQTTMessage next;
+            xQueuePeek(DM_ThingSpeak::_outboundQueue, &next, pdMS_TO_TICKS(DM_ThingSpeak::servicePeriodMs));
+        }
+        else
+        {
+            vTaskDelay(pdMS_TO_TICKS(DM_ThingSpeak::servicePeriodMs));
+        }
     }
+}
+
+/**
+ * Publish up to "maxPublishesPerWakeup" queued messages (oldest first). A message only leaves the queue once the client accepted it; after a failure it is retried on the next wakeup, and dropped after "maxPublishAttempts" failures.
+ */
+void DM_ThingSpeak::_publishQueuedMessages()
+{
+    for (size_t i = 0; i < DM_ThingSpeak::maxPublishesPerWakeup; i++)
+    {
+        // Take the next message out of the queue if we aren't retrying one
+        if (!DM_ThingSpeak::_hasInFlight)
+        {
+            if (xQueueReceive(DM_ThingSpeak::_outboundQueue, &DM_ThingSpeak::_inFlight, 0) != pdTRUE)
+                return;
+            DM_ThingSpeak::_hasInFlight = true;
+        }
+
+        // Send the information to ThingSpeak
+        bool sent;
+        {
+            DM_PROFILE_SCOPE(DM_STAGE_MQTT_PUBLISH);
+            sent = MQTTClient.publish(DM_ThingSpeak::_publishTopic, DM_ThingSpeak::_inFlight.payload);
+        }
+        DM_ThingSpeak::_amountOfUplinkCalls.fetch_add(1, std::memory_order_relaxed);
 
-    // If we get here, we are connected so return true
-    return true;
+        // Keep the message for the next wakeup if it failed (the connection is probably lost, so stop for now), unless it failed too often
+        if (!sent)
+        {
+            DM_ThingSpeak::_inFlight.attempts += 1;
+            if (DM_ThingSpeak::_inFlight.attempts >= DM_ThingSpeak::maxPublishAttempts)
+            {
+                DM_LOG_WARNING("DM_ThingSpeak", "Something went wrong while sending the information to ThingSpeak, the message is dropped.");
+                DM_ThingSpeak::_droppedMessages.fetch_add(1, std::memory_order_relaxed);
+                DM_ThingSpeak::_hasInFlight = false;
+            }
+            else
+                DM_ThingSpeak::_amountOfRetries.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        // Keep track of how long the message waited
+        uint32_t latencyMs = millis() - DM_ThingSpeak::_inFlight.queuedMs;
+        DM_ThingSpeak::_publishLatencyMs.fetch_add(latencyMs, std::memory_order_relaxed);
+        if (latencyMs > DM_ThingSpeak::_maxPublishLatencyMs.load(std::memory_order_relaxed))
+            DM_ThingSpeak::_maxPublishLatencyMs.store(latencyMs, std::memory_order_relaxed);
+        DM_ThingSpeak::_amountOfPublishes.fetch_add(1, std::memory_order_relaxed);
+        DM_ThingSpeak::_hasInFlight = false;
+    }
 }
\ No newline at end of file
@@ -0,0 +1,95 @@
+/** +----------------------------------------------+
+ *  |     DM_Time - SNTP time synchronisation      |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "Arduino.h" // Include the Arduino library
+#include "DM_Time.h" // Include the header file where the declarations for this library are stored
+#include <time.h>    // Used to read the system clock and to format timestamps
+#include <DM_Log.h>  // Include the self-made library that prints the status messages without waiting for the serial port
+
+// INITIALIZE THE CLASS MEMBER (if we don't do this, the code will give errors saying these should be initialised first)
+bool DM_Time::_started = false; // If the SNTP client has been started
+
+// OTHER VARIABLES
+const uint32_t firstValidEpochSeconds = 1600000000; // Any time before this (September 2020) means the clock has not been synchronized yet
+
+/**
+ * Start synchronizing the system clock with an NTP server in the background (call this once the network is up, calling it again does nothing).
+ */
+void DM_Time::begin()
+{
+    // Only start the SNTP client once
+    if (_started)
+        return;
+
+    // Keep the clock in UTC and let the SNTP client synchronize it in the background (this returns immediately)
+    configTime(0, 0, "pool.ntp.org", "time.nist.gov");
+    _started = true;
+
+    // Inform the user
+    DM_LOG_INFO("DM_Time", "Synchronizing the clock with an NTP server...");
+}
+
+/**
+ * Check if the system clock has been synchronized.
+ *
+ * @return True if the clock holds the real time.
+ */
+bool DM_Time::isSynchronized()
+{
+    return time(NULL) >= (time_t)firstValidEpochSeconds;
+}
+
+/**
+ * Get the current Unix time.
+ *
+ * @return The amount of seconds since 1 January 1970 (UTC), or 0 if the clock has not been synchronized yet.
+ */
+uint32_t DM_Time::getEpochSeconds()
+{
+    return DM_Time::isSynchronized() ? (uint32_t)time(NULL) : 0;
+}
+
+/**
+ * Give a sample that was taken before the clock got synchronized its real time (only call this for samples taken since the last boot).
+ *
+ * @param sample The sample to complete.
+ */
+void DM_Time::completeTimestamp(DM_Sample &sample)
+{
+    DM_Time::completeTimestamp(sample, millis());
+}
+
+/**
+ * Give a sample that was taken before the clock got synchronized its real time, for samples that are timed with another clock than "millis()" (like the station clock in low-power mode).
+ *
+ * @param sample The sample to complete.
+ * @param nowMs The current time on the clock the sample was timed with.
+ */
+void DM_Time::completeTimestamp(DM_Sample &sample, uint32_t nowMs)
+{
+    // Calculate the real time from how long ago the sample was taken
+    if (sample.epochSeconds == 0 && DM_Time::isSynchronized())
+        sample.epochSeconds = DM_Time::getEpochSeconds() - (nowMs - sample.timestampMs) / 1000;
+}
+
+/**
+ * Write a Unix time as an ISO 8601 timestamp (e.g. "2024-05-01T12:00:00Z").
+ *
+ * @param epochSeconds The Unix time.
+ * @param buffer The buffer the timestamp will be written to.
+ * @param bufferSize The size of the buffer (21 bytes are needed).
+ *
+ * @return The length of the timestamp (0 if the buffer is too small).
+ */
+size_t DM_Time::formatISO8601(uint32_t epochSeconds, char *buffer, size_t bufferSize)
+{
+    time_t time = epochSeconds;
+    struct tm dateTime;
+    gmtime_r(&time, &dateTime);
+    return strftime(buffer, bufferSize, "%Y-%m-%dT%H:%M:%SZ", &dateTime);
+}
\ No newline at end of file
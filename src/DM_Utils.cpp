@@ -10,7 +10,7 @@
 #include "DM_Utils.h" // Include the header file where the declarations for this library are stored
 
 /**
- * Round the given parameter by multiplying the number by 100, taking the whole part and then dividing by 100.
+ * Round the given parameter to two decimals by multiplying the number by 100, rounding it to the nearest whole number (halfway cases away from zero) and then dividing by 100.
  *
  * @param decimal The decimal number to round
  *
@@ -18,5 +18,5 @@
  */
 float DM_Utils::roundTwoDecimals(float decimal)
 {
-    return floor(decimal * 100.0) / 100.0;
+    return round(decimal * 100.0) / 100.0;
 }
@@ -0,0 +1,363 @@
+/** +----------------------------------------------+
+ *  |      DM_WebServer - Metrics and history      |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "Arduino.h"           // Include the Arduino library
+#include "DM_WebServer.h"      // Include the header file where the declarations for this library are stored
+#include <ESPAsyncWebServer.h> // Used to answer the requests on the task of the asynchronous TCP stack
+#include <esp_heap_caps.h>     // Used to show how much memory is free
+#include <DM_Time.h>           // Include the self-made library that gives the samples their real time
+#include <DM_Profiler.h>       // Include the self-made library that keeps the latency of the hot paths
+#include <DM_Log.h>            // Include the self-made library that prints the status messages without waiting for the serial port
+
+// INITIALIZE THE CLASS MEMBERS (if we don't do this, the code will give errors saying these should be initialised first)
+bool DM_WebServer::_started = false;                   // If the server is listening
+DM_History *DM_WebServer::_history = nullptr;          // The history that is streamed by "/history"
+const DM_Field *DM_WebServer::_fields = nullptr;       // The values of a sample that are shown
+size_t DM_WebServer::_amountOfFields = 0;              // The amount of fields
+DM_Sink *const *DM_WebServer::_sinks = nullptr;        // The sinks whose counters are shown
+size_t DM_WebServer::_amountOfSinks = 0;               // The amount of sinks
+const DM_Metric *DM_WebServer::_metrics = nullptr;     // The other metrics that are shown
+size_t DM_WebServer::_amountOfMetrics = 0;             // The amount of other metrics
+volatile uint32_t DM_WebServer::_amountOfRequests = 0; // The amount of requests answered since the server started
+
+// OTHER VARIABLES
+AsyncWebServer WebServer(DM_WebServer::port); // The server
+#ifdef DM_PROFILING
+const size_t builtInMetricFamilies = 9; // The metrics every station has (see _writeMetricsLine()), the ones of "setMetrics()" come after them
+#else
+const size_t builtInMetricFamilies = 7; // The metrics every station has, without the latencies of the stages (the station is built without "-D DM_PROFILING")
+#endif
+const uint32_t maxHistoryAgeMs = 0x7FFFFFFF; // The oldest sample that can be asked for (the times since boot are compared as signed differences)
+
+/**
+ * Set the history that is streamed by "/history", and the values of a sample that are shown (normally the fields of the sensor set).
+ *
+ * @param history The history (it has to stay valid).
+ * @param fields The table of fields (it has to stay valid).
+ * @param amountOfFields The amount of fields.
+ */
+void DM_WebServer::setHistory(DM_History *history, const DM_Field *fields, size_t amountOfFields)
+{
+    DM_WebServer::_history = history;
+    DM_WebServer::_fields = fields;
+    DM_WebServer::_amountOfFields = amountOfFields;
+}
+
+/**
+ * Set the sinks whose counters are shown on "/metrics".
+ *
+ * @param sinks The table of sinks (it has to stay valid).
+ * @param amountOfSinks The amount of sinks.
+ */
+void DM_WebServer::setSinks(DM_Sink *const *sinks, size_t amountOfSinks)
+{
+    DM_WebServer::_sinks = sinks;
+    DM_WebServer::_amountOfSinks = amountOfSinks;
+}
+
+/**
+ * Set the other metrics that are shown on "/metrics" (e.g. the counters of the buffers and the connections).
+ *
+ * @param metrics The table of metrics (it has to stay valid).
+ * @param amountOfMetrics The amount of metrics.
+ */
+void DM_WebServer::setMetrics(const DM_Metric *metrics, size_t amountOfMetrics)
+{
+    DM_WebServer::_metrics = metrics;
+    DM_WebServer::_amountOfMetrics = amountOfMetrics;
+}
+
+/**
+ * Start listening (only the first call does something, so call this once the network is up).
+ */
+void DM_WebServer::begin()
+{
+    // Don't start twice
+    if (DM_WebServer::_started)
+        return;
+    DM_WebServer::_started = true;
+
+    // "/metrics": one line per call of the filler until the send buffer is full, the position is kept in the response itself
+    WebServer.on("/metrics", HTTP_GET, [](AsyncWebServerRequest *request)
+                 {
+                     DM_WebServer::_amountOfRequests += 1;
+                     size_t family = 0, line = 0;
+                     request->send(request->beginChunkedResponse("text/plain; version=0.0.4", [family, line](uint8_t *buffer, size_t maxLength, size_t index) mutable -> size_t
+                                                                 { return DM_WebServer::_fillMetrics(buffer, maxLength, family, line); }));
+                 });
+
+    // "/history": the range is turned into times since boot once, the stream continues after the last sample it sent
+    WebServer.on("/history", HTTP_GET, [](AsyncWebServerRequest *request)
+                 {
+                     DM_WebServer::_amountOfRequests += 1;
+                     if (DM_WebServer::_history == nullptr)
+                     {
+                         request->send(503, "text/plain", "The history is not available.\n");
+                         return;
+                     }
+
+                     // Without a range, stream everything that is in the history now
+                     uint32_t nowMs = millis();
+                     uint32_t fromAgeMs = maxHistoryAgeMs, toAgeMs = 0;
+                     if (request->hasParam("from") || request->hasParam("to"))
+                     {
+                         // A Unix time can only be turned into a time since boot when the clock is synchronized
+                         if (!DM_Time::isSynchronized())
+                         {
+                             request->send(503, "text/plain", "The clock is not synchronized yet.\n");
+                             return;
+                         }
+                         uint32_t nowSeconds = DM_Time::getEpochSeconds();
+                         if (request->hasParam("from"))
+                         {
+                             uint32_t from = strtoul(request->getParam("from")->value().c_str(), nullptr, 10);
+                             fromAgeMs = from >= nowSeconds ? 0 : min((uint64_t)(nowSeconds - from) * 1000, (uint64_t)maxHistoryAgeMs);
+                         }
+                         if (request->hasParam("to"))
+                         {
+                             uint32_t to = strtoul(request->getParam("to")->value().c_str(), nullptr, 10);
+                             toAgeMs = to >= nowSeconds ? 0 : min((uint64_t)(nowSeconds - to) * 1000, (uint64_t)maxHistoryAgeMs);
+                         }
+                     }
+                     uint32_t nextMs = nowMs - fromAgeMs, toMs = nowMs - toAgeMs;
+                     request->send(request->beginChunkedResponse("text/csv", [nextMs, toMs](uint8_t *buffer, size_t maxLength, size_t index) mutable -> size_t
+                                                                 { return DM_WebServer::_fillHistory(buffer, maxLength, index, nextMs, toMs); }));
+                 });
+
+    // Everything else doesn't exist
+    WebServer.onNotFound([](AsyncWebServerRequest *request)
+                         { request->send(404, "text/plain", "Not found. Try /metrics or /history?from=<Unix time>&to=<Unix time>.\n"); });
+
+    // Start listening
+    WebServer.begin();
+    DM_LOG_INFO("DM_WebServer", "Listening on port %u (/metrics and /history).", (unsigned)DM_WebServer::port);
+}
+
+/**
+ * Get the amount of requests answered since the server started.
+ *
+ * @return The amount of requests.
+ */
+uint32_t DM_WebServer::getAmountOfRequests()
+{
+    return DM_WebServer::_amountOfRequests;
+}
+
+/**
+ * Write the next lines of "/metrics" into the send buffer (called by the web server until it returns 0).
+ *
+ * @param buffer The send buffer.
+ * @param maxLength The space in the send buffer.
+ * @param family The metric that is being written (kept between the calls).
+ * @param line The line of that metric that is written next (kept between the calls).
+ *
+ * @return The amount of bytes written (0 when everything has been sent, "RESPONSE_TRY_AGAIN" when not even one line fits now).
+ */
+size_t DM_WebServer::_fillMetrics(uint8_t *buffer, size_t maxLength, size_t &family, size_t &line)
+{
+    size_t length = 0;
+    while (family < builtInMetricFamilies + DM_WebServer::_amountOfMetrics)
+    {
+        // Write the next line right behind the others (a line that doesn't fit is written again in the next call)
+        DM_Formatter output((char *)buffer + length, maxLength - length);
+        if (!DM_WebServer::_writeMetricsLine(output, family, line))
+        {
+            family += 1;
+            line = 0;
+            continue;
+        }
+        if (output.hasOverflowed())
+            return length > 0 ? length : RESPONSE_TRY_AGAIN;
+        length += output.length();
+        line += 1;
+    }
+    return length;
+}
+
+/**
+ * Write one line of "/metrics" in the Prometheus text format. Every metric starts with its HELP and TYPE line, followed by one line per series.
+ *
+ * @param output The formatter to write to.
+ * @param family The metric (the built-in ones first, then the ones of "setMetrics()").
+ * @param line The line of the metric (0 = HELP, 1 = TYPE, 2 and further = the series).
+ *
+ * @return False if the metric has no such line (nothing is written).
+ */
+bool DM_WebServer::_writeMetricsLine(DM_Formatter &output, size_t family, size_t line)
+{
+    // Find the name, type, description and amount of series of the metric
+    const char *name, *type, *help;
+    size_t amountOfSeries = 1;
+    switch (family)
+    {
+    case 0:
+        name = "dm_reading", type = "gauge", help = "The newest reading of every value of the station.", amountOfSeries = DM_WebServer::_history != nullptr ? DM_WebServer::_amountOfFields : 0;
+        break;
+    case 1:
+        name = "dm_sink_delivered_total", type = "counter", help = "The amount of measurements every sink delivered.", amountOfSeries = DM_WebServer::_amountOfSinks;
+        break;
+    case 2:
+        name = "dm_sink_dropped_total", type = "counter", help = "The amount of measurements every sink dropped because its queue was full or they can never be delivered.", amountOfSeries = DM_WebServer::_amountOfSinks;
+        break;
+    case 3:
+        name = "dm_uptime_seconds", type = "gauge", help = "The time since boot.";
+        break;
+    case 4:
+        name = "dm_free_heap_bytes", type = "gauge", help = "The amount of free internal memory.";
+        break;
+    case 5:
+        name = "dm_history_samples", type = "gauge", help = "The amount of samples in the history.";
+        break;
+    case 6:
+        name = "dm_http_requests_total", type = "counter", help = "The amount of requests the web server answered.";
+        break;
+#ifdef DM_PROFILING
+    case 7:
+        name = "dm_stage_latency_microseconds", type = "summary", help = "The latency of every hot path since boot (the percentiles are read from a log-linear histogram).", amountOfSeries = DM_AMOUNT_OF_STAGES * (DM_Profiler::amountOfPercentiles + 1);
+        break;
+    case 8:
+        name = "dm_stage_latency_max_microseconds", type = "gauge", help = "The highest latency of every hot path since boot.", amountOfSeries = DM_AMOUNT_OF_STAGES;
+        break;
+#endif
+    default:
+        const DM_Metric &metric = DM_WebServer::_metrics[family - builtInMetricFamilies];
+        name = metric.name, type = metric.type, help = metric.help;
+        break;
+    }
+
+    // Write the HELP and TYPE lines
+    if (line == 0)
+    {
+        output.appendLiteral("# HELP ").append(name).appendLiteral(" ").append(help).appendLiteral("\n");
+        return true;
+    }
+    if (line == 1)
+    {
+        output.appendLiteral("# TYPE ").append(name).appendLiteral(" ").append(type).appendLiteral("\n");
+        return true;
+    }
+
+    // Write one series
+    size_t series = line - 2;
+    if (series >= amountOfSeries)
+        return false;
+    output.append(name);
+    switch (family)
+    {
+    case 0:
+    {
+        // The newest sample in the history (a value that couldn't be measured is "NaN")
+        DM_Sample sample;
+        size_t amount = DM_WebServer::_history->getAmount();
+        float value = amount > 0 && DM_WebServer::_history->get(amount - 1, sample) ? sample.*DM_WebServer::_fields[series].member : NAN;
+        output.appendLiteral("{name=\"").append(DM_WebServer::_fields[series].name).appendLiteral("\",unit=\"").append(DM_WebServer::_fields[series].unit).appendLiteral("\"} ");
+        if (isnan(value))
+            output.appendLiteral("NaN");
+        else
+            output.appendFixed(value, 2);
+        break;
+    }
+    case 1:
+        output.appendLiteral("{sink=\"").append(DM_WebServer::_sinks[series]->getName()).appendLiteral("\"} ").appendUnsigned(DM_WebServer::_sinks[series]->getAmountOfDeliveredSamples());
+        break;
+    case 2:
+        output.appendLiteral("{sink=\"").append(DM_WebServer::_sinks[series]->getName()).appendLiteral("\"} ").appendUnsigned(DM_WebServer::_sinks[series]->getAmountOfDroppedSamples());
+        break;
+    case 3:
+        output.appendLiteral(" ").appendUnsigned(millis() / 1000);
+        break;
+    case 4:
+        output.appendLiteral(" ").appendUnsigned(heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+        break;
+    case 5:
+        output.appendLiteral(" ").appendUnsigned(DM_WebServer::_history != nullptr ? DM_WebServer::_history->getAmount() : 0);
+        break;
+    case 6:
+        output.appendLiteral(" ").appendUnsigned(DM_WebServer::_amountOfRequests);
+        break;
+#ifdef DM_PROFILING
+    case 7:
+    {
+        // Every stage has one series per percentile, followed by its count
+        DM_Stage stage = (DM_Stage)(series / (DM_Profiler::amountOfPercentiles + 1));
+        size_t percentile = series % (DM_Profiler::amountOfPercentiles + 1);
+        if (percentile == DM_Profiler::amountOfPercentiles)
+        {
+            output.appendLiteral("_count{stage=\"").append(DM_Profiler::getStageName(stage)).appendLiteral("\"} ").appendUnsigned(DM_Profiler::getAmountOfSamples(stage));
+            break;
+        }
+        uint16_t perMille = DM_Profiler::percentiles[percentile];
+        output.appendLiteral("{stage=\"").append(DM_Profiler::getStageName(stage)).appendLiteral("\",quantile=\"").appendFixed(perMille / 1000.0f, 2).appendLiteral("\"} ");
+        output.appendUnsigned(DM_Profiler::getPercentileMicroseconds(stage, perMille));
+        break;
+    }
+    case 8:
+        output.appendLiteral("{stage=\"").append(DM_Profiler::getStageName((DM_Stage)series)).appendLiteral("\"} ").appendUnsigned(DM_Profiler::getMaximumMicroseconds((DM_Stage)series));
+        break;
+#endif
+    default:
+        output.appendLiteral(" ").appendUnsigned(DM_WebServer::_metrics[family - builtInMetricFamilies].read());
+        break;
+    }
+    output.appendLiteral("\n");
+    return true;
+}
+
+/**
+ * Write the next samples of "/history" into the send buffer as CSV (called by the web server until it returns 0). The samples are read straight from the history, one at a time.
+ *
+ * @param buffer The send buffer.
+ * @param maxLength The space in the send buffer.
+ * @param index The amount of bytes that have been sent already (the header is written when this is 0).
+ * @param nextMs The time since boot of the next sample to send (kept between the calls).
+ * @param toMs The time since boot of the last sample to send.
+ *
+ * @return The amount of bytes written (0 when everything has been sent, "RESPONSE_TRY_AGAIN" when not even one line fits now).
+ */
+size_t DM_WebServer::_fillHistory(uint8_t *buffer, size_t maxLength, size_t index, uint32_t &nextMs, uint32_t toMs)
+{
+    // Start with the header (e.g. "timestampMs,epochSeconds,Temperature (°C),...")
+    size_t length = 0;
+    if (index == 0)
+    {
+        DM_Formatter header((char *)buffer, maxLength);
+        header.appendLiteral("timestampMs,epochSeconds");
+        for (size_t i = 0; i < DM_WebServer::_amountOfFields; i++)
+            header.appendLiteral(",").append(DM_WebServer::_fields[i].name).appendLiteral(" (").append(DM_WebServer::_fields[i].unit).appendLiteral(")");
+        header.appendLiteral("\n");
+        if (header.hasOverflowed())
+            return RESPONSE_TRY_AGAIN;
+        length = header.length();
+    }
+
+    // Write one line per sample, until the last one of the range or until the send buffer is full
+    DM_Sample sample;
+    uint32_t nowMs = millis();
+    while (DM_WebServer::_history->findFirst(nextMs, sample) && (int32_t)(sample.timestampMs - toMs) <= 0)
+    {
+        // Give the sample its real time (if the clock is synchronized) and write its values (a value that couldn't be measured stays empty)
+        DM_Time::completeTimestamp(sample, nowMs);
+        DM_Formatter line((char *)buffer + length, maxLength - length);
+        line.appendUnsigned(sample.timestampMs).appendLiteral(",").appendUnsigned(sample.epochSeconds);
+        for (size_t i = 0; i < DM_WebServer::_amountOfFields; i++)
+        {
+            float value = sample.*DM_WebServer::_fields[i].member;
+            line.appendLiteral(",");
+            if (!isnan(value))
+                line.appendFixed(value, 2);
+        }
+        line.appendLiteral("\n");
+
+        // Stop when the line doesn't fit (it is written again in the next call)
+        if (line.hasOverflowed())
+            return length > 0 ? length : RESPONSE_TRY_AGAIN;
+        length += line.length();
+        nextMs = sample.timestampMs + 1;
+    }
+    return length;
+}
\ No newline at end of file
@@ -6,187 +6,410 @@
  */
 
 // IMPORT THE NECESSARY LIBRARIES
-#include "Arduino.h" // Include the Arduino library
-#include "DM_WiFi.h" // Include the header file where the declarations for this library are stored
-#include <WiFi.h>    // Include the "WiFi" library to communicate with the Wi-Fi chip on the ESP32
-using namespace std; // Used to be able to use the string type without needing to say "std::string" every time
+#include "Arduino.h"             // Include the Arduino library
+#include "DM_WiFi.h"             // Include the header file where the declarations for this library are stored
+#include <WiFi.h>                // Include the "WiFi" library to communicate with the Wi-Fi chip on the ESP32
+#include <Preferences.h>         // Used to keep the last good connection in NVS, so it survives a power-off
+#include <esp_netif.h>           // Used to find the network interface of the Wi-Fi station
+#include <esp_netif_net_stack.h> // Used to get the lwIP interface behind it, with its DHCP client
+#include <lwip/dhcp.h>           // Used to read the lease time the DHCP server gave
+#include <lwip/tcpip.h>          // Used to lock the TCP/IP core while the DHCP client is read (the TCP/IP task changes it)
+#include <DM_Profiler.h>         // Used to keep the latency of the connections
+#include <DM_Time.h>             // Used to know when the cached DHCP lease runs out
+#include <DM_Log.h>              // Include the self-made library that prints the status messages without waiting for the serial port
+using namespace std;             // Used to be able to use the string type without needing to say "std::string" every time
+
+// INITIALIZE THE CLASS MEMBERS (if we don't do this, the code will give errors saying these should be initialised first)
+string DM_WiFi::_SSID;     // The name of the Wi-Fi network to connect to
+string DM_WiFi::_password; // The password of the Wi-Fi network
+
+RTC_DATA_ATTR DM_WiFiCache DM_WiFi::_cache;               // The last good connection (kept in RTC memory during deep sleep, and in NVS)
+bool DM_WiFi::_cacheLoaded = false;                       // If the cache has been loaded from NVS since boot
+DM_WiFiAttempt DM_WiFi::_attempt = DM_WIFI_ATTEMPT_PLAIN; // How the current connection attempt was started
+uint32_t DM_WiFi::_attemptStartMs = 0;                    // The moment the current connection attempt started
+bool DM_WiFi::_scanValid = false;                         // If the result of the last scan can still be used
+uint32_t DM_WiFi::_scanMs = 0;                            // The moment the last scan finished
+uint8_t DM_WiFi::_scannedBSSID[6];                        // The strongest access point with our SSID the last scan found
+int32_t DM_WiFi::_scannedChannel = 0;                     // The channel of that access point
+uint32_t DM_WiFi::_leaseSeconds = 0;                      // The lease time of the DHCP lease of this connection (0 if the cached IP address was reused)
+uint32_t DM_WiFi::_leaseStartMs = 0;                      // The moment that lease was received
+
+DM_ConnectionStateMachine DM_WiFi::_stateMachine("DM_WiFi", 15000, 1000, 60000); // Give up an attempt after 15 seconds, wait 1 second after the first failure and never more than one minute
+
+// OTHER VARIABLES
+const uint32_t WiFiCacheMagic = 0x444D5702;   // The value of "magic" for a valid cache
+const uint32_t fastConnectTimeoutMs = 3000;   // The time the fast path may take before we fall back to scanning (it normally takes a few hundred milliseconds)
+const uint32_t cachedConnectTimeoutMs = 8000; // The time a connection to the cached access point with DHCP may take before we fall back to scanning (DHCP normally takes about a second)
+const uint32_t leaseMarginSeconds = 600;      // The cached IP address is given back this long before its lease runs out (so a connection on it never outlives the lease)
+const uint32_t scanMaxAgeMs = 300000;         // The time a scan result is reused for new attempts (after that, the access points are scanned again)
+const char *WiFiCacheNamespace = "dm_wifi";   // The NVS namespace of the cache
 
 /**
- * Connect to a Wi-Fi network with the given SSID and password (return false when no connection could be established for one minute of trying).
+ * Set the SSID and password of the Wi-Fi network to connect to (the connection itself is made by tick()).
  *
  * @param SSID The name of the Wi-Fi network you want to connect to.
  * @param password The password of the Wi-Fi network you want to connect to.
+ */
+void DM_WiFi::setCredentials(string SSID, string password)
+{
+    // Update the class members
+    DM_WiFi::_SSID = SSID;
+    DM_WiFi::_password = password;
+}
+
+/**
+ * Move the Wi-Fi connection one step forward (IDLE → CONNECTING → CONNECTED, and BACKOFF after a failure). Call this often: it never waits for the Wi-Fi chip.
  *
- * @return The success rate of the connection.
+ * @return If we are connected to the Wi-Fi network.
  */
-bool DM_WiFi::connectToWiFi(string SSID, string password)
+bool DM_WiFi::tick()
 {
-    // Set the Wi-Fi mode to 'station' in order to connect to another network
-    WiFi.mode(WIFI_STA);
+    // Read the status of the Wi-Fi chip once
+    wl_status_t status = DM_WiFi::_isConnected();
+
+    // Do what is needed in the current state
+    switch (_stateMachine.getState())
+    {
+    case DM_STATE_IDLE:
+        // Print a status message
+        DM_LOG_INFO("DM_WiFi", "Connecting to Wi-Fi...");
 
-    // Make the connection with the given SSID using the given Wi-Fi password (and convert the parameters to the correct formats)
-    WiFi.begin(SSID.c_str(), password.c_str());
+        // Set the Wi-Fi mode to 'station' and start the fastest connection attempt we have the information for (this returns immediately)
+        WiFi.mode(WIFI_STA);
+        _stateMachine.changeState(DM_STATE_CONNECTING);
+        DM_WiFi::_startAttempt();
+        break;
 
-    // Print a status message
-    Serial.println("\n[DM_WiFi] Connecting to Wi-Fi...\n");
+    case DM_STATE_CONNECTING:
+        if (_attempt == DM_WIFI_ATTEMPT_SCANNING)
+        {
+            // Connect to the access point the scan found once it is done (if it found nothing, "_collectScan()" already started an attempt without one)
+            if (DM_WiFi::_collectScan())
+                DM_WiFi::_startAttempt();
+            else if (_stateMachine.hasConnectTimedOut())
+            {
+                DM_WiFi::_printConnectionFailure(status);
+                WiFi.scanDelete();
+                _stateMachine.changeState(DM_STATE_BACKOFF);
+            }
+        }
+        else if (status == WL_CONNECTED)
+        {
+            // Print a status message that indicates success
+            DM_LOG_INFO("DM_WiFi", "Succesfully connected on Wi-Fi network \"%s\" and received IP address \"%s\".", _SSID.c_str(), WiFi.localIP().toString().c_str());
 
-    // Initialize the fail counter
-    int amountOfFails = 0;
+            // Show how long it took to get an IP address, since the boot (or the wake) and since the start of this attempt
+            DM_LOG_INFO("DM_WiFi", "IP address received %lu ms after the boot, the attempt took %lu ms%s", (unsigned long)millis(), (unsigned long)(millis() - _attemptStartMs),
+                        _attempt == DM_WIFI_ATTEMPT_FAST ? " (fast path: cached access point and IP address)." : _attempt == DM_WIFI_ATTEMPT_CACHED ? " (cached access point)." : ".");
+            DM_PROFILE_MICROSECONDS(DM_STAGE_WIFI_CONNECT, (millis() - _attemptStartMs) * 1000);
 
-    // Keep looping until we are connected to the network or if the fail counter is higher than 11
-    while (DM_WiFi::_isConnected() != WL_CONNECTED && amountOfFails < 12)
-    {
-        // Store the amount of available Wi-Fi networks
-        int amountOfAvailableWiFiNetworks = _getAmountOfAvailableWiFiNetworks();
+            // Remember this connection and its lease, so the next one can skip the scan and DHCP
+            DM_WiFi::_storeCache();
 
-        // Check for the amount of available Wi-Fi networks
-        if (amountOfAvailableWiFiNetworks == -2)
+            // Move to the connected state and show what the connection cost
+            _stateMachine.changeState(DM_STATE_CONNECTED);
+            _stateMachine.printStatistics();
+        }
+        else if ((_attempt == DM_WIFI_ATTEMPT_FAST || _attempt == DM_WIFI_ATTEMPT_CACHED) &&
+                 (status == WL_CONNECT_FAILED || status == WL_NO_SSID_AVAIL || millis() - _attemptStartMs >= (_attempt == DM_WIFI_ATTEMPT_FAST ? fastConnectTimeoutMs : cachedConnectTimeoutMs)))
         {
-            // Inform the user that the Wi-Fi network scan failed
-            Serial.println("[DM_WiFi] Scanning for Wi-Fi networks failed or not done yet. Retrying in 5 seconds...");
+            // The cached access point (or IP address) doesn't work anymore: forget it, go back to DHCP and look for the best access point
+            DM_LOG_WARNING("DM_WiFi", "The cached connection failed, scanning for the access point...");
+            WiFi.disconnect();
+            WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+            DM_WiFi::_clearCache();
+            DM_WiFi::_startScan();
         }
-        else if (amountOfAvailableWiFiNetworks < 1)
+        else if (status == WL_CONNECT_FAILED || status == WL_NO_SSID_AVAIL || _stateMachine.hasConnectTimedOut())
         {
-            // Inform the user no Wi-Fi networks have been found
-            Serial.println("[DM_WiFi] No available Wi-Fi networks have been found. Retrying in 5 seconds...");
+            // Inform the user, stop the attempt and wait before trying again (the next attempt scans again, the access point might have changed)
+            DM_WiFi::_printConnectionFailure(status);
+            WiFi.disconnect();
+            _scanValid = false;
+            _stateMachine.changeState(DM_STATE_BACKOFF);
         }
-        else if (DM_WiFi::_isConnected() == WL_CONNECT_FAILED)
+        break;
+
+    case DM_STATE_CONNECTED:
+        if (status != WL_CONNECTED)
         {
-            // Inform user that the SSID has been found, but a connection could not be established
-            Serial.println("[DM_WiFi] The SSID has been found, but no connection could be established. Please check the credentials (retrying in 5 seconds).");
+            // Inform the user that the connection has been lost and reconnect on the next tick
+            DM_LOG_WARNING("DM_WiFi", "The Wi-Fi has been disconnected. Trying to reconnect...");
+            _stateMachine.changeState(DM_STATE_IDLE);
+        }
+        else if (_attempt == DM_WIFI_ATTEMPT_FAST && !DM_WiFi::_isLeaseValid())
+        {
+            // The lease of the cached IP address runs out and it can't be renewed without DHCP: reconnect to the same access point with DHCP
+            DM_LOG_INFO("DM_WiFi", "The DHCP lease of the cached IP address runs out, reconnecting with DHCP...");
+            WiFi.disconnect();
+            _stateMachine.changeState(DM_STATE_IDLE);
         }
         else
         {
-            // Inform user that the connection could not be established
-            Serial.print("[DM_WiFi] The connection could not be established. Make sure the SSID \"");
-            Serial.print(SSID.c_str());
-            Serial.println("\" is an available Wi-Fi network. Retrying in 5 seconds...");
-
-            // Print every available network
-            _printAvailableWiFiNetworks();
+            // Calculate when the lease runs out once the clock is synchronized (it is not yet at the first connection after a power-on)
+            DM_WiFi::_completeLeaseExpiry();
         }
+        break;
 
-        // Increase the fail count
-        amountOfFails += 1;
+    case DM_STATE_BACKOFF:
+        // Start a new attempt when we waited long enough
+        if (_stateMachine.isBackoffOver())
+            _stateMachine.changeState(DM_STATE_IDLE);
+        break;
+
+    default:
+        break;
+    }
+
+    // Return if we are connected
+    return _stateMachine.getState() == DM_STATE_CONNECTED;
+}
+
+/**
+ * Get the state machine of the Wi-Fi connection (used to read the connection statistics).
+ *
+ * @return A reference to the state machine.
+ */
+DM_ConnectionStateMachine &DM_WiFi::getStateMachine()
+{
+    return _stateMachine;
+}
 
-        // Wait five seconds
-        delay(5000);
+/**
+ * Print why a connection attempt failed.
+ *
+ * @param status The status of the Wi-Fi chip at the moment the attempt failed.
+ */
+void DM_WiFi::_printConnectionFailure(wl_status_t status)
+{
+    if (status == WL_NO_SSID_AVAIL)
+    {
+        // Inform the user that the network has not been found
+        DM_LOG_WARNING("DM_WiFi", "The connection could not be established. Make sure the SSID \"%s\" is an available Wi-Fi network.", _SSID.c_str());
+    }
+    else if (status == WL_CONNECT_FAILED)
+    {
+        // Inform user that the SSID has been found, but a connection could not be established
+        DM_LOG_WARNING("DM_WiFi", "The SSID has been found, but no connection could be established. Please check the credentials.");
+    }
+    else
+    {
+        // Inform user that the connection could not be established in time
+        DM_LOG_WARNING("DM_WiFi", "The connection could not be established in time.");
     }
+}
 
-    // Check if the Wi-Fi connection failed
-    if (amountOfFails > 11)
+/**
+ * Start a connection attempt: straight to the cached access point with the cached IP address while its DHCP lease runs, straight to the cached access point with DHCP after that,
+ * to the access point of a recent scan, or start a scan (without waiting for it).
+ */
+void DM_WiFi::_startAttempt()
+{
+    // Load the last good connection from NVS once (after a deep sleep it is still in RTC memory)
+    if (!_cacheLoaded)
+        DM_WiFi::_loadCache();
+
+    // Fast path: associate directly with the cached access point and reuse the last DHCP lease while it runs, so the scan and the DHCP exchange are skipped
+    _attemptStartMs = millis();
+    if (_cache.magic == WiFiCacheMagic && DM_WiFi::_isLeaseValid())
     {
-        // Inform the user that the connection failed
-        Serial.println("\n[DM_WiFi] WARNING: Connecting to Wi-Fi failed (tried for one minute). Everything that depends on a Wi-Fi connection will be disabled.");
+        _attempt = DM_WIFI_ATTEMPT_FAST;
+        WiFi.config(IPAddress(_cache.localIP), IPAddress(_cache.gatewayIP), IPAddress(_cache.subnetMask), IPAddress(_cache.DNSIP));
+        WiFi.begin(_SSID.c_str(), _password.c_str(), _cache.channel, _cache.BSSID);
+        return;
+    }
 
-        // Give the user a little time to read the warning
-        delay(5000);
+    // Every other attempt asks for an IP address with DHCP (the router may have given the cached one to another device)
+    WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
 
-        // Return the success rate
-        return false;
+    // The lease ran out (or its end is unknown): still skip the scan with the cached access point
+    if (_cache.magic == WiFiCacheMagic)
+    {
+        _attempt = DM_WIFI_ATTEMPT_CACHED;
+        WiFi.begin(_SSID.c_str(), _password.c_str(), _cache.channel, _cache.BSSID);
+        return;
     }
 
-    // Print a status message that indicates success
-    Serial.print("\n[DM_WiFi] Succesfully connected on Wi-Fi network \"");
-    Serial.print(SSID.c_str());
-    Serial.print("\" and received IP address \"");
-    Serial.print(WiFi.localIP());
-    Serial.println("\".");
+    // Reuse a recent scan instead of scanning again on every retry
+    if (_scanValid && millis() - _scanMs < scanMaxAgeMs)
+    {
+        _attempt = DM_WIFI_ATTEMPT_SCANNED;
+        WiFi.begin(_SSID.c_str(), _password.c_str(), _scannedChannel, _scannedBSSID);
+        return;
+    }
 
-    // Return the success rate (if we get to this point, we are successfully connected)
-    return true;
+    // Look for the access points in the background
+    DM_WiFi::_startScan();
 }
 
 /**
- * This function returns the amount of available Wi-Fi networks (if this returns -2, it means that no scanning could be done).
- *
- * @return The amount of available Wi-Fi networks.
+ * Start scanning for access points in the background (the result is collected by "_collectScan()").
  */
-int DM_WiFi::_getAmountOfAvailableWiFiNetworks()
+void DM_WiFi::_startScan()
 {
-    // Create a loopcount varaible to prevent being stuck waiting for scan results
-    int loopCount = 0;
+    _attempt = DM_WIFI_ATTEMPT_SCANNING;
+    _scanValid = false;
+    if (WiFi.scanNetworks(true) == WIFI_SCAN_FAILED)
+    {
+        // Connect to any access point with the SSID if the scan can't be started
+        _attempt = DM_WIFI_ATTEMPT_PLAIN;
+        WiFi.begin(_SSID.c_str(), _password.c_str());
+    }
+}
 
-    // Scan the Wi-Fi networks
-    int result = WiFi.scanNetworks();
+/**
+ * Check if the scan is done, and remember the strongest access point with our SSID (this never waits). If the scan didn't find it, an attempt without a specific access point is started.
+ *
+ * @return True if the scan is done and found an access point with our SSID.
+ */
+bool DM_WiFi::_collectScan()
+{
+    // Check if the scan is still running
+    int16_t amountOfNetworks = WiFi.scanComplete();
+    if (amountOfNetworks == WIFI_SCAN_RUNNING)
+        return false;
 
-    // Keep looping until the result is higher than -1 or if we looped to much
-    while (result < 0 && loopCount < 20)
+    // Find the strongest access point with our SSID (a failed scan finds nothing)
+    int32_t strongestRSSI = INT32_MIN;
+    for (int16_t i = 0; i < amountOfNetworks; i++)
     {
-        // Increment loop count variable and wait 200ms
-        loopCount++;
-        delay(200);
+        if (WiFi.SSID(i) != _SSID.c_str() || WiFi.RSSI(i) <= strongestRSSI)
+            continue;
+        strongestRSSI = WiFi.RSSI(i);
+        memcpy(_scannedBSSID, WiFi.BSSID(i), sizeof(_scannedBSSID));
+        _scannedChannel = WiFi.channel(i);
+        _scanValid = true;
+        _scanMs = millis();
     }
+    WiFi.scanDelete();
 
-    // Return the result
-    return result;
+    // Connect to any access point with the SSID if the scan didn't find it (the Wi-Fi chip looks for it itself then)
+    if (!_scanValid)
+    {
+        _attempt = DM_WIFI_ATTEMPT_PLAIN;
+        _attemptStartMs = millis();
+        WiFi.begin(_SSID.c_str(), _password.c_str());
+    }
+    return _scanValid;
 }
 
 /**
- * Print the SSID of every available Wi-Fi network.
+ * Load the last good connection from NVS (unless it is still in RTC memory after a deep sleep).
  */
-void DM_WiFi::_printAvailableWiFiNetworks()
+void DM_WiFi::_loadCache()
 {
-    // Get the number of available Wi-Fi networks
-    int amountOfNetworks = _getAmountOfAvailableWiFiNetworks();
-
-    // Print the number of available Wi-Fi networks
-    Serial.print("[DM_WiFi] ");
-    Serial.print(amountOfNetworks);
-    Serial.println(amountOfNetworks > 1 ? " Wi-Fi networks have been found:" : " Wi-Fi network has been found:"); // Adjust the message slightly if the amount is exactly 1
-
-    // Loop through every Wi-Fi network and print its SSID and security type (or show the only one if there is only one SSID)
-    if (amountOfNetworks == 1)
+    _cacheLoaded = true;
+    if (_cache.magic == WiFiCacheMagic)
+        return;
+    Preferences preferences;
+    size_t storedLength = 0;
+    if (preferences.begin(WiFiCacheNamespace, true))
     {
-        Serial.print("   - ");
-        Serial.print(WiFi.SSID(1));
-        Serial.print(WiFi.encryptionType(1) == WIFI_AUTH_OPEN ? " (public network)" : "  (private network)");
+        storedLength = preferences.getBytesLength("cache");
+        if (storedLength != sizeof(_cache) || preferences.getBytes("cache", &_cache, sizeof(_cache)) != sizeof(_cache))
+            _cache.magic = 0;
+        preferences.end();
     }
+
+    // Remove a cache that can't be used (it was written by another version of the firmware), so it isn't read again on every boot
+    if (storedLength > 0 && _cache.magic != WiFiCacheMagic)
+        DM_WiFi::_clearCache();
+}
+
+/**
+ * Remember the current connection in RTC memory and in NVS (NVS is only written when something changed, to spare the flash).
+ */
+void DM_WiFi::_storeCache()
+{
+    // Fill in the cache from the current connection
+    DM_WiFiCache cache;
+    memset(&cache, 0, sizeof(cache));
+    cache.magic = WiFiCacheMagic;
+    memcpy(cache.BSSID, WiFi.BSSID(), sizeof(cache.BSSID));
+    cache.channel = WiFi.channel();
+    cache.localIP = WiFi.localIP();
+    cache.gatewayIP = WiFi.gatewayIP();
+    cache.subnetMask = WiFi.subnetMask();
+    cache.DNSIP = WiFi.dnsIP();
+
+    // Keep the end of the lease the cached IP address came with, or read the lease DHCP just gave (its end is only known once the clock is synchronized)
+    _leaseSeconds = 0;
+    if (_attempt == DM_WIFI_ATTEMPT_FAST)
+        cache.leaseExpiryEpochSeconds = _cache.leaseExpiryEpochSeconds;
     else
     {
-        for (int i = 0; i < amountOfNetworks; i++)
-        {
-            Serial.print("   - ");
-            Serial.print(WiFi.SSID(i));
-            Serial.println(WiFi.encryptionType(i) == WIFI_AUTH_OPEN ? " (public network)" : " (private network)");
-        }
+        esp_netif_t *station = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+        struct netif *interface = station != NULL ? (struct netif *)esp_netif_get_netif_impl(station) : NULL;
+        LOCK_TCPIP_CORE();
+        struct dhcp *client = interface != NULL ? netif_dhcp_data(interface) : NULL;
+        _leaseSeconds = client != NULL ? client->offered_t0_lease : 0;
+        UNLOCK_TCPIP_CORE();
+        _leaseStartMs = millis();
+        cache.leaseExpiryEpochSeconds = _leaseSeconds > 0 && DM_Time::isSynchronized() ? DM_Time::getEpochSeconds() + _leaseSeconds : 0;
     }
 
-    // Print two empty lines
-    Serial.println();
-    Serial.println();
+    // Store it where it changed
+    if (memcmp(&cache, &_cache, sizeof(cache)) == 0)
+        return;
+    _cache = cache;
+    DM_WiFi::_writeCache();
 }
 
 /**
- * Check if the device is connected to a Wi-Fi network.
- *
- * @return The status of the Wi-Fi connection.
+ * Forget the cache in RTC memory and in NVS (the next connection scans for the access point and uses DHCP).
  */
-wl_status_t DM_WiFi::_isConnected()
+void DM_WiFi::_clearCache()
 {
-    return WiFi.status();
+    _cache.magic = 0;
+    Preferences preferences;
+    if (preferences.begin(WiFiCacheNamespace, false))
+    {
+        preferences.remove("cache");
+        preferences.end();
+    }
 }
 
 /**
- * If we are not connected to the Wi-Fi, connect to it and return the result of the reconnection attempt.
- *
- * @param SSID The name of the Wi-Fi network you want to connect to.
- * @param password The password for the Wi-Fi network.
- *
- * @return If we are (now) connected to a Wi-Fi network.
+ * Write the cache to NVS, so it survives a power-off.
  */
-bool DM_WiFi::checkAndReconnect(string SSID, string password)
+void DM_WiFi::_writeCache()
 {
-    // Return true if we are connected, and of not connect to the Wi-Fi and return that result
-    if (DM_WiFi::_isConnected() != WL_CONNECTED)
+    Preferences preferences;
+    if (preferences.begin(WiFiCacheNamespace, false))
     {
-        // Inform the user that the connection has been lost
-        Serial.println("\n[DM_WiFi] The Wi-Fi has been disconnected. Trying to reconnect...");
-
-        // (Re)connect
-        return DM_WiFi::connectToWiFi(SSID, password);
+        preferences.putBytes("cache", &_cache, sizeof(_cache));
+        preferences.end();
     }
+}
 
-    // If we get here, we are connected so return true
-    return true;
+/**
+ * Check if the DHCP lease of the cached IP address still runs for more than "leaseMarginSeconds" (without a synchronized clock, its end is unknown and it counts as run out).
+ *
+ * @return True if the cached IP address may still be used.
+ */
+bool DM_WiFi::_isLeaseValid()
+{
+    uint32_t nowEpochSeconds = DM_Time::getEpochSeconds();
+    return nowEpochSeconds != 0 && (uint64_t)nowEpochSeconds + leaseMarginSeconds < _cache.leaseExpiryEpochSeconds;
+}
+
+/**
+ * Calculate when the DHCP lease of this connection runs out once the clock got synchronized, and store it (a lease received before that has no end in the cache yet).
+ */
+void DM_WiFi::_completeLeaseExpiry()
+{
+    if (_leaseSeconds == 0 || _cache.leaseExpiryEpochSeconds != 0 || !DM_Time::isSynchronized())
+        return;
+    _cache.leaseExpiryEpochSeconds = DM_Time::getEpochSeconds() - (millis() - _leaseStartMs) / 1000 + _leaseSeconds;
+    DM_WiFi::_writeCache();
+}
+
+/**
+ * Check if the device is connected to a Wi-Fi network.
+ *
+ * @return The status of the Wi-Fi connection.
+ */
+wl_status_t DM_WiFi::_isConnected()
+{
+    return WiFi.status();
 }
\ No newline at end of file
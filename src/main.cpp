@@ -10,104 +10,510 @@
 #include <BH1750.h>          // Used to create an object based on the class defined in this library
 #include <Adafruit_BMP280.h> // Used to create an object based on the class defined in this library
 #include <DM_Utils.h>        // Used to access the round function inside this library
-#include <DM_Measurer.h>     // Used for the measurements
+#include <DM_Sensors.h>      // Used for the measurements
+#include <DM_SensorSet.h>    // Used to measure every sensor at its own rate
+#include <DM_Statistics.h>   // Used to summarize the measurements per window (minimum, maximum, mean, variance and last value)
+#include <DM_Reporting.h>    // Used to only send the summaries in which something changed
+#include <DM_History.h>      // Used to keep the recent measurements in memory in a compact form
 #include <DM_WiFi.h>         // Used for all Wi-Fi related functionalities
 #include <DM_ThingSpeak.h>   // Used for all ThingSpeak and MQTT related functionalities
 #include <DM_Discord.h>      // Used for the Discord integration
+#include <DM_Sinks.h>        // Used to send every measurement to every destination, each in its own task
+#include <DM_Sample.h>       // Used to pass timestamped measurements from the sampling task to the uplink task
+#include <DM_RingBuffer.h>   // Used as the lock-free queue between the sampling task and the uplink task
+#include <DM_Storage.h>      // Used to keep the measurements on flash while we are offline
+#include <DM_Time.h>         // Used to give every measurement its real time
+#include <DM_Power.h>        // Used to sleep between two samples in low-power mode
+#include <DM_WebServer.h>    // Used to show the readings, the counters and the history over HTTP
+#include <DM_Profiler.h>     // Used to measure the latency of the hot paths (only when built with "-D DM_PROFILING")
+#include <DM_Log.h>          // Used to print the messages without waiting for the serial port
 using namespace std;         // Used to be able to use the string type without needing to say "std::string" every time
 
 // VARIABLES
-bool successfullSetup;                             // This will decide if we start our loop() code or not
-bool initialWiFiSuccessfullyConnected;             // We will update this according to the success of establishing the network connection for the first time
+bool successfullSetup;                             // This will decide if we start the sampling and uplink tasks or not
 bool wifiSuccessfullyConnected;                    // We will update this according to the success of establishing the network connection
-bool mqttSuccessfullyConnected;                    // We will update this according to the success of establishing a connection to the MQTT server
-bool initialMQTTSuccessfullyConnected;             // We will update this according to the success of establishing a connection to the MQTT server for the first time
 string WiFiSSID = "xxxxxxxxxxxxxxxxxxxx";          // The Wi-Fi SSID
 string WiFiPassword = "xxxxxxxxxxxxxxxxxxxx";      // The Wi-Fi password
 string MQTTClientID = "xxxxxxxxxxxxxxxxxxxx";      // The client ID for MQTT
 string MQTTUsername = "xxxxxxxxxxxxxxxxxxxx";      // The username for MQTT
 string MQTTPassword = "xxxxxxxxxxxxxxxxxxxx";      // The password for MQTT
 unsigned long ThingSpeakChannel = 1973314;         // The ThingSpeak channel number
+string ThingSpeakWriteAPIKey = "xxxxxxxxxxxxxxxx"; // The write API key of the ThingSpeak channel (used to replay stored measurements in batches)
 string DiscordWebhookURL = "xxxxxxxxxxxxxxxxxxxx"; // The Discord webhook ID
+const uint32_t samplePeriodMs = 1000;              // The time between two samples added to the statistics (every sensor is measured at its own rate, see "DM_Sensors.h")
+const uint32_t maxSampleDelayMs = 500;             // The longest a sample waits for a running burst of conversions (a longer burst, like the BH1750 in the dark, leaves its last value in the sample)
+const uint32_t uplinkPollPeriodMs = 100;           // The time the uplink task waits between two rounds (ticking the connections and sending the waiting measurements)
+const size_t replayBatchSize = 100;                // The maximum amount of stored measurements sent in one batch
+const uint32_t profilerReportPeriodMs = 600000;    // The time between two latency reports on the serial monitor (only when built with "-D DM_PROFILING")
+
+const uint32_t statisticsWindowMs = 60000;    // The length of a window of the statistics (one summary is sent per window)
+const uint32_t statisticsSlideMs = 60000;     // The time between the start of two windows (equal to the window length: tumbling windows, shorter: sliding windows)
+const size_t historyExternalCapacity = 86400; // The amount of samples kept in the external RAM (a day of samples taken every second, about 1 MB)
+const size_t historyInternalCapacity = 3600;  // The amount of samples kept in the internal memory of a board without external RAM (an hour, about 42 KB, the rest is left for Wi-Fi, TLS and the tasks)
+
+const uint32_t reportingHeartbeatMs = 900000;  // The longest time without sending a summary (one is sent after this time, even when nothing changed)
+const uint32_t fastStatisticsWindowMs = 15000; // The length of a window while a value is changing fast (ThingSpeak accepts one update every 15 seconds)
+const uint32_t fastReportingHoldMs = 300000;   // The time every value has to be calm again before the normal windows are used again
+
+const size_t ThingSpeakBatchSize = 20;               // The amount of measurements sent to ThingSpeak in one bulk update (1 publishes every measurement on its own over MQTT)
+const uint32_t ThingSpeakBatchMaxLatencyMs = 300000; // The longest time a measurement may wait before its batch is sent anyway
+
+const size_t DiscordSamplesPerMessage = 5; // The amount of measurements shown in one Discord message
+const uint32_t DiscordMaxDelayMs = 300000; // The longest time a measurement may wait before its Discord message is sent anyway
+
+const bool InfluxEnabled = false;               // If the measurements are written to InfluxDB
+string InfluxHost = "xxx.xxx.xxx.xxx";          // The host of the UDP listener of InfluxDB or Telegraf (leave empty to use the HTTP write API below)
+uint16_t InfluxPort = 8089;                     // The port of the UDP listener
+string InfluxWriteURL = "xxxxxxxxxxxxxxxxxxxx"; // The URL of the write API (e.g. "http://influx.local:8086/api/v2/write?org=home&bucket=weather&precision=s")
+string InfluxToken = "xxxxxxxxxxxxxxxxxxxx";    // The API token that is allowed to write to the bucket
+const size_t InfluxBatchSize = 10;              // The amount of measurements written to InfluxDB at once
+const uint32_t InfluxBatchMaxLatencyMs = 60000; // The longest time a measurement may wait before its batch is written anyway
+
+const bool MQTTBrokerEnabled = false;                             // If the measurements are published to an MQTT broker of your own
+string MQTTBrokerHost = "xxx.xxx.xxx.xxx";                        // The host of the broker
+uint16_t MQTTBrokerPort = 1883;                                   // The port of the broker
+string MQTTBrokerClientID = "weather-station";                    // The client ID for the broker
+string MQTTBrokerUsername = "";                                   // The username for the broker (empty if it doesn't need one)
+string MQTTBrokerPassword = "";                                   // The password for the broker
+string MQTTBrokerTopic = "weather-station/samples";               // The topic the measurements are published to
+const DM_PayloadFormat MQTTBrokerPayloadFormat = DM_PAYLOAD_JSON; // The format of the payloads (DM_PAYLOAD_BINARY for "tools/ingest", with the topic "channels/<channel>/publish/packed")
+const size_t MQTTBrokerBatchSize = 1;                             // The amount of measurements sent together (a binary payload carries them in one message, JSON publishes them one by one)
+const uint32_t MQTTBrokerBatchMaxLatencyMs = 60000;               // The longest time a measurement may wait before its batch is sent anyway
+
+#ifdef DM_LOW_POWER
+const uint32_t lowPowerSamplePeriodMs = 60000; // The time between two samples in low-power mode (the station is in deep sleep in between)
+const size_t lowPowerBatchSize = 30;           // The amount of samples that are sent in one go (the radio is only turned on for a full batch)
+const uint32_t lowPowerMaxLatencyMs = 3600000; // The longest time a sample may wait for the radio
+const uint32_t lowPowerRadioTimeoutMs = 20000; // The longest time the radio may stay on to connect and synchronize the clock
+#endif
+
+DM_RingBuffer<DM_WindowSummary, 16> summaryBuffer; // The summaries that are waiting to be sent (filled by the sampling task, drained by the uplink task)
+TaskHandle_t samplingTaskHandle;                   // The handle of the task that reads the sensors
+TaskHandle_t uplinkTaskHandle;                     // The handle of the task that sends the measurements over the network
+DM_Sample replayBatch[replayBatchSize];            // The measurements that are being replayed from the flash log (by the ThingSpeak sink, or in low-power mode)
+uint32_t normalWindowMs = statisticsWindowMs;      // The length of a window the user asked for last (used again when a fast change is over, only used by the uplink task)
+uint32_t normalSlideMs = statisticsSlideMs;        // The slide the user asked for last
+volatile uint8_t BMP280i2cTransactions;            // The amount of I2C transactions the last BMP280 measurement took (written by the sampling task, printed by the uplink task)
+volatile uint32_t BMP280i2cBusTimeUs;              // The time the last BMP280 measurement spent on the I2C bus
 
 BH1750 lightSensor;                          // This will be our BH1750 sensor "object"
 Adafruit_BMP280 temperaturePressureChip;     // This will be our BPM280 chip "object"
-DM_Measurer measurer;                        // This will be our measure "object"
 DM_ThingSpeak ThingSpeakClient;              // This will be our ThingSpeak "client"
 DM_WebhookConnector DiscordWebhookConnector; // This will be our Discord webhook connector
 
+DM_ThingSpeakSink ThingSpeakSink(replayBatch, replayBatchSize);                   // Sends the measurements to ThingSpeak (and keeps them in the flash log while that is not possible)
+DM_DiscordSink DiscordSink;                                                       // Shows the measurements in Discord
+DM_InfluxSink InfluxSink;                                                         // Writes the measurements to InfluxDB
+DM_MQTTSink MQTTBrokerSink;                                                       // Publishes the measurements to an MQTT broker of your own
+DM_Sink *sinks[] = {&ThingSpeakSink, &DiscordSink, &InfluxSink, &MQTTBrokerSink}; // Every destination of the measurements (the ones that are not started are skipped)
+
+DM_BMP280Sensor temperaturePressureSensor(temperaturePressureChip);                                      // The BMP280 as a sensor of the station (temperature and air pressure)
+DM_BH1750Sensor lightIntensitySensor(lightSensor);                                                       // The BH1750 as a sensor of the station (light intensity)
+DM_SensorSet<DM_BMP280Sensor, DM_BH1750Sensor> sensors(temperaturePressureSensor, lightIntensitySensor); // All sensors of the station (the payloads are built from their fields)
+DM_WindowedStatistics statistics(sensors.getFields(), sensors.amountOfFields);                           // The statistics of every value over the current window
+DM_History history;                                                                                      // The recent samples (12 bytes per sample)
+DM_ReportingPolicy reportingPolicy(sensors.getFields(), sensors.amountOfFields);                         // Decides which summaries are worth sending
+static_assert(sensors.amountOfFields <= DM_WindowSummary::maxAmountOfFields, "A window summary can't hold the values of all sensors");
+
+// The counters that are shown on "/metrics" next to the readings and the counters of the sinks (they are read from the task of the web server, so they may not wait)
+const DM_Metric metrics[] = {
+  {"dm_summary_buffer_depth", "gauge", "The amount of summaries waiting for the uplink task.", []() -> uint32_t { return summaryBuffer.getDepth(); }},
+  {"dm_summary_buffer_overruns_total", "counter", "The amount of summaries dropped because the summary buffer was full.", []() -> uint32_t { return summaryBuffer.getOverruns(); }},
+  {"dm_reports_changed_total", "counter", "The amount of summaries sent because a value changed.", []() -> uint32_t { return reportingPolicy.getAmountOfPublishes(); }},
+  {"dm_reports_heartbeat_total", "counter", "The amount of summaries sent as heartbeat.", []() -> uint32_t { return reportingPolicy.getAmountOfHeartbeats(); }},
+  {"dm_reports_suppressed_total", "counter", "The amount of summaries not sent because every value stayed within its deadband.", []() -> uint32_t { return reportingPolicy.getAmountOfSuppressed(); }},
+  {"dm_wifi_connects_total", "counter", "The amount of times the Wi-Fi connection has been established.", []() -> uint32_t { return DM_WiFi::getStateMachine().getAmountOfConnects(); }},
+  {"dm_mqtt_connects_total", "counter", "The amount of times the MQTT connection to ThingSpeak has been established.", []() -> uint32_t { return DM_ThingSpeak::getStateMachine().getAmountOfConnects(); }},
+  {"dm_flash_log_samples", "gauge", "The amount of measurements waiting in the flash log to be replayed.", DM_StorageLog::getAmountOfStoredSamples},
+  {"dm_flash_log_dropped_total", "counter", "The amount of measurements dropped from the flash log because it was full.", DM_StorageLog::getAmountOfDroppedSamples},
+  {"dm_bmp280_bus_time_microseconds", "gauge", "The time the last BMP280 measurement spent on the I2C bus.", []() -> uint32_t { return BMP280i2cBusTimeUs; }},
+  {"dm_filter_spikes_total", "counter", "The amount of filtered readings that were rejected as a spike (and replaced by the rolling median).", []() -> uint32_t { return temperaturePressureSensor.getAmountOfSpikes() + lightIntensitySensor.getAmountOfSpikes(); }},
+  {"dm_log_dropped_total", "counter", "The amount of log messages dropped because the log queue was full.", DM_Log::getAmountOfDroppedMessages},
+};
+
+// FUNCTIONS
+/**
+ * Read the commands that are typed in the serial monitor (this never waits for input). Known commands:
+ *  - "window <window length in seconds> <slide in seconds>": change the windows of the statistics, e.g. "window 300 60" for the last 5 minutes, every minute.
+ */
+void handleSerialCommands()
+{
+  // The characters of the command that is being typed
+  static char command[32];
+  static size_t commandLength = 0;
+
+  // Handle every character that has been received
+  while (Serial.available() > 0)
+  {
+    // Collect the characters until the end of the line
+    char character = Serial.read();
+    if (character != '\n' && character != '\r')
+    {
+      if (commandLength < sizeof(command) - 1)
+        command[commandLength++] = character;
+      continue;
+    }
+    command[commandLength] = '\0';
+    commandLength = 0;
+
+    // Ask the sampling task to use the new windows (it checks the values itself), and remember them to use them again after a fast change
+    unsigned long windowSeconds, slideSeconds;
+    if (sscanf(command, "window %lu %lu", &windowSeconds, &slideSeconds) == 2)
+    {
+      if (DM_WindowedStatistics::isValidConfiguration(windowSeconds * 1000, slideSeconds * 1000))
+      {
+        normalWindowMs = windowSeconds * 1000;
+        normalSlideMs = slideSeconds * 1000;
+      }
+      statistics.requestConfiguration(windowSeconds * 1000, slideSeconds * 1000);
+    }
+  }
+}
+
+#ifdef DM_LOW_POWER
+/**
+ * Turn on the radio and send the samples that are waiting in RTC memory in one bulk update (or store them in the flash log if that is not possible), then turn the radio off again.
+ */
+void lowPowerUplink()
+{
+  // Set the connection parameters (nothing in normal RAM survives a deep sleep)
+  DM_WiFi::setCredentials(WiFiSSID, WiFiPassword);
+  ThingSpeakClient.setConnectionParameters(ThingSpeakChannel, MQTTClientID, MQTTUsername, MQTTPassword);
+  ThingSpeakClient.setWriteAPIKey(ThingSpeakWriteAPIKey);
+  ThingSpeakClient.setFields(sensors.getFields(), sensors.amountOfFields);
+
+  // Connect to the Wi-Fi network, and synchronize the clock if that never happened (the RTC keeps it running during deep sleep)
+  uint32_t radioStartMs = millis();
+  bool connected = DM_WiFi::tick();
+  while (!connected && millis() - radioStartMs < lowPowerRadioTimeoutMs)
+  {
+    delay(10);
+    connected = DM_WiFi::tick();
+  }
+  if (connected && !DM_Time::isSynchronized())
+  {
+    DM_Time::begin();
+    while (!DM_Time::isSynchronized() && millis() - radioStartMs < lowPowerRadioTimeoutMs)
+      delay(10);
+  }
+
+  // Take the samples out of RTC memory and give them their real time
+  size_t amount = DM_Power::readBufferedSamples(replayBatch, replayBatchSize);
+  for (size_t i = 0; i < amount; i++)
+    DM_Time::completeTimestamp(replayBatch[i], DM_Power::getStationMs());
+
+  // Send them in one bulk update, but only if nothing older is waiting in the flash log; otherwise they are added to the log, so everything is sent in order
+  DM_StorageLog::begin();
+  bool sent = connected && DM_StorageLog::isEmpty() && ThingSpeakClient.publishBatch(replayBatch, amount);
+  for (size_t i = 0; !sent && i < amount; i++)
+    DM_StorageLog::append(replayBatch[i]);
+  DM_StorageLog::flush();
+  DM_Power::clearBufferedSamples();
+
+  // Replay the oldest batch of the flash log if nothing was sent yet (ThingSpeak accepts one bulk update every 15 seconds)
+  if (connected && !sent && !DM_StorageLog::isEmpty())
+  {
+    size_t replayAmount = DM_StorageLog::readBatch(replayBatch, replayBatchSize);
+    if (replayAmount > 0 && ThingSpeakClient.publishBatch(replayBatch, replayAmount))
+      DM_StorageLog::commitBatch(replayAmount);
+  }
+
+  // Show what the low-power mode costs, and turn the radio off
+  DM_Power::printStatistics();
+  WiFi.disconnect(true);
+  WiFi.mode(WIFI_OFF);
+}
+
+/**
+ * Take one sample and go back to deep sleep (low-power mode, this runs on every wake instead of the tasks and never returns).
+ * Only the first boot initializes the sensors completely, after a deep sleep they are resumed with the state that was kept in RTC memory.
+ */
+void lowPowerWake()
+{
+  // Pick up the state that was kept in RTC memory and get the sensors ready
+  bool resumed = DM_Power::begin();
+  Wire.begin();
+  bool sensorsReady = resumed ? sensors.resume() : sensors.begin();
+  if (!resumed)
+    DM_LOG_INFO("DM_Power", "Low-power mode: one sample every deep-sleep cycle, the radio is only turned on for a full batch.");
+
+  // Start the conversions and light-sleep until all of them are finished
+  DM_Sample sample = {0, 0, NAN, NAN, NAN, NAN};
+  if (sensorsReady)
+  {
+    uint32_t waitMs = sensors.service(sample);
+    while (sensors.isConverting())
+    {
+      DM_Power::lightSleep(max(waitMs, (uint32_t)1));
+      waitMs = sensors.service(sample);
+    }
+
+    // Give the sample its time and keep it in RTC memory (if the buffer is full, the radio is turned on first to make room)
+    sample.timestampMs = DM_Power::getStationMs();
+    sample.epochSeconds = DM_Time::getEpochSeconds();
+    DM_Power::sampleTaken();
+    bool buffered = DM_Power::bufferSample(sample);
+
+    // Only turn on the radio when a batch is full or the oldest sample waited too long
+    if (!buffered || DM_Power::isUplinkDue(lowPowerBatchSize, lowPowerMaxLatencyMs))
+      lowPowerUplink();
+    if (!buffered)
+      DM_Power::bufferSample(sample);
+  }
+
+  // Sleep until the next sample is due
+  DM_Power::deepSleepUntilNextSample(lowPowerSamplePeriodMs);
+}
+#endif
+
+// TASKS (RUN FOREVER, NEXT TO EACH OTHER)
+/**
+ * Read the sensors at a fixed rate, add the measurements to the statistics and push the summary of every window into the summary buffer (runs as its own task, never waits on the network).
+ *
+ * @param parameters Unused (required by FreeRTOS).
+ */
+void samplingTask(void *parameters)
+{
+  // Every sensor writes its values into this sample at its own rate, it is added to the statistics every sample period
+  DM_Sample latestSample = {0, 0, NAN, NAN, NAN, NAN};
+  uint32_t nextSampleMs = millis();
+
+  // Keep sampling forever
+  for (;;)
+  {
+    // Start the conversions of the sensors that are due and collect the finished ones (this never waits)
+    uint32_t waitMs = sensors.service(latestSample);
+
+    // Add the latest values to the statistics when a sample is due (not in the middle of a burst, so a sensor that is due at the same moment is included, unless the burst takes too long)
+    uint32_t now = millis();
+    if ((int32_t)(now - nextSampleMs) >= 0 && (!sensors.isConverting() || now - nextSampleMs >= maxSampleDelayMs))
+    {
+      // Store the moment of the measurement in the sample
+      latestSample.timestampMs = now;
+      latestSample.epochSeconds = DM_Time::getEpochSeconds();
+
+      // Keep the sample in the history
+      history.push(latestSample);
+
+      // Hand the summary over to the uplink task when a window ended (if the buffer is full, the summary is dropped and counted as an overrun)
+      DM_WindowSummary summary;
+      if (statistics.add(latestSample, summary))
+        summaryBuffer.push(summary);
+
+      // Remember what the last BMP280 measurement cost on the I2C bus
+      BMP280i2cTransactions = sensors.get<0>().getLastSnapshot().i2cTransactions;
+      BMP280i2cBusTimeUs = sensors.get<0>().getLastSnapshot().i2cBusTimeUs;
+
+      // Plan the next sample at a fixed rate (unless we are more than a whole period late)
+      nextSampleMs = now - nextSampleMs >= samplePeriodMs ? now + samplePeriodMs : nextSampleMs + samplePeriodMs;
+    }
+
+    // Sleep until a sensor or the next sample is due
+    uint32_t untilNextSampleMs = (int32_t)(nextSampleMs - now) > 0 ? nextSampleMs - now : 0;
+    vTaskDelay(max((TickType_t)1, pdMS_TO_TICKS(min(waitMs, untilNextSampleMs))));
+  }
+}
+
+/**
+ * Keep the Wi-Fi connection alive and hand every measurement in the summary buffer to the sinks (runs as its own task).
+ *
+ * @param parameters Unused (required by FreeRTOS).
+ */
+void uplinkTask(void *parameters)
+{
+  // Keep sending forever
+  for (;;)
+  {
+    // Move the Wi-Fi connection forward (this never waits for the network) and store if we are connected, because this will determine if we execute Wi-Fi related functions or not
+    wifiSuccessfullyConnected = DM_WiFi::tick();
+
+    // Tell the sinks if they can reach the network (they connect, batch, send and replay by themselves, each in its own task)
+    DM_Sink::setNetworkAvailable(wifiSuccessfullyConnected);
+
+    // Start synchronizing the clock and the web server once the network is up (this only does something the first time)
+    if (wifiSuccessfullyConnected)
+    {
+      DM_Time::begin();
+      DM_WebServer::begin();
+    }
+
+    // Read the commands typed in the serial monitor
+    handleSerialCommands();
+
+#ifdef DM_PROFILING
+    // Print the latency of the hot paths every now and then
+    static uint32_t nextProfilerReportMs = profilerReportPeriodMs;
+    if ((int32_t)(millis() - nextProfilerReportMs) >= 0)
+    {
+      DM_Profiler::printReport();
+      nextProfilerReportMs = millis() + profilerReportPeriodMs;
+    }
+#endif
+
+    // Wait a little while if there is nothing to send
+    DM_WindowSummary summary;
+    if (!summaryBuffer.pop(summary))
+    {
+      vTaskDelay(pdMS_TO_TICKS(uplinkPollPeriodMs));
+      continue;
+    }
+
+    // Send the mean of every value over the window, stamped with the end of the window
+    DM_Sample sample = {summary.endMs, summary.epochSeconds, NAN, NAN, NAN, NAN};
+    for (size_t i = 0; i < summary.amountOfFields; i++)
+      sample.*sensors.getFields()[i].member = summary.fields[i].mean;
+
+    // Give the measurement its real time if it was taken before the clock got synchronized
+    DM_Time::completeTimestamp(sample);
+
+    // Show the measurement (this only formats it into the log, the serial port is left to the log task)
+    DM_LOG_INFO(nullptr, "--- New measurement --------------------------");
+
+    // Show the statistics of every value over the window
+    for (size_t i = 0; i < summary.amountOfFields; i++)
+    {
+      const DM_Field &field = sensors.getFields()[i];
+      const DM_FieldStatistics &fieldStatistics = summary.fields[i];
+      DM_LOG_INFO(nullptr, "%s: mean %.2f %s (min %.2f, max %.2f, stddev %.2f, last %.2f, %lu readings)", field.name, fieldStatistics.mean, field.unit, fieldStatistics.minimum, fieldStatistics.maximum,
+                  sqrt(fieldStatistics.variance), fieldStatistics.last, (unsigned long)fieldStatistics.amount);
+    }
+
+    // Show the state of the summary buffer and what the last BMP280 measurement cost on the I2C bus
+    DM_LOG_INFO(nullptr, "Summary buffer: %u/%u waiting, %lu overruns", (unsigned)summaryBuffer.getDepth(), (unsigned)summaryBuffer.getCapacity(), (unsigned long)summaryBuffer.getOverruns());
+    DM_LOG_INFO(nullptr, "BMP280 bus usage: %u transactions, %lu µs", (unsigned)BMP280i2cTransactions, (unsigned long)BMP280i2cBusTimeUs);
+
+    // Decide if the summary is worth sending (every summary is evaluated, so the rates of change stay up to date)
+    DM_ReportingDecision decision = reportingPolicy.evaluate(summary);
+    reportingPolicy.printStatistics();
+    ThingSpeakClient.printStatistics();
+    for (DM_Sink *sink : sinks)
+      if (sink->isStarted())
+        sink->printStatistics();
+
+    // Use short windows while a value is changing fast, and go back to the windows the user asked for last once every value is calm again
+    static bool fastReporting = false;
+    if (reportingPolicy.isFastReporting() != fastReporting)
+    {
+      fastReporting = reportingPolicy.isFastReporting();
+      if (fastReporting)
+        statistics.requestConfiguration(fastStatisticsWindowMs, fastStatisticsWindowMs);
+      else
+        statistics.requestConfiguration(normalWindowMs, normalSlideMs);
+    }
+
+    // Don't send anything if every value stayed within its deadband (the samples themselves are still in the history)
+    if (decision == DM_REPORT_SUPPRESS)
+      continue;
+
+    // Hand the results over to every sink (this never waits: a slow or unreachable destination only fills up its own queue)
+    for (DM_Sink *sink : sinks)
+      sink->offer(sample);
+  }
+}
+
 // SETUP (EXECUTES ONE TIME, WHEN THE DEVICE BOOTS)
 void setup()
 {
   // Set the speed of data transfer to 9.600 bits per second
   Serial.begin(9600);
 
+  // Print the log from a task with a low priority, so logging never waits for the serial port
+  DM_Log::begin(0, 0);
+
+#ifdef DM_PROFILING
+  // Read how fast the clock of the latency probes runs
+  DM_Profiler::begin();
+#endif
+
+#ifdef DM_LOW_POWER
+  // In low-power mode every wake takes one sample and goes back to deep sleep (the tasks are never started)
+  lowPowerWake();
+#endif
+
   // Print a boot message
-  Serial.println("\n+----------------------------------------------+\n|               WEATHER STATION                |\n|----------------------------------------------|\n| Coded by DataMind (aka. Rune Van den Heuvel) |\n+----------------------------------------------+");
+  DM_LOG_INFO(nullptr, "+----------------------------------------------+");
+  DM_LOG_INFO(nullptr, "|               WEATHER STATION                |");
+  DM_LOG_INFO(nullptr, "|----------------------------------------------|");
+  DM_LOG_INFO(nullptr, "| Coded by DataMind (aka. Rune Van den Heuvel) |");
+  DM_LOG_INFO(nullptr, "+----------------------------------------------+");
 
   // Initialize the I2C bus as a master (we say "as a master" because we don't give an address as parameter)
   Wire.begin();
 
-  // Start the Wi-Fi connector and store the success rate of the very first wifi connection attempt
-  initialWiFiSuccessfullyConnected = DM_WiFi::connectToWiFi(WiFiSSID, WiFiPassword);
+  // Set the Wi-Fi credentials (the uplink task makes and keeps the connection)
+  DM_WiFi::setCredentials(WiFiSSID, WiFiPassword);
 
-  // Set the MQTT connection parameters;
+  // Set the MQTT connection parameters (the MQTT service task makes and keeps the connection)
   ThingSpeakClient.setConnectionParameters(ThingSpeakChannel, MQTTClientID, MQTTUsername, MQTTPassword);
+  ThingSpeakClient.setWriteAPIKey(ThingSpeakWriteAPIKey);
+  ThingSpeakSink.setBatchPolicy(ThingSpeakBatchSize, ThingSpeakBatchMaxLatencyMs);
+  ThingSpeakClient.setFields(sensors.getFields(), sensors.amountOfFields);
 
-  // Connect to MQTT for the first time, but only if the first Wi-Fi connection succeeded (based on the 'initialWiFiSuccessfullyConnected' variable)
-  initialMQTTSuccessfullyConnected = initialWiFiSuccessfullyConnected && ThingSpeakClient.connectToMQTT();
+  // Set the Discord webhook and how many measurements are shown in one message
+  DiscordWebhookConnector.setWebhookURL(DiscordWebhookURL);
+  DiscordWebhookConnector.setFields(sensors.getFields(), sensors.amountOfFields);
+  DiscordSink.setBatchPolicy(DiscordSamplesPerMessage, DiscordMaxDelayMs);
 
-  // Initialize the BH1750 sensor and the BMP280 as a measure device and save the success rate in a variable
-  successfullSetup = measurer.initializeBH1750(lightSensor) && measurer.initializeBMP280(temperaturePressureChip);
-}
+  // Set the InfluxDB server (UDP if a host is given, the HTTP write API otherwise)
+  if (InfluxHost.empty())
+    InfluxSink.setHTTPServer(InfluxWriteURL, InfluxToken);
+  else
+    InfluxSink.setUDPServer(InfluxHost, InfluxPort);
+  InfluxSink.setFields(sensors.getFields(), sensors.amountOfFields);
+  InfluxSink.setBatchPolicy(InfluxBatchSize, InfluxBatchMaxLatencyMs);
 
-// LOOP (EXECUTES UNTILL DEVICE LOSES POWER)
-void loop()
-{
-  // Don't start this code if the setup of the BMP280 or BH1750 wasn't a success
+  // Set the MQTT broker, and the format of the payloads (the ThingSpeak channel number is the station ID of a binary payload)
+  MQTTBrokerSink.setBroker(MQTTBrokerHost, MQTTBrokerPort, MQTTBrokerClientID, MQTTBrokerUsername, MQTTBrokerPassword);
+  MQTTBrokerSink.setTopic(MQTTBrokerTopic);
+  MQTTBrokerSink.setFields(sensors.getFields(), sensors.amountOfFields);
+  MQTTBrokerSink.setPayloadFormat(MQTTBrokerPayloadFormat, ThingSpeakChannel);
+  MQTTBrokerSink.setBatchPolicy(MQTTBrokerBatchSize, MQTTBrokerBatchMaxLatencyMs);
+
+  // Reserve the memory for the history of the samples
+  history.begin(historyExternalCapacity, historyInternalCapacity);
+
+  // Show the readings, the history and the counters on the web server (the uplink task starts it once the network is up)
+  DM_WebServer::setHistory(&history, sensors.getFields(), sensors.amountOfFields);
+  DM_WebServer::setSinks(sinks, sizeof(sinks) / sizeof(sinks[0]));
+  DM_WebServer::setMetrics(metrics, sizeof(metrics) / sizeof(metrics[0]));
+
+  // Set the windows of the statistics (this can be changed later by typing "window <seconds> <seconds>" in the serial monitor)
+  statistics.configure(statisticsWindowMs, statisticsSlideMs);
+
+  // Set when a summary is sent even though nothing changed, and how long the short windows are kept after a fast change
+  reportingPolicy.configure(reportingHeartbeatMs, fastReportingHoldMs);
+
+  // Open the flash log (measurements that could not be sent before the last reboot are replayed by the uplink task)
+  DM_StorageLog::begin();
+
+  // Initialize all sensors and save the success rate in a variable
+  successfullSetup = sensors.begin();
+
+  // Don't start the tasks if the setup of one of the sensors wasn't a success
   if (!successfullSetup)
     return;
 
-  // Reconnect to the Wi-Fi network if the connection has been lost and store the result of the connection attempt in a variable because this will determine if we execute Wi-Fi related functions or not (only do this when the very first Wi-Fi connection was a success)
-  wifiSuccessfullyConnected = initialWiFiSuccessfullyConnected && DM_WiFi::checkAndReconnect(WiFiSSID, WiFiPassword);
-
-  // Reconnect to the MQTT server if the connection has been lost and store the result of the connection attempt in a variable because this will determine if we execute MQTT related functions (only do this when the very first Wi-Fi and MQTT connection were a success)
-  mqttSuccessfullyConnected = wifiSuccessfullyConnected && initialMQTTSuccessfullyConnected && DM_ThingSpeak::checkAndReconnectToMQTT();
-
-  // Read the measurements and store them in variables
-  float lightLevel = DM_Measurer::BH1750readLightLevelLux(lightSensor);
-  float temperature = measurer.BMP280readTemperatureC();
-  float pressurePa = measurer.BMP280readPressurePa();
-  float pressureBar = measurer.BMP280readPressureBar();
-
-  // Make room for (new) measurements to display
-  Serial.println("\n--- New measurement --------------------------");
-
-  // Show the light intensity
-  Serial.print("Current light intensity: "); // Print the light intensity value (first part)
-  Serial.print(lightLevel);                  // Print the light intensity value (second part)
-  Serial.println(" lux");                    // Print the light intensity value (third part)
-
-  // Show the temperature, pressure and altitude
-  Serial.print("Current temperature: "); // Print the temperature value (first part)
-  Serial.print(temperature);             // Print the temperature value (second part)
-  Serial.println(" °C");                 // Print the temperature value (third part)
-  Serial.print("Current pressure: ");    // Print the pressure value (first part)
-  Serial.print(pressurePa);              // Print the pressure value in Pa (second part)
-  Serial.print(" Pa (");                 // Print the pressure value (third part)
-  Serial.print(pressureBar);             // Print the pressure value in bar (fourth part)
-  Serial.println(" bar)\n");             // Print the pressure value (fifth part)
-
-  // Publish the results to ThingSpeak, only if we are successfully connected with the MQTT server
-  if (mqttSuccessfullyConnected)
-  {
-    ThingSpeakClient.publishInformation(temperature, lightLevel, pressurePa);
-  }
+  // Start the sampling task on the application core (core 1) with a higher priority, so reading the sensors is never delayed by the network
+  xTaskCreatePinnedToCore(samplingTask, "DM_Sampling", 4096, NULL, 3, &samplingTaskHandle, 1);
+
+  // Start the uplink task on the protocol core (core 0), next to the Wi-Fi stack
+  xTaskCreatePinnedToCore(uplinkTask, "DM_Uplink", 8192, NULL, 1, &uplinkTaskHandle, 0);
+
+  // Start the MQTT service task on the same core with a higher priority, so the keepalive pings are never delayed by the (slow) HTTP requests of the sinks
+  ThingSpeakClient.startService(0, 2);
 
-  // Send the results to a Discord webhook, only if we are succesfully connected to the Wi-Fi network
-  if (wifiSuccessfullyConnected)
-    DiscordWebhookConnector.sendMessage(DiscordWebhookURL, DiscordWebhookConnector.embedBuilder(temperature, lightLevel, pressurePa));
+  // Start a task for every sink on the protocol core (Discord needs a larger stack for TLS)
+  ThingSpeakSink.start(0, 1, 8192);
+  DiscordSink.start(0, 1, 8192);
+  if (InfluxEnabled)
+    InfluxSink.start(0, 1, 4096);
+  if (MQTTBrokerEnabled)
+    MQTTBrokerSink.start(0, 1, 4096);
+}
 
-  // Wait fifteen seconds before reading new data
-  delay(15000);
+// LOOP (NOT USED, THE WORK IS DONE BY THE SAMPLING TASK AND THE UPLINK TASK)
+void loop()
+{
+  // Delete the Arduino loop task, so it doesn't take up any processor time
+  vTaskDelete(NULL);
 }
\ No newline at end of file
@@ -0,0 +1,188 @@
+#!/usr/bin/env python3
+"""
++----------------------------------------------+
+|    benchmark.py - Soak tests of the station  |
+|----------------------------------------------|
+| Coded by DataMind (aka. Rune Van den Heuvel) |
++----------------------------------------------+
+
+Runs the station in the simulator (the "native" environment in "platformio.ini") through a set of scenarios, and collects the benchmark results of every
+scenario in one JSON file: the sampling cycle, the compression of the flash log, the latency of the hot paths, the heap high-water mark and the uplink throughput.
+With "--trace", a recorded trace (or a CSV of "/history" of a real station) is replayed as a scenario as well, to see how well the weather of the field compresses.
+
+Every result but the "host" member only depends on the scenario, so two commits can be compared directly:
+
+    pio run -e native
+    python3 tools/benchmark.py --output before.json
+    ... change the station ...
+    pio run -e native
+    python3 tools/benchmark.py --output after.json --baseline before.json
+
+With "--baseline", every metric that got worse by more than the tolerance is shown, and the script exits with 1.
+It also exits with 1 when a check of a scenario fails: the filter rejected a spike in a scenario without glitches, a compressed sample did not decode to what went in, or a measurement that the station keeps
+until it is delivered (the ThingSpeak sink, the flash log and the summary buffer) was dropped or still waits in the flash log at the end, or ThingSpeak received a measurement twice.
+The low-power scenarios run the simulator of the low-power mode ("pio run -e native-lowpower"), which deep-sleeps between the samples and wakes many times: they check that the flash log drains across the wakes.
+The Discord sink only shows the newest measurements, so what it drops during an outage is shown, but not checked.
+"""
+
+# IMPORT THE NECESSARY LIBRARIES
+import argparse    # Used to read the options
+import json        # Used to read and write the results
+import os          # Used to find the simulator and the temporary result files
+import re          # Used to read the counters of "/metrics"
+import subprocess  # Used to run the simulator
+import sys         # Used to exit with the result of the comparison
+import tempfile    # Used to let every scenario write its results to a file of its own
+
+# The scenarios: a name and the options of the simulator (every minute is a minute after the boot)
+SCENARIOS = {
+    "day": ["--duration", "24"],
+    "week": ["--duration", "168"],
+    "outages": ["--duration", "24", "--outage", "wifi:120:15", "--outage", "internet:360:30", "--outage", "wifi:600:5:6:60"],
+    "broker-flaps": ["--duration", "24", "--outage", "mqtt:60:2:48:20"],
+    "glitches": ["--duration", "24", "--glitches", "0.05"],
+    "internet-day": ["--duration", "30", "--outage", "internet:10:1440"],
+    "wifi-day": ["--duration", "30", "--outage", "wifi:10:1440"],
+}
+
+# The scenarios of the low-power mode (the web server doesn't run in that mode, so the counters of the station are not checked)
+LOW_POWER_SCENARIOS = {
+    "low-power-outage": ["--duration", "30", "--outage", "wifi:60:360"],
+}
+
+# The metrics that are compared with the baseline: a path in the results, and if higher is better
+METRICS = [
+    (("sensors", "bmp280", "longest_cycle_us"), False),
+    (("sensors", "bh1750", "longest_cycle_us"), False),
+    (("codec", "flash_bytes_per_sample"), False),
+    (("memory", "high_water_mark_bytes"), False),
+    (("memory", "allocations"), False),
+    (("uplink", "thingspeak", "items_per_hour"), True),
+    (("uplink", "discord", "items_per_hour"), True),
+    (("uplink", "thingspeak_max_age_s"), False),
+    (("uplink", "thingspeak_replay", "items_per_minute"), True),
+] + [(("stages", stage, "p99_us"), False) for stage in ("i2c_bmp280", "i2c_bh1750", "mqtt_publish", "bulk_update", "discord_post", "wifi_connect", "mqtt_connect", "serial_print")]
+
+
+def run_scenario(program, arguments):
+    """Run the simulator with the options of a scenario, and return its benchmark results with the counters of the station ("/metrics" at the end) in "station"."""
+    with tempfile.TemporaryDirectory() as directory:
+        path = os.path.join(directory, "benchmark.json")
+        output = subprocess.run([program, "--quiet", "--benchmark", path, "--fetch", "/metrics"] + arguments, check=True, stdout=subprocess.PIPE, universal_newlines=True).stdout
+        with open(path) as file:
+            results = json.load(file)
+    results["station"] = read_metrics(output)
+    return results
+
+
+def read_metrics(output):
+    """Read the counters of the station from "/metrics": the filtered spikes, the measurements every sink, the flash log and the summary buffer dropped, and what still waits in the flash log."""
+    counters = {"dm_filter_spikes_total": "filter_spikes", "dm_flash_log_dropped_total": "flash_log_dropped", "dm_flash_log_samples": "flash_log_waiting", "dm_summary_buffer_overruns_total": "summary_overruns"}
+    station = {name: 0 for name in counters.values()}
+    station["dropped"] = {}
+    for line in output.splitlines():
+        match = re.match(r'^(\w+) (\d+)$', line)
+        if match and match.group(1) in counters:
+            station[counters[match.group(1)]] = int(match.group(2))
+        match = re.match(r'^dm_sink_dropped_total\{sink="(\w+)"\} (\d+)$', line)
+        if match:
+            station["dropped"][match.group(1)] = int(match.group(2))
+    return station
+
+
+def check(name, arguments, scenario):
+    """Check the results of a scenario, and return the amount of failed checks."""
+    failures = 0
+    if "--glitches" not in arguments and "--replay" not in arguments and scenario["station"]["filter_spikes"] > 0:
+        print("FAILED %s: the filter rejected %d spike(s) without glitches" % (name, scenario["station"]["filter_spikes"]))
+        failures += 1
+    if scenario["codec"]["mismatches"] > 0:
+        print("FAILED %s: %d compressed sample(s) did not decode to what went in" % (name, scenario["codec"]["mismatches"]))
+        failures += 1
+    if scenario["uplink"]["thingspeak_duplicates"] > 0:
+        print("FAILED %s: ThingSpeak received %d measurement(s) twice" % (name, scenario["uplink"]["thingspeak_duplicates"]))
+        failures += 1
+    if name in LOW_POWER_SCENARIOS and scenario["wakes"] == 0:
+        print("FAILED %s: the station never woke from deep sleep (the simulator was not built for the low-power mode)" % name)
+        failures += 1
+    lost = {"the ThingSpeak sink dropped": scenario["station"]["dropped"].get("DM_ThingSpeak", 0), "the flash log dropped": scenario["station"]["flash_log_dropped"],
+            "the summary buffer dropped": scenario["station"]["summary_overruns"], "the flash log still holds": scenario["station"]["flash_log_waiting"]}
+    for what, amount in lost.items():
+        if amount > 0:
+            print("FAILED %s: %s %d measurement(s)" % (name, what, amount))
+            failures += 1
+    return failures
+
+
+def get_metric(results, path):
+    """Find a metric in the results of a scenario (None if it isn't there)."""
+    for key in path:
+        if not isinstance(results, dict) or key not in results:
+            return None
+        results = results[key]
+    return results
+
+
+def compare(results, baseline, tolerance):
+    """Show every metric that got worse than in the baseline by more than the tolerance (in percent), and return the amount of regressions."""
+    regressions = 0
+    for name, scenario in results["scenarios"].items():
+        if name not in baseline.get("scenarios", {}):
+            continue
+        for path, higherIsBetter in METRICS:
+            old, new = get_metric(baseline["scenarios"][name], path), get_metric(scenario, path)
+            if old is None or new is None or old == new:
+                continue
+            change = (new - old) / old * 100 if old != 0 else float("inf")
+            if (change < -tolerance) if higherIsBetter else (change > tolerance):
+                print("REGRESSION %s %s: %s -> %s (%+.1f %%)" % (name, ".".join(path), old, new, change))
+                regressions += 1
+    return regressions
+
+
+def main():
+    # Read the options
+    parser = argparse.ArgumentParser(description="Run the soak tests of the station in the simulator and collect the benchmark results.")
+    parser.add_argument("--program", default=os.path.join(".pio", "build", "native", "program"), help="the simulator (built with \"pio run -e native\")")
+    parser.add_argument("--low-power-program", default=os.path.join(".pio", "build", "native-lowpower", "program"), help="the simulator of the low-power mode (built with \"pio run -e native-lowpower\")")
+    parser.add_argument("--output", default="benchmark.json", help="the file the results are written to")
+    parser.add_argument("--baseline", help="the results of an earlier commit to compare with")
+    parser.add_argument("--tolerance", type=float, default=10, help="how much worse a metric may get, in percent (default 10)")
+    parser.add_argument("--trace", action="append", default=[], help="a trace (or a CSV of \"/history\") to replay as an extra scenario (can be repeated)")
+    parser.add_argument("--only", nargs="+", help="only run these scenarios")
+    options = parser.parse_args()
+
+    # Run every scenario, and every trace as a scenario of its own
+    scenarios = dict(SCENARIOS, **LOW_POWER_SCENARIOS)
+    for trace in options.trace:
+        scenarios["replay-" + os.path.basename(trace)] = ["--replay", trace]
+    results = {"format": 1, "scenarios": {}}
+    failures = 0
+    for name, arguments in scenarios.items():
+        if options.only and name not in options.only:
+            continue
+        results["scenarios"][name] = run_scenario(options.low_power_program if name in LOW_POWER_SCENARIOS else options.program, arguments)
+        host = results["scenarios"][name]["host"]
+        replay = results["scenarios"][name]["uplink"]["thingspeak_replay"]
+        print("%s: %.1f simulated hours in %.1f s (%.0fx), %d measurement(s) replayed at %.1f per minute, %d dropped by Discord" % (name, results["scenarios"][name]["simulated_hours"], host["real_seconds"],
+              host["speedup"], replay["items"], replay["items_per_minute"], results["scenarios"][name]["station"]["dropped"].get("DM_Discord", 0)))
+        codec = results["scenarios"][name]["codec"]
+        print("%s: %.2f bytes of flash per sample (%.1fx smaller than packed), %.0f ns to compress and %.0f ns to decompress a sample" % (name,
+              codec["flash_bytes_per_sample"], codec["ratio_to_packed"], host["encode_ns_per_sample"], host["decode_ns_per_sample"]))
+        failures += check(name, arguments, results["scenarios"][name])
+    with open(options.output, "w") as file:
+        json.dump(results, file, indent=2)
+        file.write("\n")
+
+    # Compare with the baseline
+    regressions = 0
+    if options.baseline:
+        with open(options.baseline) as file:
+            regressions = compare(results, json.load(file), options.tolerance)
+        print("%d regression(s) compared with %s" % (regressions, options.baseline))
+    print("%d failed check(s)" % failures)
+    sys.exit(1 if regressions > 0 or failures > 0 else 0)
+
+
+if __name__ == "__main__":
+    main()
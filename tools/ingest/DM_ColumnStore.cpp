@@ -0,0 +1,322 @@
+/** +----------------------------------------------+
+ *  |     DM_ColumnStore - Per-station columns     |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "DM_ColumnStore.h" // Include the header file where the declarations for this library are stored
+#include <fcntl.h>          // Used to open the column files
+#include <math.h>           // Used to fill the missing values with NaN
+#include <algorithm>        // Used to limit the amount of samples that are skipped
+#include <string.h>         // Used to copy the values into the mapped files
+#include <sys/mman.h>       // Used to map the column files into memory
+#include <sys/stat.h>       // Used to create the directories and to read the size of a file
+#include <unistd.h>         // Used to grow and close the files
+
+// OTHER VARIABLES
+const size_t amountOffset = 16; // The position of the amount of values in the header (after the magic and the size of one value)
+
+/**
+ * Create a column that is not opened yet.
+ */
+DM_ColumnFile::DM_ColumnFile() : _valueSize(0), _map(nullptr), _mapSize(0)
+{
+}
+
+/**
+ * Unmap the file.
+ */
+DM_ColumnFile::~DM_ColumnFile()
+{
+    this->close();
+}
+
+/**
+ * Open a column file, or create it if it doesn't exist.
+ *
+ * @param path The path of the file.
+ * @param valueSize The size of one value in bytes (it has to be the same as when the file was created).
+ *
+ * @return The success rate of opening the file.
+ */
+bool DM_ColumnFile::open(const std::string &path, uint32_t valueSize)
+{
+    // Open the file, and give a new file its header and room for the first values
+    int file = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (file < 0)
+        return false;
+    struct stat status;
+    bool isNew = fstat(file, &status) == 0 && status.st_size == 0;
+    size_t size = isNew ? headerSize + initialCapacity * valueSize : (size_t)status.st_size;
+    if ((isNew && ftruncate(file, size) != 0) || size < headerSize)
+    {
+        ::close(file);
+        return false;
+    }
+
+    // Map it, and check the header of an existing file
+    void *map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    ::close(file);
+    if (map == MAP_FAILED)
+        return false;
+    this->_map = (uint8_t *)map;
+    this->_mapSize = size;
+    this->_path = path;
+    this->_valueSize = valueSize;
+    if (isNew)
+    {
+        memcpy(this->_map, magic, sizeof(magic));
+        memcpy(this->_map + sizeof(magic), &valueSize, sizeof(valueSize));
+        return true;
+    }
+    uint32_t storedValueSize;
+    memcpy(&storedValueSize, this->_map + sizeof(magic), sizeof(storedValueSize));
+    if (memcmp(this->_map, magic, sizeof(magic)) != 0 || storedValueSize != valueSize || headerSize + this->getAmount() * valueSize > size)
+    {
+        this->close();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Add a value at the end of the column (the file grows when it is full).
+ *
+ * @param value The value (the size given to open()).
+ *
+ * @return The success rate of adding the value.
+ */
+bool DM_ColumnFile::append(const void *value)
+{
+    uint64_t amount = this->getAmount();
+    if (this->_map == nullptr || (headerSize + (amount + 1) * this->_valueSize > this->_mapSize && !this->_grow()))
+        return false;
+    memcpy(this->_map + headerSize + amount * this->_valueSize, value, this->_valueSize);
+    __atomic_store_n((uint64_t *)(this->_map + amountOffset), amount + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/**
+ * Get the amount of values in the column.
+ *
+ * @return The amount of values.
+ */
+uint64_t DM_ColumnFile::getAmount() const
+{
+    return this->_map == nullptr ? 0 : __atomic_load_n((uint64_t *)(this->_map + amountOffset), __ATOMIC_ACQUIRE);
+}
+
+/**
+ * Ask the kernel to write the column to the disk, and unmap it.
+ */
+void DM_ColumnFile::close()
+{
+    if (this->_map == nullptr)
+        return;
+    msync(this->_map, this->_mapSize, MS_ASYNC);
+    munmap(this->_map, this->_mapSize);
+    this->_map = nullptr;
+}
+
+/**
+ * Double the size of the file and map it again.
+ *
+ * @return The success rate of growing the file.
+ */
+bool DM_ColumnFile::_grow()
+{
+    size_t size = this->_mapSize * 2;
+    int file = ::open(this->_path.c_str(), O_RDWR | O_CLOEXEC);
+    if (file < 0)
+        return false;
+    bool grown = ftruncate(file, size) == 0;
+    ::close(file);
+    void *map = grown ? mremap(this->_map, this->_mapSize, size, MREMAP_MAYMOVE) : MAP_FAILED;
+    if (map == MAP_FAILED)
+        return false;
+    this->_map = (uint8_t *)map;
+    this->_mapSize = size;
+    return true;
+}
+
+/**
+ * Create the store of a station (the directory and the time column are created by the first append).
+ *
+ * @param directory The directory of the station.
+ */
+DM_StationStore::DM_StationStore(const std::string &directory) : _directory(directory), _sequenced(false), _bootID(0), _nextSequence(0)
+{
+}
+
+/**
+ * Add a sample to the columns of the station.
+ *
+ * @param timeMs The time of the sample (Unix time in ms).
+ * @param values The value of every field (field 1 first, "amountOfFields" values).
+ * @param presentFields A bit per field that the sample has (bit 0 for field 1).
+ *
+ * @return The success rate of adding the sample.
+ */
+bool DM_StationStore::append(uint64_t timeMs, const float *values, uint8_t presentFields)
+{
+    std::lock_guard<std::mutex> guard(this->_lock);
+
+    // Open the time column the first time
+    if (this->_time.getAmount() == 0 && !this->_time.open(this->_directory + "/time.col", sizeof(uint64_t)))
+    {
+        mkdir(this->_directory.c_str(), 0755);
+        if (!this->_time.open(this->_directory + "/time.col", sizeof(uint64_t)))
+            return false;
+    }
+
+    // Add the value of every field that has a column or is sent now (a field that isn't in the sample gets NaN)
+    for (uint8_t field = 0; field < amountOfFields; field++)
+    {
+        bool present = presentFields & (1 << field);
+        if (this->_fields[field].getAmount() == 0 && !(present && this->_openField(field)))
+            continue;
+        float value = present ? values[field] : NAN;
+        if (!this->_fields[field].append(&value))
+            return false;
+    }
+    return this->_time.append(&timeMs);
+}
+
+/**
+ * Check the sequence numbers of a binary payload against the samples the station sent before, and remember the highest one.
+ * A station only moves on to the next sequence numbers once a payload is acknowledged, so the samples it already sent are always the first ones of a payload that is sent again.
+ * The sequence numbers are only kept in memory: a payload that is sent again after the server restarted is stored twice.
+ *
+ * @param bootID The boot ID in the payload.
+ * @param sequence The sequence number of the first sample.
+ * @param amount The amount of samples in the payload.
+ *
+ * @return The amount of samples at the start of the payload that were already stored.
+ */
+uint32_t DM_StationStore::skipKnownSamples(uint32_t bootID, uint32_t sequence, uint32_t amount)
+{
+    std::lock_guard<std::mutex> guard(this->_lock);
+
+    // A new boot ID means the station restarted and counts from 0 again
+    if (!this->_sequenced || bootID != this->_bootID)
+    {
+        this->_sequenced = true;
+        this->_bootID = bootID;
+        this->_nextSequence = sequence;
+    }
+
+    // Skip the samples before the next sequence number (calculated modulo 2^32, so a sequence number that wraps around still counts up)
+    int32_t known = (int32_t)(this->_nextSequence - sequence);
+    uint32_t skipped = known <= 0 ? 0 : std::min((uint32_t)known, amount);
+    if ((int32_t)(sequence + amount - this->_nextSequence) > 0)
+        this->_nextSequence = sequence + amount;
+    return skipped;
+}
+
+/**
+ * Get the amount of samples of the station.
+ *
+ * @return The amount of samples.
+ */
+uint64_t DM_StationStore::getAmount() const
+{
+    return this->_time.getAmount();
+}
+
+/**
+ * Open the column of a field, and fill it up with NaN for the samples from before the field was sent.
+ *
+ * @param field The field (0 for field 1).
+ *
+ * @return The success rate of opening the column.
+ */
+bool DM_StationStore::_openField(uint8_t field)
+{
+    DM_ColumnFile &column = this->_fields[field];
+    if (!column.open(this->_directory + "/field" + std::to_string(field + 1) + ".col", sizeof(float)))
+        return false;
+    float missing = NAN;
+    while (column.getAmount() < this->_time.getAmount())
+        if (!column.append(&missing))
+            return false;
+    return true;
+}
+
+/**
+ * Use a directory for the stores of the stations (it is created if it doesn't exist).
+ *
+ * @param directory The directory.
+ *
+ * @return The success rate of creating the directory.
+ */
+bool DM_ColumnStore::begin(const std::string &directory)
+{
+    this->_directory = directory;
+    struct stat status;
+    return (mkdir(directory.c_str(), 0755) == 0 || errno == EEXIST) && stat(directory.c_str(), &status) == 0 && S_ISDIR(status.st_mode);
+}
+
+/**
+ * Add a sample of a station.
+ *
+ * @param station The channel number of the station.
+ * @param timeMs The time of the sample (Unix time in ms).
+ * @param values The value of every field (field 1 first).
+ * @param presentFields A bit per field that the sample has (bit 0 for field 1).
+ *
+ * @return The success rate of adding the sample.
+ */
+bool DM_ColumnStore::append(uint32_t station, uint64_t timeMs, const float *values, uint8_t presentFields)
+{
+    return this->_getStation(station)->append(timeMs, values, presentFields);
+}
+
+/**
+ * Check the sequence numbers of a binary payload of a station (see "DM_StationStore::skipKnownSamples()").
+ *
+ * @param station The channel number of the station.
+ * @param bootID The boot ID in the payload.
+ * @param sequence The sequence number of the first sample.
+ * @param amount The amount of samples in the payload.
+ *
+ * @return The amount of samples at the start of the payload that were already stored.
+ */
+uint32_t DM_ColumnStore::skipKnownSamples(uint32_t station, uint32_t bootID, uint32_t sequence, uint32_t amount)
+{
+    return this->_getStation(station)->skipKnownSamples(bootID, sequence, amount);
+}
+
+/**
+ * Count the stations that sent something.
+ *
+ * @return The amount of stations.
+ */
+size_t DM_ColumnStore::getAmountOfStations()
+{
+    size_t amount = 0;
+    for (_Shard &shard : this->_shards)
+    {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        amount += shard.stations.size();
+    }
+    return amount;
+}
+
+/**
+ * Find the store of a station, or create it (only the shard of the station is locked meanwhile).
+ *
+ * @param station The channel number of the station.
+ *
+ * @return The store (it stays valid as long as the column store exists).
+ */
+DM_StationStore *DM_ColumnStore::_getStation(uint32_t station)
+{
+    _Shard &shard = this->_shards[(station * 2654435761u) >> 26 & (amountOfShards - 1)];
+    std::lock_guard<std::mutex> guard(shard.lock);
+    std::unique_ptr<DM_StationStore> &store = shard.stations[station];
+    if (store == nullptr)
+        store.reset(new DM_StationStore(this->_directory + "/" + std::to_string(station)));
+    return store.get();
+}
\ No newline at end of file
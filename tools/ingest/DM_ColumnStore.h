@@ -0,0 +1,102 @@
+/** +----------------------------------------------+
+ *  |     DM_ColumnStore - Per-station columns     |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef DM_ColumnStore_h
+#define DM_ColumnStore_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h>      // Used to be able to use the "size_t" type
+#include <stdint.h>      // Used to be able to use the fixed width integer types
+#include <memory>        // Used to own the stores of the stations
+#include <mutex>         // Used to let one thread at a time append to a station
+#include <string>        // Used to keep the paths of the files
+#include <unordered_map> // Used to find the store of a station
+
+/**
+ * One append-only column of fixed-size values in a memory-mapped file.
+ *
+ * The file starts with a header of 64 bytes ("DMCOL1", the size of one value and the amount of values), followed by the values.
+ * The file is grown in steps that double (and mapped again), so an append is a copy into memory: the kernel writes the pages to the disk in the background.
+ * The amount in the header is only raised after the value is written, so a reader that maps the same file never sees a half-written value.
+ * The file descriptor is closed as soon as the file is mapped, so thousands of columns don't take thousands of descriptors.
+ */
+class DM_ColumnFile
+{
+public: // The public functions and constants
+    static constexpr size_t headerSize = 64;        // The size of the header in front of the values
+    static constexpr size_t initialCapacity = 4096; // The amount of values a new file has room for
+    static constexpr char magic[8] = "DMCOL1";      // The first bytes of a column file
+
+    DM_ColumnFile();
+    ~DM_ColumnFile();
+    bool open(const std::string &path, uint32_t valueSize);
+    bool append(const void *value);
+    uint64_t getAmount() const;
+    void close();
+
+private: // The private functions and members
+    std::string _path;   // The path of the file
+    uint32_t _valueSize; // The size of one value in bytes
+    uint8_t *_map;       // The mapped file (nullptr if the column is closed)
+    size_t _mapSize;     // The size of the mapping (and of the file)
+    bool _grow();
+};
+
+/**
+ * The columns of one station: the time of every sample (Unix time in ms) and one column per ThingSpeak field (a float per sample, NaN when the sample didn't have the field).
+ * A column of a field is only created when the station sends that field for the first time (it is filled up with NaN, so every column has a value for every sample).
+ */
+class DM_StationStore
+{
+public: // The public functions and constants
+    static constexpr uint8_t amountOfFields = 8; // The fields a ThingSpeak channel has
+
+    explicit DM_StationStore(const std::string &directory);
+    bool append(uint64_t timeMs, const float *values, uint8_t presentFields);
+    uint32_t skipKnownSamples(uint32_t bootID, uint32_t sequence, uint32_t amount);
+    uint64_t getAmount() const;
+
+private: // The private functions and members
+    std::string _directory;                // The directory with the columns of the station
+    std::mutex _lock;                      // Held while a sample is appended (or the sequence numbers are checked)
+    bool _sequenced;                       // If the station sent a binary payload since the server started
+    uint32_t _bootID;                      // The boot ID of the last binary payload
+    uint32_t _nextSequence;                // The sequence number after the last sample of that boot ID
+    DM_ColumnFile _time;                   // The time of every sample
+    DM_ColumnFile _fields[amountOfFields]; // The values of every field (only opened once the field is used)
+    bool _openField(uint8_t field);
+};
+
+/**
+ * The stores of all stations under one directory ("<directory>/<channel number>/<column>.col").
+ *
+ * The stations are spread over shards by their channel number, and every shard has its own lock, so threads that append for different stations rarely wait for each other.
+ * Appending to one station locks only that station.
+ */
+class DM_ColumnStore
+{
+public: // The public functions and constants
+    static constexpr size_t amountOfShards = 64; // The amount of shards (a power of two)
+
+    bool begin(const std::string &directory);
+    bool append(uint32_t station, uint64_t timeMs, const float *values, uint8_t presentFields);
+    uint32_t skipKnownSamples(uint32_t station, uint32_t bootID, uint32_t sequence, uint32_t amount);
+    size_t getAmountOfStations();
+
+private: // The private functions and members
+    struct _Shard
+    {
+        std::mutex lock;                                                         // Held while a station is looked up or added
+        std::unordered_map<uint32_t, std::unique_ptr<DM_StationStore>> stations; // The stores of the stations of the shard
+    };
+    std::string _directory;         // The directory with one directory per station
+    _Shard _shards[amountOfShards]; // The shards
+    DM_StationStore *_getStation(uint32_t station);
+};
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,631 @@
+/** +----------------------------------------------+
+ *  |  DM_IngestServer - MQTT ingest for stations  |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "DM_IngestServer.h" // Include the header file where the declarations for this library are stored
+#include <errno.h>           // Used to tell a socket that has nothing to read from a failed one
+#include <netinet/in.h>      // Used to bind the listening sockets
+#include <netinet/tcp.h>     // Used to send the acknowledgements without delay
+#include <stdlib.h>          // Used to convert the values of a text payload
+#include <string.h>          // Used to compare the topics
+#include <sys/epoll.h>       // Used to wait for the sockets of a worker
+#include <sys/socket.h>      // Used to accept, read and write the connections
+#include <time.h>            // Used to read the clock and the processor time of a worker
+#include <unistd.h>          // Used to close the sockets
+#include <DM_Payload.h>      // Include the self-made library that decodes the binary payloads (the same code as on the station)
+
+// OTHER VARIABLES
+const uint8_t packetConnect = 1; // The MQTT packet types the broker handles
+const uint8_t packetPublish = 3;
+const uint8_t packetSubscribe = 8;
+const uint8_t packetPingRequest = 12;
+const uint8_t packetDisconnect = 14;
+
+/**
+ * Get the current Unix time in milliseconds.
+ *
+ * @return The Unix time in ms.
+ */
+static uint64_t getEpochMs()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+/**
+ * Create a server that doesn't run yet.
+ */
+DM_IngestServer::DM_IngestServer() : _store(nullptr), _port(0), _running(false)
+{
+}
+
+/**
+ * Stop the workers.
+ */
+DM_IngestServer::~DM_IngestServer()
+{
+    this->stop();
+}
+
+/**
+ * Start the workers, every one with its own listening socket on the port.
+ *
+ * @param store The store the samples are written to (it has to stay valid until the server is stopped).
+ * @param port The TCP port (0 to let the system choose one, see getPort()).
+ * @param amountOfWorkers The amount of threads that serve the connections.
+ *
+ * @return The success rate of starting the server.
+ */
+bool DM_IngestServer::begin(DM_ColumnStore *store, uint16_t port, unsigned int amountOfWorkers)
+{
+    this->_store = store;
+    this->_port = port;
+    this->_running = true;
+    for (unsigned int i = 0; i < amountOfWorkers; i++)
+    {
+        // Open the listening socket (the first one picks the port when it is 0, the others use the same one)
+        std::unique_ptr<_Worker> worker(new _Worker());
+        worker->listener = this->_listen(this->_port);
+        worker->poll = epoll_create1(EPOLL_CLOEXEC);
+        struct epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.fd = worker->listener;
+        if (worker->listener < 0 || worker->poll < 0 || epoll_ctl(worker->poll, EPOLL_CTL_ADD, worker->listener, &event) != 0)
+        {
+            if (worker->listener >= 0)
+                close(worker->listener);
+            if (worker->poll >= 0)
+                close(worker->poll);
+            this->stop();
+            return false;
+        }
+
+        // Start the thread of the worker
+        _Worker *running = worker.get();
+        this->_workers.push_back(std::move(worker));
+        running->thread = std::thread(&DM_IngestServer::_run, this, running);
+    }
+    return !this->_workers.empty();
+}
+
+/**
+ * Stop the workers, and close all connections.
+ */
+void DM_IngestServer::stop()
+{
+    this->_running = false;
+    for (std::unique_ptr<_Worker> &worker : this->_workers)
+    {
+        if (worker->thread.joinable())
+            worker->thread.join();
+        for (std::pair<const int, _Connection> &connection : worker->connections)
+            close(connection.first);
+        worker->connections.clear();
+        close(worker->listener);
+        close(worker->poll);
+    }
+    this->_workers.clear();
+}
+
+/**
+ * Get the port the server listens on.
+ *
+ * @return The port.
+ */
+uint16_t DM_IngestServer::getPort() const
+{
+    return this->_port;
+}
+
+/**
+ * Get the amount of workers.
+ *
+ * @return The amount of workers.
+ */
+unsigned int DM_IngestServer::getAmountOfWorkers() const
+{
+    return this->_workers.size();
+}
+
+/**
+ * Get the amount of samples written since the start.
+ *
+ * @return The amount of samples.
+ */
+uint64_t DM_IngestServer::getAmountOfSamples() const
+{
+    uint64_t amount = 0;
+    for (const std::unique_ptr<_Worker> &worker : this->_workers)
+        amount += worker->samples.load(std::memory_order_relaxed);
+    return amount;
+}
+
+/**
+ * Get the amount of samples that were skipped since the start, because a station sent them again (see "DM_StationStore::skipKnownSamples()").
+ *
+ * @return The amount of samples.
+ */
+uint64_t DM_IngestServer::getAmountOfDuplicateSamples() const
+{
+    uint64_t amount = 0;
+    for (const std::unique_ptr<_Worker> &worker : this->_workers)
+        amount += worker->duplicates.load(std::memory_order_relaxed);
+    return amount;
+}
+
+/**
+ * Get the amount of PUBLISH packets accepted since the start.
+ *
+ * @return The amount of messages.
+ */
+uint64_t DM_IngestServer::getAmountOfMessages() const
+{
+    uint64_t amount = 0;
+    for (const std::unique_ptr<_Worker> &worker : this->_workers)
+        amount += worker->messages.load(std::memory_order_relaxed);
+    return amount;
+}
+
+/**
+ * Get the amount of PUBLISH packets that had no valid sample (a topic or payload that isn't understood).
+ *
+ * @return The amount of rejected messages.
+ */
+uint64_t DM_IngestServer::getAmountOfRejectedMessages() const
+{
+    uint64_t amount = 0;
+    for (const std::unique_ptr<_Worker> &worker : this->_workers)
+        amount += worker->rejected.load(std::memory_order_relaxed);
+    return amount;
+}
+
+/**
+ * Get the amount of connections accepted since the start.
+ *
+ * @return The amount of connections.
+ */
+uint64_t DM_IngestServer::getAmountOfConnections() const
+{
+    uint64_t amount = 0;
+    for (const std::unique_ptr<_Worker> &worker : this->_workers)
+        amount += worker->accepted.load(std::memory_order_relaxed);
+    return amount;
+}
+
+/**
+ * Get the processor time the workers used since the start.
+ *
+ * @return The processor time of all workers together in seconds.
+ */
+double DM_IngestServer::getCPUSeconds() const
+{
+    double seconds = 0;
+    for (const std::unique_ptr<_Worker> &worker : this->_workers)
+        seconds += worker->CPUSeconds.load(std::memory_order_relaxed);
+    return seconds;
+}
+
+/**
+ * Read the channel number from a topic the stations publish to.
+ *
+ * @param topic The topic (not terminated).
+ * @param length The length of the topic.
+ * @param channel Set to the channel number.
+ * @param packed Set to true for the binary variant ("channels/<channel>/publish/packed").
+ *
+ * @return If the topic is one the stations publish to.
+ */
+bool DM_IngestServer::parseTopic(const uint8_t *topic, size_t length, uint32_t &channel, bool &packed)
+{
+    static const char prefix[] = "channels/";
+    static const char suffix[] = "/publish";
+    static const char packedSuffix[] = "/packed";
+    if (length < sizeof(prefix) - 1 || memcmp(topic, prefix, sizeof(prefix) - 1) != 0)
+        return false;
+
+    // Read the channel number
+    size_t position = sizeof(prefix) - 1;
+    uint64_t number = 0;
+    size_t start = position;
+    while (position < length && topic[position] >= '0' && topic[position] <= '9' && number <= UINT32_MAX)
+        number = number * 10 + (topic[position++] - '0');
+    if (position == start || number > UINT32_MAX)
+        return false;
+    channel = number;
+
+    // Check the rest of the topic
+    if (length - position < sizeof(suffix) - 1 || memcmp(topic + position, suffix, sizeof(suffix) - 1) != 0)
+        return false;
+    position += sizeof(suffix) - 1;
+    packed = length - position == sizeof(packedSuffix) - 1 && memcmp(topic + position, packedSuffix, sizeof(packedSuffix) - 1) == 0;
+    return packed || position == length;
+}
+
+/**
+ * Read the fields of a text payload ("field1=21.50&field2=312.00", keys that aren't a field are skipped).
+ *
+ * @param payload The payload (not terminated).
+ * @param length The length of the payload.
+ * @param values Set to the value of every field that is in the payload (field 1 first, "DM_StationStore::amountOfFields" values).
+ * @param presentFields Set to a bit per field that is in the payload (bit 0 for field 1).
+ *
+ * @return If the payload has at least one field with a valid value.
+ */
+bool DM_IngestServer::parseFields(const uint8_t *payload, size_t length, float *values, uint8_t &presentFields)
+{
+    presentFields = 0;
+    size_t position = 0;
+    while (position < length)
+    {
+        // Find the end of the pair
+        const uint8_t *pair = payload + position;
+        const uint8_t *end = (const uint8_t *)memchr(pair, '&', length - position);
+        size_t pairLength = end == nullptr ? length - position : end - pair;
+        position += pairLength + 1;
+
+        // Read the value of a field (a value that doesn't fit the buffer or isn't a number rejects the whole payload)
+        if (pairLength < 7 || memcmp(pair, "field", 5) != 0 || pair[5] < '1' || pair[5] > '0' + DM_StationStore::amountOfFields || pair[6] != '=')
+            continue;
+        char value[32];
+        size_t valueLength = pairLength - 7;
+        if (valueLength == 0 || valueLength >= sizeof(value))
+            return false;
+        memcpy(value, pair + 7, valueLength);
+        value[valueLength] = '\0';
+        char *valueEnd;
+        uint8_t field = pair[5] - '1';
+        values[field] = strtof(value, &valueEnd);
+        if (*valueEnd != '\0')
+            return false;
+        presentFields |= 1 << field;
+    }
+    return presentFields != 0;
+}
+
+/**
+ * Open a non-blocking listening socket that shares the port with the other workers.
+ *
+ * @param port The port (0 to let the system choose one, the chosen port is kept for the next workers).
+ *
+ * @return The socket, or -1 if it couldn't be opened.
+ */
+int DM_IngestServer::_listen(uint16_t port)
+{
+    int listener = socket(AF_INET6, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listener < 0)
+        return -1;
+    int on = 1;
+    int off = 0;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    setsockopt(listener, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+    setsockopt(listener, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+    struct sockaddr_in6 address = {};
+    address.sin6_family = AF_INET6;
+    address.sin6_addr = in6addr_any;
+    address.sin6_port = htons(port);
+    socklen_t addressLength = sizeof(address);
+    if (bind(listener, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(listener, SOMAXCONN) != 0 || getsockname(listener, (struct sockaddr *)&address, &addressLength) != 0)
+    {
+        close(listener);
+        return -1;
+    }
+    this->_port = ntohs(address.sin6_port);
+    return listener;
+}
+
+/**
+ * The loop of a worker: wait for its sockets, and serve the ones that are ready.
+ *
+ * @param worker The worker.
+ */
+void DM_IngestServer::_run(_Worker *worker)
+{
+    struct epoll_event events[maxEventsPerWait];
+    while (this->_running.load(std::memory_order_relaxed))
+    {
+        int amount = epoll_wait(worker->poll, events, maxEventsPerWait, waitTimeoutMs);
+        for (int i = 0; i < amount; i++)
+        {
+            int socket = events[i].data.fd;
+            if (socket == worker->listener)
+            {
+                this->_accept(worker);
+                continue;
+            }
+            std::unordered_map<int, _Connection>::iterator found = worker->connections.find(socket);
+            if (found == worker->connections.end())
+                continue;
+            bool open = !(events[i].events & (EPOLLERR | EPOLLHUP)) || (events[i].events & EPOLLIN);
+            if (open && (events[i].events & EPOLLIN))
+                open = this->_receive(worker, socket, found->second);
+            if (open && (events[i].events & EPOLLOUT))
+                open = this->_send(worker, socket, found->second);
+            if (!open)
+                this->_close(worker, socket);
+        }
+
+        // Keep the processor time of the thread up to date
+        struct timespec used;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &used);
+        worker->CPUSeconds.store(used.tv_sec + used.tv_nsec / 1e9, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Accept every connection that waits on the listening socket of a worker.
+ *
+ * @param worker The worker.
+ */
+void DM_IngestServer::_accept(_Worker *worker)
+{
+    while (true)
+    {
+        int socket = accept4(worker->listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (socket < 0)
+            return;
+        int on = 1;
+        setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        struct epoll_event event = {};
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.fd = socket;
+        if (epoll_ctl(worker->poll, EPOLL_CTL_ADD, socket, &event) != 0)
+        {
+            close(socket);
+            continue;
+        }
+        worker->connections[socket];
+        worker->accepted.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Read what a client sent, handle every whole packet, and send the replies.
+ *
+ * @param worker The worker.
+ * @param socket The socket of the connection.
+ * @param connection The connection.
+ *
+ * @return If the connection stays open.
+ */
+bool DM_IngestServer::_receive(_Worker *worker, int socket, _Connection &connection)
+{
+    // Read everything that is available
+    bool closed = false;
+    uint8_t buffer[16384];
+    while (true)
+    {
+        ssize_t received = recv(socket, buffer, sizeof(buffer), 0);
+        if (received > 0)
+            connection.input.insert(connection.input.end(), buffer, buffer + received);
+        else if (received == 0 || errno != EINTR)
+        {
+            closed = received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+            break;
+        }
+    }
+
+    // Handle every whole packet (a fixed header, the remaining length as a varint of at most 4 bytes, and the body)
+    const uint8_t *data = connection.input.data();
+    size_t available = connection.input.size();
+    size_t position = 0;
+    while (available - position >= 2)
+    {
+        size_t length = 0;
+        size_t header = 1;
+        bool complete = false;
+        for (unsigned int shift = 0; header < 5 && position + header < available; shift += 7)
+        {
+            uint8_t digit = data[position + header++];
+            length |= (size_t)(digit & 0x7F) << shift;
+            if (!(digit & 0x80))
+            {
+                complete = true;
+                break;
+            }
+        }
+        if (!complete && header == 5)
+            return false;
+        if (length > maxPacketSize)
+            return false;
+        if (!complete || available - position - header < length)
+            break;
+        if (!this->_handlePacket(worker, connection, data[position] >> 4, data[position] & 0x0F, data + position + header, length))
+            return false;
+        position += header + length;
+    }
+    connection.input.erase(connection.input.begin(), connection.input.begin() + position);
+
+    // Send the replies (what doesn't fit in the socket is sent when it is writable again)
+    return this->_send(worker, socket, connection) && !closed;
+}
+
+/**
+ * Send what waits to be sent, and only wait for EPOLLOUT as long as something is left.
+ *
+ * @param worker The worker.
+ * @param socket The socket of the connection.
+ * @param connection The connection.
+ *
+ * @return If the connection stays open.
+ */
+bool DM_IngestServer::_send(_Worker *worker, int socket, _Connection &connection)
+{
+    size_t position = 0;
+    while (position < connection.output.size())
+    {
+        ssize_t sent = send(socket, connection.output.data() + position, connection.output.size() - position, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR)
+            continue;
+        if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+            return false;
+        if (sent < 0)
+            break;
+        position += sent;
+    }
+    connection.output.erase(0, position);
+
+    // Register for EPOLLOUT only when it changes
+    bool waitToSend = !connection.output.empty();
+    if (waitToSend == connection.waitingToSend)
+        return true;
+    struct epoll_event event = {};
+    event.events = EPOLLIN | EPOLLRDHUP | (waitToSend ? (uint32_t)EPOLLOUT : 0);
+    event.data.fd = socket;
+    connection.waitingToSend = waitToSend;
+    return epoll_ctl(worker->poll, EPOLL_CTL_MOD, socket, &event) == 0;
+}
+
+/**
+ * Handle one MQTT packet.
+ *
+ * @param worker The worker.
+ * @param connection The connection the packet came from.
+ * @param type The packet type.
+ * @param flags The flags of the fixed header.
+ * @param body The variable header and the payload.
+ * @param length The length of the body.
+ *
+ * @return If the connection stays open.
+ */
+bool DM_IngestServer::_handlePacket(_Worker *worker, _Connection &connection, uint8_t type, uint8_t flags, const uint8_t *body, size_t length)
+{
+    // The first packet has to be a CONNECT (accepted without checking the credentials, like ThingSpeak only checks them for the channel)
+    if (type == packetConnect)
+    {
+        static const uint8_t protocol[] = {0x00, 0x04, 'M', 'Q', 'T', 'T'};
+        if (connection.connected || length < sizeof(protocol) || memcmp(body, protocol, sizeof(protocol)) != 0)
+            return false;
+        connection.connected = true;
+        connection.output.append("\x20\x02\x00\x00", 4);
+        return true;
+    }
+    if (!connection.connected)
+        return false;
+
+    switch (type)
+    {
+    case packetPublish:
+    {
+        // Read the topic and the packet identifier (QoS 2 isn't supported)
+        uint8_t quality = (flags >> 1) & 0x03;
+        if (quality > 1 || length < 2)
+            return false;
+        size_t topicLength = body[0] << 8 | body[1];
+        size_t payloadStart = 2 + topicLength + (quality > 0 ? 2 : 0);
+        if (payloadStart > length)
+            return false;
+
+        // Store the samples, and acknowledge the packet when it asks for it (also when the payload isn't understood, so the station doesn't send it again and again)
+        uint32_t channel;
+        bool packed;
+        if (!parseTopic(body + 2, topicLength, channel, packed) || !this->_handlePublish(worker, channel, packed, body + payloadStart, length - payloadStart))
+            worker->rejected.fetch_add(1, std::memory_order_relaxed);
+        else
+            worker->messages.fetch_add(1, std::memory_order_relaxed);
+        if (quality == 1)
+        {
+            const char acknowledgement[] = {0x40, 0x02, (char)body[2 + topicLength], (char)body[3 + topicLength]};
+            connection.output.append(acknowledgement, sizeof(acknowledgement));
+        }
+        return true;
+    }
+    case packetSubscribe:
+    {
+        // Refuse every subscription (0x80 per topic filter)
+        if (length < 2)
+            return false;
+        std::string acknowledgement = {(char)0x90, 0, (char)body[0], (char)body[1]};
+        for (size_t position = 2; position + 2 <= length;)
+        {
+            position += 2 + (body[position] << 8 | body[position + 1]) + 1;
+            acknowledgement.push_back((char)0x80);
+        }
+        if (acknowledgement.size() - 2 > 127)
+            return false;
+        acknowledgement[1] = acknowledgement.size() - 2;
+        connection.output.append(acknowledgement);
+        return true;
+    }
+    case packetPingRequest:
+        connection.output.append("\xD0\x00", 2);
+        return true;
+    case packetDisconnect:
+    default:
+        return false;
+    }
+}
+
+/**
+ * Write the samples of a PUBLISH packet to the store.
+ *
+ * @param worker The worker.
+ * @param channel The channel number of the station.
+ * @param packed If the payload is binary (otherwise it is text).
+ * @param payload The payload.
+ * @param length The length of the payload.
+ *
+ * @return If the payload had at least one valid sample.
+ */
+bool DM_IngestServer::_handlePublish(_Worker *worker, uint32_t channel, bool packed, const uint8_t *payload, size_t length)
+{
+    float values[DM_StationStore::amountOfFields];
+
+    // A text payload is one sample, stored at the time it arrives
+    if (!packed)
+    {
+        uint8_t presentFields;
+        if (!parseFields(payload, length, values, presentFields) || !this->_store->append(channel, getEpochMs(), values, presentFields))
+            return false;
+        worker->samples.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Decode all samples of a binary payload first, so a broken payload (or one of another station) stores nothing
+    DM_PayloadDecoder decoder;
+    if (!decoder.begin(payload, length) || decoder.getStationID() != channel)
+        return false;
+    uint32_t amount = decoder.getAmount();
+    DM_PackedSample samples[maxSamplesPerMessage];
+    uint32_t epochSeconds[maxSamplesPerMessage];
+    for (uint32_t i = 0; i < amount; i++)
+        if (!decoder.next(samples[i], epochSeconds[i]))
+            return false;
+
+    // Skip the samples that are already stored (the station sent the payload again because the acknowledgement got lost)
+    uint32_t skipped = this->_store->skipKnownSamples(channel, decoder.getBootID(), decoder.getSequence(), amount);
+    worker->duplicates.fetch_add(skipped, std::memory_order_relaxed);
+
+    // Store the others at their Unix time (a sample from before the clock of the station was synchronized is placed before the time of arrival, by the distance of its timestamp to the last one)
+    uint64_t receivedMs = getEpochMs();
+    uint32_t lastTimestampMs = samples[amount - 1].timestampMs;
+    for (uint32_t i = skipped; i < amount; i++)
+    {
+        DM_Sample sample = DM_PackedSample::unpack(samples[i]);
+        values[0] = sample.temperatureC;
+        values[1] = sample.lightIntensityLux;
+        values[2] = sample.airPressurePa;
+        uint64_t timeMs = epochSeconds[i] != 0 ? (uint64_t)epochSeconds[i] * 1000 : receivedMs - (uint32_t)(lastTimestampMs - samples[i].timestampMs);
+        if (!this->_store->append(channel, timeMs, values, 0x07))
+            return false;
+        worker->samples.fetch_add(1, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+/**
+ * Close a connection.
+ *
+ * @param worker The worker.
+ * @param socket The socket of the connection.
+ */
+void DM_IngestServer::_close(_Worker *worker, int socket)
+{
+    epoll_ctl(worker->poll, EPOLL_CTL_DEL, socket, nullptr);
+    close(socket);
+    worker->connections.erase(socket);
+}
\ No newline at end of file
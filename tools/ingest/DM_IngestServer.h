@@ -0,0 +1,95 @@
+/** +----------------------------------------------+
+ *  |  DM_IngestServer - MQTT ingest for stations  |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef DM_IngestServer_h
+#define DM_IngestServer_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h>         // Used to be able to use the "size_t" type
+#include <stdint.h>         // Used to be able to use the fixed width integer types
+#include <atomic>           // Used to count what the workers did without locking
+#include <memory>           // Used to own the workers
+#include <string>           // Used to keep the data that waits to be sent
+#include <thread>           // Used to run the workers
+#include <unordered_map>    // Used to find a connection by its socket
+#include <vector>           // Used to keep the workers and the received bytes
+#include "DM_ColumnStore.h" // Include the column files the samples are written to
+#include <DM_Payload.h>     // Used to know how many samples a binary payload can carry
+
+/**
+ * A small MQTT 3.1.1 broker that only accepts what the stations publish, and writes every sample to a column store (see "DM_ColumnStore.h").
+ *
+ * Two topics are accepted (QoS 0 and 1, QoS 1 is acknowledged once the sample is in the column files):
+ *  - "channels/<channel>/publish": the text payload of "DM_ThingSpeak::publishInformation()" ("field1=21.50&field2=312.00&field3=101325.00"), stored at the time it arrives.
+ *  - "channels/<channel>/publish/packed": a binary payload of "DM_Payload.h" with the same station ID, stored at the Unix time of every sample
+ *    (temperature in field 1, light intensity in field 2 and air pressure in field 3, like the sensor set sends them).
+ * Subscriptions are refused (this broker only receives), other packets and QoS 2 close the connection.
+ *
+ * Every worker is a thread with its own epoll loop and its own listening socket on the same port (SO_REUSEPORT), so the kernel spreads the connections over the workers and a connection never moves between threads.
+ * The sockets are non-blocking, and a connection only waits for EPOLLOUT while it has data that couldn't be sent yet.
+ */
+class DM_IngestServer
+{
+public: // The public functions and constants
+    static constexpr uint16_t defaultPort = 1883;                                           // The standard MQTT port
+    static constexpr size_t maxPacketSize = 64 * 1024;                                      // The largest packet a client may send (a larger one closes the connection)
+    static constexpr size_t maxSamplesPerMessage = DM_PayloadEncoder::maxSamplesPerPayload; // The most samples a binary payload can carry
+    static constexpr int maxEventsPerWait = 256;                                            // The amount of events one epoll_wait() call can return
+    static constexpr int waitTimeoutMs = 100;                                               // The longest a worker waits for an event (so it notices when it is stopped)
+
+    DM_IngestServer();
+    ~DM_IngestServer();
+    bool begin(DM_ColumnStore *store, uint16_t port, unsigned int amountOfWorkers);
+    void stop();
+    uint16_t getPort() const;
+    unsigned int getAmountOfWorkers() const;
+    uint64_t getAmountOfSamples() const;
+    uint64_t getAmountOfDuplicateSamples() const;
+    uint64_t getAmountOfMessages() const;
+    uint64_t getAmountOfRejectedMessages() const;
+    uint64_t getAmountOfConnections() const;
+    double getCPUSeconds() const;
+    static bool parseTopic(const uint8_t *topic, size_t length, uint32_t &channel, bool &packed);
+    static bool parseFields(const uint8_t *payload, size_t length, float *values, uint8_t &presentFields);
+
+private: // The private functions and members
+    struct _Connection
+    {
+        std::vector<uint8_t> input; // The received bytes that don't form a whole packet yet
+        std::string output;         // The bytes that wait to be sent
+        bool connected = false;     // If the client sent its CONNECT packet
+        bool waitingToSend = false; // If the socket is registered for EPOLLOUT
+    };
+    struct _Worker
+    {
+        std::thread thread;                               // The thread that runs the loop
+        int poll = -1;                                    // The epoll instance
+        int listener = -1;                                // The listening socket of this worker
+        std::unordered_map<int, _Connection> connections; // The connections of this worker, by socket
+        std::atomic<uint64_t> samples{0};                 // The amount of samples written
+        std::atomic<uint64_t> duplicates{0};              // The amount of samples of binary payloads that were skipped because they were already stored
+        std::atomic<uint64_t> messages{0};                // The amount of PUBLISH packets accepted
+        std::atomic<uint64_t> rejected{0};                // The amount of PUBLISH packets that had no valid sample
+        std::atomic<uint64_t> accepted{0};                // The amount of connections accepted
+        std::atomic<double> CPUSeconds{0};                // The processor time the thread used (updated while it runs)
+    };
+    DM_ColumnStore *_store;                         // The store the samples are written to
+    uint16_t _port;                                 // The port the workers listen on
+    std::atomic<bool> _running;                     // Cleared to stop the workers
+    std::vector<std::unique_ptr<_Worker>> _workers; // The workers
+    int _listen(uint16_t port);
+    void _run(_Worker *worker);
+    void _accept(_Worker *worker);
+    bool _receive(_Worker *worker, int socket, _Connection &connection);
+    bool _send(_Worker *worker, int socket, _Connection &connection);
+    bool _handlePacket(_Worker *worker, _Connection &connection, uint8_t type, uint8_t flags, const uint8_t *body, size_t length);
+    bool _handlePublish(_Worker *worker, uint32_t channel, bool packed, const uint8_t *payload, size_t length);
+    void _close(_Worker *worker, int socket);
+};
+
+#endif // End the header guard
\ No newline at end of file
@@ -0,0 +1,342 @@
+/** +----------------------------------------------+
+ *  |    DM_LoadGenerator - Simulated stations     |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include "DM_LoadGenerator.h" // Include the header file where the declarations for this library are stored
+#include <errno.h>            // Used to tell a socket that has nothing to read from a failed one
+#include <fcntl.h>            // Used to make the connections non-blocking
+#include <netinet/in.h>       // Used to connect to the server
+#include <netinet/tcp.h>      // Used to send the publishes without delay
+#include <stdio.h>            // Used to format the text payloads
+#include <sys/epoll.h>        // Used to wait for the sockets of a thread
+#include <sys/socket.h>       // Used to connect, read and write the connections
+#include <time.h>             // Used to pick the boot ID of the stations
+#include <unistd.h>           // Used to close the sockets
+#include <DM_Payload.h>       // Include the self-made library that encodes the binary payloads (the same code as on the station)
+
+// OTHER VARIABLES
+const uint32_t startEpochSeconds = 1714521600; // The Unix time of the first sample of every station (1 May 2024, 00:00 UTC)
+const uint32_t sampleIntervalSeconds = 60;     // The time between two samples of a station
+
+/**
+ * Append an MQTT remaining length (a varint of at most 4 bytes) to a packet.
+ *
+ * @param packet The packet.
+ * @param length The remaining length.
+ */
+static void appendRemainingLength(std::string &packet, size_t length)
+{
+    do
+    {
+        uint8_t digit = length & 0x7F;
+        length >>= 7;
+        packet.push_back((char)(digit | (length > 0 ? 0x80 : 0)));
+    } while (length > 0);
+}
+
+/**
+ * Create a generator that doesn't run yet.
+ */
+DM_LoadGenerator::DM_LoadGenerator() : _packed(false), _samplesPerMessage(1), _bootID(0), _running(false), _failed(false)
+{
+}
+
+/**
+ * Stop the threads.
+ */
+DM_LoadGenerator::~DM_LoadGenerator()
+{
+    this->stop();
+}
+
+/**
+ * Connect the stations and start publishing.
+ *
+ * @param port The port of the server (on this computer).
+ * @param amountOfStations The amount of stations (every one has its own connection and channel number).
+ * @param amountOfThreads The amount of threads the stations are spread over.
+ * @param packed If the stations send binary payloads (otherwise the text payload).
+ * @param samplesPerMessage The amount of samples in one binary payload (1 to 255).
+ *
+ * @return The success rate of connecting all stations.
+ */
+bool DM_LoadGenerator::begin(uint16_t port, size_t amountOfStations, unsigned int amountOfThreads, bool packed, uint8_t samplesPerMessage)
+{
+    this->_packed = packed;
+    this->_samplesPerMessage = packed ? samplesPerMessage : 1;
+    this->_bootID = (uint32_t)time(nullptr);
+    this->_running = true;
+    struct sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    for (unsigned int i = 0; i < amountOfThreads; i++)
+    {
+        std::unique_ptr<_Thread> thread(new _Thread());
+        thread->poll = epoll_create1(EPOLL_CLOEXEC);
+        thread->stations.resize(amountOfStations / amountOfThreads + (i < amountOfStations % amountOfThreads ? 1 : 0));
+        bool connected = thread->poll >= 0;
+        for (size_t j = 0; connected && j < thread->stations.size(); j++)
+        {
+            // Connect (blocking, it is only done once) and queue the CONNECT packet (MQTT 3.1.1, clean session, keep alive of 60 s, client identifier "s<channel>")
+            _Station &station = thread->stations[j];
+            station.channel = firstChannel + i + j * amountOfThreads;
+            station.socket = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            connected = station.socket >= 0 && connect(station.socket, (struct sockaddr *)&address, sizeof(address)) == 0;
+            if (!connected)
+                break;
+            int on = 1;
+            setsockopt(station.socket, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+            fcntl(station.socket, F_SETFL, fcntl(station.socket, F_GETFL) | O_NONBLOCK);
+            std::string identifier = "s" + std::to_string(station.channel);
+            station.output = {0x10};
+            appendRemainingLength(station.output, 12 + identifier.size());
+            station.output.append("\x00\x04MQTT\x04\x02\x00\x3C", 10);
+            station.output.push_back((char)(identifier.size() >> 8));
+            station.output.push_back((char)identifier.size());
+            station.output.append(identifier);
+            struct epoll_event event = {};
+            event.events = EPOLLIN | EPOLLOUT;
+            event.data.u64 = j;
+            station.waitingToSend = true;
+            connected = epoll_ctl(thread->poll, EPOLL_CTL_ADD, station.socket, &event) == 0;
+        }
+        _Thread *running = thread.get();
+        this->_threads.push_back(std::move(thread));
+        if (!connected)
+        {
+            this->stop();
+            return false;
+        }
+        running->thread = std::thread(&DM_LoadGenerator::_run, this, running);
+    }
+    return true;
+}
+
+/**
+ * Stop the threads, and close all connections.
+ */
+void DM_LoadGenerator::stop()
+{
+    this->_running = false;
+    for (std::unique_ptr<_Thread> &thread : this->_threads)
+    {
+        if (thread->thread.joinable())
+            thread->thread.join();
+        for (_Station &station : thread->stations)
+            if (station.socket >= 0)
+                close(station.socket);
+        if (thread->poll >= 0)
+            close(thread->poll);
+    }
+    this->_threads.clear();
+}
+
+/**
+ * Get the amount of samples the server acknowledged since the start.
+ *
+ * @return The amount of samples.
+ */
+uint64_t DM_LoadGenerator::getAmountOfSamples() const
+{
+    uint64_t amount = 0;
+    for (const std::unique_ptr<_Thread> &thread : this->_threads)
+        amount += thread->samples.load(std::memory_order_relaxed);
+    return amount;
+}
+
+/**
+ * Get the amount of stations the server accepted.
+ *
+ * @return The amount of connected stations.
+ */
+size_t DM_LoadGenerator::getAmountOfConnectedStations() const
+{
+    size_t amount = 0;
+    for (const std::unique_ptr<_Thread> &thread : this->_threads)
+        amount += thread->connected.load(std::memory_order_relaxed);
+    return amount;
+}
+
+/**
+ * Check if a connection was lost or refused.
+ *
+ * @return If a station failed.
+ */
+bool DM_LoadGenerator::hasFailed() const
+{
+    return this->_failed;
+}
+
+/**
+ * The loop of a thread: wait for the sockets of its stations, read the acknowledgements and send the next publishes.
+ *
+ * @param thread The thread.
+ */
+void DM_LoadGenerator::_run(_Thread *thread)
+{
+    struct epoll_event events[maxEventsPerWait];
+    while (this->_running.load(std::memory_order_relaxed))
+    {
+        int amount = epoll_wait(thread->poll, events, maxEventsPerWait, waitTimeoutMs);
+        for (int i = 0; i < amount; i++)
+        {
+            _Station &station = thread->stations[events[i].data.u64];
+            if (station.socket < 0)
+                continue;
+            bool open = !(events[i].events & (EPOLLERR | EPOLLHUP));
+            if (open && (events[i].events & EPOLLIN))
+                open = this->_receive(thread, station);
+            if (open && (events[i].events & EPOLLOUT))
+                open = this->_send(thread, station);
+            if (!open)
+            {
+                // A station that loses its connection is not reconnected, the benchmark is not valid anymore
+                this->_failed = true;
+                epoll_ctl(thread->poll, EPOLL_CTL_DEL, station.socket, nullptr);
+                close(station.socket);
+                station.socket = -1;
+            }
+        }
+    }
+}
+
+/**
+ * Queue the next publish of a station (QoS 1).
+ *
+ * @param station The station.
+ */
+void DM_LoadGenerator::_publish(_Station &station)
+{
+    // Build the payload, with values that change a bit from sample to sample
+    char payload[DM_PayloadEncoder::maxHeaderSize + DM_PayloadEncoder::maxSamplesPerPayload * DM_Encoder::maxEncodedSampleSize];
+    size_t payloadLength;
+    char topic[48];
+    size_t topicLength = snprintf(topic, sizeof(topic), this->_packed ? "channels/%lu/publish/packed" : "channels/%lu/publish", (unsigned long)station.channel);
+    if (!this->_packed)
+    {
+        uint32_t sequence = station.sequence++;
+        payloadLength = snprintf(payload, sizeof(payload), "field1=%.2f&field2=%.2f&field3=%.2f", 18 + (sequence % 97) / 10.0, 300 + (sequence % 89) * 2.5, 101325 + (sequence % 53) * 3.0);
+    }
+    else
+    {
+        DM_PayloadEncoder encoder;
+        encoder.begin((uint8_t *)payload, sizeof(payload), station.channel, this->_bootID, station.sequence);
+        for (uint8_t i = 0; i < this->_samplesPerMessage; i++)
+        {
+            uint32_t sequence = station.sequence++;
+            DM_PackedSample sample;
+            sample.timestampMs = sequence * sampleIntervalSeconds * 1000;
+            sample.temperature = 1800 + (sequence % 97) * 10;
+            sample.lightIntensity = 3000 + (sequence % 89) * 250;
+            sample.airPressure = 7132500 + (sequence % 53) * 300;
+            encoder.add(sample, startEpochSeconds + sequence * sampleIntervalSeconds);
+        }
+        payloadLength = encoder.getLength();
+    }
+
+    // Queue the PUBLISH packet
+    uint16_t packetId = station.nextPacketId++;
+    if (station.nextPacketId == 0)
+        station.nextPacketId = 1;
+    station.output.push_back((char)0x32);
+    appendRemainingLength(station.output, 2 + topicLength + 2 + payloadLength);
+    station.output.push_back((char)(topicLength >> 8));
+    station.output.push_back((char)topicLength);
+    station.output.append(topic, topicLength);
+    station.output.push_back((char)(packetId >> 8));
+    station.output.push_back((char)packetId);
+    station.output.append(payload, payloadLength);
+    station.inFlight++;
+}
+
+/**
+ * Read the acknowledgements of a station, and queue a publish for every one.
+ *
+ * @param thread The thread of the station.
+ * @param station The station.
+ *
+ * @return If the connection stays open.
+ */
+bool DM_LoadGenerator::_receive(_Thread *thread, _Station &station)
+{
+    char buffer[4096];
+    while (true)
+    {
+        ssize_t received = recv(station.socket, buffer, sizeof(buffer), 0);
+        if (received > 0)
+            station.input.append(buffer, received);
+        else if (received == 0)
+            return false;
+        else if (errno != EINTR)
+        {
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                return false;
+            break;
+        }
+    }
+
+    // The server only sends CONNACK and PUBACK, both 4 bytes long
+    size_t position = 0;
+    for (; station.input.size() - position >= 4; position += 4)
+    {
+        uint8_t type = station.input[position];
+        if (type == 0x20 && !station.connected && station.input[position + 3] == 0)
+        {
+            station.connected = true;
+            thread->connected.fetch_add(1, std::memory_order_relaxed);
+        }
+        else if (type == 0x40 && station.inFlight > 0)
+        {
+            station.inFlight--;
+            thread->samples.fetch_add(this->_samplesPerMessage, std::memory_order_relaxed);
+        }
+        else
+            return false;
+    }
+    station.input.erase(0, position);
+
+    // Keep the window of publishes full
+    while (station.connected && station.inFlight < maxInFlight && this->_running.load(std::memory_order_relaxed))
+        this->_publish(station);
+    return this->_send(thread, station);
+}
+
+/**
+ * Send what waits to be sent, and only wait for EPOLLOUT as long as something is left.
+ *
+ * @param thread The thread of the station.
+ * @param station The station.
+ *
+ * @return If the connection stays open.
+ */
+bool DM_LoadGenerator::_send(_Thread *thread, _Station &station)
+{
+    size_t position = 0;
+    while (position < station.output.size())
+    {
+        ssize_t sent = send(station.socket, station.output.data() + position, station.output.size() - position, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR)
+            continue;
+        if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+            return false;
+        if (sent < 0)
+            break;
+        position += sent;
+    }
+    station.output.erase(0, position);
+
+    // Register for EPOLLOUT only when it changes
+    bool waitToSend = !station.output.empty();
+    if (waitToSend == station.waitingToSend)
+        return true;
+    struct epoll_event event = {};
+    event.events = EPOLLIN | (waitToSend ? (uint32_t)EPOLLOUT : 0);
+    event.data.u64 = &station - thread->stations.data();
+    station.waitingToSend = waitToSend;
+    return epoll_ctl(thread->poll, EPOLL_CTL_MOD, station.socket, &event) == 0;
+}
\ No newline at end of file
@@ -0,0 +1,78 @@
+/** +----------------------------------------------+
+ *  |    DM_LoadGenerator - Simulated stations     |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+// If this library is already included in a file, make sure to not include it again → we set the ifndef header guard
+#ifndef DM_LoadGenerator_h
+#define DM_LoadGenerator_h
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <stddef.h> // Used to be able to use the "size_t" type
+#include <stdint.h> // Used to be able to use the fixed width integer types
+#include <atomic>   // Used to count the acknowledged samples without locking
+#include <memory>   // Used to own the threads
+#include <string>   // Used to keep the packets that are sent
+#include <thread>   // Used to run the threads
+#include <vector>   // Used to keep the threads and the connections
+
+/**
+ * Many stations that publish to an ingest server as fast as it acknowledges (see "DM_IngestServer.h").
+ *
+ * Every station is an MQTT connection that publishes with QoS 1 to "channels/<channel>/publish" (the text payload of "DM_ThingSpeak::publishInformation()")
+ * or to "channels/<channel>/publish/packed" (a batch of samples in the binary payload of "DM_Payload.h"), and keeps a few publishes in flight.
+ * Only acknowledged samples are counted, so the rate is what the server wrote to its column files, not what was sent.
+ * The stations are spread over threads that each run their own epoll loop.
+ */
+class DM_LoadGenerator
+{
+public: // The public functions and constants
+    static constexpr uint32_t firstChannel = 1000000; // The channel number of the first station (the next ones count up)
+    static constexpr uint32_t maxInFlight = 4;        // The amount of publishes a station sends before it waits for an acknowledgement
+    static constexpr int maxEventsPerWait = 256;      // The amount of events one epoll_wait() call can return
+    static constexpr int waitTimeoutMs = 100;         // The longest a thread waits for an event (so it notices when it is stopped)
+
+    DM_LoadGenerator();
+    ~DM_LoadGenerator();
+    bool begin(uint16_t port, size_t amountOfStations, unsigned int amountOfThreads, bool packed, uint8_t samplesPerMessage);
+    void stop();
+    uint64_t getAmountOfSamples() const;
+    size_t getAmountOfConnectedStations() const;
+    bool hasFailed() const;
+
+private: // The private functions and members
+    struct _Station
+    {
+        int socket = -1;            // The connection to the server
+        uint32_t channel = 0;       // The channel number of the station
+        uint32_t sequence = 0;      // The amount of samples the station made (it makes the values change)
+        uint32_t inFlight = 0;      // The amount of publishes that aren't acknowledged yet
+        uint16_t nextPacketId = 1;  // The identifier of the next publish
+        bool connected = false;     // If the server acknowledged the CONNECT packet
+        bool waitingToSend = false; // If the socket is registered for EPOLLOUT
+        std::string output;         // The bytes that wait to be sent
+        std::string input;          // The received bytes that don't form a whole packet yet
+    };
+    struct _Thread
+    {
+        std::thread thread;               // The thread that runs the loop
+        int poll = -1;                    // The epoll instance
+        std::vector<_Station> stations;   // The stations of this thread
+        std::atomic<uint64_t> samples{0}; // The amount of acknowledged samples
+        std::atomic<size_t> connected{0}; // The amount of stations that are connected
+    };
+    bool _packed;                                   // If the stations send binary payloads
+    uint8_t _samplesPerMessage;                     // The amount of samples in one binary payload
+    uint32_t _bootID;                               // The boot ID of the binary payloads (the time "begin()" was called, so the samples of a second run are not skipped as duplicates)
+    std::atomic<bool> _running;                     // Cleared to stop the threads
+    std::atomic<bool> _failed;                      // Set when a connection is lost
+    std::vector<std::unique_ptr<_Thread>> _threads; // The threads
+    void _run(_Thread *thread);
+    void _publish(_Station &station);
+    bool _receive(_Thread *thread, _Station &station);
+    bool _send(_Thread *thread, _Station &station);
+};
+
+#endif // End the header guard
\ No newline at end of file
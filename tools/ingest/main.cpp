@@ -0,0 +1,500 @@
+/** +----------------------------------------------+
+ *  |    DM_Ingest - Ingest server for stations    |
+ *  |----------------------------------------------|
+ *  | Coded by DataMind (aka. Rune Van den Heuvel) |
+ *  +----------------------------------------------+
+ */
+
+/**
+ * A Linux service that receives the samples of many stations over MQTT and writes them to memory-mapped column files, instead of sending them to ThingSpeak
+ * (which limits how often a channel can be updated and how long the data is kept).
+ * The stations only need another broker and channel number: the topic and the payload are the ones of "DM_ThingSpeak::publishInformation()".
+ *
+ * Build it with "pio run -e ingest" (or with any C++17 compiler on Linux, the files in this directory and the payload code of the station:
+ * "g++ -std=gnu++17 -O2 -pthread -Iinclude tools/ingest/DM_*.cpp tools/ingest/main.cpp src/DM_Sample.cpp src/DM_Codec.cpp src/DM_Payload.cpp src/DM_Format.cpp -o ingest"), and run:
+ *
+ *     ingest --data /var/lib/stations                    Serve on port 1883 with one worker per core
+ *     ingest --benchmark --stations 5000 --packed 10     Measure how many samples per second (and per core) the server sustains
+ *     ingest --payloads                                  Compare the size, the encoding time and the allocations of the text, JSON and binary payloads of the station
+ */
+
+// IMPORT THE NECESSARY LIBRARIES
+#include <math.h>             // Used to make up the weather of the payload comparison
+#include <signal.h>           // Used to stop the server with Ctrl+C
+#include <stdio.h>            // Used to show the results
+#include <stdlib.h>           // Used to read the options
+#include <string.h>           // Used to compare the options
+#include <ftw.h>              // Used to remove the data of a benchmark
+#include <sys/resource.h>     // Used to allow a descriptor per connection
+#include <time.h>             // Used to measure the duration of a benchmark
+#include <unistd.h>           // Used to count the cores and to wait
+#include <algorithm>          // Used to pick the default amount of threads
+#include <atomic>             // Used to count the allocations of the payload comparison
+#include <chrono>             // Used to wait between two status lines
+#include <functional>         // Used to pass the encoder of a payload to the comparison
+#include <new>                // Used to count the allocations of the payload comparison
+#include <random>             // Used to add noise to the weather of the payload comparison
+#include <string>             // Used to build the text payload the way the station did before "DM_Formatter"
+#include <thread>             // Used to wait between two status lines
+#include <vector>             // Used to keep the samples of the payload comparison
+#include <DM_Format.h>        // Include the self-made library that writes the text payloads of the station
+#include <DM_Payload.h>       // Include the self-made library that writes the binary payloads of the station
+#include "DM_ColumnStore.h"   // Include the column files the samples are written to
+#include "DM_IngestServer.h"  // Include the MQTT server
+#include "DM_LoadGenerator.h" // Include the simulated stations of the benchmark
+
+// OTHER VARIABLES
+const unsigned int statusIntervalSeconds = 10;                     // The time between two status lines of the server
+const unsigned int connectTimeoutSeconds = 30;                     // The longest a benchmark waits for all stations to be connected
+const unsigned int warmUpSeconds = 1;                              // The time a benchmark runs before it starts measuring
+const size_t comparedSamples = 1440;                               // The samples of the payload comparison (a day with a sample every minute)
+const double comparisonSeconds = 0.2;                              // The shortest time every payload is encoded for, to measure its encoding time
+const size_t comparedBatchSizes[] = {1, 10, 32};                   // The amounts of samples per binary payload that are compared (32 is "DM_Sink::maxBatchSize")
+const size_t TCPIPHeaderSize = 40;                                 // The IPv4 and TCP headers of every message (without options), counted as bytes on air
+const char *const textTopic = "channels/1973314/publish";          // The topic of a text or JSON payload (the channel number in "main.cpp" of the station)
+const char *const binaryTopic = "channels/1973314/publish/packed"; // The topic of a binary payload
+volatile sig_atomic_t stopRequested = 0;                           // Set by Ctrl+C or "kill"
+std::atomic<uint64_t> amountOfAllocations(0);                      // The amount of times "new" was called (see "operator new()" below)
+
+/**
+ * Count every allocation with "new" (the containers and "std::string" included), so the payload comparison can show how many allocations a payload costs.
+ *
+ * @param size The size of the block.
+ *
+ * @return The block.
+ */
+void *operator new(size_t size)
+{
+    amountOfAllocations.fetch_add(1, std::memory_order_relaxed);
+    void *block = malloc(size == 0 ? 1 : size);
+    if (block == nullptr)
+        throw std::bad_alloc();
+    return block;
+}
+
+/**
+ * Count every allocation of an array with "new".
+ *
+ * @param size The size of the block.
+ *
+ * @return The block.
+ */
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+/**
+ * Give a block of "new" back.
+ *
+ * @param block The block.
+ */
+void operator delete(void *block) noexcept
+{
+    free(block);
+}
+
+/**
+ * Give a block of "new" back.
+ *
+ * @param block The block.
+ * @param size The size of the block.
+ */
+void operator delete(void *block, size_t size) noexcept
+{
+    (void)size;
+    free(block);
+}
+
+/**
+ * Give a block of "new[]" back.
+ *
+ * @param block The block.
+ */
+void operator delete[](void *block) noexcept
+{
+    free(block);
+}
+
+/**
+ * Give a block of "new[]" back.
+ *
+ * @param block The block.
+ * @param size The size of the block.
+ */
+void operator delete[](void *block, size_t size) noexcept
+{
+    (void)size;
+    free(block);
+}
+
+/**
+ * Ask the server to stop.
+ *
+ * @param signal The signal that was received.
+ */
+static void requestStop(int signal)
+{
+    (void)signal;
+    stopRequested = 1;
+}
+
+/**
+ * Get the time of a monotonic clock.
+ *
+ * @return The time in seconds.
+ */
+static double getSeconds()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/**
+ * Remove a file or a directory (used by nftw() to remove the data of a benchmark).
+ *
+ * @return 0 to go on with the next one.
+ */
+static int removeEntry(const char *path, const struct stat *status, int type, struct FTW *position)
+{
+    (void)status;
+    (void)type;
+    (void)position;
+    remove(path);
+    return 0;
+}
+
+/**
+ * Show the command line options.
+ *
+ * @param program The name of the program.
+ */
+static void printUsage(const char *program)
+{
+    fprintf(stderr, "Usage: %s [options]\n", program);
+    fprintf(stderr, "  --port <port>                       The MQTT port (default %u, 0 to let the system choose one)\n", (unsigned int)DM_IngestServer::defaultPort);
+    fprintf(stderr, "  --data <directory>                  The directory with the column files (default \"data\", a temporary one for a benchmark)\n");
+    fprintf(stderr, "  --workers <amount>                  The amount of server threads (default one per core, half of the cores for a benchmark)\n");
+    fprintf(stderr, "  --benchmark                         Run simulated stations against the server, and show the sustained samples per second (per core)\n");
+    fprintf(stderr, "  --stations <amount>                 The amount of simulated stations in a benchmark (default 2000)\n");
+    fprintf(stderr, "  --threads <amount>                  The amount of threads of the simulated stations (default the other half of the cores)\n");
+    fprintf(stderr, "  --packed <samples>                  Let the simulated stations send binary payloads with this amount of samples (default the text payload)\n");
+    fprintf(stderr, "  --seconds <seconds>                 The duration of the measurement of a benchmark (default 10)\n");
+    fprintf(stderr, "  --payloads                          Compare the bytes per sample, the encoding time and the allocations of the payloads of the station, and exit\n");
+}
+
+/**
+ * Serve until Ctrl+C, with a status line every 10 seconds.
+ *
+ * @param server The running server.
+ * @param store The store the server writes to.
+ */
+static void serve(DM_IngestServer &server, DM_ColumnStore &store)
+{
+    uint64_t previousSamples = 0;
+    double previousSeconds = getSeconds();
+    while (!stopRequested)
+    {
+        for (unsigned int i = 0; i < statusIntervalSeconds && !stopRequested; i++)
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+        uint64_t samples = server.getAmountOfSamples();
+        double seconds = getSeconds();
+        printf("%llu samples (%.0f/s), %llu duplicates, %llu messages, %llu rejected, %zu stations, %llu connections\n", (unsigned long long)samples, (samples - previousSamples) / (seconds - previousSeconds),
+               (unsigned long long)server.getAmountOfDuplicateSamples(), (unsigned long long)server.getAmountOfMessages(), (unsigned long long)server.getAmountOfRejectedMessages(), store.getAmountOfStations(), (unsigned long long)server.getAmountOfConnections());
+        fflush(stdout);
+        previousSamples = samples;
+        previousSeconds = seconds;
+    }
+}
+
+/**
+ * Run simulated stations against the server, and show the rate the samples were written at.
+ *
+ * @param server The running server.
+ * @param store The store the server writes to.
+ * @param stations The amount of simulated stations.
+ * @param threads The amount of threads of the simulated stations.
+ * @param samplesPerMessage The amount of samples in a binary payload (0 for the text payload).
+ * @param measureSeconds The duration of the measurement.
+ *
+ * @return If the benchmark ran without losing a connection.
+ */
+static bool benchmark(DM_IngestServer &server, DM_ColumnStore &store, size_t stations, unsigned int threads, uint8_t samplesPerMessage, double measureSeconds)
+{
+    // Connect the stations, and wait until the server accepted all of them
+    DM_LoadGenerator generator;
+    if (!generator.begin(server.getPort(), stations, threads, samplesPerMessage > 0, samplesPerMessage))
+    {
+        fprintf(stderr, "Could not connect %zu stations to port %u\n", stations, (unsigned int)server.getPort());
+        return false;
+    }
+    double connectStart = getSeconds();
+    while (generator.getAmountOfConnectedStations() < stations && getSeconds() - connectStart < connectTimeoutSeconds && !generator.hasFailed())
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    if (generator.getAmountOfConnectedStations() < stations)
+    {
+        fprintf(stderr, "Only %zu of %zu stations were accepted\n", generator.getAmountOfConnectedStations(), stations);
+        return false;
+    }
+
+    // Measure after a warm-up (only samples the server acknowledged are counted)
+    std::this_thread::sleep_for(std::chrono::seconds(warmUpSeconds));
+    uint64_t startSamples = generator.getAmountOfSamples();
+    uint64_t startMessages = server.getAmountOfMessages();
+    double startCPUSeconds = server.getCPUSeconds();
+    double start = getSeconds();
+    std::this_thread::sleep_for(std::chrono::duration<double>(measureSeconds));
+    uint64_t samples = generator.getAmountOfSamples() - startSamples;
+    uint64_t messages = server.getAmountOfMessages() - startMessages;
+    double CPUSeconds = server.getCPUSeconds() - startCPUSeconds;
+    double seconds = getSeconds() - start;
+    generator.stop();
+
+    // Show the results (the rate per core is the rate per second of processor time of the server threads, so the simulated stations on the same computer don't count)
+    printf("Stations:           %zu (%zu with samples), simulated by %u threads\n", stations, store.getAmountOfStations(), threads);
+    printf("Payload:            %s\n", samplesPerMessage > 0 ? (std::to_string(samplesPerMessage) + " samples per binary message").c_str() : "text, 1 sample per message");
+    printf("Server:             %u workers, %.2f cores busy\n", server.getAmountOfWorkers(), CPUSeconds / seconds);
+    printf("Sustained:          %.0f samples/s (%.0f messages/s) over %.1f s\n", samples / seconds, messages / seconds, seconds);
+    printf("Per core:           %.0f samples/s\n", CPUSeconds > 0 ? samples / CPUSeconds : 0);
+    if (generator.hasFailed())
+        fprintf(stderr, "A station lost its connection during the benchmark\n");
+    return !generator.hasFailed();
+}
+
+/**
+ * Get the size of an MQTT PUBLISH packet with QoS 0 (the way "PubSubClient" publishes), with the IPv4 and TCP headers of its segment.
+ *
+ * @param topic The topic.
+ * @param payloadLength The length of the payload.
+ *
+ * @return The bytes on air.
+ */
+static size_t getBytesOnAir(const char *topic, size_t payloadLength)
+{
+    size_t remainingLength = 2 + strlen(topic) + payloadLength;
+    return TCPIPHeaderSize + 1 + (remainingLength < 128 ? 1 : remainingLength < 16384 ? 2 : 3) + remainingLength;
+}
+
+/**
+ * Encode all samples over and over for at least "comparisonSeconds", and show the bytes per sample, the encoding time per sample and per payload, and the allocations per payload.
+ *
+ * @param name The name of the payload.
+ * @param samplesPerMessage The amount of samples in one message.
+ * @param samples The samples.
+ * @param encode Writes the messages of all samples, and adds their payload bytes and bytes on air (the result of one round is used, the others are only timed).
+ */
+static void comparePayload(const char *name, size_t samplesPerMessage, const std::vector<DM_Sample> &samples, const std::function<void(size_t &, size_t &)> &encode)
+{
+    size_t payloadBytes = 0, bytesOnAir = 0, rounds = 0;
+    uint64_t allocations = amountOfAllocations.load(std::memory_order_relaxed);
+    double start = getSeconds(), seconds;
+    do
+    {
+        payloadBytes = 0;
+        bytesOnAir = 0;
+        encode(payloadBytes, bytesOnAir);
+        rounds++;
+        seconds = getSeconds() - start;
+    } while (seconds < comparisonSeconds);
+    allocations = amountOfAllocations.load(std::memory_order_relaxed) - allocations;
+    double payloads = (double)rounds * ((samples.size() + samplesPerMessage - 1) / samplesPerMessage);
+    printf("%-10s %9zu %15.1f %15.1f %15.1f %15.1f %15.2f\n", name, samplesPerMessage, (double)payloadBytes / samples.size(), (double)bytesOnAir / samples.size(),
+           seconds * 1e9 / (rounds * samples.size()), seconds * 1e9 / payloads, allocations / payloads);
+}
+
+/**
+ * Compare the payloads of the station on a day of made-up weather (a daily cycle with noise): the text payload of "DM_ThingSpeak::publishInformation()" (and the way it was built with "std::string" before),
+ * the JSON payload and the binary payload of "DM_MQTTSink", with the same code the station runs.
+ * The encoding time is the time of this computer, the time on the station is the "encode_payload" stage of "/metrics" (see "DM_Profiler.h").
+ */
+static void comparePayloads()
+{
+    // The fields of the sensor set (see "DM_Sensors.h")
+    static const DM_Field fields[] = {
+        {"Temperature", "°C", &DM_Sample::temperatureC, 1, 0.1, 0.3},
+        {"Air pressure", "Pa", &DM_Sample::airPressurePa, 3, 10, 10},
+        {"Light intensity", "lux", &DM_Sample::lightIntensityLux, 2, 20, 2000},
+    };
+
+    // Make up the weather
+    std::mt19937 generator(1);
+    std::normal_distribution<float> noise(0, 1);
+    std::vector<DM_Sample> samples(comparedSamples);
+    for (size_t i = 0; i < comparedSamples; i++)
+    {
+        double hour = i / 60.0;
+        samples[i].timestampMs = i * 60000 + 5000;
+        samples[i].epochSeconds = 1714521600 + i * 60;
+        samples[i].temperatureC = 14 + 6 * sin((hour - 9) * M_PI / 12) + 0.05 * noise(generator);
+        samples[i].airPressurePa = 101325 + 120 * sin(hour * M_PI / 36) + 3 * noise(generator);
+        samples[i].lightIntensityLux = std::max(0.0, 30000 * sin((hour - 6) * M_PI / 12)) * (1 + 0.02 * noise(generator));
+        samples[i].airPressureBar = samples[i].airPressurePa / 100000;
+    }
+
+    // Compare the payloads
+    printf("%-10s %9s %15s %15s %15s %15s %15s\n", "Payload", "Samples", "Bytes/sample", "On air/sample", "ns/sample", "ns/payload", "Allocs/payload");
+    comparePayload("string", 1, samples, [&](size_t &payloadBytes, size_t &bytesOnAir) {
+        for (const DM_Sample &sample : samples)
+        {
+            // The text payload the way "DM_ThingSpeak::publishInformation()" built it before "DM_Formatter", as reference
+            std::string topic = "channels/" + std::to_string(1973314) + "/publish";
+            std::string value;
+            for (const DM_Field &field : fields)
+                value += (value.empty() ? "field" : "&field") + std::to_string(field.thingSpeakField) + "=" + std::to_string(roundf(sample.*field.member * 100) / 100);
+            payloadBytes += value.length();
+            bytesOnAir += getBytesOnAir(topic.c_str(), value.length());
+        }
+    });
+    comparePayload("text", 1, samples, [&](size_t &payloadBytes, size_t &bytesOnAir) {
+        for (const DM_Sample &sample : samples)
+        {
+            char payload[160];
+            DM_Formatter value(payload, sizeof(payload));
+            for (const DM_Field &field : fields)
+                value.append(value.length() == 0 ? "field" : "&field").appendUnsigned(field.thingSpeakField).appendLiteral("=").appendFixed(sample.*field.member, 2);
+            payloadBytes += value.length();
+            bytesOnAir += getBytesOnAir(textTopic, value.length());
+        }
+    });
+    comparePayload("JSON", 1, samples, [&](size_t &payloadBytes, size_t &bytesOnAir) {
+        for (const DM_Sample &sample : samples)
+        {
+            char payload[192];
+            DM_Formatter JSON(payload, sizeof(payload));
+            JSON.appendLiteral("{\"epochSeconds\":").appendUnsigned(sample.epochSeconds);
+            for (const DM_Field &field : fields)
+                JSON.appendLiteral(",\"").append(field.name).appendLiteral("\":").appendFixed(sample.*field.member, 2);
+            JSON.appendLiteral("}");
+            payloadBytes += JSON.length();
+            bytesOnAir += getBytesOnAir(textTopic, JSON.length());
+        }
+    });
+    for (size_t batchSize : comparedBatchSizes)
+        comparePayload("binary", batchSize, samples, [&](size_t &payloadBytes, size_t &bytesOnAir) {
+            uint8_t payload[DM_PayloadEncoder::maxHeaderSize + 32 * DM_Encoder::maxEncodedSampleSize];
+            for (size_t first = 0; first < samples.size(); first += batchSize)
+            {
+                DM_PayloadEncoder encoder;
+                encoder.begin(payload, sizeof(payload), 1973314, 1, first);
+                for (size_t i = first; i < std::min(first + batchSize, samples.size()); i++)
+                    encoder.add(DM_PackedSample::pack(samples[i]), samples[i].epochSeconds);
+                payloadBytes += encoder.getLength();
+                bytesOnAir += getBytesOnAir(binaryTopic, encoder.getLength());
+            }
+        });
+}
+
+/**
+ * Read the options, and serve or run the benchmark.
+ */
+int main(int argc, char **argv)
+{
+    // Read the options
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    uint16_t port = DM_IngestServer::defaultPort;
+    const char *dataDirectory = nullptr;
+    unsigned int workers = 0, threads = 0;
+    bool runBenchmark = false;
+    size_t stations = 2000;
+    unsigned long samplesPerMessage = 0;
+    double measureSeconds = 10;
+    for (int i = 1; i < argc; i++)
+    {
+        const char *option = argv[i];
+        if (strcmp(option, "--benchmark") == 0)
+        {
+            runBenchmark = true;
+            continue;
+        }
+        if (strcmp(option, "--payloads") == 0)
+        {
+            comparePayloads();
+            return 0;
+        }
+        if (i + 1 >= argc)
+        {
+            printUsage(argv[0]);
+            return 2;
+        }
+        const char *value = argv[++i];
+        if (strcmp(option, "--port") == 0)
+            port = strtoul(value, nullptr, 10);
+        else if (strcmp(option, "--data") == 0)
+            dataDirectory = value;
+        else if (strcmp(option, "--workers") == 0)
+            workers = strtoul(value, nullptr, 10);
+        else if (strcmp(option, "--stations") == 0)
+            stations = strtoul(value, nullptr, 10);
+        else if (strcmp(option, "--threads") == 0)
+            threads = strtoul(value, nullptr, 10);
+        else if (strcmp(option, "--packed") == 0)
+            samplesPerMessage = strtoul(value, nullptr, 10);
+        else if (strcmp(option, "--seconds") == 0)
+            measureSeconds = atof(value);
+        else
+        {
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+    if (samplesPerMessage > DM_IngestServer::maxSamplesPerMessage || stations == 0 || measureSeconds <= 0)
+    {
+        printUsage(argv[0]);
+        return 2;
+    }
+    if (workers == 0)
+        workers = runBenchmark ? std::max(1L, cores / 2) : std::max(1L, cores);
+    if (threads == 0)
+        threads = std::max(1L, cores - (long)workers);
+
+    // Allow a descriptor for every connection (a benchmark needs two per station)
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0)
+    {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    // A benchmark writes to a temporary directory on its own port, unless they are given
+    char temporaryDirectory[] = "/tmp/dm-ingest-XXXXXX";
+    if (runBenchmark && dataDirectory == nullptr)
+    {
+        dataDirectory = mkdtemp(temporaryDirectory);
+        port = 0;
+    }
+    if (dataDirectory == nullptr)
+        dataDirectory = "data";
+
+    // Start the server
+    DM_ColumnStore store;
+    DM_IngestServer server;
+    if (!store.begin(dataDirectory))
+    {
+        fprintf(stderr, "Could not use \"%s\" as data directory\n", dataDirectory);
+        return 1;
+    }
+    if (!server.begin(&store, port, workers))
+    {
+        fprintf(stderr, "Could not listen on port %u\n", (unsigned int)port);
+        return 1;
+    }
+    signal(SIGINT, requestStop);
+    signal(SIGTERM, requestStop);
+    signal(SIGPIPE, SIG_IGN);
+    bool succeeded = true;
+    if (runBenchmark)
+        succeeded = benchmark(server, store, stations, threads, samplesPerMessage, measureSeconds);
+    else
+    {
+        printf("Listening on port %u with %u workers, writing to \"%s\"\n", (unsigned int)server.getPort(), workers, dataDirectory);
+        fflush(stdout);
+        serve(server, store);
+    }
+    server.stop();
+
+    // Remove the temporary data of a benchmark
+    if (dataDirectory == temporaryDirectory)
+        nftw(temporaryDirectory, removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+    return succeeded ? 0 : 1;
+}
\ No newline at end of file